@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <system_error>
 
@@ -41,5 +42,12 @@ public:
   virtual std::error_code read(IReadBatch& batch) = 0;
   virtual std::error_code readThreadSafe(IReadBatch &batch) = 0;
 
+  // Moves records written with an older physical layout of the store to the current one
+  virtual std::error_code migrateStorageLayout() = 0;
+
+  // Read-only view of the data as it is now, unaffected by later writes. Writing to it fails.
+  // It must be released before the database is shut down.
+  virtual std::unique_ptr<IDataBase> createSnapshot() = 0;
+
 };
 }
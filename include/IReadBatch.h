@@ -20,6 +20,7 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <utility>
 
 namespace CryptoNote {
@@ -28,6 +29,12 @@ class IReadBatch {
 public:
   virtual std::vector<std::string> getRawKeys() const = 0; 
   virtual void submitRawResult(const std::vector<std::string>& values, const std::vector<bool>& resultStates) = 0;
+
+  // Values point into memory owned by the database and are valid only during the call,
+  // which lets a batch deserialize them in place. Batches which don't care get a copy.
+  virtual void submitRawResult(const std::vector<std::string_view>& values, const std::vector<bool>& resultStates) {
+    submitRawResult(std::vector<std::string>(values.begin(), values.end()), resultStates);
+  }
   virtual ~IReadBatch() {}
 };
 
@@ -26,6 +26,11 @@ class IStreamSerializable {
 public:
   virtual void save(std::ostream& os) = 0;
   virtual void load(std::istream& in) = 0;
+
+  // Writes the changes made since the last save, load or saveChanges call. loadChanges applies them on top of the
+  // state they were made against. The whole state is a valid set of changes, so this is the default.
+  virtual void saveChanges(std::ostream& os) { save(os); }
+  virtual void loadChanges(std::istream& in) { load(in); }
   virtual ~IStreamSerializable() {}
 };
 
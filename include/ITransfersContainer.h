@@ -69,6 +69,14 @@ struct TransactionSpentOutputInformation: public TransactionOutputInformation {
   uint32_t inputInTransaction;
 };
 
+// Order in which spendable outputs are picked to cover an amount
+enum class OutputSelectionStrategy : uint8_t {
+  Random,             // outputs in random order
+  LargestFirst,       // largest outputs first, fewest inputs
+  SmallestSufficient, // the smallest output covering the whole amount, largest outputs first if there is none
+  ConsolidateDust     // as many dust outputs as allowed, smallest first, then largest outputs first
+};
+
 class ITransfersContainer : public IStreamSerializable {
 public:
   enum Flags : uint32_t {
@@ -98,6 +106,10 @@ public:
   virtual size_t transactionsCount() const = 0;
   virtual uint64_t balance(uint32_t flags = IncludeDefault) const = 0;
   virtual void getOutputs(std::vector<TransactionOutputInformation>& transfers, uint32_t flags = IncludeDefault) const = 0;
+  // Appends unlocked key outputs in the order of the strategy until they cover neededMoney, returns their amount.
+  // Outputs not above dustThreshold are picked separately, at most dustCount of them.
+  virtual uint64_t selectOutputs(uint64_t neededMoney, uint64_t dustThreshold, size_t dustCount, OutputSelectionStrategy strategy,
+    std::vector<TransactionOutputInformation>& outputs) const = 0;
   virtual bool getTransactionInformation(const Crypto::Hash& transactionHash, TransactionInformation& info,
     uint64_t* amountIn = nullptr, uint64_t* amountOut = nullptr) const = 0;
   virtual std::vector<TransactionOutputInformation> getTransactionOutputs(const Crypto::Hash& transactionHash, uint32_t flags = IncludeDefault) const = 0;
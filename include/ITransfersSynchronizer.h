@@ -40,6 +40,10 @@ struct AccountSubscription {
 
 class ITransfersSubscription;
 
+/**
+ * All callbacks come from the thread that feeds the synchronizer's consumers, in chain order. Containers
+ * may be updated on scanning threads, but their observers are never called from them.
+ */
 class ITransfersObserver {
 public:
   virtual void onError(ITransfersSubscription* object,
@@ -120,6 +120,7 @@ struct TransactionParameters {
   uint64_t unlockTimestamp = 0;
   DonationSettings donation;
   std::string changeDestination;
+  OutputSelectionStrategy outputSelection = OutputSelectionStrategy::Random;
 };
 
 struct WalletTransactionWithTransfers {
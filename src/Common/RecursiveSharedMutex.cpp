@@ -0,0 +1,111 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "RecursiveSharedMutex.h"
+
+#include <cassert>
+
+namespace Common {
+
+RecursiveSharedMutex::RecursiveSharedMutex() :
+  m_waitingWriters(0),
+  m_writing(false),
+  m_owner(std::thread::id()),
+  m_depth(0) {
+}
+
+void RecursiveSharedMutex::lock() {
+  auto self = std::this_thread::get_id();
+  if (m_owner.load() == self) {
+    ++m_depth;
+    return;
+  }
+
+  std::unique_lock<std::mutex> guard(m_mutex);
+  ++m_waitingWriters;
+  m_writersGate.wait(guard, [this] { return !m_writing && m_readers.empty(); });
+  --m_waitingWriters;
+  m_writing = true;
+
+  m_owner.store(self);
+  m_depth = 1;
+}
+
+void RecursiveSharedMutex::unlock() {
+  assert(m_owner.load() == std::this_thread::get_id());
+  if (--m_depth > 0) {
+    return;
+  }
+
+  m_owner.store(std::thread::id());
+
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_writing = false;
+  }
+
+  m_writersGate.notify_one();
+  m_readersGate.notify_all();
+}
+
+void RecursiveSharedMutex::lock_shared() {
+  auto self = std::this_thread::get_id();
+  if (m_owner.load() == self) {
+    ++m_depth;
+    return;
+  }
+
+  std::unique_lock<std::mutex> guard(m_mutex);
+  auto it = m_readers.find(self);
+  if (it != m_readers.end()) {
+    // the writer waits for this thread anyway, holding it at the gate would deadlock both
+    ++it->second;
+    return;
+  }
+
+  m_readersGate.wait(guard, [this] { return !m_writing && m_waitingWriters == 0; });
+  m_readers.emplace(self, 1);
+}
+
+void RecursiveSharedMutex::unlock_shared() {
+  auto self = std::this_thread::get_id();
+  if (m_owner.load() == self) {
+    assert(m_depth > 1);
+    --m_depth;
+    return;
+  }
+
+  bool wakeWriter;
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto it = m_readers.find(self);
+    assert(it != m_readers.end());
+    if (--it->second > 0) {
+      return;
+    }
+
+    m_readers.erase(it);
+    wakeWriter = m_readers.empty() && m_waitingWriters > 0;
+  }
+
+  if (wakeWriter) {
+    m_writersGate.notify_one();
+  }
+}
+
+}
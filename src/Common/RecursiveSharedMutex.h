@@ -0,0 +1,60 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace Common {
+
+// Reader-writer lock usable with std::unique_lock and std::shared_lock.
+// The exclusive side is recursive, and the thread holding it may also take the shared side.
+// Writers are preferred: once a writer waits no new reader gets in, but a thread that already
+// holds the shared side may take it again.
+class RecursiveSharedMutex {
+public:
+  RecursiveSharedMutex();
+  RecursiveSharedMutex(const RecursiveSharedMutex&) = delete;
+  RecursiveSharedMutex& operator=(const RecursiveSharedMutex&) = delete;
+
+  void lock();
+  void unlock();
+
+  void lock_shared();
+  void unlock_shared();
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_readersGate;
+  std::condition_variable m_writersGate;
+  // threads holding the shared side, each with its own hold count
+  std::unordered_map<std::thread::id, size_t> m_readers;
+  size_t m_waitingWriters;
+  bool m_writing;
+
+  // only the owner reads its own id back, other threads just see a different one
+  std::atomic<std::thread::id> m_owner;
+  size_t m_depth;
+};
+
+}
@@ -121,6 +121,8 @@ static_assert(0 < UPGRADE_VOTING_THRESHOLD && UPGRADE_VOTING_THRESHOLD <= 100, "
 static_assert(UPGRADE_VOTING_WINDOW > 1, "Bad UPGRADE_VOTING_WINDOW");
 
 const char     P2P_NET_DATA_FILENAME[]                       = "p2pstate.bin";
+const char     BLOCK_INDEXES_CACHE_FILENAME[]                = "blockindexes.bin";
+const char     SPENT_KEY_IMAGES_FILTER_FILENAME[]            = "spentkeyimages.bin";
 const char     MINER_CONFIG_FILE_NAME[]                      = "miner_conf.json";
 } // parameters
 
@@ -142,6 +144,12 @@ const uint8_t  BLOCK_MINOR_VERSION_1                         =  1;
 
 const size_t   BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT        =  10000;  //by default, blocks ids count in synchronizing
 const size_t   BLOCKS_SYNCHRONIZING_DEFAULT_COUNT            =  128;    //by default, blocks count in blocks downloading
+const size_t   BLOCKS_SYNCHRONIZING_MIN_COUNT                =  16;     //batch size bounds when adjusted to peer throughput
+const size_t   BLOCKS_SYNCHRONIZING_MAX_COUNT                =  512;
+const size_t   BLOCKS_SYNCHRONIZING_REQUESTS_IN_FLIGHT       =  3;      //per peer
+const uint32_t BLOCKS_SYNCHRONIZING_WINDOW                   =  4096;   //blocks downloaded ahead of the lowest missing one
+const uint32_t BLOCKS_SYNCHRONIZING_RESPONSE_TIME            =  2;      //seconds, batch sizes aim at it
+const uint32_t BLOCKS_SYNCHRONIZING_STALL_TIMEOUT            =  10;     //seconds before the lowest missing blocks are requested again
 const size_t   COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT         =  1000;
 
 const int      P2P_DEFAULT_PORT                              =  8200;
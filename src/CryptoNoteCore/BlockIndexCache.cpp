@@ -0,0 +1,127 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockIndexCache.h"
+
+#include <cassert>
+#include <cstring>
+
+#include <boost/filesystem/operations.hpp>
+
+namespace CryptoNote {
+
+namespace {
+
+// bump whenever CachedBlockInfo or the meaning of the records changes
+const uint32_t BLOCK_INDEX_CACHE_VERSION = 2;
+
+}
+
+BlockIndexCache::BlockIndexCache(const std::string& path) : m_closedCleanly(false) {
+  try {
+    m_blocks.open(path, Common::FileMappedVectorOpenMode::OPEN_OR_CREATE, sizeof(Prefix));
+  } catch (std::exception&) {
+    // unreadable leftovers of an older layout or a truncated file, start over;
+    // open() may fail after mapping the file, so close it first
+    std::error_code ignoreClose;
+    m_blocks.close(ignoreClose);
+
+    boost::system::error_code ignore;
+    boost::filesystem::remove(path, ignore);
+    m_blocks.open(path, Common::FileMappedVectorOpenMode::CREATE, sizeof(Prefix));
+  }
+
+  m_blocks.setAutoFlush(false);
+
+  Prefix stored;
+  std::memcpy(&stored, m_blocks.prefix(), sizeof(stored));
+  if (stored.version != BLOCK_INDEX_CACHE_VERSION || stored.recordSize != sizeof(CachedBlockInfo)) {
+    m_blocks.clear();
+  } else {
+    // the mapping is only synced on save, after a crash any entry may be stale, not just the last one
+    m_closedCleanly = stored.closedCleanly != 0 && stored.checksum == getChecksum();
+  }
+
+  // stays marked this way until the destructor, so a crash is noticed on the next start
+  writePrefix(false);
+}
+
+BlockIndexCache::~BlockIndexCache() {
+  if (m_blocks.isOpened()) {
+    try {
+      m_blocks.flush();
+      writePrefix(true);
+    } catch (std::exception&) {
+    }
+
+    std::error_code ignore;
+    m_blocks.close(ignore);
+  }
+}
+
+bool BlockIndexCache::wasClosedCleanly() const {
+  return m_closedCleanly;
+}
+
+uint32_t BlockIndexCache::getBlockCount() const {
+  return static_cast<uint32_t>(m_blocks.size());
+}
+
+const CachedBlockInfo& BlockIndexCache::operator[](uint32_t blockIndex) const {
+  assert(blockIndex < m_blocks.size());
+  return m_blocks[blockIndex];
+}
+
+void BlockIndexCache::reserve(uint32_t blockCount) {
+  m_blocks.reserve(blockCount);
+}
+
+void BlockIndexCache::push(const CachedBlockInfo& blockInfo) {
+  m_blocks.push_back(blockInfo);
+}
+
+void BlockIndexCache::cut(uint32_t blockCount) {
+  while (m_blocks.size() > blockCount) {
+    m_blocks.pop_back();
+  }
+}
+
+void BlockIndexCache::flush() {
+  m_blocks.flush();
+}
+
+Crypto::Hash BlockIndexCache::getChecksum() const {
+  Crypto::Hash checksum;
+  Crypto::cn_fast_hash(m_blocks.data(), m_blocks.size() * sizeof(CachedBlockInfo), checksum);
+  return checksum;
+}
+
+void BlockIndexCache::writePrefix(bool closedCleanly) {
+  Prefix prefix = {};
+  prefix.version = BLOCK_INDEX_CACHE_VERSION;
+  prefix.recordSize = sizeof(CachedBlockInfo);
+  prefix.closedCleanly = closedCleanly ? 1 : 0;
+  if (closedCleanly) {
+    prefix.checksum = getChecksum();
+  }
+
+  std::memcpy(m_blocks.prefix(), &prefix, sizeof(prefix));
+  m_blocks.flush();
+}
+
+}
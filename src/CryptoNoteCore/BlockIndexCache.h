@@ -0,0 +1,76 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/FileMappedVector.h"
+#include "crypto/hash.h"
+#include "CryptoNoteCore/IBlockchainCache.h"
+
+namespace CryptoNote {
+
+// Memory-mapped copy of the CachedBlockInfo records of the main chain (hash, timestamp, cumulative
+// difficulty, generated coins and transactions, size), indexed by block index. The records are used
+// in place rather than rebuilt from the database, but opening and closing still hash the whole file
+// to check it (see getChecksum), so both read every record: one sequential pass, linear in the chain
+// length.
+//
+// The file is not synced on every change: whoever opens it checks it against the database and
+// cuts or refills the tail as needed.
+class BlockIndexCache {
+public:
+  // throws if the file can't be opened or created
+  explicit BlockIndexCache(const std::string& path);
+  // stores the checksum and marks the file as cleanly closed
+  ~BlockIndexCache();
+
+  BlockIndexCache(const BlockIndexCache&) = delete;
+  BlockIndexCache& operator=(const BlockIndexCache&) = delete;
+
+  // false if the process holding the file didn't close it or the entries don't match their checksum,
+  // the entries can't be trusted then
+  bool wasClosedCleanly() const;
+  uint32_t getBlockCount() const;
+  const CachedBlockInfo& operator[](uint32_t blockIndex) const;
+
+  void reserve(uint32_t blockCount);
+  void push(const CachedBlockInfo& blockInfo);
+  // keeps the first blockCount blocks
+  void cut(uint32_t blockCount);
+  void flush();
+
+private:
+  struct Prefix {
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t closedCleanly;
+    uint32_t reserved;
+    Crypto::Hash checksum;
+  };
+
+  Common::FileMappedVector<CachedBlockInfo> m_blocks;
+  bool m_closedCleanly;
+
+  Crypto::Hash getChecksum() const;
+  void writePrefix(bool closedCleanly);
+};
+
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "BlockSignatureBatch.h"
+
+#include <limits>
+
+namespace CryptoNote {
+
+BlockSignatureBatch::BlockSignatureBatch(Utilities::ThreadPool<bool> &threadPool):
+    m_threadPool(threadPool),
+    m_cancelled(false),
+    m_failedTransactionIndex(std::numeric_limits<size_t>::max())
+{
+}
+
+BlockSignatureBatch::~BlockSignatureBatch()
+{
+    cancel();
+
+    for (auto &job : m_jobs)
+    {
+        if (job.second.valid())
+        {
+            job.second.wait();
+        }
+    }
+}
+
+void BlockSignatureBatch::addJob(const size_t transactionIndex, const std::function<bool()> &job)
+{
+    m_jobs.emplace_back(transactionIndex, m_threadPool.addJob([transactionIndex, job, this] {
+        if (m_cancelled.load())
+        {
+            return false;
+        }
+
+        if (job())
+        {
+            return true;
+        }
+
+        /* Remember the earliest failed transaction, so the reported error
+         * doesn't depend on the order in which the threads finished */
+        size_t failedIndex = m_failedTransactionIndex.load();
+        while (transactionIndex < failedIndex &&
+               !m_failedTransactionIndex.compare_exchange_weak(failedIndex, transactionIndex))
+        {
+        }
+
+        m_cancelled.store(true);
+
+        return false;
+    }));
+}
+
+void BlockSignatureBatch::cancel()
+{
+    m_cancelled.store(true);
+}
+
+bool BlockSignatureBatch::wait(size_t &failedTransactionIndex)
+{
+    for (auto &job : m_jobs)
+    {
+        job.second.get();
+    }
+
+    m_jobs.clear();
+
+    failedTransactionIndex = m_failedTransactionIndex.load();
+
+    return failedTransactionIndex == std::numeric_limits<size_t>::max();
+}
+
+size_t BlockSignatureBatch::jobCount() const
+{
+    return m_jobs.size();
+}
+
+}
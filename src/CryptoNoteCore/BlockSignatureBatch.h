@@ -0,0 +1,72 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <vector>
+
+#include "Common/ThreadPool.h"
+
+namespace CryptoNote
+{
+
+/* Collects the expensive per-input checks (key image lookups, output key
+ * extraction and check_ring_signature) of every transaction in a block and
+ * runs them on the validation thread pool as a single batch, so the pool is
+ * kept busy across transaction boundaries. The first failing job cancels all
+ * jobs which have not been started yet. */
+class BlockSignatureBatch
+{
+    public:
+        /////////////////
+        /* CONSTRUCTOR */
+        /////////////////
+        BlockSignatureBatch(Utilities::ThreadPool<bool> &threadPool);
+
+        ////////////////
+        /* DESTRUCTOR */
+        ////////////////
+
+        /* Cancels and waits for all outstanding jobs, as they reference the
+         * transaction validators which own them */
+        ~BlockSignatureBatch();
+
+        BlockSignatureBatch(const BlockSignatureBatch &) = delete;
+        BlockSignatureBatch &operator=(const BlockSignatureBatch &) = delete;
+
+        /////////////////////////////
+        /* PUBLIC MEMBER FUNCTIONS */
+        /////////////////////////////
+
+        /* Queue a job belonging to the transaction at the given index of the block */
+        void addJob(const size_t transactionIndex, const std::function<bool()> &job);
+
+        /* Stop any job which has not been started yet */
+        void cancel();
+
+        /* Wait for every queued job. Returns false and sets failedTransactionIndex
+         * to the lowest index of a transaction that failed verification */
+        bool wait(size_t &failedTransactionIndex);
+
+        size_t jobCount() const;
+
+    private:
+        /////////////////////////
+        /* PRIVATE MEMBER VARS */
+        /////////////////////////
+        Utilities::ThreadPool<bool> &m_threadPool;
+
+        std::atomic<bool> m_cancelled;
+
+        /* Lowest index of a transaction with a job which failed (not cancelled) */
+        std::atomic<size_t> m_failedTransactionIndex;
+
+        std::vector<std::pair<size_t, std::future<bool>>> m_jobs;
+};
+
+}
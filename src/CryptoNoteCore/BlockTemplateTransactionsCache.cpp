@@ -0,0 +1,48 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockTemplateTransactionsCache.h"
+
+#include "crypto/crypto.h"
+
+namespace CryptoNote {
+
+bool BlockTemplateTransactionsCache::select(const ITransactionPool& pool, const Crypto::Hash& topBlockHash, size_t fusionTxMaxSize,
+  size_t medianSize, size_t maxTotalSize, std::vector<Crypto::Hash>& transactionHashes, size_t& transactionsSize, uint64_t& fee) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  bool reused = m_selection && m_selection->topBlockHash == topBlockHash && m_selection->poolVersion == pool.getVersion() &&
+    m_selection->fusionTxMaxSize == fusionTxMaxSize && m_selection->medianSize == medianSize && m_selection->maxTotalSize == maxTotalSize;
+
+  if (!reused) {
+    Selection selection;
+    selection.topBlockHash = topBlockHash;
+    selection.fusionTxMaxSize = fusionTxMaxSize;
+    selection.medianSize = medianSize;
+    selection.maxTotalSize = maxTotalSize;
+    selection.poolVersion = pool.selectBlockTemplateTransactions(fusionTxMaxSize, medianSize, maxTotalSize, selection.transactionHashes,
+      selection.transactionsSize, selection.fee);
+    m_selection = std::move(selection);
+  }
+
+  transactionHashes = m_selection->transactionHashes;
+  transactionsSize = m_selection->transactionsSize;
+  fee = m_selection->fee;
+  return reused;
+}
+
+}
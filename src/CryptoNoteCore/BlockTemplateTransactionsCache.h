@@ -0,0 +1,54 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "crypto/hash.h"
+#include "ITransactionPool.h"
+
+namespace CryptoNote {
+
+// Transactions of the last block template, reused while the tip, the pool and the size limits stay the same
+class BlockTemplateTransactionsCache {
+public:
+  // true if the previous selection was still valid and was returned again
+  bool select(const ITransactionPool& pool, const Crypto::Hash& topBlockHash, size_t fusionTxMaxSize, size_t medianSize,
+    size_t maxTotalSize, std::vector<Crypto::Hash>& transactionHashes, size_t& transactionsSize, uint64_t& fee);
+
+private:
+  struct Selection {
+    Crypto::Hash topBlockHash;
+    uint64_t poolVersion;
+    size_t fusionTxMaxSize;
+    size_t medianSize;
+    size_t maxTotalSize;
+    std::vector<Crypto::Hash> transactionHashes;
+    size_t transactionsSize;
+    uint64_t fee;
+  };
+
+  std::mutex m_mutex;
+  boost::optional<Selection> m_selection;
+};
+
+}
@@ -749,6 +749,11 @@ std::vector<RawBlock> BlockchainCache::getNonEmptyBlocks(const uint32_t startHei
   return blocks;
 }
 
+std::unique_ptr<IBlockchainCache> BlockchainCache::createSnapshot() const {
+  // in-memory segments change in place, copying them isn't worth it
+  return nullptr;
+}
+
 std::vector<RawBlock> BlockchainCache::getBlocksByHeight(const uint32_t startHeight, uint32_t endHeight) const
 {
   if (endHeight < startIndex)
@@ -994,6 +999,30 @@ std::vector<uint32_t> BlockchainCache::getRandomOutsByAmount(Amount amount, size
   return offs;
 }
 
+std::vector<RandomOutputsForAmount> BlockchainCache::getRandomOutsByAmounts(const std::vector<uint64_t>& amounts, size_t count,
+                                                                            uint32_t blockIndex) const {
+  std::vector<RandomOutputsForAmount> result;
+  result.reserve(amounts.size());
+
+  for (auto amount : amounts) {
+    RandomOutputsForAmount outs;
+    outs.amount = amount;
+    outs.globalIndexes = getRandomOutsByAmount(amount, count, blockIndex);
+    if (!outs.globalIndexes.empty()) {
+      std::sort(outs.globalIndexes.begin(), outs.globalIndexes.end());
+      if (extractKeyOutputKeys(amount, blockIndex, {outs.globalIndexes.data(), outs.globalIndexes.size()}, outs.publicKeys) != ExtractOutputKeysResult::SUCCESS) {
+        logger(Logging::DEBUGGING) << "getRandomOutsByAmounts: failed to extract key outputs for amount " << amount;
+        outs.globalIndexes.clear();
+        outs.publicKeys.clear();
+      }
+    }
+
+    result.push_back(std::move(outs));
+  }
+
+  return result;
+}
+
 ExtractOutputKeysResult BlockchainCache::extractKeyOutputKeys(uint64_t amount, uint32_t blockIndex,
                                                               Common::ArrayView<uint32_t> globalIndexes,
                                                               std::vector<Crypto::PublicKey>& publicKeys) const {
@@ -195,6 +195,7 @@ public:
   virtual std::vector<Crypto::Hash> getTransactionHashes() const override;
   virtual std::vector<Crypto::Hash> getTransactionHashes(uint32_t startIndex, uint32_t endIndex) const override;
   virtual std::vector<uint32_t> getRandomOutsByAmount(uint64_t amount, size_t count, uint32_t blockIndex) const override;
+  virtual std::vector<RandomOutputsForAmount> getRandomOutsByAmounts(const std::vector<uint64_t>& amounts, size_t count, uint32_t blockIndex) const override;
   virtual ExtractOutputKeysResult extractKeyOutputs(uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes,
     std::function<ExtractOutputKeysResult(const CachedTransactionInfo& info, PackedOutIndex index,
     uint32_t globalIndex)> pred) const override;
@@ -203,6 +204,7 @@ public:
   virtual std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount) const override;
   virtual std::vector<RawBlock> getBlocksByHeight(const uint32_t startHeight, const uint32_t endHeight) const override;
   virtual std::vector<RawBlock> getNonEmptyBlocks(const uint32_t startHeight, const size_t blockCount) const override;
+  virtual std::unique_ptr<IBlockchainCache> createSnapshot() const override;
 
 private:
 
@@ -169,7 +169,7 @@ BlockchainReadResult BlockchainReadBatch::extractResult() {
   state.multisignatureOutputAmountsCount = {{}, false};
 
   resultSubmitted = false;
-  return BlockchainReadResult(st);
+  return BlockchainReadResult(std::move(st));
 }
 
 std::vector<std::string> BlockchainReadBatch::getRawKeys() const {
@@ -321,7 +321,20 @@ const KeyOutputKeyResult& BlockchainReadResult::getKeyOutputInfo() const {
   return state.keyOutputKeys;
 }
 
+std::unordered_map<uint32_t, RawBlock> BlockchainReadResult::extractRawBlocks() {
+  return std::move(state.rawBlocks);
+}
+
 void BlockchainReadBatch::submitRawResult(const std::vector<std::string>& values, const std::vector<bool>& resultStates) {
+  deserializeRawResult(values, resultStates);
+}
+
+void BlockchainReadBatch::submitRawResult(const std::vector<std::string_view>& values, const std::vector<bool>& resultStates) {
+  deserializeRawResult(values, resultStates);
+}
+
+template <class Values>
+void BlockchainReadBatch::deserializeRawResult(const Values& values, const std::vector<bool>& resultStates) {
   assert(state.size() == values.size());
   assert(values.size() == resultStates.size());
   auto range = boost::combine(values, resultStates);
@@ -119,6 +119,8 @@ public:
   const std::pair<uint64_t, bool>& getTransactionsCount() const;
   const KeyOutputKeyResult& getKeyOutputInfo() const;
 
+  std::unordered_map<uint32_t, RawBlock> extractRawBlocks();
+
 private:
   BlockchainReadState state;
 };
@@ -156,10 +158,14 @@ public:
 
   std::vector<std::string> getRawKeys() const override;
   void submitRawResult(const std::vector<std::string>& values, const std::vector<bool>& resultStates) override;
+  void submitRawResult(const std::vector<std::string_view>& values, const std::vector<bool>& resultStates) override;
 
   BlockchainReadResult extractResult();
 
 private:
+  template <class Values>
+  void deserializeRawResult(const Values& values, const std::vector<bool>& resultStates);
+
   bool resultSubmitted = false;
   BlockchainReadState state;
 };
@@ -60,22 +60,47 @@ const Crypto::Hash& CachedBlock::getBlockHash() const {
 
 const Crypto::Hash& CachedBlock::getBlockLongHash(cn_context& cryptoContext) const {
   if (!blockLongHash.is_initialized()) {
-    if (block.majorVersion == BLOCK_MAJOR_VERSION_1 || block.majorVersion >= BLOCK_MAJOR_VERSION_4) {
-      const auto& rawHashingBlock = getBlockHashingBinaryArray();
-      blockLongHash = Hash();
-      cn_slow_hash(cryptoContext, rawHashingBlock.data(), rawHashingBlock.size(), blockLongHash.get());
-    } else if (block.majorVersion == BLOCK_MAJOR_VERSION_2 || block.majorVersion == BLOCK_MAJOR_VERSION_3) {
-      const auto& rawHashingBlock = getParentBlockHashingBinaryArray(true);
-      blockLongHash = Hash();
-      cn_slow_hash(cryptoContext, rawHashingBlock.data(), rawHashingBlock.size(), blockLongHash.get());
-    } else {
-      throw std::runtime_error("Unknown block major version.");
-    }
+    const auto& rawHashingBlock = getBlockLongHashingBinaryArray();
+    blockLongHash = Hash();
+    cn_slow_hash(cryptoContext, rawHashingBlock.data(), rawHashingBlock.size(), blockLongHash.get());
   }
 
   return blockLongHash.get();
 }
 
+void CachedBlock::getBlockLongHashes(const CachedBlock* const* blocks, size_t count, cn_context& cryptoContext) {
+  std::vector<const CachedBlock*> pending;
+  std::vector<const void*> data;
+  std::vector<size_t> sizes;
+  for (size_t i = 0; i < count; ++i) {
+    if (!blocks[i]->blockLongHash.is_initialized()) {
+      const auto& rawHashingBlock = blocks[i]->getBlockLongHashingBinaryArray();
+      pending.push_back(blocks[i]);
+      data.push_back(rawHashingBlock.data());
+      sizes.push_back(rawHashingBlock.size());
+    }
+  }
+
+  std::vector<Hash*> hashes;
+  hashes.reserve(pending.size());
+  for (const CachedBlock* block : pending) {
+    block->blockLongHash = Hash();
+    hashes.push_back(&block->blockLongHash.get());
+  }
+
+  cn_slow_hash(cryptoContext, data.data(), sizes.data(), hashes.data(), hashes.size());
+}
+
+const BinaryArray& CachedBlock::getBlockLongHashingBinaryArray() const {
+  if (block.majorVersion == BLOCK_MAJOR_VERSION_1 || block.majorVersion >= BLOCK_MAJOR_VERSION_4) {
+    return getBlockHashingBinaryArray();
+  } else if (block.majorVersion == BLOCK_MAJOR_VERSION_2 || block.majorVersion == BLOCK_MAJOR_VERSION_3) {
+    return getParentBlockHashingBinaryArray(true);
+  } else {
+    throw std::runtime_error("Unknown block major version.");
+  }
+}
+
 const Crypto::Hash& CachedBlock::getAuxiliaryBlockHeaderHash() const {
   if (!auxiliaryBlockHeaderHash.is_initialized()) {
     auxiliaryBlockHeaderHash = getObjectHash(getBlockHashingBinaryArray());
@@ -42,7 +42,12 @@ public:
   const BinaryArray& getParentBlockHashingBinaryArray(bool headerOnly) const;
   uint32_t getBlockIndex() const;
 
+  // Computes the long hashes of several blocks at once, interleaving them on CPUs that allow it
+  static void getBlockLongHashes(const CachedBlock* const* blocks, size_t count, Crypto::cn_context& cryptoContext);
+
 private:
+  const BinaryArray& getBlockLongHashingBinaryArray() const;
+
   const BlockTemplate& block;
   mutable boost::optional<BinaryArray> blockHashingBinaryArray;
   mutable boost::optional<BinaryArray> parentBlockBinaryArray;
@@ -0,0 +1,125 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ChainSnapshot.h"
+
+#include <cassert>
+#include <stdexcept>
+
+#include "CryptoNoteBasic.h"
+
+namespace CryptoNote {
+
+ChainSnapshot::ChainSnapshot(std::unique_ptr<IBlockchainCache>&& mainChain) :
+  m_ownedChain(std::move(mainChain)),
+  m_leaf(m_ownedChain.get()) {
+  assert(m_leaf != nullptr);
+}
+
+ChainSnapshot::ChainSnapshot(const IBlockchainCache& mainChainLeaf, std::shared_lock<Common::RecursiveSharedMutex>&& lock) :
+  m_lock(std::move(lock)),
+  m_leaf(&mainChainLeaf) {
+  assert(m_lock.owns_lock());
+}
+
+bool ChainSnapshot::isLocked() const {
+  return m_lock.owns_lock();
+}
+
+uint32_t ChainSnapshot::getTopBlockIndex() const {
+  return m_leaf->getTopBlockIndex();
+}
+
+Crypto::Hash ChainSnapshot::getTopBlockHash() const {
+  return m_leaf->getTopBlockHash();
+}
+
+Crypto::Hash ChainSnapshot::getBlockHashByIndex(uint32_t blockIndex) const {
+  if (blockIndex > getTopBlockIndex()) {
+    return NULL_HASH;
+  }
+
+  return m_leaf->getBlockHash(blockIndex);
+}
+
+std::vector<Crypto::Hash> ChainSnapshot::findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds, size_t maxCount,
+  uint32_t& totalBlockCount, uint32_t& startBlockIndex) const {
+  assert(!remoteBlockIds.empty());
+
+  totalBlockCount = getTopBlockIndex() + 1;
+
+  for (const auto& hash : remoteBlockIds) {
+    const IBlockchainCache* segment = findSegmentContainingBlock(hash);
+    if (segment != nullptr) {
+      startBlockIndex = segment->getBlockIndex(hash);
+      return m_leaf->getBlockHashes(startBlockIndex, maxCount);
+    }
+  }
+
+  throw std::runtime_error("Genesis block hash was not found.");
+}
+
+void ChainSnapshot::getBlocks(const std::vector<Crypto::Hash>& blockHashes, std::vector<RawBlock>& blocks,
+  std::vector<Crypto::Hash>& missedHashes) const {
+  for (const auto& hash : blockHashes) {
+    const IBlockchainCache* segment = findSegmentContainingBlock(hash);
+    if (segment == nullptr) {
+      missedHashes.push_back(hash);
+    } else {
+      blocks.push_back(segment->getBlockByIndex(segment->getBlockIndex(hash)));
+    }
+  }
+}
+
+void ChainSnapshot::getTransactions(const std::vector<Crypto::Hash>& transactionHashes, std::vector<BinaryArray>& transactions,
+  std::vector<Crypto::Hash>& missedHashes) const {
+  std::vector<Crypto::Hash> leftTransactions = transactionHashes;
+
+  const IBlockchainCache* segment = m_leaf;
+  do {
+    std::vector<Crypto::Hash> missedTransactions;
+    segment->getRawTransactions(leftTransactions, transactions, missedTransactions);
+
+    leftTransactions = std::move(missedTransactions);
+    segment = segment->getParent();
+  } while (segment != nullptr && !leftTransactions.empty());
+
+  missedHashes.insert(missedHashes.end(), leftTransactions.begin(), leftTransactions.end());
+}
+
+bool ChainSnapshot::getTransactionGlobalIndexes(const Crypto::Hash& transactionHash, std::vector<uint32_t>& globalIndexes) const {
+  for (const IBlockchainCache* segment = m_leaf; segment != nullptr; segment = segment->getParent()) {
+    if (segment->getTransactionGlobalIndexes(transactionHash, globalIndexes)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+const IBlockchainCache* ChainSnapshot::findSegmentContainingBlock(const Crypto::Hash& blockHash) const {
+  for (const IBlockchainCache* segment = m_leaf; segment != nullptr; segment = segment->getParent()) {
+    if (segment->hasBlock(blockHash)) {
+      return segment;
+    }
+  }
+
+  return nullptr;
+}
+
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+#include "Common/RecursiveSharedMutex.h"
+#include "CryptoNoteCore/IBlockchainCache.h"
+
+namespace CryptoNote {
+
+// Immutable view of the main chain as it was when the snapshot was taken. Long queries running
+// outside the dispatcher thread use it instead of Core and don't hold up block import.
+//
+// Normally it reads a database snapshot of the main chain. While the main chain still ends with
+// in-memory segments (after switching to an alternative chain, until the next save merges them)
+// it holds the shared side of the core lock and reads the live chain instead, so such a snapshot
+// must not be kept on the dispatcher thread.
+class ChainSnapshot {
+public:
+  explicit ChainSnapshot(std::unique_ptr<IBlockchainCache>&& mainChain);
+  ChainSnapshot(const IBlockchainCache& mainChainLeaf, std::shared_lock<Common::RecursiveSharedMutex>&& lock);
+
+  ChainSnapshot(const ChainSnapshot&) = delete;
+  ChainSnapshot& operator=(const ChainSnapshot&) = delete;
+
+  bool isLocked() const;
+
+  uint32_t getTopBlockIndex() const;
+  Crypto::Hash getTopBlockHash() const;
+  Crypto::Hash getBlockHashByIndex(uint32_t blockIndex) const;
+
+  std::vector<Crypto::Hash> findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds, size_t maxCount,
+    uint32_t& totalBlockCount, uint32_t& startBlockIndex) const;
+
+  // blocks and transactions of alternative chains are reported missing
+  void getBlocks(const std::vector<Crypto::Hash>& blockHashes, std::vector<RawBlock>& blocks, std::vector<Crypto::Hash>& missedHashes) const;
+  void getTransactions(const std::vector<Crypto::Hash>& transactionHashes, std::vector<BinaryArray>& transactions,
+    std::vector<Crypto::Hash>& missedHashes) const;
+  bool getTransactionGlobalIndexes(const Crypto::Hash& transactionHash, std::vector<uint32_t>& globalIndexes) const;
+
+private:
+  std::unique_ptr<IBlockchainCache> m_ownedChain;
+  std::shared_lock<Common::RecursiveSharedMutex> m_lock;
+  const IBlockchainCache* m_leaf;
+
+  const IBlockchainCache* findSegmentContainingBlock(const Crypto::Hash& blockHash) const;
+};
+
+}
@@ -34,6 +34,7 @@
 #include "CryptoNoteFormatUtils.h"
 #include "BlockchainCache.h"
 #include "BlockchainStorage.h"
+#include "BlockSignatureBatch.h"
 #include "BlockchainUtils.h"
 #include "CryptoNoteCore/ITimeProvider.h"
 #include "CryptoNoteCore/CoreErrors.h"
@@ -66,33 +67,16 @@ std::vector<T> preallocateVector(size_t elements) {
 }
 UseGenesis addGenesisBlock = UseGenesis(true);
 
-class TransactionSpentInputsChecker {
-public:
-  bool haveSpentInputs(const Transaction& transaction) {
-    for (const auto& input : transaction.inputs) {
-      if (input.type() == typeid(KeyInput)) {
-        auto inserted = alreadSpentKeyImages.insert(boost::get<KeyInput>(input).keyImage);
-        if (!inserted.second) {
-          return true;
-        }
-      } else if (input.type() == typeid(MultisignatureInput)) {
-        const auto& multisignature = boost::get<MultisignatureInput>(input);
-        auto inserted =
-            alreadySpentMultisignatures.insert(std::make_pair(multisignature.amount, multisignature.outputIndex));
-        if (!inserted.second) {
-          return true;
-        }
-      }
-    }
-
-    return false;
-  }
-
-private:
-  std::unordered_set<Crypto::KeyImage> alreadSpentKeyImages;
-  std::set<std::pair<uint64_t, uint64_t>> alreadySpentMultisignatures;
+// "index (hash)" of a block, formatted only when a message mentioning it is logged
+struct BlockDescription {
+  uint32_t index;
+  const Crypto::Hash& hash;
 };
 
+std::ostream& operator<<(std::ostream& os, const BlockDescription& block) {
+  return os << block.index << " (" << block.hash << ")";
+}
+
 inline IBlockchainCache* findIndexInChain(IBlockchainCache* blockSegment, const Crypto::Hash& blockHash) {
   assert(blockSegment != nullptr);
   while (blockSegment != nullptr) {
@@ -570,18 +554,16 @@ double calc_poisson_ln(double lam, uint64_t k)
 std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlock) {
   throwIfNotInitialized();
 
-  std::lock_guard<std::recursive_mutex> lock(m_blockchain_lock);
+  std::unique_lock<Common::RecursiveSharedMutex> lock(m_blockchain_lock);
 
   uint32_t blockIndex = cachedBlock.getBlockIndex();
   Crypto::Hash blockHash = cachedBlock.getBlockHash();
-  std::ostringstream os;
-  os << blockIndex << " (" << blockHash << ")";
-  std::string blockStr = os.str();
+  BlockDescription blockDescription{blockIndex, blockHash};
 
-  logger(Logging::DEBUGGING) << "Request came to add block " << blockStr;
+  logger(Logging::DEBUGGING) << "Request came to add block " << blockDescription;
 
   if (hasBlock(blockHash)) {
-    logger(Logging::DEBUGGING) << "Block " << blockStr << " already exists";
+    logger(Logging::DEBUGGING) << "Block " << blockDescription << " already exists";
     return error::AddBlockErrorCode::ALREADY_EXISTS;
   }
 
@@ -592,14 +574,14 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
 
   auto cache = findSegmentContainingBlock(previousBlockHash);
   if (cache == nullptr) {
-    logger(Logging::WARNING) << "Block " << blockStr << " rejected as orphaned";
+    logger(Logging::WARNING) << "Block " << blockDescription << " rejected as orphaned";
     return error::AddBlockErrorCode::REJECTED_AS_ORPHANED;
   }
 
   std::vector<CachedTransaction> transactions;
   uint64_t cumulativeSize = 0;
   if (!extractTransactions(rawBlock.transactions, transactions, cumulativeSize)) {
-    logger(Logging::WARNING) << "Couldn't deserialize raw block transactions in block " << blockStr;
+    logger(Logging::WARNING) << "Couldn't deserialize raw block transactions in block " << blockDescription;
     return error::AddBlockErrorCode::DESERIALIZATION_FAILED;
   }
 
@@ -615,20 +597,20 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
 
   auto maxBlockCumulativeSize = currency.maxBlockCumulativeSize(previousBlockIndex + 1);
   if (cumulativeBlockSize > maxBlockCumulativeSize) {
-    logger(Logging::WARNING) << "Block " << blockStr << " has too big cumulative size";
+    logger(Logging::WARNING) << "Block " << blockDescription << " has too big cumulative size";
     return error::BlockValidationError::CUMULATIVE_BLOCK_SIZE_TOO_BIG;
   }
 
   uint64_t minerReward = 0;
   auto blockValidationResult = validateBlock(cachedBlock, cache, minerReward);
   if (blockValidationResult) {
-    logger(Logging::WARNING) << "Failed to validate block " << blockStr << ": " << blockValidationResult.message();
+    logger(Logging::WARNING) << "Failed to validate block " << blockDescription << ": " << blockValidationResult.message();
     return blockValidationResult;
   }
 
   auto currentDifficulty = cache->getDifficultyForNextBlock(previousBlockIndex);
   if (currentDifficulty == 0) {
-    logger(Logging::WARNING) << "Block " << blockStr << " has difficulty overhead";
+    logger(Logging::WARNING) << "Block " << blockDescription << " has difficulty overhead";
     return error::BlockValidationError::DIFFICULTY_OVERHEAD;
   }
 
@@ -636,6 +618,30 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
 
   std::unordered_set<Crypto::Hash> txBlobsHashes;
 
+  auto rejectTransaction = [this](const CachedTransaction& transaction, const std::error_code& error) {
+    const auto hash = transaction.getTransactionHash();
+    logger(Logging::WARNING) << "Failed to validate transaction " << hash << ": " << error.message();
+
+    if (transactionPool->checkIfTransactionPresent(hash))
+    {
+      logger(Logging::DEBUGGING) << "Invalid transaction " << hash << " is present in the pool, removing";
+      transactionPool->removeTransaction(hash);
+      notifyObservers(makeDelTransactionMessage({ hash }, Messages::DeleteTransaction::Reason::NotActual));
+    }
+  };
+
+  // Cheap checks (double spends within the block, mixin, fee etc.) run in order here,
+  // while the key image lookups and ring signature checks of all transactions are
+  // queued into one batch. The batch is declared after the validators, so it is
+  // destroyed (and its jobs are cancelled and joined) first on every return path.
+  std::vector<std::unique_ptr<TransactionValidator>> transactionValidators;
+  transactionValidators.reserve(transactions.size());
+  BlockSignatureBatch signatureBatch(m_transactionValidationThreadPool);
+
+  // Skip expensive fee validation (due to a dynamic minimal fee calculation)
+  // for transactions in a checkpoints range - they are assumed valid.
+  const uint64_t minFee = checkpoints.isInCheckpointZone(blockIndex) ? 0 : getMinimalFee(blockIndex);
+
   for (size_t i = 0; i < transactions.size(); ++i) {
     // check if tx hashes in txs blob and header match
     Crypto::Hash transactionHash = transactions[i].getTransactionHash();
@@ -653,26 +659,24 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
       return error::BlockValidationError::DUPLICATE_TRANSACTION;
     }
 
-    uint64_t fee = 0;
-    // Skip expensive fee validation (due to a dynamic minimal fee calculation)
-    // for transactions in a checkpoints range - they are assumed valid.
-    const uint64_t minFee = checkpoints.isInCheckpointZone(blockIndex) ? 0 : getMinimalFee(blockIndex);
-    auto transactionValidationResult = validateTransaction(transactions[i], validatorState, cache, m_transactionValidationThreadPool, fee, minFee, previousBlockIndex, false);
-    if (transactionValidationResult) {
-      const auto hash = transactions[i].getTransactionHash();
-      logger(Logging::WARNING) << "Failed to validate transaction " << hash << ": " << transactionValidationResult.message();
+    transactionValidators.emplace_back(new TransactionValidator(transactions[i], validatorState, cache, currency, checkpoints,
+      m_transactionValidationThreadPool, previousBlockIndex, blockMedianSize, minFee, false, &signatureBatch, i));
 
-      if (transactionPool->checkIfTransactionPresent(hash))
-      {
-        logger(Logging::DEBUGGING) << "Invalid transaction " << hash << " is present in the pool, removing";
-        transactionPool->removeTransaction(hash);
-        notifyObservers(makeDelTransactionMessage({ hash }, Messages::DeleteTransaction::Reason::NotActual));
-      }
-
-      return transactionValidationResult;
+    const auto transactionValidationResult = transactionValidators.back()->validate();
+    if (transactionValidationResult.errorCode) {
+      signatureBatch.cancel();
+      rejectTransaction(transactions[i], transactionValidationResult.errorCode);
+      return transactionValidationResult.errorCode;
     }
 
-    cumulativeFee += fee;
+    cumulativeFee += transactionValidationResult.fee;
+  }
+
+  size_t failedTransactionIndex = 0;
+  if (!signatureBatch.wait(failedTransactionIndex)) {
+    const auto& errorCode = transactionValidators[failedTransactionIndex]->getValidationResult().errorCode;
+    rejectTransaction(transactions[failedTransactionIndex], errorCode);
+    return errorCode;
   }
 
   uint64_t reward = 0;
@@ -827,7 +831,7 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
 
             updateBlockMedianSize();
             //actualizePoolTransactions();
-            checkAndRemoveInvalidPoolTransactions(validatorState);
+            checkAndRemoveInvalidPoolTransactions(getPoolOutputsSpentInMainChain());
 
             copyTransactionsToPool(chainsLeaves[endpointIndex]);
 
@@ -896,11 +900,12 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
   }
 
   logger(Logging::DEBUGGING) << "Block: " << blockHash << " successfully added";
+  publishChainSnapshot();
   notifyOnSuccess(ret, previousBlockIndex, cachedBlock, *cache);
 
   return ret;
 }
-/* Take the current block spent key images and run them
+/* Take the spent key images of the blocks added to the main chain and run them
    against the pool to remove any transactions that may
    be in the pool that would now be considered invalid.
    This method is a light version of transaction validation that is used
@@ -908,60 +913,65 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
    by the addition of a block to the blockchain. As the transactions are already
    in the pool, there are only a subset of normal transaction validation
    tests that need to be completed to determine if the transaction can
-   stay in the pool at this time. */
-void Core::checkAndRemoveInvalidPoolTransactions(const TransactionValidatorState blockTransactionsState) {
+   stay in the pool at this time. Each test is a lookup in one of the pool
+   indexes, so only the failing transactions are visited. */
+void Core::checkAndRemoveInvalidPoolTransactions(const TransactionValidatorState& blockTransactionsState) {
   auto &pool = *transactionPool;
 
-  const auto poolHashes = pool.getTransactionHashes();
+  std::unordered_set<Crypto::Hash> invalidTransactions;
+  auto addInvalidTransactions = [&invalidTransactions](const std::vector<Crypto::Hash>& hashes) {
+    invalidTransactions.insert(hashes.begin(), hashes.end());
+  };
 
-  const auto maxTransactionSize = getMaximumTransactionAllowedSize(blockMedianSize, currency);
+  /* If the the transaction contains outputs that were spent in the new blocks, fail.
+     This also catches the pool transactions included in the blocks, as they spend
+     the same key images. */
+  addInvalidTransactions(pool.getTransactionHashesSpendingOutputs(blockTransactionsState));
 
-  for (const auto poolTxHash : poolHashes) {
-    const auto poolTx = pool.tryGetTransaction(poolTxHash);
+  /* If the transaction exceeds the maximum size of a transaction, fail */
+  addInvalidTransactions(pool.getTransactionHashesBiggerThan(getMaximumTransactionAllowedSize(blockMedianSize, currency)));
 
-    /* Tx got removed by another thread */
-    if (!poolTx) {
-      continue;
-    }
+  /* If the transaction does not have the right number of mixins, fail */
+  if (getTopBlockIndex() > CryptoNote::parameters::UPGRADE_HEIGHT_V3_1) {
+    addInvalidTransactions(pool.getTransactionHashesByMixin(static_cast<uint64_t>(currency.maxMixin()) + 1, std::numeric_limits<uint64_t>::max()));
+  }
 
-    const auto poolTxState = extractSpentOutputs(*poolTx);
+  if (getTopBlockIndex() > currency.upgradeHeightV4() && currency.minMixin() > 0) {
+    /* mixin 1 stays allowed below the minimum */
+    addInvalidTransactions(pool.getTransactionHashesByMixin(0, 0));
+    addInvalidTransactions(pool.getTransactionHashesByMixin(2, currency.minMixin() - 1));
+  }
 
-    uint64_t mixin;
-    const auto tx = poolTx.get().getTransaction();
-    bool mixinSuccess = Core::getMixin(tx, mixin);
-    if (mixinSuccess) {
-      if ((getTopBlockIndex() > CryptoNote::parameters::UPGRADE_HEIGHT_V3_1 && mixin > currency.maxMixin()) ||
-        (getTopBlockIndex() > currency.upgradeHeightV4() && mixin < currency.minMixin() && mixin != 1)) {
-        mixinSuccess = false;
-      }
+  /* If the transaction is no longer valid, remove it from the pool
+     and tell everyone else that they should also remove it from the pool */
+  for (const auto& poolTxHash : invalidTransactions) {
+    if (pool.removeTransaction(poolTxHash)) {
+      notifyObservers(makeDelTransactionMessage({ poolTxHash }, Messages::DeleteTransaction::Reason::NotActual));
     }
+  }
+}
 
-    bool isValid = true;
+/* After a reorg any block of the new main chain above the split point may spend
+   outputs the pool spends too, not only the top one. The pool transactions included
+   in those blocks spend them as well. */
+TransactionValidatorState Core::getPoolOutputsSpentInMainChain() const {
+  const auto& poolState = transactionPool->getPoolTransactionValidationState();
+  const IBlockchainCache* mainChain = chainsLeaves[0];
 
-    /* If the transaction is in the chain but somehow was not previously removed, fail */
-    if (isTransactionInChain(poolTxHash)) {
-      isValid = false;
-    }
-    /* If the transaction does not have the right number of mixins, fail */
-    else if (!mixinSuccess) {
-      isValid = false;
-    }
-    /* If the transaction exceeds the maximum size of a transaction, fail */
-    else if (poolTx->getTransactionBinaryArray().size() > maxTransactionSize) {
-      isValid = false;
-    }
-    /* If the the transaction contains outputs that were spent in the new block, fail */
-    else if (hasIntersections(blockTransactionsState, poolTxState)) {
-      isValid = false;
+  TransactionValidatorState spentState;
+  for (const auto& keyImage : poolState.spentKeyImages) {
+    if (mainChain->checkIfSpent(keyImage)) {
+      spentState.spentKeyImages.insert(keyImage);
     }
+  }
 
-    /* If the transaction is no longer valid, remove it from the pool
-       and tell everyone else that they should also remove it from the pool */
-    if (!isValid) {
-      pool.removeTransaction(poolTxHash);
-      notifyObservers(makeDelTransactionMessage({ poolTxHash }, Messages::DeleteTransaction::Reason::NotActual));
+  for (const auto& output : poolState.spentMultisignatureGlobalIndexes) {
+    if (mainChain->checkIfSpentMultisignature(output.first, output.second)) {
+      spentState.spentMultisignatureGlobalIndexes.insert(output);
     }
   }
+
+  return spentState;
 }
 
 /* This quickly finds out if a transaction is in the blockchain somewhere */
@@ -1101,7 +1111,7 @@ std::error_code Core::submitBlock(BinaryArray&& rawBlockTemplate) {
 
   rawBlock.transactions.reserve(blockTemplate.transactionHashes.size());
 
-  std::lock_guard<std::recursive_mutex> lock(m_blockchain_lock);
+  std::unique_lock<Common::RecursiveSharedMutex> lock(m_blockchain_lock);
 
   for (const auto& transactionHash : blockTemplate.transactionHashes) {
     if (!transactionPool->checkIfTransactionPresent(transactionHash)) {
@@ -1145,6 +1155,21 @@ bool Core::getTransactionGlobalIndexes(const Crypto::Hash& transactionHash,
 
 bool Core::getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_t>& globalIndexes,
                             std::vector<Crypto::PublicKey>& publicKeys) const {
+  std::vector<RandomOutputsForAmount> outs;
+  if (!getRandomOutputs(std::vector<uint64_t>{amount}, count, outs)) {
+    return false;
+  }
+
+  if (!outs.empty()) {
+    globalIndexes = std::move(outs.front().globalIndexes);
+    publicKeys = std::move(outs.front().publicKeys);
+  }
+
+  return true;
+}
+
+bool Core::getRandomOutputs(const std::vector<uint64_t>& amounts, uint16_t count,
+                            std::vector<RandomOutputsForAmount>& outs) const {
   throwIfNotInitialized();
 
   if (count == 0) {
@@ -1157,26 +1182,18 @@ bool Core::getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_
     return false;
   }
 
-  globalIndexes = chainsLeaves[0]->getRandomOutsByAmount(amount, count, getTopBlockIndex());
-  if (globalIndexes.empty()) {
-    return false;
-  }
-
-  std::sort(globalIndexes.begin(), globalIndexes.end());
-
-  switch (chainsLeaves[0]->extractKeyOutputKeys(amount, getTopBlockIndex(), {globalIndexes.data(), globalIndexes.size()},
-                                                publicKeys)) {
-    case ExtractOutputKeysResult::SUCCESS:
-      return true;
-    case ExtractOutputKeysResult::INVALID_GLOBAL_INDEX:
-      logger(Logging::DEBUGGING) << "Invalid global index is given";
-      return false;
-    case ExtractOutputKeysResult::OUTPUT_LOCKED:
-      logger(Logging::DEBUGGING) << "Output is locked";
+  // all amounts are picked together so the database is visited once per round, not once per amount
+  outs = chainsLeaves[0]->getRandomOutsByAmounts(amounts, count, getTopBlockIndex());
+  for (const auto& outsForAmount : outs) {
+    if (outsForAmount.globalIndexes.empty()) {
+      logger(Logging::DEBUGGING) << "No unlocked outputs for amount " << outsForAmount.amount;
       return false;
+    }
+
+    assert(outsForAmount.globalIndexes.size() == outsForAmount.publicKeys.size());
   }
 
-  return false;
+  return true;
 }
 
 bool Core::addTransactionToPool(const BinaryArray& transactionBinaryArray) {
@@ -1191,6 +1208,8 @@ bool Core::addTransactionToPool(const BinaryArray& transactionBinaryArray) {
   CachedTransaction cachedTransaction(std::move(transaction));
   auto transactionHash = cachedTransaction.getTransactionHash();
 
+  std::unique_lock<Common::RecursiveSharedMutex> lock(m_blockchain_lock);
+
   if (!addTransactionToPool(std::move(cachedTransaction))) {
     return false;
   }
@@ -1588,16 +1607,7 @@ std::error_code Core::validateTransaction(const CachedTransaction& cachedTransac
 }
 
 bool Core::getMixin(const Transaction& transaction, uint64_t& mixin) {
-  mixin = 0;
-  for (const TransactionInput& txin : transaction.inputs) {
-    if (txin.type() != typeid(KeyInput)) {
-      continue;
-    }
-    uint64_t currentMixin = boost::get<KeyInput>(txin).outputIndexes.size();
-    if (currentMixin > mixin) {
-      mixin = currentMixin;
-    }
-  }
+  mixin = getTransactionMixin(transaction);
   return true;
 }
 
@@ -1734,9 +1744,12 @@ const Currency& Core::getCurrency() const {
 void Core::save() {
   throwIfNotInitialized();
 
+  std::unique_lock<Common::RecursiveSharedMutex> lock(m_blockchain_lock);
+
   deleteAlternativeChains();
   mergeMainChainSegments();
   chainsLeaves[0]->save();
+  publishChainSnapshot();
 }
 
 void Core::load(const MinerConfig& minerConfig) {
@@ -1763,9 +1776,12 @@ void Core::initRootSegment() {
   updateBlockMedianSize();
 
   chainsLeaves[0]->load();
+  publishChainSnapshot();
 }
 
 void Core::rewind(const uint32_t blockIndex) {
+  std::unique_lock<Common::RecursiveSharedMutex> lock(m_blockchain_lock);
+
   IBlockchainCache *mainChain = chainsLeaves[0];
 
   if (mainChain->getTopBlockIndex() < blockIndex)
@@ -1775,6 +1791,7 @@ void Core::rewind(const uint32_t blockIndex) {
   }
 
   mainChain->rewind(blockIndex);
+  publishChainSnapshot();
 
   logger(Logging::INFO) << "Blockchain rewound to: " << blockIndex << std::endl;
 }
@@ -2028,46 +2045,16 @@ size_t Core::calculateCumulativeBlocksizeLimit(uint32_t height) const {
 
 void Core::fillBlockTemplate(BlockTemplate& block, size_t medianSize, size_t maxCumulativeSize,
                              size_t& transactionsSize, uint64_t& fee) const {
-  transactionsSize = 0;
-  fee = 0;
-
   size_t maxTotalSize = (125 * medianSize) / 100;
   maxTotalSize = std::min(maxTotalSize, maxCumulativeSize) - currency.minerTxBlobReservedSize();
 
-  TransactionSpentInputsChecker spentInputsChecker;
-
-  std::vector<CachedTransaction> poolTransactions = transactionPool->getPoolTransactions();
-  for (auto it = poolTransactions.rbegin(); it != poolTransactions.rend() && it->getTransactionFee() == 0; ++it) {
-    const CachedTransaction& transaction = *it;
-
-    auto transactionBlobSize = transaction.getTransactionBinaryArray().size();
-    if (currency.fusionTxMaxSize() < transactionsSize + transactionBlobSize) {
-      continue;
-    }
-
-    if (!spentInputsChecker.haveSpentInputs(transaction.getTransaction())) {
-      block.transactionHashes.emplace_back(transaction.getTransactionHash());
-      transactionsSize += transactionBlobSize;
-      logger(Logging::TRACE) << "Fusion transaction " << transaction.getTransactionHash() << " included to block template";
-    }
+  std::vector<Crypto::Hash> transactionHashes;
+  if (!m_blockTemplateTransactions.select(*transactionPool, getTopBlockHash(), currency.fusionTxMaxSize(), medianSize, maxTotalSize,
+      transactionHashes, transactionsSize, fee)) {
+    logger(Logging::TRACE) << transactionHashes.size() << " transactions included to block template";
   }
 
-  for (const auto& cachedTransaction : poolTransactions) {
-    size_t blockSizeLimit = (cachedTransaction.getTransactionFee() == 0) ? medianSize : maxTotalSize;
-
-    if (blockSizeLimit < transactionsSize + cachedTransaction.getTransactionBinaryArray().size()) {
-      continue;
-    }
-
-    if (!spentInputsChecker.haveSpentInputs(cachedTransaction.getTransaction())) {
-      transactionsSize += cachedTransaction.getTransactionBinaryArray().size();
-      fee += cachedTransaction.getTransactionFee();
-      block.transactionHashes.emplace_back(cachedTransaction.getTransactionHash());
-      logger(Logging::TRACE) << "Transaction " << cachedTransaction.getTransactionHash() << " included to block template";
-    } else {
-      logger(Logging::TRACE) << "Transaction " << cachedTransaction.getTransactionHash() << " is failed to include to block template";
-    }
-  }
+  block.transactionHashes.insert(block.transactionHashes.end(), transactionHashes.begin(), transactionHashes.end());
 }
 
 void Core::deleteAlternativeChains() {
@@ -2719,7 +2706,12 @@ void Core::transactionPoolCleaningProcedure() {
     for (;;) {
       timer.sleep(OUTDATED_TRANSACTION_POLLING_INTERVAL);
 
-      auto deletedTransactions = transactionPool->clean();
+      std::vector<Crypto::Hash> deletedTransactions;
+      {
+        std::unique_lock<Common::RecursiveSharedMutex> lock(m_blockchain_lock);
+        deletedTransactions = transactionPool->clean();
+      }
+
       notifyObservers(makeDelTransactionMessage(std::move(deletedTransactions), Messages::DeleteTransaction::Reason::Outdated));
     }
   } catch (System::InterruptedException&) {
@@ -2762,4 +2754,38 @@ std::time_t Core::getStartTime() const {
   return start_time;
 }
 
+std::shared_lock<Common::RecursiveSharedMutex> Core::lockForReading() const {
+  return std::shared_lock<Common::RecursiveSharedMutex>(m_blockchain_lock);
+}
+
+std::shared_ptr<const ChainSnapshot> Core::getChainSnapshot() const {
+  auto snapshot = std::atomic_load(&m_chainSnapshot);
+  if (snapshot) {
+    return snapshot;
+  }
+
+  // the main chain has in-memory segments, read it live until they are merged
+  auto lock = lockForReading();
+  snapshot = std::atomic_load(&m_chainSnapshot);
+  if (snapshot) {
+    return snapshot;
+  }
+
+  return std::make_shared<const ChainSnapshot>(*chainsLeaves[0], std::move(lock));
+}
+
+void Core::publishChainSnapshot() {
+  std::unique_ptr<IBlockchainCache> mainChain;
+  if (chainsLeaves[0]->getParent() == nullptr) {
+    mainChain = chainsLeaves[0]->createSnapshot();
+  }
+
+  std::shared_ptr<const ChainSnapshot> snapshot;
+  if (mainChain) {
+    snapshot = std::make_shared<const ChainSnapshot>(std::move(mainChain));
+  }
+
+  std::atomic_store(&m_chainSnapshot, snapshot);
+}
+
 }
@@ -20,10 +20,13 @@
 #pragma once
 #include <ctime>
 #include <mutex>
+#include <shared_mutex>
 #include <vector>
 #include <unordered_map>
 #include "BlockchainCache.h"
 #include "BlockchainMessages.h"
+#include "BlockTemplateTransactionsCache.h"
+#include "ChainSnapshot.h"
 #include "CachedBlock.h"
 #include "CachedTransaction.h"
 #include "Currency.h"
@@ -39,6 +42,7 @@
 #include "MessageQueue.h"
 #include "TransactionValidatorState.h"
 #include "SwappedVector.h"
+#include "Common/RecursiveSharedMutex.h"
 #include "Common/ThreadPool.h"
 #include "CryptoNoteCore/IMinerHandler.h"
 #include "CryptoNoteCore/MinerConfig.h"
@@ -96,6 +100,7 @@ public:
 
   virtual bool getTransactionGlobalIndexes(const Crypto::Hash& transactionHash, std::vector<uint32_t>& globalIndexes) const override;
   virtual bool getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_t>& globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const override;
+  virtual bool getRandomOutputs(const std::vector<uint64_t>& amounts, uint16_t count, std::vector<RandomOutputsForAmount>& outs) const override;
 
   virtual bool addTransactionToPool(const BinaryArray& transactionBinaryArray) override;
 
@@ -166,6 +171,13 @@ public:
   bool isKeyImageSpent(const Crypto::KeyImage& key_im);
   bool isKeyImageSpent(const Crypto::KeyImage& key_im, uint32_t blockIndex);
 
+  // Everything that changes the chain or the pool holds the blockchain lock exclusively. Queries
+  // issued from threads other than the dispatcher's (RPC workers) must hold this for their duration.
+  std::shared_lock<Common::RecursiveSharedMutex> lockForReading() const;
+
+  // Main chain as of the last completed write. Don't call it while holding lockForReading().
+  std::shared_ptr<const ChainSnapshot> getChainSnapshot() const;
+
 private:
   const Currency& currency;
   System::Dispatcher& dispatcher;
@@ -244,7 +256,8 @@ private:
   
   void actualizePoolTransactions();
   void actualizePoolTransactionsLite(const TransactionValidatorState& validatorState); //Checks pool txs only for double spend.
-  void checkAndRemoveInvalidPoolTransactions(const TransactionValidatorState blockTransactionsState);
+  void checkAndRemoveInvalidPoolTransactions(const TransactionValidatorState& blockTransactionsState);
+  TransactionValidatorState getPoolOutputsSpentInMainChain() const;
 
   bool isTransactionInChain(const Crypto::Hash &txnHash);
 
@@ -255,8 +268,13 @@ private:
 
   void initRootSegment();
   void cutSegment(IBlockchainCache& segment, uint32_t startIndex);
+  void publishChainSnapshot();
+
+  mutable Common::RecursiveSharedMutex m_blockchain_lock;
+  // replaced under the exclusive lock, read with atomic_load
+  std::shared_ptr<const ChainSnapshot> m_chainSnapshot;
 
-  std::recursive_mutex m_blockchain_lock;
+  mutable BlockTemplateTransactionsCache m_blockTemplateTransactions;
 };
 
 }
@@ -51,7 +51,8 @@ namespace CryptoNote {
 
 template <class T>
 std::ostream &print256(std::ostream &o, const T &v) {
-  return o << Common::podToHex(v);
+  // don't format for a message which isn't going to be logged
+  return o ? o << Common::podToHex(v) : o;
 }
 
 bool parse_hash256(const std::string& str_hash, Crypto::Hash& hash);
@@ -18,6 +18,7 @@
 
 #include "CryptoNoteFormatUtils.h"
 
+#include <algorithm>
 #include <set>
 #include "Logging/LoggerRef.h"
 #include "Common/Varint.h"
@@ -309,6 +310,17 @@ bool getInputsMoneyAmount(const Transaction& tx, uint64_t& money) {
   return true;
 }
 
+uint64_t getTransactionMixin(const TransactionPrefix& tx) {
+  uint64_t mixin = 0;
+  for (const auto& in : tx.inputs) {
+    if (in.type() == typeid(KeyInput)) {
+      mixin = std::max<uint64_t>(mixin, boost::get<KeyInput>(in).outputIndexes.size());
+    }
+  }
+
+  return mixin;
+}
+
 bool checkInputTypesSupported(const TransactionPrefix& tx) {
   for (const auto& in : tx.inputs) {
     if (in.type() != typeid(KeyInput) && in.type() != typeid(MultisignatureInput)) {
@@ -76,6 +76,7 @@ bool lookup_acc_outs(const AccountKeys& acc, const Transaction& tx, std::vector<
 bool get_tx_fee(const Transaction& tx, uint64_t & fee);
 bool generate_key_image_helper(const AccountKeys& ack, const Crypto::PublicKey& tx_public_key, size_t real_output_index, KeyPair& in_ephemeral, Crypto::KeyImage& ki);
 bool getInputsMoneyAmount(const Transaction& tx, uint64_t& money);
+uint64_t getTransactionMixin(const TransactionPrefix& tx);
 bool checkInputTypesSupported(const TransactionPrefix& tx);
 bool checkOutsValid(const TransactionPrefix& tx, std::string* error = nullptr);
 bool checkMultisignatureInputsDiff(const TransactionPrefix& tx);
@@ -18,6 +18,10 @@
 
 #include "DBUtils.h"
 
+#include <cstring>
+
+#include "Serialization/KVBinaryCommon.h"
+
 namespace {
   const std::string RAW_BLOCK_NAME = "raw_block";
   const std::string RAW_TXS_NAME = "raw_txs";
@@ -36,12 +40,33 @@ namespace DB {
     return ss.str();
   }
 
-  void deserialize(const std::string& serialized, RawBlock& value, const std::string& name) {
-    std::stringstream ss(serialized);
-    Common::StdInputStream stream(ss);
+  void deserialize(std::string_view serialized, RawBlock& value, const std::string& name) {
+    Common::MemoryInputStream stream(serialized.data(), serialized.size());
     CryptoNote::BinaryInputStreamSerializer serializer(stream);
     serializer(value.block, RAW_BLOCK_NAME);
     serializer(value.transactions, RAW_TXS_NAME);
   }
+
+  std::string getKeyPrefix(const std::string& rawKey) {
+    // KV binary header, root entries count and the length of the root entry name,
+    // which serializeKey sets to the prefix
+    const size_t prefixOffset = sizeof(KVBinaryStorageBlockHeader) + 2;
+    if (rawKey.size() < prefixOffset) {
+      return std::string();
+    }
+
+    KVBinaryStorageBlockHeader header;
+    std::memcpy(&header, rawKey.data(), sizeof(header));
+    if (header.m_signature_a != PORTABLE_STORAGE_SIGNATUREA || header.m_signature_b != PORTABLE_STORAGE_SIGNATUREB) {
+      return std::string();
+    }
+
+    size_t prefixSize = static_cast<uint8_t>(rawKey[prefixOffset - 1]);
+    if (rawKey.size() < prefixOffset + prefixSize) {
+      return std::string();
+    }
+
+    return rawKey.substr(prefixOffset, prefixSize);
+  }
 }
 }
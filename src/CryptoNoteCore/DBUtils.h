@@ -19,6 +19,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <sstream>
 
 #include "Common/StdOutputStream.h"
@@ -26,8 +27,9 @@
 #include "Serialization/SerializationOverloads.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "Common/MemoryInputStream.h"
 #include "Common/StdInputStream.h"
-#include "Serialization/KVBinaryInputStreamSerializer.h"
+#include "Serialization/KVBinaryStreamingInputSerializer.h"
 
 namespace CryptoNote {
 namespace DB {
@@ -92,14 +94,15 @@ namespace DB {
   }
 
   template <class Value>
-  void deserialize(const std::string& serialized, Value& value, const std::string& name) {
-    std::stringstream ss(serialized);
-    Common::StdInputStream stream(ss);
-    CryptoNote::KVBinaryInputStreamSerializer serializer(stream);
+  void deserialize(std::string_view serialized, Value& value, const std::string& name) {
+    CryptoNote::KVBinaryStreamingInputSerializer serializer(serialized.data(), serialized.size());
     serializer(value, name);
   }
 
-  void deserialize(const std::string& serialized, RawBlock& value, const std::string& name);
+  void deserialize(std::string_view serialized, RawBlock& value, const std::string& name);
+
+  // returns the record prefix of a key made by serializeKey, empty string for any other key
+  std::string getKeyPrefix(const std::string& rawKey);
 
   template <class Key, class Value>
   void serializeKeys(std::vector<std::string>& rawKeys, const std::string keyPrefix, const std::unordered_map<Key, Value>& map) {
@@ -22,10 +22,15 @@
 
 #include <ctime>
 #include <cstdlib>
+#include <fstream>
 
+#include <boost/filesystem.hpp>
 #include <boost/iterator/iterator_facade.hpp>
 
+#include <Common/ScopeExit.h>
 #include <Common/ShuffleGenerator.h>
+#include <Common/StdInputStream.h>
+#include <Common/StdOutputStream.h>
 
 #include "BlockchainUtils.h"
 
@@ -35,6 +40,8 @@
 #include <CryptoNoteCore/CryptoNoteTools.h>
 #include <CryptoNoteCore/CryptoNoteBasicImpl.h>
 #include "CryptoNoteCore/TransactionExtra.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
 
 namespace CryptoNote {
 
@@ -458,7 +465,9 @@ private:
   uint32_t schemeVersion;
 };
 
-const uint32_t CURRENT_DB_SCHEME_VERSION = 2;
+const uint32_t CURRENT_DB_SCHEME_VERSION = 3;
+// the oldest scheme which can be upgraded in place instead of being rebuilt from blocks.bin
+const uint32_t MIGRATABLE_DB_SCHEME_VERSION = 2;
 
 }
 
@@ -468,8 +477,10 @@ struct DatabaseBlockchainCache::ExtendedPushedBlockInfo {
 };
 
 
-DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase& dataBase, IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& _logger)
-    : currency(curr), database(dataBase), blockchainCacheFactory(blockchainCacheFactory), logger(_logger, "DatabaseBlockchainCache") {
+DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase& dataBase, IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& _logger,
+                                                 const std::string& cacheDirectory)
+    : currency(curr), database(dataBase), blockchainCacheFactory(blockchainCacheFactory), logger(_logger, "DatabaseBlockchainCache"),
+      keyImageLookups(0), keyImageLookupsFiltered(0), keyImageFalsePositives(0) {
   DatabaseVersionReadBatch readBatch;
   auto ec = database.read(readBatch);
   if (ec) {
@@ -493,6 +504,181 @@ DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase
     logger(Logging::DEBUGGING) << "top block index is null, add genesis block";
     addGenesisBlock(CachedBlock (currency.genesisBlock()));
   }
+
+  if (!cacheDirectory.empty()) {
+    openBlockIndexCache(cacheDirectory + "/" + parameters::BLOCK_INDEXES_CACHE_FILENAME);
+    openSpentKeyImageFilter(cacheDirectory + "/" + parameters::SPENT_KEY_IMAGES_FILTER_FILENAME);
+  }
+}
+
+void DatabaseBlockchainCache::openBlockIndexCache(const std::string& path) {
+  std::unique_ptr<BlockIndexCache> cache;
+  try {
+    cache.reset(new BlockIndexCache(path));
+
+    // the difficulty windows read these entries, so a cache left behind by a crash isn't trusted at all
+    if (!cache->wasClosedCleanly() && cache->getBlockCount() > 0) {
+      logger(Logging::INFO) << "Block index cache wasn't closed cleanly or is damaged, rebuilding it";
+      cache->cut(0);
+    }
+
+    // blocks written to the cache but not to the database
+    uint32_t blockCount = getTopBlockIndex() + 1;
+    cache->cut(blockCount);
+
+    // a different tail means the database was replaced or rolled back without the cache
+    uint32_t cachedCount = cache->getBlockCount();
+    if (cachedCount > 0 && (*cache)[cachedCount - 1].blockHash != readCachedBlockInfos(cachedCount - 1, 1).front().blockHash) {
+      logger(Logging::INFO) << "Block index cache doesn't match the database, rebuilding it";
+      cache->cut(0);
+      cachedCount = 0;
+    }
+
+    if (blockCount - cachedCount > 1000) {
+      logger(Logging::INFO) << "Filling block index cache with " << blockCount - cachedCount << " blocks, this may take a while...";
+    }
+
+    cache->reserve(blockCount);
+    const uint32_t step = 1000;
+    while (cachedCount < blockCount) {
+      for (const auto& blockInfo : readCachedBlockInfos(cachedCount, std::min(step, blockCount - cachedCount))) {
+        cache->push(blockInfo);
+      }
+
+      cachedCount = cache->getBlockCount();
+    }
+
+    cache->flush();
+  } catch (std::exception& e) {
+    logger(Logging::WARNING) << "Failed to open block index cache " << path << ": " << e.what() << ", block indexes will be read from the database";
+    return;
+  }
+
+  blockIndexCache = std::move(cache);
+}
+
+void DatabaseBlockchainCache::openSpentKeyImageFilter(const std::string& path) {
+  std::unique_ptr<SpentKeyImageFilter> filter(new SpentKeyImageFilter());
+  spentKeyImageFilterPath = path;
+
+  try {
+    std::ifstream file(path, std::ios::binary);
+    if (file) {
+      Common::StdInputStream stream(file);
+      BinaryInputStreamSerializer s(stream);
+      filter->serialize(s);
+    }
+  } catch (std::exception& e) {
+    logger(Logging::WARNING) << "Failed to load spent key image filter " << path << ": " << e.what() << ", rebuilding it";
+    filter->clear();
+  }
+
+  try {
+    uint32_t blockCount = getTopBlockIndex() + 1;
+    uint32_t filteredCount = filter->getBlockCount();
+    if (filteredCount > blockCount || (filteredCount > 0 && filter->getLastBlockHash() != getBlockHash(filteredCount - 1)) ||
+        filter->isWorthRebuilding()) {
+      logger(Logging::INFO) << "Spent key image filter doesn't match the database, rebuilding it";
+      filter->clear();
+      filteredCount = 0;
+    }
+
+    if (blockCount - filteredCount > 1000) {
+      logger(Logging::INFO) << "Adding spent key images of " << blockCount - filteredCount << " blocks to the filter, this may take a while...";
+    }
+
+    const uint32_t step = 1000;
+    while (filteredCount < blockCount) {
+      uint32_t count = std::min(step, blockCount - filteredCount);
+      BlockchainReadBatch batch;
+      for (auto index = filteredCount; index < filteredCount + count; ++index) {
+        batch.requestSpentKeyImagesByBlock(index);
+      }
+
+      for (const auto& kv : readDatabase(batch).getSpentKeyImagesByBlock()) {
+        for (const auto& keyImage : kv.second) {
+          filter->add(keyImage);
+        }
+      }
+
+      filteredCount += count;
+      filter->setTop(filteredCount, getBlockHash(filteredCount - 1));
+    }
+  } catch (std::exception& e) {
+    logger(Logging::WARNING) << "Failed to fill spent key image filter: " << e.what() << ", spent key images will be looked up in the database";
+    return;
+  }
+
+  logger(Logging::DEBUGGING) << "Spent key image filter holds " << filter->getKeyImageCount() << " key images in "
+    << filter->getMemoryUsage() / (1024 * 1024) << " MB";
+  spentKeyImageFilter = std::move(filter);
+}
+
+void DatabaseBlockchainCache::saveSpentKeyImageFilter() {
+  if (!spentKeyImageFilter) {
+    return;
+  }
+
+  // a crash while writing must not leave a half written filter behind, it would pass for a complete one
+  boost::filesystem::path tmpPath = boost::filesystem::unique_path(spentKeyImageFilterPath + ".tmp.%%%%-%%%%");
+  Tools::ScopeExit tmpFileDeleter([&tmpPath] {
+    boost::system::error_code ignore;
+    boost::filesystem::remove(tmpPath, ignore);
+  });
+
+  try {
+    {
+      std::ofstream file(tmpPath.string(), std::ios::binary | std::ios::trunc);
+      Common::StdOutputStream stream(file);
+      BinaryOutputStreamSerializer s(stream);
+      spentKeyImageFilter->serialize(s);
+
+      file.flush();
+      if (!file) {
+        throw std::runtime_error("failed to write " + tmpPath.string());
+      }
+    }
+
+    boost::filesystem::rename(tmpPath, spentKeyImageFilterPath);
+    tmpFileDeleter.cancel();
+  } catch (std::exception& e) {
+    logger(Logging::WARNING) << "Failed to save spent key image filter " << spentKeyImageFilterPath << ": " << e.what();
+  }
+}
+
+void DatabaseBlockchainCache::removeFromSpentKeyImageFilter(uint64_t keyImageCount) {
+  if (!spentKeyImageFilter) {
+    return;
+  }
+
+  // the rolled back key images stay behind as false positives until the filter is rebuilt on the next start
+  spentKeyImageFilter->markRemoved(keyImageCount);
+  spentKeyImageFilter->setTop(getTopBlockIndex() + 1, getTopBlockHash());
+}
+
+void DatabaseBlockchainCache::logSpentKeyImageFilterStats() const {
+  uint64_t lookups = keyImageLookups;
+  if (!spentKeyImageFilter || lookups == 0) {
+    return;
+  }
+
+  uint64_t filtered = keyImageLookupsFiltered;
+  logger(Logging::INFO) << "Spent key image filter: " << lookups << " lookups, " << filtered << " database reads avoided ("
+    << filtered * 100 / lookups << "%), " << keyImageFalsePositives << " false positives";
+}
+
+DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, std::unique_ptr<IDataBase>&& snapshot,
+                                                 IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& _logger,
+                                                 uint32_t topIndex, const Crypto::Hash& topHash, uint64_t transactionCount)
+    : currency(curr), snapshotDatabase(std::move(snapshot)), database(*snapshotDatabase), blockchainCacheFactory(blockchainCacheFactory),
+      topBlockIndex(topIndex), topBlockHash(topHash), transactionsCount(transactionCount), logger(_logger, "DatabaseBlockchainCache"),
+      keyImageLookups(0), keyImageLookupsFiltered(0), keyImageFalsePositives(0) {
+}
+
+std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::createSnapshot() const {
+  // called while nothing is written, so the top block matches the database snapshot
+  return std::unique_ptr<IBlockchainCache>(new DatabaseBlockchainCache(currency, database.createSnapshot(), blockchainCacheFactory,
+    logger.getLogger(), getTopBlockIndex(), getTopBlockHash(), getCachedTransactionsCount()));
 }
 
 bool DatabaseBlockchainCache::checkDBSchemeVersion(IDataBase& database, Logging::ILogger& _logger) {
@@ -508,6 +694,22 @@ bool DatabaseBlockchainCache::checkDBSchemeVersion(IDataBase& database, Logging:
   if (!version) {
     //DB scheme version not found. Looks like it was just created.
     return true;
+  } else if (*version >= MIGRATABLE_DB_SCHEME_VERSION && *version < CURRENT_DB_SCHEME_VERSION) {
+    // version 3 only changed the physical layout of the store (RocksDB column families)
+    logger(Logging::INFO) << "Upgrading DB scheme from version " << *version << " to " << CURRENT_DB_SCHEME_VERSION << ", this may take a while...";
+    auto migrateError = database.migrateStorageLayout();
+    if (migrateError) {
+      throw std::system_error(migrateError);
+    }
+
+    DatabaseVersionWriteBatch writeBatch(CURRENT_DB_SCHEME_VERSION);
+    auto writeError = database.writeSync(writeBatch);
+    if (writeError) {
+      throw std::system_error(writeError);
+    }
+
+    logger(Logging::INFO) << "DB scheme upgraded";
+    return true;
   } else if (*version < CURRENT_DB_SCHEME_VERSION) {
     logger(Logging::WARNING) << "DB scheme version is less than expected. Expected version " << CURRENT_DB_SCHEME_VERSION << ". Actual version " << *version << ". DB will be destroyed and recreated from blocks.bin file.";
     return false;
@@ -621,6 +823,11 @@ std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitB
   }
 
   cutTail(unitsCache, currentTop + 1 - splitBlockIndex);
+  if (blockIndexCache) {
+    blockIndexCache->cut(splitBlockIndex);
+  }
+
+  unlockedKeyOutputsBoundaries.clear();
 
   children.push_back(cache.get());
   logger(Logging::TRACE) << "Delete successfull";
@@ -630,6 +837,13 @@ std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitB
   topBlockHash = boost::none;
   transactionsCount = boost::none;
 
+  uint64_t removedKeyImages = 0;
+  for (const auto& deletedBlock : deletingBlocks) {
+    removedKeyImages += std::get<2>(deletedBlock).spentKeyImages.size();
+  }
+
+  removeFromSpentKeyImageFilter(removedKeyImages);
+
   logger(Logging::DEBUGGING) << "split completed";
   // return new cache
   return cache;
@@ -643,6 +857,10 @@ void DatabaseBlockchainCache::rewind(const uint32_t height)
   {
     logger(Logging::TRACE) << "DatabaseBlockchainCache::rewind height=" << std::to_string(height) << " calling database.recreate()";
     database.recreate();
+
+    // both are checked against the database and refilled on the next start
+    blockIndexCache.reset();
+    spentKeyImageFilter.reset();
     return;
   }
 
@@ -756,6 +974,11 @@ void DatabaseBlockchainCache::rewind(const uint32_t height)
 
   /* Remove cached blocks */
   cutTail(unitsCache, currentTop + 1 - height);
+  if (blockIndexCache) {
+    blockIndexCache->cut(height);
+  }
+
+  unlockedKeyOutputsBoundaries.clear();
   children.push_back(cache.get());
   logger(Logging::TRACE) << "Delete successful";
 
@@ -763,6 +986,13 @@ void DatabaseBlockchainCache::rewind(const uint32_t height)
   topBlockIndex = boost::none;
   topBlockHash = boost::none;
   transactionsCount = boost::none;
+
+  uint64_t removedKeyImages = 0;
+  for (const auto& deletedBlock : deletingBlocks) {
+    removedKeyImages += std::get<2>(deletedBlock).spentKeyImages.size();
+  }
+
+  removeFromSpentKeyImageFilter(removedKeyImages);
 }
 
 //returns hash of pushed block
@@ -1196,6 +1426,19 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
   if (unitsCache.size() > unitsCacheSize) {
     unitsCache.pop_front();
   }
+
+  if (blockIndexCache) {
+    assert(blockIndexCache->getBlockCount() == *topBlockIndex);
+    blockIndexCache->push(blockInfo);
+  }
+
+  if (spentKeyImageFilter) {
+    for (const auto& keyImage : validatorState.spentKeyImages) {
+      spentKeyImageFilter->add(keyImage);
+    }
+
+    spentKeyImageFilter->setTop(*topBlockIndex + 1, *topBlockHash);
+  }
 }
 
 PushedBlockInfo DatabaseBlockchainCache::getPushedBlockInfo(uint32_t blockIndex) const {
@@ -1203,6 +1446,14 @@ PushedBlockInfo DatabaseBlockchainCache::getPushedBlockInfo(uint32_t blockIndex)
 }
 
 bool DatabaseBlockchainCache::checkIfSpent(const Crypto::KeyImage& keyImage, uint32_t blockIndex) const {
+  if (spentKeyImageFilter) {
+    ++keyImageLookups;
+    if (!spentKeyImageFilter->mayContain(keyImage)) {
+      ++keyImageLookupsFiltered;
+      return false;
+    }
+  }
+
   auto batch = BlockchainReadBatch().requestBlockIndexBySpentKeyImage(keyImage);
   auto res = database.readThreadSafe(batch);
   if (res) {
@@ -1212,8 +1463,15 @@ bool DatabaseBlockchainCache::checkIfSpent(const Crypto::KeyImage& keyImage, uin
 
   auto readResult = batch.extractResult();
   auto it = readResult.getBlockIndexesBySpentKeyImages().find(keyImage);
+  if (it == readResult.getBlockIndexesBySpentKeyImages().end()) {
+    if (spentKeyImageFilter) {
+      ++keyImageFalsePositives;
+    }
+
+    return false;
+  }
 
-  return it != readResult.getBlockIndexesBySpentKeyImages().end() && it->second <= blockIndex;
+  return it->second <= blockIndex;
 }
 
 bool DatabaseBlockchainCache::checkIfSpent(const Crypto::KeyImage& keyImage) const {
@@ -1363,6 +1621,7 @@ bool DatabaseBlockchainCache::doGetMultisignatureOutputIfExists(
 }
 
 uint32_t DatabaseBlockchainCache::getTopBlockIndex() const {
+  std::lock_guard<std::mutex> lock(lazyStateLock);
   if (!topBlockIndex) {
     auto batch = BlockchainReadBatch().requestLastBlockIndex();
     auto result = database.readThreadSafe(batch);
@@ -1395,6 +1654,7 @@ uint8_t DatabaseBlockchainCache::getBlockMajorVersionForHeight(uint32_t height)
 }
 
 uint64_t DatabaseBlockchainCache::getCachedTransactionsCount() const {
+  std::lock_guard<std::mutex> lock(lazyStateLock);
   if (!transactionsCount) {
     auto batch = BlockchainReadBatch().requestTransactionsCount();
     auto result = database.readThreadSafe(batch);
@@ -1417,10 +1677,13 @@ uint64_t DatabaseBlockchainCache::getCachedTransactionsCount() const {
 }
 
 const Crypto::Hash& DatabaseBlockchainCache::getTopBlockHash() const {
+  uint32_t topIndex = getTopBlockIndex();
+
+  std::lock_guard<std::mutex> lock(lazyStateLock);
   if (!topBlockHash) {
-    auto batch = BlockchainReadBatch().requestCachedBlock(getTopBlockIndex());
+    auto batch = BlockchainReadBatch().requestCachedBlock(topIndex);
     auto result = readDatabase(batch);
-    topBlockHash = result.getCachedBlocks().at(getTopBlockIndex()).blockHash;
+    topBlockHash = result.getCachedBlocks().at(topIndex).blockHash;
   }
   return *topBlockHash;
 }
@@ -1500,11 +1763,33 @@ Difficulty DatabaseBlockchainCache::getCurrentCumulativeDifficulty(uint32_t bloc
 }
 
 CachedBlockInfo DatabaseBlockchainCache::getCachedBlockInfo(uint32_t index) const {
+  if (blockIndexCache && index < blockIndexCache->getBlockCount()) {
+    return (*blockIndexCache)[index];
+  }
+
   auto batch = BlockchainReadBatch().requestCachedBlock(index);
   auto result = readDatabase(batch);
   return result.getCachedBlocks().at(index);
 }
 
+std::vector<CachedBlockInfo> DatabaseBlockchainCache::readCachedBlockInfos(uint32_t startIndex, uint32_t count) const {
+  BlockchainReadBatch batch;
+  for (auto index = startIndex; index < startIndex + count; ++index) {
+    batch.requestCachedBlock(index);
+  }
+
+  auto result = readDatabase(batch);
+
+  std::map<uint32_t, CachedBlockInfo> sortedResult(result.getCachedBlocks().begin(), result.getCachedBlocks().end());
+  std::vector<CachedBlockInfo> blockInfos;
+  blockInfos.reserve(count);
+  for (const auto& kv : sortedResult) {
+    blockInfos.push_back(kv.second);
+  }
+
+  return blockInfos;
+}
+
 uint64_t DatabaseBlockchainCache::getAlreadyGeneratedCoins() const {
   return getAlreadyGeneratedCoins(getTopBlockIndex());
 }
@@ -1561,6 +1846,14 @@ std::vector<CachedBlockInfo> DatabaseBlockchainCache::getLastDbUnits(uint32_t bl
   std::vector<CachedBlockInfo> units;
   units.reserve(toRead);
 
+  if (blockIndexCache && blockIndex < blockIndexCache->getBlockCount()) {
+    for (auto index = readFrom; index <= blockIndex; ++index) {
+      units.push_back((*blockIndexCache)[index]);
+    }
+
+    return units;
+  }
+
   const uint32_t step = 200;
   while (toRead > 0) {
     auto next = std::min(toRead, step);
@@ -1635,9 +1928,7 @@ Crypto::Hash DatabaseBlockchainCache::getBlockHash(uint32_t blockIndex) const {
     return getTopBlockHash();
   }
 
-  auto batch = BlockchainReadBatch().requestCachedBlock(blockIndex);
-  auto result = readDatabase(batch);
-  return result.getCachedBlocks().at(blockIndex).blockHash;
+  return getCachedBlockInfo(blockIndex).blockHash;
 }
 
 std::vector<Crypto::Hash> DatabaseBlockchainCache::getBlockHashes(uint32_t startIndex, size_t maxCount) const {
@@ -1649,6 +1940,16 @@ std::vector<Crypto::Hash> DatabaseBlockchainCache::getBlockHashes(uint32_t start
     return {};
   }
 
+  if (blockIndexCache && startIndex + count <= blockIndexCache->getBlockCount()) {
+    std::vector<Crypto::Hash> hashes;
+    hashes.reserve(count);
+    for (auto index = startIndex; index < startIndex + count; ++index) {
+      hashes.push_back((*blockIndexCache)[index].blockHash);
+    }
+
+    return hashes;
+  }
+
   BlockchainReadBatch request;
   auto index = startIndex;
   while (index != startIndex + count) {
@@ -1771,6 +2072,12 @@ size_t DatabaseBlockchainCache::getChildCount() const {
 }
 
 void DatabaseBlockchainCache::save() {
+  if (blockIndexCache) {
+    blockIndexCache->flush();
+  }
+
+  saveSpentKeyImageFilter();
+  logSpentKeyImageFilterStats();
 }
 
 void DatabaseBlockchainCache::load() {
@@ -1805,11 +2112,10 @@ void DatabaseBlockchainCache::getRawTransactions(const std::vector<Crypto::Hash>
     batch.requestRawBlock(tx.second.blockIndex);
   }
 
-  auto blocks = readDatabase(batch);
+  auto blocksMap = readDatabase(batch).extractRawBlocks();
 
   foundTransactions.reserve(foundTransactions.size() + transactions.size());
   auto& hashesMap = res.getCachedTransactions();
-  auto& blocksMap = blocks.getRawBlocks();
   for (const auto& hash: transactions) {
     auto transactionIt = hashesMap.find(hash);
     if (transactionIt == hashesMap.end()) {
@@ -1837,8 +2143,8 @@ void DatabaseBlockchainCache::getRawTransactions(const std::vector<Crypto::Hash>
 
 RawBlock DatabaseBlockchainCache::getBlockByIndex(uint32_t index) const {
   auto batch = BlockchainReadBatch().requestRawBlock(index);
-  auto res = readDatabase(batch);
-  return std::move(res.getRawBlocks().at(index));
+  auto rawBlocks = readDatabase(batch).extractRawBlocks();
+  return std::move(rawBlocks.at(index));
 }
 
 BinaryArray DatabaseBlockchainCache::getRawTransaction(uint32_t blockIndex, uint32_t transactionIndex) const {
@@ -1857,58 +2163,130 @@ std::vector<Crypto::Hash> DatabaseBlockchainCache::getTransactionHashes(uint32_t
 
 std::vector<uint32_t> DatabaseBlockchainCache::getRandomOutsByAmount(uint64_t amount, size_t count,
                                                                      uint32_t blockIndex) const {
-  auto batch = BlockchainReadBatch().requestKeyOutputGlobalIndexesCountForAmount(amount);
-  auto result = readDatabase(batch);
-  auto outputsCount = result.getKeyOutputGlobalIndexesCountForAmounts();
-  auto outputsToPick = std::min(static_cast<uint32_t>(count), outputsCount[amount]);
+  auto outs = getRandomOutsByAmounts({amount}, count, blockIndex);
+  return std::move(outs.front().globalIndexes);
+}
+
+std::vector<RandomOutputsForAmount> DatabaseBlockchainCache::getRandomOutsByAmounts(const std::vector<uint64_t>& amounts, size_t count,
+                                                                                    uint32_t blockIndex) const {
+  BlockchainReadBatch countsBatch;
+  for (auto amount : amounts) {
+    countsBatch.requestKeyOutputGlobalIndexesCountForAmount(amount);
+  }
+
+  auto outputsCounts = readDatabase(countsBatch).getKeyOutputGlobalIndexesCountForAmounts();
 
-  std::vector<uint32_t> resultOuts;
-  resultOuts.reserve(outputsToPick);
+  uint32_t upperBlockIndex = 0;
+  if (blockIndex > currency.minedMoneyUnlockWindow()) {
+    upperBlockIndex = blockIndex - currency.minedMoneyUnlockWindow();
+  }
+
+  std::vector<RandomOutputsForAmount> result(amounts.size());
+  std::vector<ShuffleGenerator<uint32_t>> generators;
+  std::vector<size_t> outputsToPick(amounts.size());
+  generators.reserve(amounts.size());
+
+  for (size_t i = 0; i < amounts.size(); ++i) {
+    // the read batch leaves out amounts without outputs
+    auto countIt = outputsCounts.find(amounts[i]);
+    uint32_t outputsCount = countIt != outputsCounts.end() ? countIt->second : 0;
 
-  ShuffleGenerator<uint32_t> generator(outputsCount[amount]);
+    // every candidate below the boundary is mature, only unlock time has to be checked
+    auto unlockedCount = getUnlockedKeyOutputsCount(amounts[i], upperBlockIndex, outputsCount);
+
+    result[i].amount = amounts[i];
+    outputsToPick[i] = std::min(count, static_cast<size_t>(unlockedCount));
+    generators.emplace_back(unlockedCount);
+  }
 
-  while (outputsToPick) {
-    std::vector<uint32_t> globalIndexes;
-    globalIndexes.reserve(outputsToPick);
+  // one database round trip per round for all amounts; further rounds are only needed
+  // to replace candidates locked by their unlock time
+  for (;;) {
+    BlockchainReadBatch batch;
+    std::vector<std::pair<size_t, uint32_t>> candidates;
 
-    try {
-      for (uint32_t i = 0; i < outputsToPick; ++i, globalIndexes.push_back(generator())) { }
-      //std::generate_n(std::back_inserter(globalIndexes), outputsToPick, generator);
-    } catch (const SequenceEnded&) {
-      logger(Logging::TRACE) << "getRandomOutsByAmount: generator reached sequence end";
-      return resultOuts;
+    for (size_t i = 0; i < amounts.size(); ++i) {
+      for (size_t j = 0; j < outputsToPick[i] && !generators[i].empty(); ++j) {
+        auto globalIndex = generators[i]();
+        batch.requestKeyOutputInfo(amounts[i], globalIndex);
+        candidates.emplace_back(i, globalIndex);
+      }
     }
 
-    std::vector<PackedOutIndex> outputs;
-    if (extractKeyOtputIndexes(amount, Common::ArrayView<uint32_t>(globalIndexes.data(), globalIndexes.size()), outputs) != ExtractOutputKeysResult::SUCCESS) {
-      logger(Logging::DEBUGGING) << "getRandomOutsByAmount: failed to extract key output indexes";
-      throw std::runtime_error("Invalid output index"); //TODO: make error code
+    if (candidates.empty()) {
+      break;
     }
 
-    std::vector<ExtendedTransactionInfo> transactions;
-    if (!requestExtendedTransactionInfos(outputs, database, transactions)) {
-      logger(Logging::TRACE) << "getRandomOutsByAmount: requestExtendedTransactionInfos failed";
-      throw std::runtime_error("Error while requesting transactions"); //TODO: make error code
+    auto outputs = readDatabase(batch).getKeyOutputInfo();
+    for (const auto& candidate : candidates) {
+      auto it = outputs.find(std::make_pair(amounts[candidate.first], candidate.second));
+      if (it == outputs.end()) {
+        logger(Logging::DEBUGGING) << "getRandomOutsByAmounts: failed to read key output " << candidate.second
+                                   << " for amount " << amounts[candidate.first];
+        throw std::runtime_error("Invalid output index"); //TODO: make error code
+      }
+
+      if (!isTransactionSpendTimeUnlocked(it->second.unlockTime, blockIndex)) {
+        continue;
+      }
+
+      result[candidate.first].globalIndexes.push_back(candidate.second);
+      result[candidate.first].publicKeys.push_back(it->second.publicKey);
+      --outputsToPick[candidate.first];
+    }
+  }
+
+  for (auto& outs : result) {
+    std::vector<std::pair<uint32_t, Crypto::PublicKey>> sorted;
+    sorted.reserve(outs.globalIndexes.size());
+    for (size_t i = 0; i < outs.globalIndexes.size(); ++i) {
+      sorted.emplace_back(outs.globalIndexes[i], outs.publicKeys[i]);
     }
 
-    assert(globalIndexes.size() == transactions.size());
+    std::sort(sorted.begin(), sorted.end(), [] (const std::pair<uint32_t, Crypto::PublicKey>& a, const std::pair<uint32_t, Crypto::PublicKey>& b) {
+      return a.first < b.first;
+    });
 
-    uint32_t uppperBlockIndex = 0;
-    if (blockIndex > currency.minedMoneyUnlockWindow()) {
-      uppperBlockIndex = blockIndex - currency.minedMoneyUnlockWindow();
+    for (size_t i = 0; i < sorted.size(); ++i) {
+      outs.globalIndexes[i] = sorted[i].first;
+      outs.publicKeys[i] = sorted[i].second;
     }
+  }
 
-    for (size_t i = 0; i < transactions.size(); ++i) {
-      if (!isTransactionSpendTimeUnlocked(transactions[i].unlockTime, blockIndex) || transactions[i].blockIndex > uppperBlockIndex) {
-        continue;
-      }
+  return result;
+}
 
-      resultOuts.push_back(globalIndexes[i]);
-      --outputsToPick;
+uint32_t DatabaseBlockchainCache::getUnlockedKeyOutputsCount(Amount amount, uint32_t upperBlockIndex, uint32_t outputsCount) const {
+  uint32_t lower = 0;
+  uint32_t upper = outputsCount;
+
+  {
+    std::lock_guard<std::mutex> lock(lazyStateLock);
+    auto it = unlockedKeyOutputsBoundaries.find(amount);
+    if (it != unlockedKeyOutputsBoundaries.end()) {
+      if (it->second.blockIndex <= upperBlockIndex) {
+        lower = std::min(it->second.outputsCount, outputsCount);
+      } else {
+        upper = std::min(it->second.outputsCount, outputsCount);
+      }
     }
   }
 
-  return resultOuts;
+  // usually only the outputs of the few blocks added since the last request are searched
+  auto getOutput = std::bind(retrieveKeyOutput, std::placeholders::_1, std::placeholders::_2, std::ref(database));
+  auto begin = DbOutputConstIterator(getOutput, amount, lower);
+  auto end = DbOutputConstIterator(getOutput, amount, upper);
+
+  auto found = std::partition_point(begin, end, [upperBlockIndex] (const PackedOutIndex& output) {
+    return output.blockIndex <= upperBlockIndex;
+  });
+
+  uint32_t unlockedCount = lower + static_cast<uint32_t>(std::distance(begin, found));
+
+  std::lock_guard<std::mutex> lock(lazyStateLock);
+  unlockedKeyOutputsBoundaries[amount] = {upperBlockIndex, unlockedCount};
+
+  return unlockedCount;
 }
 
 ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOutputs(
@@ -1999,16 +2377,16 @@ DatabaseBlockchainCache::getNonEmptyBlocks(const uint32_t startHeight, const siz
     uint32_t endHeight = startHeight + (blockCount * 2);
 
     auto blockBatch = BlockchainReadBatch().requestRawBlocks(startHeight, endHeight);
-    const auto rawBlocks = readDatabase(blockBatch).getRawBlocks();
+    auto rawBlocks = readDatabase(blockBatch).extractRawBlocks();
 
     while (orderedBlocks.size() < blockCount && height < startHeight + rawBlocks.size()) {
-      const auto block = rawBlocks.at(height);
+      auto& block = rawBlocks.at(height);
       height++;
       if (block.transactions.empty()) {
         continue;
       }
 
-      orderedBlocks.push_back(block);
+      orderedBlocks.push_back(std::move(block));
     }
   }
 
@@ -2020,13 +2398,14 @@ DatabaseBlockchainCache::getBlocksByHeight(const uint32_t startHeight, uint32_t
   auto blockBatch = BlockchainReadBatch().requestRawBlocks(startHeight, endHeight);
 
   /* Get the info from the DB */
-  auto rawBlocks = readDatabase(blockBatch).getRawBlocks();
+  auto rawBlocks = readDatabase(blockBatch).extractRawBlocks();
 
   std::vector<RawBlock> orderedBlocks;
+  orderedBlocks.reserve(rawBlocks.size());
 
   /* Order, and convert from map, to vector */
   for (uint32_t height = startHeight; height < startHeight + rawBlocks.size(); height++) {
-    orderedBlocks.push_back(rawBlocks.at(height));
+    orderedBlocks.push_back(std::move(rawBlocks.at(height)));
   }
 
   return orderedBlocks;
@@ -18,10 +18,15 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+
 #include "Common/StringView.h"
+#include "BlockIndexCache.h"
 #include "Currency.h"
 #include "Difficulty.h"
 #include "IBlockchainCache.h"
+#include "SpentKeyImageFilter.h"
 
 #include "CryptoNoteCore/UpgradeManager.h"
 
@@ -50,10 +55,17 @@ public:
    * BlockchainCache objects as children are supported.
    */
   DatabaseBlockchainCache(const Currency& currency, IDataBase& dataBase,
-                          IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& logger);
+                          IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& logger,
+                          const std::string& cacheDirectory = std::string());
 
   static bool checkDBSchemeVersion(IDataBase& dataBase, Logging::ILogger& logger);
 
+  /*
+   * Snapshot is read-only: it reads a snapshot of the database, starts out knowing its top block
+   * and doesn't touch the database on construction.
+   */
+  virtual std::unique_ptr<IBlockchainCache> createSnapshot() const override;
+
   /*
    * This methods splits cache, upper part (ie blocks with indexes larger than splitBlockIndex)
    * is copied to new BlockchainCache. Unfortunately, implementation requires return value to be of
@@ -167,6 +179,8 @@ public:
   virtual std::vector<Crypto::Hash> getTransactionHashes(uint32_t startIndex, uint32_t endIndex) const override;
   virtual std::vector<uint32_t> getRandomOutsByAmount(uint64_t amount, size_t count,
                                                       uint32_t blockIndex) const override;
+  virtual std::vector<RandomOutputsForAmount> getRandomOutsByAmounts(const std::vector<uint64_t>& amounts, size_t count,
+                                                                     uint32_t blockIndex) const override;
   virtual ExtractOutputKeysResult
   extractKeyOutputs(uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes,
                     std::function<ExtractOutputKeysResult(const CachedTransactionInfo& info, PackedOutIndex index,
@@ -180,8 +194,13 @@ public:
 
 private:
   const Currency& currency;
+  // set for snapshots only, database refers to it then
+  std::unique_ptr<IDataBase> snapshotDatabase;
   IDataBase& database;
   IBlockchainCacheFactory& blockchainCacheFactory;
+  // Const queries may run on several threads at once (RPC workers), so whatever they fill in
+  // lazily is guarded by lazyStateLock. Writers run alone and don't take it.
+  mutable std::mutex lazyStateLock;
   mutable boost::optional<uint32_t> topBlockIndex;
   mutable boost::optional<Crypto::Hash> topBlockHash;
   mutable boost::optional<uint64_t> transactionsCount;
@@ -193,12 +212,44 @@ private:
   Logging::LoggerRef logger;
   std::deque<CachedBlockInfo> unitsCache;
   const size_t unitsCacheSize = 1000;
+  // CachedBlockInfo of every block, kept in step with the database. Not set for snapshots.
+  std::unique_ptr<BlockIndexCache> blockIndexCache;
+  // Key images spent up to the top block, saved to spentKeyImageFilterPath. Not set for snapshots.
+  std::unique_ptr<SpentKeyImageFilter> spentKeyImageFilter;
+  std::string spentKeyImageFilterPath;
+
+  // checkIfSpent lookups, those answered by the filter alone and those the database didn't confirm
+  mutable std::atomic<uint64_t> keyImageLookups;
+  mutable std::atomic<uint64_t> keyImageLookupsFiltered;
+  mutable std::atomic<uint64_t> keyImageFalsePositives;
+
+  /*
+   * Key outputs are numbered in chain order, so the outputs of an amount which are old enough
+   * to be spent are exactly the global indexes below a boundary. The boundary is remembered per
+   * amount together with the block index it was found for and moved forward as the chain grows.
+   * Reset on split and rewind.
+   */
+  struct UnlockedKeyOutputsBoundary {
+    uint32_t blockIndex;
+    uint32_t outputsCount;
+  };
+  mutable std::unordered_map<Amount, UnlockedKeyOutputsBoundary> unlockedKeyOutputsBoundaries;
+
+  DatabaseBlockchainCache(const Currency& currency, std::unique_ptr<IDataBase>&& snapshotDatabase,
+                          IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& logger,
+                          uint32_t topBlockIndex, const Crypto::Hash& topBlockHash, uint64_t transactionsCount);
 
   struct ExtendedPushedBlockInfo;
   ExtendedPushedBlockInfo getExtendedPushedBlockInfo(uint32_t blockIndex) const;
 
   void deleteClosestTimestampBlockIndex(BlockchainWriteBatch& writeBatch, uint32_t splitBlockIndex);
   CachedBlockInfo getCachedBlockInfo(uint32_t index) const;
+  std::vector<CachedBlockInfo> readCachedBlockInfos(uint32_t startIndex, uint32_t count) const;
+  void openBlockIndexCache(const std::string& path);
+  void openSpentKeyImageFilter(const std::string& path);
+  void saveSpentKeyImageFilter();
+  void removeFromSpentKeyImageFilter(uint64_t keyImageCount);
+  void logSpentKeyImageFilterStats() const;
   BlockchainReadResult readDatabase(BlockchainReadBatch& batch) const;
 
   void addSpentKeyImage(const Crypto::KeyImage& keyImage, uint32_t blockIndex);
@@ -210,6 +261,7 @@ private:
   uint32_t insertKeyOutputToGlobalIndex(uint64_t amount, PackedOutIndex output); //TODO not implemented. Should it be removed?
   uint32_t insertMultisignatureToGlobalIndex(uint64_t amount, PackedOutIndex output);
   uint32_t updateKeyOutputCount(Amount amount, int32_t diff) const;
+  uint32_t getUnlockedKeyOutputsCount(Amount amount, uint32_t upperBlockIndex, uint32_t outputsCount) const;
   uint32_t updateMultiOutputCount(Amount amount, int32_t diff) const;
   void insertPaymentId(BlockchainWriteBatch& batch, const Crypto::Hash& transactionHash, const Crypto::Hash& paymentId);
   void insertBlockTimestamp(BlockchainWriteBatch& batch, uint64_t timestamp, const Crypto::Hash& blockHash);
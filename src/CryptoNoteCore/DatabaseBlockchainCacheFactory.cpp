@@ -25,7 +25,8 @@
 
 namespace CryptoNote {
 
-DatabaseBlockchainCacheFactory::DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger): database(database), logger(logger) {
+DatabaseBlockchainCacheFactory::DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger, const std::string& cacheDirectory):
+  database(database), logger(logger), cacheDirectory(cacheDirectory) {
 
 }
 
@@ -34,7 +35,7 @@ DatabaseBlockchainCacheFactory::~DatabaseBlockchainCacheFactory() {
 }
 
 std::unique_ptr<IBlockchainCache> DatabaseBlockchainCacheFactory::createRootBlockchainCache(const Currency& currency) {
-  return std::unique_ptr<IBlockchainCache> (new DatabaseBlockchainCache(currency, database, *this, logger));
+  return std::unique_ptr<IBlockchainCache> (new DatabaseBlockchainCache(currency, database, *this, logger, cacheDirectory));
 }
 
 std::unique_ptr<IBlockchainCache> DatabaseBlockchainCacheFactory::createBlockchainCache(const Currency& currency, IBlockchainCache* parent, uint32_t startIndex) {
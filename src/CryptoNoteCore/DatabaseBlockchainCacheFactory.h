@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "IBlockchainCacheFactory.h"
 #include <Logging/LoggerMessage.h>
 
@@ -27,7 +29,8 @@ class IDataBase;
 
 class DatabaseBlockchainCacheFactory: public IBlockchainCacheFactory {
 public:
-  explicit DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger);
+  // cacheDirectory: where the root cache keeps its block index cache and spent key image filter, none if empty
+  DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger, const std::string& cacheDirectory = std::string());
   virtual ~DatabaseBlockchainCacheFactory() override;
 
   virtual std::unique_ptr<IBlockchainCache> createRootBlockchainCache(const Currency& currency) override;
@@ -36,6 +39,7 @@ public:
 private:
   IDataBase& database;
   Logging::ILogger& logger;
+  std::string cacheDirectory;
 };
 
 } //namespace CryptoNote
@@ -50,6 +50,12 @@ union PackedOutIndex {
   uint64_t packedValue;
 };
 
+struct RandomOutputsForAmount {
+  uint64_t amount;
+  std::vector<uint32_t> globalIndexes; // sorted
+  std::vector<Crypto::PublicKey> publicKeys;
+};
+
 const uint32_t INVALID_BLOCK_INDEX = std::numeric_limits<uint32_t>::max();
 
 struct CachedBlockInfo {
@@ -199,12 +205,17 @@ public:
   virtual std::vector<Crypto::Hash> getTransactionHashes() const = 0;
   virtual std::vector<Crypto::Hash> getTransactionHashes(uint32_t startIndex, uint32_t endIndex) const = 0;
   virtual std::vector<uint32_t> getRandomOutsByAmount(uint64_t amount, size_t count, uint32_t blockIndex) const = 0;
+  virtual std::vector<RandomOutputsForAmount> getRandomOutsByAmounts(const std::vector<uint64_t>& amounts, size_t count, uint32_t blockIndex) const = 0;
 
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const = 0;
   virtual std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount) const = 0;
 
   virtual std::vector<RawBlock> getBlocksByHeight(const uint32_t startHeight, uint32_t endHeight) const = 0;
   virtual std::vector<RawBlock> getNonEmptyBlocks(const uint32_t startHeight, const size_t blockCount) const = 0;
+
+  // Read-only copy of this segment as it is now, which isn't affected by changes to the segment.
+  // Returns nullptr if the segment can't provide one.
+  virtual std::unique_ptr<IBlockchainCache> createSnapshot() const = 0;
 };
 
 }
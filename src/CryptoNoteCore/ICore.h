@@ -33,6 +33,7 @@
 #include "CachedBlock.h"
 #include "CachedTransaction.h"
 #include "CoreStatistics.h"
+#include "IBlockchainCache.h"
 #include "Difficulty.h"
 #include "ICoreObserver.h"
 #include "ICoreDefinitions.h"
@@ -95,6 +96,8 @@ public:
                                            std::vector<uint32_t>& globalIndexes) const = 0;
   virtual bool getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_t>& globalIndexes,
                                 std::vector<Crypto::PublicKey>& publicKeys) const = 0;
+  virtual bool getRandomOutputs(const std::vector<uint64_t>& amounts, uint16_t count,
+                                std::vector<RandomOutputsForAmount>& outs) const = 0;
 
   virtual bool addTransactionToPool(const BinaryArray& transactionBinaryArray) = 0;
   virtual boost::optional<std::pair<MultisignatureOutput, uint64_t>>
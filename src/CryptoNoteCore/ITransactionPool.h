@@ -44,6 +44,19 @@ public:
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const = 0;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const = 0;
+
+  // Pool transactions spending any key image or multisignature output of the state
+  virtual std::vector<Crypto::Hash> getTransactionHashesSpendingOutputs(const TransactionValidatorState& state) const = 0;
+  virtual std::vector<Crypto::Hash> getTransactionHashesBiggerThan(size_t size) const = 0;
+  // Pool transactions with mixin in [minMixin, maxMixin]
+  virtual std::vector<Crypto::Hash> getTransactionHashesByMixin(uint64_t minMixin, uint64_t maxMixin) const = 0;
+
+  // Changes whenever a transaction is pushed or removed
+  virtual uint64_t getVersion() const = 0;
+  // Picks block template transactions by fee per byte, fusion transactions first within fusionTxMaxSize,
+  // zero fee transactions within medianSize, the rest within maxTotalSize. Returns the version picked from.
+  virtual uint64_t selectBlockTemplateTransactions(size_t fusionTxMaxSize, size_t medianSize, size_t maxTotalSize,
+    std::vector<Crypto::Hash>& transactionHashes, size_t& transactionsSize, uint64_t& fee) const = 0;
 };
 
 }
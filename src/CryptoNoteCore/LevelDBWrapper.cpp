@@ -217,6 +217,11 @@ std::error_code LevelDBWrapper::write(IWriteBatch &batch, bool sync)
 }
 
 std::error_code LevelDBWrapper::read(IReadBatch &batch)
+{
+    return read(batch, nullptr);
+}
+
+std::error_code LevelDBWrapper::read(IReadBatch &batch, const leveldb::Snapshot *snapshot)
 {
     if (state.load() != INITIALIZED)
     {
@@ -224,6 +229,7 @@ std::error_code LevelDBWrapper::read(IReadBatch &batch)
     }
 
     leveldb::ReadOptions readOptions;
+    readOptions.snapshot = snapshot;
 
     std::vector<std::string> rawKeys(batch.getRawKeys());
     std::vector<leveldb::Slice> keySlices;
@@ -236,7 +242,7 @@ std::error_code LevelDBWrapper::read(IReadBatch &batch)
     for (const std::string &key : rawKeys)
     {
         std::string tmp_value;
-        leveldb::Status s = db->Get(leveldb::ReadOptions(), key, &tmp_value);
+        leveldb::Status s = db->Get(readOptions, key, &tmp_value);
         if (!s.ok() && !s.IsNotFound())
         {
             return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
@@ -257,6 +263,82 @@ std::error_code LevelDBWrapper::readThreadSafe(IReadBatch &batch)
     return read(batch);
 }
 
+/* Pins a leveldb snapshot, reads go through the wrapper with it set in the read options */
+class LevelDBWrapper::Snapshot : public IDataBase
+{
+    public:
+        Snapshot(LevelDBWrapper &wrapper) : wrapper(wrapper), snapshot(wrapper.db->GetSnapshot())
+        {
+        }
+
+        ~Snapshot() override
+        {
+            wrapper.db->ReleaseSnapshot(snapshot);
+        }
+
+        void init() override
+        {
+        }
+
+        void shutdown() override
+        {
+        }
+
+        void destroy() override
+        {
+            throw std::runtime_error("Database snapshot is read-only");
+        }
+
+        void recreate() override
+        {
+            throw std::runtime_error("Database snapshot is read-only");
+        }
+
+        std::error_code write(IWriteBatch &batch) override
+        {
+            return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+        }
+
+        std::error_code writeSync(IWriteBatch &batch) override
+        {
+            return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+        }
+
+        std::error_code read(IReadBatch &batch) override
+        {
+            return wrapper.read(batch, snapshot);
+        }
+
+        std::error_code readThreadSafe(IReadBatch &batch) override
+        {
+            return wrapper.read(batch, snapshot);
+        }
+
+        std::error_code migrateStorageLayout() override
+        {
+            return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+        }
+
+        std::unique_ptr<IDataBase> createSnapshot() override
+        {
+            throw std::runtime_error("Snapshots are taken from the database itself");
+        }
+
+    private:
+        LevelDBWrapper &wrapper;
+        const leveldb::Snapshot *snapshot;
+};
+
+std::unique_ptr<IDataBase> LevelDBWrapper::createSnapshot()
+{
+    if (state.load() != INITIALIZED)
+    {
+        throw std::runtime_error("Not initialized.");
+    }
+
+    return std::unique_ptr<IDataBase>(new Snapshot(*this));
+}
+
 std::string LevelDBWrapper::getDataDir(const DataBaseConfig &config)
 {
   if (config.getTestnet()) {
@@ -267,6 +349,12 @@ std::string LevelDBWrapper::getDataDir(const DataBaseConfig &config)
   }
 }
 
+std::error_code LevelDBWrapper::migrateStorageLayout()
+{
+    /* All records live in a single key space, there is nothing to move */
+    return std::error_code();
+}
+
 void LevelDBWrapper::recreate()
 {
   if (state.load() == INITIALIZED)
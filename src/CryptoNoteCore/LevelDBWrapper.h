@@ -39,11 +39,16 @@ namespace CryptoNote
         std::error_code writeSync(IWriteBatch& batch) override;
         std::error_code read(IReadBatch &batch) override;
         std::error_code readThreadSafe(IReadBatch &batch) override;
+        std::error_code migrateStorageLayout() override;
+        std::unique_ptr<IDataBase> createSnapshot() override;
 
         void recreate() override;
 
       private:
+        class Snapshot;
+
         std::error_code write(IWriteBatch &batch, bool sync);
+        std::error_code read(IReadBatch &batch, const leveldb::Snapshot *snapshot);
 
         std::string getDataDir(const DataBaseConfig &config);
 
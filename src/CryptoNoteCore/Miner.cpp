@@ -33,6 +33,7 @@
 #include <boost/utility/value_init.hpp>
 
 #include "crypto/crypto.h"
+#include "crypto/scratchpad-pool.h"
 #include "Common/CommandLine.h"
 #include "Common/StringTools.h"
 #include "Serialization/SerializationTools.h"
@@ -62,7 +63,8 @@ namespace CryptoNote
     m_do_mining(false),
     m_current_hash_rate(0),
     m_update_block_template_interval(5),
-    m_update_merge_hr_interval(2)
+    m_update_merge_hr_interval(2),
+    m_numa_affinity(false)
   {
   }
   //-----------------------------------------------------------------------------------------------------
@@ -211,6 +213,7 @@ namespace CryptoNote
       }
     }
 
+    m_numa_affinity = config.numaAffinity;
     return true;
   }
   //-----------------------------------------------------------------------------------------------------
@@ -313,11 +316,20 @@ namespace CryptoNote
   bool miner::worker_thread(uint32_t th_local_index)
   {
     logger(INFO) << "Miner thread was started ["<< th_local_index << "]";
+    if (m_numa_affinity) {
+      // the context below then takes its scratchpad from this node too
+      unsigned node = th_local_index % Crypto::numaNodeCount();
+      if (!Crypto::bindThreadToNumaNode(node)) {
+        logger(WARNING) << "Failed to bind miner thread [" << th_local_index << "] to NUMA node " << node;
+      }
+    }
+
     uint32_t nonce = m_starter_nonce + th_local_index;
     Difficulty local_diff = 0;
     uint32_t local_template_ver = 0;
     Crypto::cn_context context;
     BlockTemplate b;
+    bool scratchpadsReported = false;
 
     while(!m_stop)
     {
@@ -355,6 +367,12 @@ namespace CryptoNote
           logger(ERROR) << "getBlockLongHash failed: " << e.what();
           m_stop = true;
         }
+
+        if (!scratchpadsReported && th_local_index + 1 == m_threads_total) {
+          Crypto::ScratchpadPoolStatistics statistics = Crypto::ScratchpadPool::instance().getStatistics();
+          logger(INFO) << "Hashing scratchpads: " << statistics.scratchpads << ", on huge pages: " << statistics.hugePageScratchpads;
+          scratchpadsReported = true;
+        }
       }
 
       if (!m_stop && check_hash(h, local_diff))
@@ -35,6 +35,7 @@ public:
   std::string extraMessages;
   std::string startMining;
   uint32_t miningThreads;
+  bool numaAffinity;
 };
 
 } //namespace CryptoNote
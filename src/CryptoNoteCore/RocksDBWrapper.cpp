@@ -19,12 +19,16 @@
 
 #include "RocksDBWrapper.h"
 
+#include <unordered_map>
+
 #include "rocksdb/cache.h"
+#include "rocksdb/filter_policy.h"
 #include "rocksdb/table.h"
 #include "rocksdb/db.h"
 #include "rocksdb/utilities/backupable_db.h"
 
 #include "DataBaseErrors.h"
+#include "DBUtils.h"
 
 using namespace CryptoNote;
 using namespace Logging;
@@ -32,6 +36,55 @@ using namespace Logging;
 namespace {
   const std::string DB_NAME = "RocksDB";
   const std::string TESTNET_DB_NAME = "testnet_RocksDB";
+
+  // Records are split by access pattern: raw blocks are large and read sequentially,
+  // key images and outputs are small point lookups on every transaction check
+  enum ColumnFamily : size_t {
+    DEFAULT_FAMILY = 0,
+    BLOCKS_FAMILY,
+    BLOCK_INDEXES_FAMILY,
+    KEY_IMAGES_FAMILY,
+    OUTPUTS_FAMILY,
+    TRANSACTIONS_FAMILY,
+    FAMILIES_COUNT
+  };
+
+  const std::vector<std::string> COLUMN_FAMILY_NAMES = {
+    rocksdb::kDefaultColumnFamilyName,
+    "blocks",
+    "block_indexes",
+    "key_images",
+    "outputs",
+    "transactions"
+  };
+
+  const std::unordered_map<std::string, ColumnFamily> PREFIX_TO_COLUMN_FAMILY = {
+    { DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, BLOCKS_FAMILY },
+
+    { DB::BLOCK_INDEX_TO_KEY_IMAGE_PREFIX, BLOCK_INDEXES_FAMILY },
+    { DB::BLOCK_INDEX_TO_TX_HASHES_PREFIX, BLOCK_INDEXES_FAMILY },
+    { DB::BLOCK_INDEX_TO_SPENT_MULTISIGNATURE_PREFIX, BLOCK_INDEXES_FAMILY },
+    { DB::BLOCK_HASH_TO_BLOCK_INDEX_PREFIX, BLOCK_INDEXES_FAMILY },
+    { DB::BLOCK_INDEX_TO_BLOCK_INFO_PREFIX, BLOCK_INDEXES_FAMILY },
+    { DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, BLOCK_INDEXES_FAMILY },
+    { DB::CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX, BLOCK_INDEXES_FAMILY },
+    { DB::TIMESTAMP_TO_BLOCKHASHES_PREFIX, BLOCK_INDEXES_FAMILY },
+
+    { DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, KEY_IMAGES_FAMILY },
+
+    { DB::KEY_OUTPUT_AMOUNT_PREFIX, OUTPUTS_FAMILY },
+    { DB::MULTISIGNATURE_OUTPUT_AMOUNT_PREFIX, OUTPUTS_FAMILY },
+    { DB::SPENT_MULTISIGNATURE_OUTPUT_AMOUNT_PREFIX, OUTPUTS_FAMILY },
+    { DB::KEY_OUTPUT_AMOUNTS_COUNT_PREFIX, OUTPUTS_FAMILY },
+    { DB::MULTISIGNATURE_OUTPUT_AMOUNTS_COUNT_PREFIX, OUTPUTS_FAMILY },
+    { DB::KEY_OUTPUT_KEY_PREFIX, OUTPUTS_FAMILY },
+
+    { DB::BLOCK_INDEX_TO_TRANSACTION_INFO_PREFIX, TRANSACTIONS_FAMILY },
+    { DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, TRANSACTIONS_FAMILY },
+    { DB::PAYMENT_ID_TO_TX_HASH_PREFIX, TRANSACTIONS_FAMILY }
+  };
+
+  const size_t MIGRATION_BATCH_SIZE = 100000;
 }
 
 RocksDBWrapper::RocksDBWrapper(Logging::ILogger& logger, const DataBaseConfig &config) : 
@@ -56,14 +109,16 @@ void RocksDBWrapper::init() {
 
   rocksdb::DB* dbPtr;
 
-  rocksdb::Options dbOptions = getDBOptions(m_config);
-  rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, &dbPtr);
+  rocksdb::DBOptions dbOptions = getDBOptions(m_config);
+  std::vector<rocksdb::ColumnFamilyDescriptor> descriptors = getColumnFamilyDescriptors(m_config);
+  rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, descriptors, &columnFamilies, &dbPtr);
   if (status.ok()) {
     logger(INFO) << "DB opened in " << dataDir;
   } else if (!status.ok() && status.IsInvalidArgument()) {
     logger(INFO) << "DB not found in " << dataDir << ". Creating new DB...";
     dbOptions.create_if_missing = true;
-    rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, &dbPtr);
+    columnFamilies.clear();
+    rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, descriptors, &columnFamilies, &dbPtr);
     if (!status.ok()) {
       logger(ERROR) << "DB Error. DB can't be created in " << dataDir << ". Error: " << status.ToString();
       throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
@@ -86,8 +141,9 @@ void RocksDBWrapper::shutdown() {
   }
 
   logger(INFO) << "Closing DB.";
-  db->Flush(rocksdb::FlushOptions());
+  db->Flush(rocksdb::FlushOptions(), columnFamilies);
   db->SyncWAL();
+  closeColumnFamilies();
   db.reset();
   state.store(NOT_INITIALIZED);
 }
@@ -101,8 +157,8 @@ void RocksDBWrapper::destroy() {
 
   logger(WARNING) << "Destroying DB in " << dataDir;
 
-  rocksdb::Options dbOptions = getDBOptions(m_config);
-  rocksdb::Status status = rocksdb::DestroyDB(dataDir, dbOptions);
+  rocksdb::Options dbOptions(getDBOptions(m_config), getColumnFamilyOptions(m_config));
+  rocksdb::Status status = rocksdb::DestroyDB(dataDir, dbOptions, getColumnFamilyDescriptors(m_config));
 
   if (status.ok()) {
     logger(WARNING) << "DB destroyed in " << dataDir;
@@ -145,12 +201,12 @@ std::error_code RocksDBWrapper::write(IWriteBatch& batch, bool sync) {
   rocksdb::WriteBatch rocksdbBatch;
   std::vector<std::pair<std::string, std::string>> rawData(batch.extractRawDataToInsert());
   for (const std::pair<std::string, std::string>& kvPair : rawData) {
-    rocksdbBatch.Put(rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
+    rocksdbBatch.Put(getColumnFamily(kvPair.first), rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
   }
 
   std::vector<std::string> rawKeys(batch.extractRawKeysToRemove());
   for (const std::string& key : rawKeys) {
-    rocksdbBatch.Delete(rocksdb::Slice(key));
+    rocksdbBatch.Delete(getColumnFamily(key), rocksdb::Slice(key));
   }
 
   rocksdb::Status status = db->Write(writeOptions, &rocksdbBatch);
@@ -164,53 +220,72 @@ std::error_code RocksDBWrapper::write(IWriteBatch& batch, bool sync) {
 }
 
 std::error_code RocksDBWrapper::read(IReadBatch& batch) {
+  return read(batch, nullptr);
+}
+
+std::error_code RocksDBWrapper::read(IReadBatch& batch, const rocksdb::Snapshot* snapshot) {
   if (state.load() != INITIALIZED) {
     throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
   }
 
   rocksdb::ReadOptions readOptions;
+  readOptions.snapshot = snapshot;
 
   std::vector<std::string> rawKeys(batch.getRawKeys());
   std::vector<rocksdb::Slice> keySlices;
+  std::vector<rocksdb::ColumnFamilyHandle*> keyFamilies;
   keySlices.reserve(rawKeys.size());
+  keyFamilies.reserve(rawKeys.size());
   for (const std::string& key : rawKeys) {
     keySlices.emplace_back(rocksdb::Slice(key));
+    keyFamilies.push_back(getColumnFamily(key));
   }
 
-  std::vector<std::string> values;
-  values.reserve(rawKeys.size());
-  std::vector<rocksdb::Status> statuses = db->MultiGet(readOptions, keySlices, &values);
+  // values stay pinned in the block cache until the batch has deserialized them
+  std::vector<rocksdb::PinnableSlice> values(rawKeys.size());
+  std::vector<rocksdb::Status> statuses(rawKeys.size());
+  db->MultiGet(readOptions, rawKeys.size(), keyFamilies.data(), keySlices.data(), values.data(), statuses.data());
 
-  std::error_code error;
+  std::vector<std::string_view> valueViews;
   std::vector<bool> resultStates;
-  for (const rocksdb::Status& status : statuses) {
-    if (!status.ok() && !status.IsNotFound()) {
+  valueViews.reserve(rawKeys.size());
+  for (size_t i = 0; i < statuses.size(); ++i) {
+    if (!statuses[i].ok() && !statuses[i].IsNotFound()) {
       return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
     }
-    resultStates.push_back(status.ok());
+
+    resultStates.push_back(statuses[i].ok());
+    valueViews.emplace_back(values[i].data(), values[i].size());
   }
 
-  batch.submitRawResult(values, resultStates);
+  batch.submitRawResult(valueViews, resultStates);
   return std::error_code();
 }
 
 std::error_code RocksDBWrapper::readThreadSafe(IReadBatch &batch) {
+  return readThreadSafe(batch, nullptr);
+}
+
+std::error_code RocksDBWrapper::readThreadSafe(IReadBatch& batch, const rocksdb::Snapshot* snapshot) {
   if (state.load() != INITIALIZED) {
     throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
   }
 
   rocksdb::ReadOptions readOptions;
+  readOptions.snapshot = snapshot;
   std::vector<std::string> rawKeys(batch.getRawKeys());
   if (rawKeys.size() == 0) {
     logger(ERROR) << "RocksDBWrapper::read: detected rawKeys.size() == 0!";
     return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
   }
 
-  std::vector<std::string> values(rawKeys.size());
+  std::vector<rocksdb::PinnableSlice> values(rawKeys.size());
+  std::vector<std::string_view> valueViews;
   std::vector<bool> resultStates;
+  valueViews.reserve(rawKeys.size());
   int i = 0;
   for (const std::string &key : rawKeys) {
-    const rocksdb::Status status = db->Get(readOptions, rocksdb::Slice(key), &values[i]);
+    const rocksdb::Status status = db->Get(readOptions, getColumnFamily(key), rocksdb::Slice(key), &values[i]);
     if (status.ok()) {
       resultStates.push_back(true);
     } else {
@@ -220,14 +295,132 @@ std::error_code RocksDBWrapper::readThreadSafe(IReadBatch &batch) {
 
       resultStates.push_back(false);
     }
+    valueViews.emplace_back(values[i].data(), values[i].size());
     i++;
   }
 
-  batch.submitRawResult(values, resultStates);
+  batch.submitRawResult(valueViews, resultStates);
+  return std::error_code();
+}
+
+// Pins a rocksdb snapshot, reads go through the wrapper with it set in the read options
+class RocksDBWrapper::Snapshot : public IDataBase {
+public:
+  Snapshot(RocksDBWrapper& wrapper) : wrapper(wrapper), snapshot(wrapper.db->GetSnapshot()) {
+  }
+
+  ~Snapshot() override {
+    wrapper.db->ReleaseSnapshot(snapshot);
+  }
+
+  void init() override {
+  }
+
+  void shutdown() override {
+  }
+
+  void destroy() override {
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR), "Database snapshot is read-only");
+  }
+
+  void recreate() override {
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR), "Database snapshot is read-only");
+  }
+
+  std::error_code write(IWriteBatch& batch) override {
+    return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+  }
+
+  std::error_code writeSync(IWriteBatch& batch) override {
+    return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+  }
+
+  std::error_code read(IReadBatch& batch) override {
+    return wrapper.read(batch, snapshot);
+  }
+
+  std::error_code readThreadSafe(IReadBatch& batch) override {
+    return wrapper.readThreadSafe(batch, snapshot);
+  }
+
+  std::error_code migrateStorageLayout() override {
+    return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+  }
+
+  std::unique_ptr<IDataBase> createSnapshot() override {
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR), "Snapshots are taken from the database itself");
+  }
+
+private:
+  RocksDBWrapper& wrapper;
+  const rocksdb::Snapshot* snapshot;
+};
+
+std::unique_ptr<IDataBase> RocksDBWrapper::createSnapshot() {
+  if (state.load() != INITIALIZED) {
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
+  }
+
+  return std::unique_ptr<IDataBase>(new Snapshot(*this));
+}
+
+std::error_code RocksDBWrapper::migrateStorageLayout() {
+  if (state.load() != INITIALIZED) {
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
+  }
+
+  // Databases created before the column family split keep every record in the default family.
+  // Records are moved in chunks; an interrupted migration is simply repeated on the next start,
+  // as the scheme version is only updated once this returns.
+  rocksdb::ColumnFamilyHandle* defaultFamily = columnFamilies[DEFAULT_FAMILY];
+  std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(rocksdb::ReadOptions(), defaultFamily));
+
+  rocksdb::WriteBatch rocksdbBatch;
+  size_t movedCount = 0;
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    rocksdb::ColumnFamilyHandle* family = getColumnFamily(it->key().ToString());
+    if (family == defaultFamily) {
+      continue;
+    }
+
+    rocksdbBatch.Put(family, it->key(), it->value());
+    rocksdbBatch.Delete(defaultFamily, it->key());
+    ++movedCount;
+
+    if (movedCount % MIGRATION_BATCH_SIZE == 0) {
+      rocksdb::Status status = db->Write(rocksdb::WriteOptions(), &rocksdbBatch);
+      if (!status.ok()) {
+        logger(ERROR) << "Can't write to DB while migrating records. " << status.ToString();
+        return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+      }
+
+      rocksdbBatch.Clear();
+      logger(INFO) << "Moved " << movedCount << " records to column families";
+    }
+  }
+
+  if (!it->status().ok()) {
+    logger(ERROR) << "Can't iterate DB while migrating records. " << it->status().ToString();
+    return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+  }
+
+  it.reset();
+
+  rocksdb::WriteOptions writeOptions;
+  writeOptions.sync = true;
+  rocksdb::Status status = db->Write(writeOptions, &rocksdbBatch);
+  if (!status.ok()) {
+    logger(ERROR) << "Can't write to DB while migrating records. " << status.ToString();
+    return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+  }
+
+  logger(INFO) << "Moved " << movedCount << " records to column families, compacting";
+  db->CompactRange(rocksdb::CompactRangeOptions(), defaultFamily, nullptr, nullptr);
+
   return std::error_code();
 }
 
-rocksdb::Options RocksDBWrapper::getDBOptions(const DataBaseConfig &config) {
+rocksdb::DBOptions RocksDBWrapper::getDBOptions(const DataBaseConfig &config) {
   rocksdb::DBOptions dbOptions;
   dbOptions.IncreaseParallelism(config.getBackgroundThreadsCount());
   dbOptions.info_log_level = rocksdb::InfoLogLevel::WARN_LEVEL;
@@ -240,6 +433,13 @@ rocksdb::Options RocksDBWrapper::getDBOptions(const DataBaseConfig &config) {
   dbOptions.compaction_readahead_size = 2 * 1024 * 1024;
   dbOptions.new_table_reader_for_compaction_inputs = true;
 
+  // databases created before the column family split only have the default one
+  dbOptions.create_missing_column_families = true;
+
+  return dbOptions;
+}
+
+rocksdb::ColumnFamilyOptions RocksDBWrapper::getColumnFamilyOptions(const DataBaseConfig &config) {
   rocksdb::ColumnFamilyOptions fOptions;
   fOptions.write_buffer_size = static_cast<size_t>(config.getWriteBufferSize());
   // merge two memtables when flushing to L0
@@ -287,12 +487,53 @@ rocksdb::Options RocksDBWrapper::getDBOptions(const DataBaseConfig &config) {
 
   fOptions.bottommost_compression = config.getCompressionEnabled() ? rocksdb::kZSTD : rocksdb::kNoCompression;;
   
-  rocksdb::BlockBasedTableOptions tableOptions;
-  tableOptions.block_cache = rocksdb::NewLRUCache(config.getReadCacheSize());
-  std::shared_ptr<rocksdb::TableFactory> tfp(NewBlockBasedTableFactory(tableOptions));
-  fOptions.table_factory = tfp;
+  return fOptions;
+}
+
+std::vector<rocksdb::ColumnFamilyDescriptor> RocksDBWrapper::getColumnFamilyDescriptors(const DataBaseConfig &config) {
+  // raw blocks get a quarter of the read cache to themselves, so that streaming them
+  // to peers can't evict the indexes and filters of the point lookup tables
+  std::shared_ptr<rocksdb::Cache> blocksCache = rocksdb::NewLRUCache(config.getReadCacheSize() / 4);
+  std::shared_ptr<rocksdb::Cache> recordsCache = rocksdb::NewLRUCache(config.getReadCacheSize() - config.getReadCacheSize() / 4);
+  std::shared_ptr<const rocksdb::FilterPolicy> bloomFilter(rocksdb::NewBloomFilterPolicy(10, false));
+
+  std::vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+  for (size_t family = 0; family < FAMILIES_COUNT; ++family) {
+    rocksdb::ColumnFamilyOptions fOptions = getColumnFamilyOptions(config);
+    rocksdb::BlockBasedTableOptions tableOptions;
+    tableOptions.block_cache = recordsCache;
+
+    switch (family) {
+    case BLOCKS_FAMILY:
+      tableOptions.block_cache = blocksCache;
+      tableOptions.block_size = 64 * 1024;
+
+      // blocks repeat a lot of structure, a shared dictionary shrinks them much better than per block compression
+      fOptions.compression_opts.max_dict_bytes = 16 * 1024;
+      fOptions.compression_opts.zstd_max_train_bytes = 100 * fOptions.compression_opts.max_dict_bytes;
+      fOptions.bottommost_compression_opts = fOptions.compression_opts;
+      fOptions.bottommost_compression_opts.enabled = true;
+      break;
+    case KEY_IMAGES_FAMILY:
+    case OUTPUTS_FAMILY:
+      // most key image lookups are misses, the filters have to stay in memory for them to be cheap
+      tableOptions.filter_policy = bloomFilter;
+      tableOptions.cache_index_and_filter_blocks = true;
+      tableOptions.pin_l0_filter_and_index_blocks_in_cache = true;
+      break;
+    case BLOCK_INDEXES_FAMILY:
+    case TRANSACTIONS_FAMILY:
+      tableOptions.filter_policy = bloomFilter;
+      break;
+    default:
+      break;
+    }
 
-  return rocksdb::Options(dbOptions, fOptions);
+    fOptions.table_factory.reset(rocksdb::NewBlockBasedTableFactory(tableOptions));
+    descriptors.emplace_back(COLUMN_FAMILY_NAMES[family], fOptions);
+  }
+
+  return descriptors;
 }
 
 std::string RocksDBWrapper::getDataDir(const DataBaseConfig& config) {
@@ -302,3 +543,20 @@ std::string RocksDBWrapper::getDataDir(const DataBaseConfig& config) {
     return config.getDataDir() + '/' + DB_NAME;
   }
 }
+
+rocksdb::ColumnFamilyHandle* RocksDBWrapper::getColumnFamily(const std::string& rawKey) const {
+  auto it = PREFIX_TO_COLUMN_FAMILY.find(DB::getKeyPrefix(rawKey));
+  if (it == PREFIX_TO_COLUMN_FAMILY.end()) {
+    return columnFamilies[DEFAULT_FAMILY];
+  }
+
+  return columnFamilies[it->second];
+}
+
+void RocksDBWrapper::closeColumnFamilies() {
+  for (rocksdb::ColumnFamilyHandle* family : columnFamilies) {
+    db->DestroyColumnFamilyHandle(family);
+  }
+
+  columnFamilies.clear();
+}
@@ -21,6 +21,7 @@
 #include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "rocksdb/db.h"
 
@@ -51,13 +52,24 @@ public:
   std::error_code writeSync(IWriteBatch& batch) override;
   std::error_code read(IReadBatch& batch) override;
   std::error_code readThreadSafe(IReadBatch &batch) override;
+  std::error_code migrateStorageLayout() override;
+  std::unique_ptr<IDataBase> createSnapshot() override;
 
 private:
+  class Snapshot;
+
   std::error_code write(IWriteBatch& batch, bool sync);
+  std::error_code read(IReadBatch& batch, const rocksdb::Snapshot* snapshot);
+  std::error_code readThreadSafe(IReadBatch& batch, const rocksdb::Snapshot* snapshot);
 
-  rocksdb::Options getDBOptions(const DataBaseConfig& config);
+  rocksdb::DBOptions getDBOptions(const DataBaseConfig& config);
+  rocksdb::ColumnFamilyOptions getColumnFamilyOptions(const DataBaseConfig& config);
+  std::vector<rocksdb::ColumnFamilyDescriptor> getColumnFamilyDescriptors(const DataBaseConfig& config);
   std::string getDataDir(const DataBaseConfig& config);
 
+  rocksdb::ColumnFamilyHandle* getColumnFamily(const std::string& rawKey) const;
+  void closeColumnFamilies();
+
   enum State {
     NOT_INITIALIZED,
     INITIALIZED
@@ -65,6 +77,8 @@ private:
 
   Logging::LoggerRef logger;
   std::unique_ptr<rocksdb::DB> db;
+  // indexed by the ColumnFamily enum, owned by db
+  std::vector<rocksdb::ColumnFamilyHandle*> columnFamilies;
   std::atomic<State> state;
   const DataBaseConfig m_config;
 };
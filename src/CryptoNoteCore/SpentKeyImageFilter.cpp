@@ -0,0 +1,220 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SpentKeyImageFilter.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "crypto/random.h"
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "Serialization/ISerializer.h"
+#include "Serialization/SerializationOverloads.h"
+
+namespace CryptoNote {
+
+namespace {
+
+const uint32_t SPENT_KEY_IMAGE_FILTER_VERSION = 1;
+
+const uint64_t FIRST_LAYER_CAPACITY = 1 << 20;
+// 12 bits per key image and 5 of them set in a 512-bit block keep false positives near 1%
+const uint64_t BITS_PER_KEY_IMAGE_SLOT = 12;
+const unsigned BITS_PER_KEY_IMAGE = 5;
+const uint64_t WORDS_PER_BLOCK = 8;
+const uint64_t BITS_PER_BLOCK = WORDS_PER_BLOCK * 64;
+
+uint64_t mix(uint64_t value) {
+  // splitmix64 finalizer
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9ULL;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111ebULL;
+  value ^= value >> 31;
+  return value;
+}
+
+}
+
+void SpentKeyImageFilter::Layer::serialize(ISerializer& s) {
+  s(capacity, "capacity");
+  s(keyImageCount, "key_image_count");
+
+  uint64_t wordCount = words.size();
+  s(wordCount, "word_count");
+  if (s.type() == ISerializer::INPUT) {
+    if (wordCount % WORDS_PER_BLOCK != 0 || wordCount == 0) {
+      throw std::runtime_error("Wrong spent key image filter layer size");
+    }
+
+    words.resize(wordCount);
+  }
+
+  s.binary(words.data(), words.size() * sizeof(uint64_t), "words");
+}
+
+SpentKeyImageFilter::SpentKeyImageFilter() {
+  clear();
+}
+
+bool SpentKeyImageFilter::mayContain(const Crypto::KeyImage& keyImage) const {
+  uint64_t keyImageHash = hash(keyImage);
+  for (const auto& layer : m_layers) {
+    if (layerContains(layer, keyImageHash)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void SpentKeyImageFilter::add(const Crypto::KeyImage& keyImage) {
+  if (m_layers.back().keyImageCount >= m_layers.back().capacity) {
+    addLayer(m_layers.back().capacity * 2);
+  }
+
+  Layer& layer = m_layers.back();
+  uint64_t keyImageHash = hash(keyImage);
+  uint64_t* block = &layer.words[blockOffset(layer, keyImageHash)];
+
+  uint64_t bits = mix(keyImageHash);
+  for (unsigned i = 0; i < BITS_PER_KEY_IMAGE; ++i, bits >>= 9) {
+    block[(bits & 511) / 64] |= uint64_t(1) << (bits & 63);
+  }
+
+  ++layer.keyImageCount;
+}
+
+void SpentKeyImageFilter::markRemoved(uint64_t keyImageCount) {
+  m_removedCount += keyImageCount;
+}
+
+bool SpentKeyImageFilter::isWorthRebuilding() const {
+  return m_removedCount > getKeyImageCount() / 4;
+}
+
+void SpentKeyImageFilter::clear() {
+  m_seed = Random::randomValue<uint64_t>();
+  m_layers.clear();
+  m_removedCount = 0;
+  m_blockCount = 0;
+  m_lastBlockHash = Crypto::Hash();
+  addLayer(FIRST_LAYER_CAPACITY);
+}
+
+uint32_t SpentKeyImageFilter::getBlockCount() const {
+  return m_blockCount;
+}
+
+const Crypto::Hash& SpentKeyImageFilter::getLastBlockHash() const {
+  return m_lastBlockHash;
+}
+
+void SpentKeyImageFilter::setTop(uint32_t blockCount, const Crypto::Hash& lastBlockHash) {
+  m_blockCount = blockCount;
+  m_lastBlockHash = lastBlockHash;
+}
+
+uint64_t SpentKeyImageFilter::getKeyImageCount() const {
+  uint64_t count = 0;
+  for (const auto& layer : m_layers) {
+    count += layer.keyImageCount;
+  }
+
+  return count;
+}
+
+size_t SpentKeyImageFilter::getMemoryUsage() const {
+  size_t size = 0;
+  for (const auto& layer : m_layers) {
+    size += layer.words.size() * sizeof(uint64_t);
+  }
+
+  return size;
+}
+
+void SpentKeyImageFilter::serialize(ISerializer& s) {
+  uint32_t version = SPENT_KEY_IMAGE_FILTER_VERSION;
+  s(version, "version");
+  if (version != SPENT_KEY_IMAGE_FILTER_VERSION) {
+    throw std::runtime_error("Unsupported spent key image filter version");
+  }
+
+  s(m_seed, "seed");
+  s(m_removedCount, "removed_count");
+  s(m_blockCount, "block_count");
+  s(m_lastBlockHash, "last_block_hash");
+
+  size_t layerCount = m_layers.size();
+  s.beginArray(layerCount, "layers");
+  if (s.type() == ISerializer::INPUT) {
+    if (layerCount == 0) {
+      throw std::runtime_error("Spent key image filter has no layers");
+    }
+
+    m_layers.resize(layerCount);
+  }
+
+  for (auto& layer : m_layers) {
+    s.beginObject("");
+    layer.serialize(s);
+    s.endObject();
+  }
+
+  s.endArray();
+}
+
+uint64_t SpentKeyImageFilter::hash(const Crypto::KeyImage& keyImage) const {
+  // key images are already uniformly distributed, the seed only keeps anyone from aiming at a block
+  uint64_t words[4];
+  static_assert(sizeof(words) == sizeof(keyImage), "Unexpected key image size");
+  std::memcpy(words, &keyImage, sizeof(words));
+
+  return mix(words[0] ^ m_seed) ^ mix(words[1] ^ words[2] ^ words[3] ^ ~m_seed);
+}
+
+void SpentKeyImageFilter::addLayer(uint64_t capacity) {
+  uint64_t blockCount = (capacity * BITS_PER_KEY_IMAGE_SLOT + BITS_PER_BLOCK - 1) / BITS_PER_BLOCK;
+
+  Layer layer;
+  layer.words.resize(blockCount * WORDS_PER_BLOCK);
+  layer.capacity = capacity;
+  layer.keyImageCount = 0;
+  m_layers.push_back(std::move(layer));
+}
+
+size_t SpentKeyImageFilter::blockOffset(const Layer& layer, uint64_t hash) {
+  // maps the upper half of the hash onto [0, block count) without a division
+  uint64_t blockCount = layer.words.size() / WORDS_PER_BLOCK;
+  return static_cast<size_t>(((hash >> 32) * blockCount) >> 32) * WORDS_PER_BLOCK;
+}
+
+bool SpentKeyImageFilter::layerContains(const Layer& layer, uint64_t hash) {
+  const uint64_t* block = &layer.words[blockOffset(layer, hash)];
+
+  uint64_t bits = mix(hash);
+  for (unsigned i = 0; i < BITS_PER_KEY_IMAGE; ++i, bits >>= 9) {
+    if ((block[(bits & 511) / 64] & (uint64_t(1) << (bits & 63))) == 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}
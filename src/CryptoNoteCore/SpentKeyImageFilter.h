@@ -0,0 +1,80 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "CryptoTypes.h"
+
+namespace CryptoNote {
+
+class ISerializer;
+
+// Probabilistic set of the key images spent in the main chain, checked before the database is
+// asked whether a key image is spent. A negative answer is exact, a positive one has to be
+// confirmed by the database.
+//
+// It is a scalable blocked bloom filter: a key image sets BITS_PER_KEY_IMAGE bits inside a single
+// 512-bit block of a layer, so a lookup reads one cache line per layer, and a twice larger layer
+// is added when the last one fills up. Bits can't be cleared, so key images of rolled back blocks
+// stay in the filter and are only counted; once there are many of them the filter should be
+// rebuilt.
+class SpentKeyImageFilter {
+public:
+  SpentKeyImageFilter();
+
+  bool mayContain(const Crypto::KeyImage& keyImage) const;
+  void add(const Crypto::KeyImage& keyImage);
+  void markRemoved(uint64_t keyImageCount);
+  bool isWorthRebuilding() const;
+  void clear();
+
+  // the filter holds the key images of the first blockCount blocks, the last of them is lastBlockHash
+  uint32_t getBlockCount() const;
+  const Crypto::Hash& getLastBlockHash() const;
+  void setTop(uint32_t blockCount, const Crypto::Hash& lastBlockHash);
+
+  uint64_t getKeyImageCount() const;
+  size_t getMemoryUsage() const;
+
+  void serialize(ISerializer& s);
+
+private:
+  struct Layer {
+    std::vector<uint64_t> words;
+    uint64_t capacity;
+    uint64_t keyImageCount;
+
+    void serialize(ISerializer& s);
+  };
+
+  uint64_t m_seed;
+  std::vector<Layer> m_layers;
+  uint64_t m_removedCount;
+  uint32_t m_blockCount;
+  Crypto::Hash m_lastBlockHash;
+
+  uint64_t hash(const Crypto::KeyImage& keyImage) const;
+  void addLayer(uint64_t capacity);
+  static size_t blockOffset(const Layer& layer, uint64_t hash);
+  static bool layerContains(const Layer& layer, uint64_t hash);
+};
+
+}
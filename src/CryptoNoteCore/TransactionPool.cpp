@@ -19,8 +19,12 @@
 
 #include "TransactionPool.h"
 
+#include <algorithm>
+#include <unordered_set>
+
 #include "Common/int-util.h"
 #include "CryptoNoteBasicImpl.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/TransactionExtra.h"
 
 namespace CryptoNote {
@@ -51,6 +55,10 @@ const Crypto::Hash& TransactionPool::PendingTransactionInfo::getTransactionHash(
   return cachedTransaction.getTransactionHash();
 }
 
+size_t TransactionPool::PendingTransactionInfo::getTransactionSize() const {
+  return cachedTransaction.getTransactionBinaryArray().size();
+}
+
 size_t TransactionPool::PaymentIdHasher::operator() (const boost::optional<Crypto::Hash>& paymentId) const {
   if (!paymentId) {
     return std::numeric_limits<size_t>::max();
@@ -63,11 +71,15 @@ TransactionPool::TransactionPool(Logging::ILogger& logger) :
   transactionHashIndex(transactions.get<TransactionHashTag>()),
   transactionCostIndex(transactions.get<TransactionCostTag>()),
   paymentIdIndex(transactions.get<PaymentIdTag>()),
+  transactionSizeIndex(transactions.get<TransactionSizeTag>()),
+  mixinIndex(transactions.get<MixinTag>()),
+  version(0),
   logger(logger, "TransactionPool") {
 }
 
 bool TransactionPool::pushTransaction(CachedTransaction&& transaction, TransactionValidatorState&& transactionState) {
   auto pendingTx = PendingTransactionInfo{static_cast<uint64_t>(time(nullptr)), std::move(transaction)};
+  pendingTx.mixin = getTransactionMixin(pendingTx.cachedTransaction.getTransaction());
 
   Crypto::Hash paymentId;
   if(getPaymentIdFromTxExtra(pendingTx.cachedTransaction.getTransaction().extra, paymentId)) {
@@ -88,7 +100,17 @@ bool TransactionPool::pushTransaction(CachedTransaction&& transaction, Transacti
 
   mergeStates(poolState, transactionState);
 
-  logger(Logging::DEBUGGING) << "pushed transaction " << pendingTx.getTransactionHash() << " to pool";
+  const Crypto::Hash transactionHash = pendingTx.getTransactionHash();
+  for (const auto& keyImage : transactionState.spentKeyImages) {
+    keyImageTransactions.emplace(keyImage, transactionHash);
+  }
+
+  for (const auto& output : transactionState.spentMultisignatureGlobalIndexes) {
+    multisignatureOutputTransactions.emplace(output, transactionHash);
+  }
+
+  logger(Logging::DEBUGGING) << "pushed transaction " << transactionHash << " to pool";
+  ++version;
   return transactionHashIndex.emplace(std::move(pendingTx)).second;
 }
 
@@ -119,7 +141,17 @@ bool TransactionPool::removeTransaction(const Crypto::Hash& hash) {
   }
 
   excludeFromState(poolState, it->cachedTransaction);
+  for (const auto& input : it->cachedTransaction.getTransaction().inputs) {
+    if (input.type() == typeid(KeyInput)) {
+      keyImageTransactions.erase(boost::get<KeyInput>(input).keyImage);
+    } else if (input.type() == typeid(MultisignatureInput)) {
+      const auto& in = boost::get<MultisignatureInput>(input);
+      multisignatureOutputTransactions.erase({in.amount, in.outputIndex});
+    }
+  }
+
   transactionHashIndex.erase(it);
+  ++version;
 
   logger(Logging::DEBUGGING) << "transaction " << hash << " removed from pool";
   return true;
@@ -183,4 +215,107 @@ std::vector<Crypto::Hash> TransactionPool::getTransactionHashesByPaymentId(const
   return transactionHashes;
 }
 
+std::vector<Crypto::Hash> TransactionPool::getTransactionHashesSpendingOutputs(const TransactionValidatorState& state) const {
+  std::lock_guard<decltype(m_transactions_lock)> lock(m_transactions_lock);
+  // a transaction spending several of the outputs is found once per output
+  std::unordered_set<Crypto::Hash> transactionHashes;
+  for (const auto& keyImage : state.spentKeyImages) {
+    auto it = keyImageTransactions.find(keyImage);
+    if (it != keyImageTransactions.end()) {
+      transactionHashes.insert(it->second);
+    }
+  }
+
+  for (const auto& output : state.spentMultisignatureGlobalIndexes) {
+    auto it = multisignatureOutputTransactions.find(output);
+    if (it != multisignatureOutputTransactions.end()) {
+      transactionHashes.insert(it->second);
+    }
+  }
+
+  return std::vector<Crypto::Hash>(transactionHashes.begin(), transactionHashes.end());
+}
+
+std::vector<Crypto::Hash> TransactionPool::getTransactionHashesBiggerThan(size_t size) const {
+  std::lock_guard<decltype(m_transactions_lock)> lock(m_transactions_lock);
+  std::vector<Crypto::Hash> transactionHashes;
+  for (auto it = transactionSizeIndex.upper_bound(size); it != transactionSizeIndex.end(); ++it) {
+    transactionHashes.push_back(it->getTransactionHash());
+  }
+
+  return transactionHashes;
+}
+
+std::vector<Crypto::Hash> TransactionPool::getTransactionHashesByMixin(uint64_t minMixin, uint64_t maxMixin) const {
+  std::lock_guard<decltype(m_transactions_lock)> lock(m_transactions_lock);
+  std::vector<Crypto::Hash> transactionHashes;
+  if (minMixin > maxMixin) {
+    return transactionHashes;
+  }
+
+  auto end = mixinIndex.upper_bound(maxMixin);
+  for (auto it = mixinIndex.lower_bound(minMixin); it != end; ++it) {
+    transactionHashes.push_back(it->getTransactionHash());
+  }
+
+  return transactionHashes;
+}
+
+uint64_t TransactionPool::getVersion() const {
+  std::lock_guard<decltype(m_transactions_lock)> lock(m_transactions_lock);
+  return version;
+}
+
+// Pool transactions never spend the same outputs, so they are taken as they come in the cost index.
+// The walk stops as soon as not even the smallest pool transaction would fit.
+uint64_t TransactionPool::selectBlockTemplateTransactions(size_t fusionTxMaxSize, size_t medianSize, size_t maxTotalSize,
+  std::vector<Crypto::Hash>& transactionHashes, size_t& transactionsSize, uint64_t& fee) const {
+  std::lock_guard<decltype(m_transactions_lock)> lock(m_transactions_lock);
+  transactionHashes.clear();
+  transactionsSize = 0;
+  fee = 0;
+
+  if (transactionSizeIndex.empty()) {
+    return version;
+  }
+
+  const size_t smallestSize = transactionSizeIndex.begin()->getTransactionSize();
+
+  // fusion transactions have no fee and are at the end of the cost index
+  std::unordered_set<Crypto::Hash> fusionTransactions;
+  for (auto it = transactionCostIndex.rbegin(); it != transactionCostIndex.rend() && it->cachedTransaction.getTransactionFee() == 0; ++it) {
+    if (fusionTxMaxSize < transactionsSize + smallestSize) {
+      break;
+    }
+
+    if (fusionTxMaxSize < transactionsSize + it->getTransactionSize()) {
+      continue;
+    }
+
+    transactionHashes.push_back(it->getTransactionHash());
+    fusionTransactions.insert(it->getTransactionHash());
+    transactionsSize += it->getTransactionSize();
+  }
+
+  const size_t sizeLimit = std::max(medianSize, maxTotalSize);
+  for (const auto& transactionItem : transactionCostIndex) {
+    if (sizeLimit < transactionsSize + smallestSize) {
+      break;
+    }
+
+    uint64_t transactionFee = transactionItem.cachedTransaction.getTransactionFee();
+    size_t blockSizeLimit = transactionFee == 0 ? medianSize : maxTotalSize;
+    if (blockSizeLimit < transactionsSize + transactionItem.getTransactionSize() ||
+        (transactionFee == 0 && fusionTransactions.count(transactionItem.getTransactionHash()) != 0)) {
+      continue;
+    }
+
+    transactionHashes.push_back(transactionItem.getTransactionHash());
+    transactionsSize += transactionItem.getTransactionSize();
+    fee += transactionFee;
+  }
+
+  return version;
+}
+
 }
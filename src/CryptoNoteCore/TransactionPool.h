@@ -18,6 +18,7 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
+#include <map>
 #include <unordered_map>
 
 #include "crypto/crypto.h"
@@ -55,6 +56,14 @@ public:
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const override;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
+
+  virtual std::vector<Crypto::Hash> getTransactionHashesSpendingOutputs(const TransactionValidatorState& state) const override;
+  virtual std::vector<Crypto::Hash> getTransactionHashesBiggerThan(size_t size) const override;
+  virtual std::vector<Crypto::Hash> getTransactionHashesByMixin(uint64_t minMixin, uint64_t maxMixin) const override;
+
+  virtual uint64_t getVersion() const override;
+  virtual uint64_t selectBlockTemplateTransactions(size_t fusionTxMaxSize, size_t medianSize, size_t maxTotalSize,
+    std::vector<Crypto::Hash>& transactionHashes, size_t& transactionsSize, uint64_t& fee) const override;
 private:
   TransactionValidatorState poolState;
 
@@ -62,8 +71,10 @@ private:
     uint64_t receiveTime;
     CachedTransaction cachedTransaction;
     boost::optional<Crypto::Hash> paymentId;
+    uint64_t mixin;
 
     const Crypto::Hash& getTransactionHash() const;
+    size_t getTransactionSize() const;
   };
 
   struct TransactionPriorityComparator {
@@ -74,6 +85,8 @@ private:
   struct TransactionHashTag {};
   struct TransactionCostTag {};
   struct PaymentIdTag {};
+  struct TransactionSizeTag {};
+  struct MixinTag {};
 
   typedef boost::multi_index::ordered_non_unique<
     boost::multi_index::tag<TransactionCostTag>,
@@ -100,12 +113,28 @@ private:
     PaymentIdHasher
   > PaymentIdIndex;
 
+  typedef boost::multi_index::ordered_non_unique<
+    boost::multi_index::tag<TransactionSizeTag>,
+    boost::multi_index::const_mem_fun<
+      PendingTransactionInfo,
+      size_t,
+      &PendingTransactionInfo::getTransactionSize
+    >
+  > TransactionSizeIndex;
+
+  typedef boost::multi_index::ordered_non_unique<
+    boost::multi_index::tag<MixinTag>,
+    BOOST_MULTI_INDEX_MEMBER(PendingTransactionInfo, uint64_t, mixin)
+  > MixinIndex;
+
   typedef boost::multi_index_container<
     PendingTransactionInfo,
     boost::multi_index::indexed_by<
       TransactionHashIndex,
       TransactionCostIndex,
-      PaymentIdIndex
+      PaymentIdIndex,
+      TransactionSizeIndex,
+      MixinIndex
     >
   > TransactionsContainer;
 
@@ -113,6 +142,13 @@ private:
   TransactionsContainer::index<TransactionHashTag>::type& transactionHashIndex;
   TransactionsContainer::index<TransactionCostTag>::type& transactionCostIndex;
   TransactionsContainer::index<PaymentIdTag>::type& paymentIdIndex;
+  TransactionsContainer::index<TransactionSizeTag>::type& transactionSizeIndex;
+  TransactionsContainer::index<MixinTag>::type& mixinIndex;
+
+  // Spent outputs of poolState mapped to the pool transaction spending them
+  std::unordered_map<Crypto::KeyImage, Crypto::Hash> keyImageTransactions;
+  std::map<std::pair<uint64_t, uint32_t>, Crypto::Hash> multisignatureOutputTransactions;
+  uint64_t version;
   
   mutable std::recursive_mutex m_transactions_lock;
 
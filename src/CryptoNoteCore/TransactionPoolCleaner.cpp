@@ -86,6 +86,27 @@ std::vector<Crypto::Hash> TransactionPoolCleanWrapper::getTransactionHashesByPay
   return transactionPool->getTransactionHashesByPaymentId(paymentId);
 }
 
+std::vector<Crypto::Hash> TransactionPoolCleanWrapper::getTransactionHashesSpendingOutputs(const TransactionValidatorState& state) const {
+  return transactionPool->getTransactionHashesSpendingOutputs(state);
+}
+
+std::vector<Crypto::Hash> TransactionPoolCleanWrapper::getTransactionHashesBiggerThan(size_t size) const {
+  return transactionPool->getTransactionHashesBiggerThan(size);
+}
+
+std::vector<Crypto::Hash> TransactionPoolCleanWrapper::getTransactionHashesByMixin(uint64_t minMixin, uint64_t maxMixin) const {
+  return transactionPool->getTransactionHashesByMixin(minMixin, maxMixin);
+}
+
+uint64_t TransactionPoolCleanWrapper::getVersion() const {
+  return transactionPool->getVersion();
+}
+
+uint64_t TransactionPoolCleanWrapper::selectBlockTemplateTransactions(size_t fusionTxMaxSize, size_t medianSize, size_t maxTotalSize,
+  std::vector<Crypto::Hash>& transactionHashes, size_t& transactionsSize, uint64_t& fee) const {
+  return transactionPool->selectBlockTemplateTransactions(fusionTxMaxSize, medianSize, maxTotalSize, transactionHashes, transactionsSize, fee);
+}
+
 std::vector<Crypto::Hash> TransactionPoolCleanWrapper::clean() {
   try {
     uint64_t currentTime = timeProvider->now();
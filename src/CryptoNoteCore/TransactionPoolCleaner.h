@@ -66,6 +66,14 @@ public:
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const override;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
 
+  virtual std::vector<Crypto::Hash> getTransactionHashesSpendingOutputs(const TransactionValidatorState& state) const override;
+  virtual std::vector<Crypto::Hash> getTransactionHashesBiggerThan(size_t size) const override;
+  virtual std::vector<Crypto::Hash> getTransactionHashesByMixin(uint64_t minMixin, uint64_t maxMixin) const override;
+
+  virtual uint64_t getVersion() const override;
+  virtual uint64_t selectBlockTemplateTransactions(size_t fusionTxMaxSize, size_t medianSize, size_t maxTotalSize,
+    std::vector<Crypto::Hash>& transactionHashes, size_t& transactionsSize, uint64_t& fee) const override;
+
   virtual std::vector<Crypto::Hash> clean() override;
 
 private:
@@ -25,7 +25,9 @@ TransactionValidator::TransactionValidator(
     const uint32_t blockHeight,
     const uint64_t blockSizeMedian,
     const uint64_t minFee,
-    const bool isPoolTransaction):
+    const bool isPoolTransaction,
+    CryptoNote::BlockSignatureBatch *signatureBatch,
+    const size_t transactionIndex):
     m_cachedTransaction(cachedTransaction),
     m_transaction(cachedTransaction.getTransaction()),
     m_validatorState(state),
@@ -37,7 +39,9 @@ TransactionValidator::TransactionValidator(
     m_blockSizeMedian(blockSizeMedian),
     m_minFee(minFee),
     m_isPoolTransaction(isPoolTransaction),
-    m_isFusion(false)
+    m_isFusion(false),
+    m_signatureBatch(signatureBatch),
+    m_transactionIndex(transactionIndex)
 {
 }
 
@@ -97,6 +101,22 @@ CryptoNote::TransactionValidationResult TransactionValidator::validate()
     m_validationResult.valid = true;
     m_validationResult.errorCode = CryptoNote::error::TransactionValidationError::VALIDATION_SUCCESS;
 
+    /* Hand the expensive checks over to the block-wide batch. This is done last,
+     * as the batch jobs overwrite m_validationResult if they fail */
+    if (m_signatureBatch != nullptr && !m_checkpoints.isInCheckpointZone(m_blockHeight + 1))
+    {
+        const CryptoNote::TransactionValidationResult result = m_validationResult;
+
+        queueTransactionInputsExpensive();
+
+        return result;
+    }
+
+    return m_validationResult;
+}
+
+const CryptoNote::TransactionValidationResult &TransactionValidator::getValidationResult() const
+{
     return m_validationResult;
 }
 
@@ -461,138 +481,184 @@ bool TransactionValidator::validateTransactionInputsExpensive()
         return true;
     }
 
-    uint64_t inputIndex = 0;
+    /* Queued by validate() once the cheap checks have passed */
+    if (m_signatureBatch != nullptr)
+    {
+        return true;
+    }
+
+    const Crypto::Hash prefixHash = m_cachedTransaction.getTransactionPrefixHash();
 
     std::vector<std::future<bool>> validationResults;
     std::atomic<bool> cancelValidation(false);
-    const Crypto::Hash prefixHash = m_cachedTransaction.getTransactionPrefixHash();
 
-    for (const auto &input : m_transaction.inputs)
+    for (size_t inputIndex = 0; inputIndex < m_transaction.inputs.size(); inputIndex++)
     {
         /* Validate each input on a separate thread in our thread pool */
-                        //emplace_back
-        validationResults.push_back(m_threadPool.addJob([inputIndex, &input, &prefixHash, &cancelValidation, this] {
-
+        validationResults.push_back(m_threadPool.addJob([inputIndex, &prefixHash, &cancelValidation, this] {
             if (cancelValidation.load())
             {
               return false; // fail the validation immediately if cancel requested
             }
 
-            if (input.type() == typeid(CryptoNote::KeyInput)) {
-                const CryptoNote::KeyInput &in = boost::get<CryptoNote::KeyInput>(input);
+            return validateTransactionInputExpensive(inputIndex, prefixHash);
+        }));
+    }
 
-                if (m_blockchainCache->checkIfSpent(in.keyImage, m_blockHeight))
-                {
-                    m_validationResult.errorCode = CryptoNote::error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT;
-                    m_validationResult.errorMessage = "Transaction contains key image that has already been spent";
+    bool valid = true;
 
-                    return false;
-                }
+    for (auto &result : validationResults)
+    {
+        if (!result.get())
+        {
+            valid = false;
+            cancelValidation.store(true);
+        }
+    }
 
-                std::vector<Crypto::PublicKey> outputKeys;
-                std::vector<uint32_t> globalIndexes(in.outputIndexes.size());
+    return valid;
+}
 
-                globalIndexes[0] = in.outputIndexes[0];
+void TransactionValidator::queueTransactionInputsExpensive()
+{
+    const Crypto::Hash prefixHash = m_cachedTransaction.getTransactionPrefixHash();
 
-                /* Convert output indexes from relative to absolute */
-                for (size_t i = 1; i < in.outputIndexes.size(); ++i)
-                {
-                    globalIndexes[i] = globalIndexes[i - 1] + in.outputIndexes[i];
-                }
+    for (size_t inputIndex = 0; inputIndex < m_transaction.inputs.size(); inputIndex++)
+    {
+        m_signatureBatch->addJob(m_transactionIndex, [inputIndex, prefixHash, this] {
+            return validateTransactionInputExpensive(inputIndex, prefixHash);
+        });
+    }
+}
 
-                const auto result = m_blockchainCache->extractKeyOutputKeys(
-                    in.amount,
-                    m_blockHeight,
-                    { globalIndexes.data(), globalIndexes.size() },
-                    outputKeys
-                );
+bool TransactionValidator::validateTransactionInputExpensive(const size_t inputIndex, const Crypto::Hash &prefixHash)
+{
+    /* The inputs are checked concurrently, so each check fills in its own
+     * result and only the failure of the lowest input is published */
+    CryptoNote::TransactionValidationResult result;
 
-                if (result == CryptoNote::ExtractOutputKeysResult::INVALID_GLOBAL_INDEX)
-                {
-                    m_validationResult.errorCode = CryptoNote::error::TransactionValidationError::INPUT_INVALID_GLOBAL_INDEX;
-                    m_validationResult.errorMessage = "Transaction contains invalid global indexes";
+    if (checkTransactionInputExpensive(inputIndex, prefixHash, result))
+    {
+        return true;
+    }
 
-                    return false;
-                }
+    std::lock_guard<std::mutex> lock(m_failedInputMutex);
 
-                if (result == CryptoNote::ExtractOutputKeysResult::OUTPUT_LOCKED)
-                {
-                    m_validationResult.errorCode = CryptoNote::error::TransactionValidationError::INPUT_SPEND_LOCKED_OUT;
-                    m_validationResult.errorMessage = "Transaction includes an input which is still locked";
+    if (inputIndex < m_failedInputIndex)
+    {
+        m_failedInputIndex = inputIndex;
+        m_validationResult.valid = false;
+        m_validationResult.errorCode = result.errorCode;
+        m_validationResult.errorMessage = result.errorMessage;
+    }
 
-                    return false;
-                }
+    return false;
+}
 
-                if (outputKeys.size() != m_transaction.signatures[inputIndex].size())
-                {
-                    m_validationResult.errorCode = CryptoNote::error::TransactionValidationError::INPUT_INVALID_SIGNATURES_COUNT;
-                    m_validationResult.errorMessage = "Transaction has an invalid number of signatures";
+bool TransactionValidator::checkTransactionInputExpensive(
+    const size_t inputIndex,
+    const Crypto::Hash &prefixHash,
+    CryptoNote::TransactionValidationResult &result) const
+{
+    const auto &input = m_transaction.inputs[inputIndex];
 
-                    return false;
-                }
+    if (input.type() == typeid(CryptoNote::KeyInput)) {
+        const CryptoNote::KeyInput &in = boost::get<CryptoNote::KeyInput>(input);
 
-                std::vector<const Crypto::PublicKey*> outputKeyPointers;
-                outputKeyPointers.reserve(outputKeys.size());
-                std::for_each(outputKeys.begin(), outputKeys.end(), [&outputKeyPointers](const Crypto::PublicKey& key) { outputKeyPointers.push_back(&key); });
-                if (!Crypto::check_ring_signature(prefixHash, in.keyImage, outputKeyPointers.data(),
-                    outputKeyPointers.size(), m_transaction.signatures[inputIndex].data(),
-                    m_blockHeight > CryptoNote::parameters::KEY_IMAGE_CHECKING_BLOCK_INDEX))
-                {
-                    m_validationResult.errorCode = CryptoNote::error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
-                    m_validationResult.errorMessage = "Transaction contains invalid signatures";
+        if (m_blockchainCache->checkIfSpent(in.keyImage, m_blockHeight))
+        {
+            result.errorCode = CryptoNote::error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT;
+            result.errorMessage = "Transaction contains key image that has already been spent";
 
-                    return false;
-                }
- 
-            } else if (input.type() == typeid(CryptoNote::MultisignatureInput)) {
-                const CryptoNote::MultisignatureInput& in = boost::get<CryptoNote::MultisignatureInput>(input);
-                CryptoNote::MultisignatureOutput output;
-           
-                size_t inputSignatureIndex = 0;
-                size_t outputKeyIndex = 0;
-                while (inputSignatureIndex < in.signatureCount) {
-                    if (outputKeyIndex == output.keys.size()) {
-                        m_validationResult.errorCode = CryptoNote::error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
-                        m_validationResult.errorMessage = "Transaction has input with invalid signature";
-
-                        return false;
-                    }
-
-                    if (Crypto::check_signature(prefixHash, output.keys[outputKeyIndex],
-                        m_transaction.signatures[inputIndex][inputSignatureIndex])) {
-                        ++inputSignatureIndex;
-                    }
-
-                    ++outputKeyIndex;
-                }
-            }
-            else {
-                assert(false);
-                m_validationResult.errorCode = CryptoNote::error::TransactionValidationError::INPUT_UNKNOWN_TYPE;
-                m_validationResult.errorMessage = "Transaction has input with unknown type";
+            return false;
+        }
 
-                return false;
-            }
+        std::vector<Crypto::PublicKey> outputKeys;
+        std::vector<uint32_t> globalIndexes(in.outputIndexes.size());
 
-            return true;
+        globalIndexes[0] = in.outputIndexes[0];
 
-        }));
+        /* Convert output indexes from relative to absolute */
+        for (size_t i = 1; i < in.outputIndexes.size(); ++i)
+        {
+            globalIndexes[i] = globalIndexes[i - 1] + in.outputIndexes[i];
+        }
 
-        inputIndex++;
-    }
+        const auto extractResult = m_blockchainCache->extractKeyOutputKeys(
+            in.amount,
+            m_blockHeight,
+            { globalIndexes.data(), globalIndexes.size() },
+            outputKeys
+        );
 
-    bool valid = true;
+        if (extractResult == CryptoNote::ExtractOutputKeysResult::INVALID_GLOBAL_INDEX)
+        {
+            result.errorCode = CryptoNote::error::TransactionValidationError::INPUT_INVALID_GLOBAL_INDEX;
+            result.errorMessage = "Transaction contains invalid global indexes";
 
-    for (auto &result : validationResults)
-    {
-        if (!result.get())
+            return false;
+        }
+
+        if (extractResult == CryptoNote::ExtractOutputKeysResult::OUTPUT_LOCKED)
         {
-            valid = false;
-            cancelValidation.store(true);
+            result.errorCode = CryptoNote::error::TransactionValidationError::INPUT_SPEND_LOCKED_OUT;
+            result.errorMessage = "Transaction includes an input which is still locked";
+
+            return false;
+        }
+
+        if (outputKeys.size() != m_transaction.signatures[inputIndex].size())
+        {
+            result.errorCode = CryptoNote::error::TransactionValidationError::INPUT_INVALID_SIGNATURES_COUNT;
+            result.errorMessage = "Transaction has an invalid number of signatures";
+
+            return false;
+        }
+
+        std::vector<const Crypto::PublicKey*> outputKeyPointers;
+        outputKeyPointers.reserve(outputKeys.size());
+        std::for_each(outputKeys.begin(), outputKeys.end(), [&outputKeyPointers](const Crypto::PublicKey& key) { outputKeyPointers.push_back(&key); });
+        if (!Crypto::check_ring_signature(prefixHash, in.keyImage, outputKeyPointers.data(),
+            outputKeyPointers.size(), m_transaction.signatures[inputIndex].data(),
+            m_blockHeight > CryptoNote::parameters::KEY_IMAGE_CHECKING_BLOCK_INDEX))
+        {
+            result.errorCode = CryptoNote::error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
+            result.errorMessage = "Transaction contains invalid signatures";
+
+            return false;
+        }
+
+    } else if (input.type() == typeid(CryptoNote::MultisignatureInput)) {
+        const CryptoNote::MultisignatureInput& in = boost::get<CryptoNote::MultisignatureInput>(input);
+        CryptoNote::MultisignatureOutput output;
+
+        size_t inputSignatureIndex = 0;
+        size_t outputKeyIndex = 0;
+        while (inputSignatureIndex < in.signatureCount) {
+            if (outputKeyIndex == output.keys.size()) {
+                result.errorCode = CryptoNote::error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
+                result.errorMessage = "Transaction has input with invalid signature";
+
+                return false;
+            }
+
+            if (Crypto::check_signature(prefixHash, output.keys[outputKeyIndex],
+                m_transaction.signatures[inputIndex][inputSignatureIndex])) {
+                ++inputSignatureIndex;
+            }
+
+            ++outputKeyIndex;
         }
     }
+    else {
+        assert(false);
+        result.errorCode = CryptoNote::error::TransactionValidationError::INPUT_UNKNOWN_TYPE;
+        result.errorMessage = "Transaction has input with unknown type";
 
-    return valid;
+        return false;
+    }
+
+    return true;
 }
 
 }
\ No newline at end of file
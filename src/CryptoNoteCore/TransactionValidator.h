@@ -8,9 +8,12 @@
 
 #pragma once
 
+#include <limits>
+#include <mutex>
 #include <system_error>
 
 #include "CryptoNote.h"
+#include "BlockSignatureBatch.h"
 #include "CachedTransaction.h"
 #include "Currency.h"
 #include "IBlockchainCache.h"
@@ -37,7 +40,9 @@ class TransactionValidator
             const uint32_t blockHeight,
             const uint64_t blockSizeMedian,
             const uint64_t minFee,
-            const bool isPoolTransaction);
+            const bool isPoolTransaction,
+            CryptoNote::BlockSignatureBatch *signatureBatch = nullptr,
+            const size_t transactionIndex = 0);
 
         /////////////////////////////
         /* PUBLIC MEMBER FUNCTIONS */
@@ -46,6 +51,10 @@ class TransactionValidator
 
         CryptoNote::TransactionValidationResult revalidateAfterHeightChange();
 
+        /* When a signature batch is used, validate() only reports the cheap
+         * checks - the final result is available here once the batch is done */
+        const CryptoNote::TransactionValidationResult &getValidationResult() const;
+
     private:
         //////////////////////////////
         /* PRIVATE MEMBER FUNCTIONS */
@@ -66,6 +75,15 @@ class TransactionValidator
 
         bool validateTransactionInputsExpensive();
 
+        void queueTransactionInputsExpensive();
+
+        bool validateTransactionInputExpensive(const size_t inputIndex, const Crypto::Hash &prefixHash);
+
+        bool checkTransactionInputExpensive(
+            const size_t inputIndex,
+            const Crypto::Hash &prefixHash,
+            CryptoNote::TransactionValidationResult &result) const;
+
         /////////////////////////
         /* PRIVATE MEMBER VARS */
         /////////////////////////
@@ -97,6 +115,16 @@ class TransactionValidator
         uint64_t m_sumOfInputs = 0;
 
         Utilities::ThreadPool<bool> &m_threadPool;
+
+        /* If set, the expensive input checks are deferred to the block-wide batch */
+        CryptoNote::BlockSignatureBatch *m_signatureBatch;
+
+        const size_t m_transactionIndex;
+
+        /* Guards the publishing of a failed expensive input check, which run concurrently */
+        std::mutex m_failedInputMutex;
+
+        size_t m_failedInputIndex = std::numeric_limits<size_t>::max();
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,354 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockDownloadScheduler.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "CryptoNoteConfig.h"
+
+namespace CryptoNote {
+
+DownloadedBlock::DownloadedBlock(BlockTemplate&& block, RawBlock&& rawBlock, const boost::uuids::uuid& peer) :
+  block(std::move(block)),
+  cachedBlock(this->block),
+  rawBlock(std::move(rawBlock)),
+  peer(peer) {
+}
+
+BlockDownloadScheduler::BlockDownloadScheduler() : m_downloadedCount(0) {
+}
+
+bool BlockDownloadScheduler::addChain(const boost::uuids::uuid& peer, uint32_t startIndex, const std::vector<Crypto::Hash>& hashes) {
+  if (hashes.empty()) {
+    return false;
+  }
+
+  // blocks of the plan are unknown to the core, so a peer on the same chain announces all of them
+  if (!m_plan.empty() && startIndex > m_plan.begin()->first) {
+    return false;
+  }
+
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    auto it = m_plan.find(startIndex + static_cast<uint32_t>(i));
+    if (it != m_plan.end() && it->second.hash != hashes[i]) {
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    uint32_t index = startIndex + static_cast<uint32_t>(i);
+    if (m_plan.count(index) != 0) {
+      continue;
+    }
+
+    PlannedBlock& planned = m_plan[index];
+    planned.hash = hashes[i];
+    planned.requesters = 0;
+    planned.stolen = false;
+    m_indexes[hashes[i]] = index;
+    m_wanted.insert(index);
+  }
+
+  uint32_t lastIndex = startIndex + static_cast<uint32_t>(hashes.size()) - 1;
+  auto it = m_peers.find(peer);
+  if (it == m_peers.end()) {
+    Peer& newPeer = m_peers[peer];
+    newPeer.firstIndex = startIndex;
+    newPeer.lastIndex = lastIndex;
+    newPeer.batchSize = BLOCKS_SYNCHRONIZING_DEFAULT_COUNT;
+    newPeer.blocksPerSecond = 0;
+  } else {
+    it->second.firstIndex = std::min(it->second.firstIndex, startIndex);
+    it->second.lastIndex = std::max(it->second.lastIndex, lastIndex);
+  }
+
+  return true;
+}
+
+bool BlockDownloadScheduler::hasPeer(const boost::uuids::uuid& peer) const {
+  return m_peers.count(peer) != 0;
+}
+
+void BlockDownloadScheduler::removePeer(const boost::uuids::uuid& peer) {
+  auto it = m_peers.find(peer);
+  if (it == m_peers.end()) {
+    return;
+  }
+
+  for (const auto& request : it->second.requests) {
+    releaseRequest(request);
+  }
+
+  if (!it->second.requests.empty()) {
+    m_discardedResponses[peer] += it->second.requests.size();
+  }
+
+  m_peers.erase(it);
+
+  if (m_peers.empty()) {
+    reset();
+    return;
+  }
+
+  uint32_t lastIndex = 0;
+  for (const auto& kv : m_peers) {
+    lastIndex = std::max(lastIndex, kv.second.lastIndex);
+  }
+
+  eraseFrom(m_plan.upper_bound(lastIndex));
+}
+
+void BlockDownloadScheduler::forgetPeer(const boost::uuids::uuid& peer) {
+  removePeer(peer);
+  m_discardedResponses.erase(peer);
+}
+
+std::vector<boost::uuids::uuid> BlockDownloadScheduler::reset() {
+  std::vector<boost::uuids::uuid> peers;
+  peers.reserve(m_peers.size());
+  for (const auto& kv : m_peers) {
+    peers.push_back(kv.first);
+    if (!kv.second.requests.empty()) {
+      m_discardedResponses[kv.first] += kv.second.requests.size();
+    }
+  }
+
+  m_peers.clear();
+  m_plan.clear();
+  m_indexes.clear();
+  m_wanted.clear();
+  m_downloadedCount = 0;
+
+  return peers;
+}
+
+std::vector<Crypto::Hash> BlockDownloadScheduler::takeBlocks(const boost::uuids::uuid& peerId, Clock::time_point now) {
+  auto peerIt = m_peers.find(peerId);
+  if (peerIt == m_peers.end() || m_plan.empty()) {
+    return {};
+  }
+
+  Peer& peer = peerIt->second;
+  if (peer.requests.size() >= BLOCKS_SYNCHRONIZING_REQUESTS_IN_FLIGHT) {
+    return {};
+  }
+
+  uint32_t windowEnd = m_plan.begin()->first + BLOCKS_SYNCHRONIZING_WINDOW;
+  std::vector<Crypto::Hash> hashes;
+
+  for (auto it = m_wanted.lower_bound(peer.firstIndex); it != m_wanted.end() && hashes.size() < peer.batchSize;) {
+    if (*it > peer.lastIndex || *it >= windowEnd) {
+      break;
+    }
+
+    PlannedBlock& planned = m_plan.at(*it);
+    ++planned.requesters;
+    planned.requested = now;
+    hashes.push_back(planned.hash);
+    it = m_wanted.erase(it);
+  }
+
+  if (hashes.empty()) {
+    // nothing new within the window: ask for the lowest missing blocks too if their peer is late with them
+    std::unordered_set<Crypto::Hash> ownRequests;
+    for (const auto& request : peer.requests) {
+      ownRequests.insert(request.blocks.begin(), request.blocks.end());
+    }
+
+    for (auto it = m_plan.lower_bound(peer.firstIndex); it != m_plan.end() && hashes.size() < peer.batchSize; ++it) {
+      PlannedBlock& planned = it->second;
+      if (planned.block) {
+        continue;
+      }
+
+      if (it->first > peer.lastIndex || planned.stolen || planned.requesters == 0 || ownRequests.count(planned.hash) != 0 ||
+          now - planned.requested < std::chrono::seconds(BLOCKS_SYNCHRONIZING_STALL_TIMEOUT)) {
+        break;
+      }
+
+      ++planned.requesters;
+      planned.stolen = true;
+      hashes.push_back(planned.hash);
+    }
+  }
+
+  if (!hashes.empty()) {
+    peer.requests.push_back(Request{hashes, now});
+  }
+
+  return hashes;
+}
+
+bool BlockDownloadScheduler::hasRequests(const boost::uuids::uuid& peer) const {
+  auto it = m_peers.find(peer);
+  return it != m_peers.end() && !it->second.requests.empty();
+}
+
+std::vector<uint32_t> BlockDownloadScheduler::getRequestIndexes(const boost::uuids::uuid& peer) const {
+  std::vector<uint32_t> indexes;
+  auto peerIt = m_peers.find(peer);
+  if (peerIt == m_peers.end() || peerIt->second.requests.empty()) {
+    return indexes;
+  }
+
+  for (const auto& hash : peerIt->second.requests.front().blocks) {
+    auto indexIt = m_indexes.find(hash);
+    if (indexIt != m_indexes.end()) {
+      indexes.push_back(indexIt->second);
+    }
+  }
+
+  return indexes;
+}
+
+bool BlockDownloadScheduler::takeDiscardedResponse(const boost::uuids::uuid& peer) {
+  auto it = m_discardedResponses.find(peer);
+  if (it == m_discardedResponses.end()) {
+    return false;
+  }
+
+  if (--it->second == 0) {
+    m_discardedResponses.erase(it);
+  }
+
+  return true;
+}
+
+bool BlockDownloadScheduler::isDone(const boost::uuids::uuid& peer) const {
+  auto peerIt = m_peers.find(peer);
+  if (peerIt == m_peers.end()) {
+    return true;
+  }
+
+  auto it = m_plan.lower_bound(peerIt->second.firstIndex);
+  return peerIt->second.requests.empty() && (it == m_plan.end() || it->first > peerIt->second.lastIndex);
+}
+
+bool BlockDownloadScheduler::completeRequest(const boost::uuids::uuid& peerId, std::vector<std::unique_ptr<DownloadedBlock>>&& blocks,
+  Clock::time_point now) {
+  auto peerIt = m_peers.find(peerId);
+  if (peerIt == m_peers.end() || peerIt->second.requests.empty()) {
+    return false;
+  }
+
+  Peer& peer = peerIt->second;
+  const Request& request = peer.requests.front();
+  if (blocks.size() != request.blocks.size()) {
+    return false;
+  }
+
+  std::unordered_set<Crypto::Hash> requested(request.blocks.begin(), request.blocks.end());
+  for (const auto& block : blocks) {
+    if (requested.erase(block->cachedBlock.getBlockHash()) == 0) {
+      return false;
+    }
+  }
+
+  updateThroughput(peer, request, now);
+
+  for (auto& block : blocks) {
+    auto indexIt = m_indexes.find(block->cachedBlock.getBlockHash());
+    if (indexIt == m_indexes.end()) {
+      // dropped from the plan meanwhile
+      continue;
+    }
+
+    PlannedBlock& planned = m_plan.at(indexIt->second);
+    if (planned.requesters > 0) {
+      --planned.requesters;
+    }
+
+    // a late answer to a request another peer was asked to repeat
+    if (!planned.block) {
+      planned.block = std::move(block);
+      ++m_downloadedCount;
+    }
+  }
+
+  peer.requests.pop_front();
+  return true;
+}
+
+std::unique_ptr<DownloadedBlock> BlockDownloadScheduler::popNextBlock() {
+  if (m_plan.empty() || !m_plan.begin()->second.block) {
+    return nullptr;
+  }
+
+  std::unique_ptr<DownloadedBlock> block = std::move(m_plan.begin()->second.block);
+  m_indexes.erase(m_plan.begin()->second.hash);
+  m_plan.erase(m_plan.begin());
+  --m_downloadedCount;
+
+  return block;
+}
+
+size_t BlockDownloadScheduler::getBatchSize(const boost::uuids::uuid& peer) const {
+  auto it = m_peers.find(peer);
+  return it != m_peers.end() ? it->second.batchSize : 0;
+}
+
+size_t BlockDownloadScheduler::getDownloadedCount() const {
+  return m_downloadedCount;
+}
+
+void BlockDownloadScheduler::releaseRequest(const Request& request) {
+  for (const auto& hash : request.blocks) {
+    auto indexIt = m_indexes.find(hash);
+    if (indexIt == m_indexes.end()) {
+      continue;
+    }
+
+    PlannedBlock& planned = m_plan.at(indexIt->second);
+    if (planned.requesters > 0) {
+      --planned.requesters;
+    }
+
+    if (planned.requesters == 0 && !planned.block) {
+      planned.stolen = false;
+      m_wanted.insert(indexIt->second);
+    }
+  }
+}
+
+void BlockDownloadScheduler::updateThroughput(Peer& peer, const Request& request, Clock::time_point now) {
+  // with several requests in flight the previous response marks the start of this one
+  auto start = std::max(request.sent, peer.lastResponse);
+  double seconds = std::max(std::chrono::duration<double>(now - start).count(), 0.001);
+  double blocksPerSecond = request.blocks.size() / seconds;
+
+  peer.blocksPerSecond = peer.blocksPerSecond > 0 ? (peer.blocksPerSecond + blocksPerSecond) / 2 : blocksPerSecond;
+  peer.batchSize = std::min(std::max(static_cast<size_t>(peer.blocksPerSecond * BLOCKS_SYNCHRONIZING_RESPONSE_TIME),
+    BLOCKS_SYNCHRONIZING_MIN_COUNT), BLOCKS_SYNCHRONIZING_MAX_COUNT);
+  peer.lastResponse = now;
+}
+
+void BlockDownloadScheduler::eraseFrom(std::map<uint32_t, PlannedBlock>::iterator it) {
+  for (auto eraseIt = it; eraseIt != m_plan.end(); ++eraseIt) {
+    m_wanted.erase(eraseIt->first);
+    m_indexes.erase(eraseIt->second.hash);
+    if (eraseIt->second.block) {
+      --m_downloadedCount;
+    }
+  }
+
+  m_plan.erase(it, m_plan.end());
+}
+
+}
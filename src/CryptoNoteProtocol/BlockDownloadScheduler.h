@@ -0,0 +1,128 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include "CryptoNote.h"
+#include "CryptoNoteCore/CachedBlock.h"
+#include "crypto/crypto.h"
+
+namespace CryptoNote
+{
+  // Block downloaded during synchronization, waiting for the blocks below it.
+  struct DownloadedBlock {
+    DownloadedBlock(BlockTemplate&& block, RawBlock&& rawBlock, const boost::uuids::uuid& peer);
+
+    BlockTemplate block;
+    CachedBlock cachedBlock;
+    RawBlock rawBlock;
+    boost::uuids::uuid peer;
+  };
+
+  // Spreads the blocks of the chain being synchronized across all peers which announced it.
+  //
+  // Chain entries of the peers are merged into one plan of block hashes by block index. Every peer
+  // takes batches of the lowest blocks nobody has requested yet and keeps several requests in flight,
+  // with the batch size adjusted to its measured throughput. Received blocks wait in the plan until
+  // all blocks below them are there and are then handed out in chain order. Peers may only run ahead
+  // of the lowest missing block by BLOCKS_SYNCHRONIZING_WINDOW blocks; when the lowest block is
+  // overdue, idle peers request it as well. The window also bounds how far parsing and hashing of
+  // received blocks may run ahead of adding them to the core.
+  //
+  // Only bookkeeping lives here, the protocol handler sends the requests and adds the blocks to the core.
+  class BlockDownloadScheduler {
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    BlockDownloadScheduler();
+
+    // false if the hashes conflict with the plan, the peer is then on another chain
+    bool addChain(const boost::uuids::uuid& peer, uint32_t startIndex, const std::vector<Crypto::Hash>& hashes);
+    bool hasPeer(const boost::uuids::uuid& peer) const;
+    // its requests go back to the plan, blocks no other peer announced are dropped from it
+    void removePeer(const boost::uuids::uuid& peer);
+    // removes the peer and everything known about it, once its connection is closed
+    void forgetPeer(const boost::uuids::uuid& peer);
+    // forgets the plan and returns the peers taking part in it
+    std::vector<boost::uuids::uuid> reset();
+
+    // next request for the peer, empty if it has enough in flight or nothing is left for it
+    std::vector<Crypto::Hash> takeBlocks(const boost::uuids::uuid& peer, Clock::time_point now);
+    bool hasRequests(const boost::uuids::uuid& peer) const;
+    // indexes of the blocks the next response of the peer has to contain
+    std::vector<uint32_t> getRequestIndexes(const boost::uuids::uuid& peer) const;
+    // true once for every response still due to a request which was dropped from the plan
+    bool takeDiscardedResponse(const boost::uuids::uuid& peer);
+    // the peer announced no block which is still missing
+    bool isDone(const boost::uuids::uuid& peer) const;
+
+    // false if the blocks don't answer the oldest request of the peer
+    bool completeRequest(const boost::uuids::uuid& peer, std::vector<std::unique_ptr<DownloadedBlock>>&& blocks, Clock::time_point now);
+    // the lowest block of the plan if it is downloaded
+    std::unique_ptr<DownloadedBlock> popNextBlock();
+
+    size_t getBatchSize(const boost::uuids::uuid& peer) const;
+    size_t getDownloadedCount() const;
+
+  private:
+    struct Request {
+      std::vector<Crypto::Hash> blocks;
+      Clock::time_point sent;
+    };
+
+    struct Peer {
+      uint32_t firstIndex;
+      uint32_t lastIndex;
+      std::deque<Request> requests;
+      size_t batchSize;
+      double blocksPerSecond;
+      Clock::time_point lastResponse;
+    };
+
+    struct PlannedBlock {
+      Crypto::Hash hash;
+      uint32_t requesters;
+      Clock::time_point requested;
+      bool stolen;
+      std::unique_ptr<DownloadedBlock> block;
+    };
+
+    std::unordered_map<boost::uuids::uuid, Peer, boost::hash<boost::uuids::uuid>> m_peers;
+    std::map<uint32_t, PlannedBlock> m_plan;
+    std::unordered_map<Crypto::Hash, uint32_t> m_indexes;
+    // indexes of the planned blocks nobody is downloading
+    std::set<uint32_t> m_wanted;
+    size_t m_downloadedCount;
+    std::unordered_map<boost::uuids::uuid, size_t, boost::hash<boost::uuids::uuid>> m_discardedResponses;
+
+    void releaseRequest(const Request& request);
+    void updateThroughput(Peer& peer, const Request& request, Clock::time_point now);
+    void eraseFrom(std::map<uint32_t, PlannedBlock>::iterator it);
+  };
+}
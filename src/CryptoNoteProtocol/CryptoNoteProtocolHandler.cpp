@@ -21,12 +21,15 @@
 
 #include "CryptoNoteProtocolHandler.h"
 
+#include <algorithm>
 #include <future>
+#include <limits>
 #include <random>
 #include <boost/optional.hpp>
 #include <boost/scope_exit.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <System/Dispatcher.h>
+#include <System/RemoteContext.h>
 
 #include "Common/ShuffleGenerator.h"
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
@@ -37,6 +40,7 @@
 #include "P2p/LevinProtocol.h"
 
 #include "crypto/random.h"
+#include "crypto/scratchpad-pool.h"
 
 using namespace Logging;
 using namespace Common;
@@ -172,6 +176,10 @@ CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, S
   m_dandelionStemSelectInterval(CryptoNote::parameters::DANDELION_EPOCH),
   m_dandelionStemFluffInterval(CryptoNote::parameters::DANDELION_STEM_EMBARGO),
   m_stemPool(),
+  m_applyingBlocks(false),
+  m_blockPreparationThreads(std::max(std::thread::hardware_concurrency(), 1u)),
+  m_blockPreparationPool(m_blockPreparationThreads),
+  m_numaAffinity(false),
   logger(log, "protocol") {
   
   if (!m_p2p) {
@@ -193,6 +201,10 @@ void CryptoNoteProtocolHandler::set_p2p_endpoint(IP2pEndpoint* p2p) {
     m_p2p = &m_p2p_stub;
 }
 
+void CryptoNoteProtocolHandler::setNumaAffinity(bool enabled) {
+  m_numaAffinity = enabled;
+}
+
 void CryptoNoteProtocolHandler::onConnectionOpened(CryptoNoteConnectionContext& context) {
   if (context.m_state != CryptoNoteConnectionContext::state_befor_handshake) {
     m_peersCount++;
@@ -220,6 +232,12 @@ void CryptoNoteProtocolHandler::onConnectionClosed(CryptoNoteConnectionContext&
     m_peersCount--;
     m_observerManager.notify(&ICryptoNoteProtocolObserver::peerCountUpdated, m_peersCount.load());
   }
+
+  bool scheduled = m_blockDownloads.hasPeer(context.m_connection_id);
+  m_blockDownloads.forgetPeer(context.m_connection_id);
+  if (scheduled) {
+    requestScheduledBlocksFromAll();
+  }
 }
 
 void CryptoNoteProtocolHandler::stop() {
@@ -242,6 +260,21 @@ bool CryptoNoteProtocolHandler::start_sync(CryptoNoteConnectionContext& context)
   return true;
 }
 
+void CryptoNoteProtocolHandler::requestChain(CryptoNoteConnectionContext& context) {
+  NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
+  r.block_ids = m_core.buildSparseChain();
+  logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
+  post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
+}
+
+void CryptoNoteProtocolHandler::dropConnection(const boost::uuids::uuid& connectionId, bool addFail) {
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (context.m_connection_id == connectionId) {
+      m_p2p->drop_connection(context, addFail);
+    }
+  });
+}
+
 CoreStatistics CryptoNoteProtocolHandler::getStatistics() {
   return m_core.getCoreStatistics();
 }
@@ -253,7 +286,8 @@ void CryptoNoteProtocolHandler::log_connections() {
     << std::setw(20) << "Peer id"
     << std::setw(25) << "Recv/Sent (inactive,sec)"
     << std::setw(25) << "State"
-    << std::setw(20) << "Lifetime(seconds)" << ENDL;
+    << std::setw(20) << "Lifetime(seconds)"
+    << std::setw(25) << "Send queue(shared/peak)" << ENDL;
 
   m_p2p->for_each_connection([&](const CryptoNoteConnectionContext& cntxt, PeerIdType peer_id) {
     ss << std::setw(25) << std::left << std::string(cntxt.m_is_income ? "[INC]" : "[OUT]") +
@@ -261,7 +295,9 @@ void CryptoNoteProtocolHandler::log_connections() {
       << std::setw(20) << std::hex << peer_id
       // << std::setw(25) << std::to_string(cntxt.m_recv_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_recv) + ")" + "/" + std::to_string(cntxt.m_send_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_send) + ")"
       << std::setw(25) << get_protocol_state_string(cntxt.m_state)
-      << std::setw(20) << std::to_string(time(NULL) - cntxt.m_started) << ENDL;
+      << std::setw(20) << std::to_string(time(NULL) - cntxt.m_started)
+      << std::setw(25) << std::to_string(cntxt.m_send_queue_size) + "(" + std::to_string(cntxt.m_send_queue_shared_size) + "/" +
+        std::to_string(cntxt.m_send_queue_peak_size) + ")" << ENDL;
   });
   logger(INFO) << "Connections: " << ENDL << ss.str();
 }
@@ -554,6 +590,16 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
 
   updateObservedHeight(arg.current_blockchain_height, context);
   context.m_remote_blockchain_height = arg.current_blockchain_height;
+
+  if (m_blockDownloads.takeDiscardedResponse(context.m_connection_id)) {
+    logger(Logging::TRACE) << context << "Ignoring response to a request dropped from the download plan";
+    return 1;
+  }
+
+  if (m_blockDownloads.hasRequests(context.m_connection_id)) {
+    return processScheduledObjects(arg, context);
+  }
+
   std::vector<BlockTemplate> blockTemplates;
   std::vector<CachedBlock> cachedBlocks;
   blockTemplates.resize(arg.blocks.size());
@@ -609,6 +655,11 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
     return 1;
   }
 
+  computeProofOfWork(cachedBlocks);
+  if (m_stop) {
+    return 1;
+  }
+
   {
     int result = processObjects(context, std::move(rawBlocks), cachedBlocks);
     if (result != 0) {
@@ -657,6 +708,267 @@ int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& conte
   return 0;
 }
 
+int CryptoNoteProtocolHandler::processScheduledObjects(NOTIFY_RESPONSE_GET_OBJECTS::request& arg, CryptoNoteConnectionContext& context) {
+  // proof of work isn't checked within the checkpoint zone, don't spend time on it
+  uint32_t proofOfWorkFrom = std::numeric_limits<uint32_t>::max();
+  for (uint32_t index : m_blockDownloads.getRequestIndexes(context.m_connection_id)) {
+    if (!m_core.isInCheckpointZone(index)) {
+      proofOfWorkFrom = std::min(proofOfWorkFrom, index);
+    }
+  }
+
+  std::vector<RawBlock> rawBlocks = convertRawBlocksLegacyToRawBlocks(arg.blocks);
+  std::vector<std::unique_ptr<DownloadedBlock>> blocks(rawBlocks.size());
+
+  // parsing and hashing run on the worker threads, the dispatcher keeps receiving and adding blocks meanwhile
+  bool prepared;
+  {
+    System::RemoteContext<bool> preparation(m_dispatcher, [&] {
+      return prepareBlocks(rawBlocks, blocks, proofOfWorkFrom, context.m_connection_id);
+    });
+
+    prepared = preparation.get();
+  }
+
+  if (m_stop) {
+    return 1;
+  }
+
+  // the plan was reset or the peer dropped while the blocks were prepared
+  if (m_blockDownloads.takeDiscardedResponse(context.m_connection_id)) {
+    logger(Logging::TRACE) << context << "Ignoring response to a request dropped from the download plan";
+    return 1;
+  }
+
+  if (!prepared) {
+    logger(Logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: failed to parse blocks, dropping connection";
+    m_p2p->drop_connection(context, true);
+    m_blockDownloads.removePeer(context.m_connection_id);
+    requestScheduledBlocksFromAll();
+    return 1;
+  }
+
+  size_t count = blocks.size();
+  if (!m_blockDownloads.completeRequest(context.m_connection_id, std::move(blocks), BlockDownloadScheduler::Clock::now())) {
+    logger(Logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: blocks don't match the request, dropping connection";
+    m_p2p->drop_connection(context, true);
+    m_blockDownloads.removePeer(context.m_connection_id);
+    requestScheduledBlocksFromAll();
+    return 1;
+  }
+
+  logger(Logging::TRACE) << context << "Received " << count << " blocks, next batch size " << m_blockDownloads.getBatchSize(context.m_connection_id)
+    << ", " << m_blockDownloads.getDownloadedCount() << " blocks waiting";
+
+  // keep the connection busy while the blocks are added
+  requestScheduledBlocks(context);
+  applyDownloadedBlocks();
+
+  return 1;
+}
+
+bool CryptoNoteProtocolHandler::prepareBlocks(std::vector<RawBlock>& rawBlocks, std::vector<std::unique_ptr<DownloadedBlock>>& blocks,
+  uint32_t proofOfWorkFrom, const boost::uuids::uuid& peer) {
+  size_t jobCount = std::min(m_blockPreparationThreads, rawBlocks.size());
+  std::vector<std::future<bool>> jobs;
+  jobs.reserve(jobCount);
+
+  for (size_t job = 0; job < jobCount; ++job) {
+    jobs.push_back(m_blockPreparationPool.addJob([&, job] {
+      try {
+        auto binding = bindPreparationJob(job);
+        Crypto::cn_context cryptoContext;
+        std::vector<const CachedBlock*> proofOfWorkBlocks;
+        for (size_t i = job; i < rawBlocks.size(); i += jobCount) {
+          BlockTemplate blockTemplate;
+          if (!fromBinaryArray(blockTemplate, rawBlocks[i].block)) {
+            return false;
+          }
+
+          blocks[i].reset(new DownloadedBlock(std::move(blockTemplate), std::move(rawBlocks[i]), peer));
+          const CachedBlock& cachedBlock = blocks[i]->cachedBlock;
+          if (cachedBlock.getBlock().transactionHashes.size() != blocks[i]->rawBlock.transactions.size()) {
+            return false;
+          }
+
+          // cached by the block, Core::addBlock finds them ready
+          cachedBlock.getBlockHash();
+          if (cachedBlock.getBlockIndex() >= proofOfWorkFrom) {
+            proofOfWorkBlocks.push_back(&cachedBlock);
+          }
+        }
+
+        // hashed together, several at a time where the CPU allows it
+        CachedBlock::getBlockLongHashes(proofOfWorkBlocks.data(), proofOfWorkBlocks.size(), cryptoContext);
+        return true;
+      } catch (std::exception&) {
+        return false;
+      }
+    }));
+  }
+
+  // all jobs have to finish, they reference the blocks
+  bool result = true;
+  for (auto& job : jobs) {
+    result = job.get() && result;
+  }
+
+  return result;
+}
+
+// The cn_context of the job is created after this, so its scratchpad comes from the same node.
+// The pool thread gets its previous CPU mask back when the job drops the binding.
+std::unique_ptr<Crypto::NumaNodeBinding> CryptoNoteProtocolHandler::bindPreparationJob(size_t job) {
+  if (!m_numaAffinity) {
+    return nullptr;
+  }
+
+  unsigned node = static_cast<unsigned>(job % Crypto::numaNodeCount());
+  std::unique_ptr<Crypto::NumaNodeBinding> binding(new Crypto::NumaNodeBinding(node));
+  if (!binding->isBound() && m_numaAffinity.exchange(false)) {
+    logger(Logging::WARNING) << "Failed to bind block preparation thread to NUMA node " << node << ", NUMA affinity disabled";
+  }
+
+  return binding;
+}
+
+// Core::addBlock finds the hashes cached instead of computing them one by one under the blockchain lock.
+// A block that fails here is hashed again by the core, which reports the error.
+void CryptoNoteProtocolHandler::computeProofOfWork(const std::vector<CachedBlock>& cachedBlocks) {
+  std::vector<const CachedBlock*> proofOfWorkBlocks;
+  for (const auto& cachedBlock : cachedBlocks) {
+    if (!m_core.isInCheckpointZone(cachedBlock.getBlockIndex())) {
+      proofOfWorkBlocks.push_back(&cachedBlock);
+    }
+  }
+
+  if (proofOfWorkBlocks.empty()) {
+    return;
+  }
+
+  System::RemoteContext<void> hashing(m_dispatcher, [&] {
+    size_t jobCount = std::min(m_blockPreparationThreads, proofOfWorkBlocks.size());
+    std::vector<std::future<bool>> jobs;
+    jobs.reserve(jobCount);
+
+    for (size_t job = 0; job < jobCount; ++job) {
+      jobs.push_back(m_blockPreparationPool.addJob([&, job] {
+        try {
+          auto binding = bindPreparationJob(job);
+          Crypto::cn_context cryptoContext;
+          std::vector<const CachedBlock*> jobBlocks;
+          for (size_t i = job; i < proofOfWorkBlocks.size(); i += jobCount) {
+            jobBlocks.push_back(proofOfWorkBlocks[i]);
+          }
+
+          CachedBlock::getBlockLongHashes(jobBlocks.data(), jobBlocks.size(), cryptoContext);
+          return true;
+        } catch (std::exception&) {
+          return false;
+        }
+      }));
+    }
+
+    // all jobs have to finish, they reference the blocks
+    for (auto& job : jobs) {
+      job.get();
+    }
+  });
+
+  hashing.get();
+}
+
+void CryptoNoteProtocolHandler::requestScheduledBlocks(CryptoNoteConnectionContext& context) {
+  if (m_stop || context.m_state != CryptoNoteConnectionContext::state_synchronizing) {
+    return;
+  }
+
+  auto now = BlockDownloadScheduler::Clock::now();
+  for (;;) {
+    NOTIFY_REQUEST_GET_OBJECTS::request req;
+    req.blocks = m_blockDownloads.takeBlocks(context.m_connection_id, now);
+    if (req.blocks.empty()) {
+      break;
+    }
+
+    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size();
+    post_notify<NOTIFY_REQUEST_GET_OBJECTS>(*m_p2p, req, context);
+  }
+
+  // blocks being added are out of the plan already, wait for them before asking for the next chain entry
+  if (!m_applyingBlocks && m_blockDownloads.isDone(context.m_connection_id)) {
+    m_blockDownloads.removePeer(context.m_connection_id);
+    if (!request_missing_objects(context, false)) {
+      logger(Logging::DEBUGGING) << context << "Failed to request missing objects, dropping connection";
+      m_p2p->drop_connection(context, true);
+    }
+  }
+}
+
+void CryptoNoteProtocolHandler::requestScheduledBlocksFromAll() {
+  m_p2p->for_each_connection([this](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (m_blockDownloads.hasPeer(context.m_connection_id)) {
+      requestScheduledBlocks(context);
+    }
+  });
+}
+
+void CryptoNoteProtocolHandler::applyDownloadedBlocks() {
+  // handlers of the other connections only store their blocks while one of them adds
+  if (m_applyingBlocks) {
+    return;
+  }
+
+  m_applyingBlocks = true;
+  size_t added = 0;
+
+  try {
+    while (!m_stop) {
+      std::unique_ptr<DownloadedBlock> block = m_blockDownloads.popNextBlock();
+      if (!block) {
+        break;
+      }
+
+      auto addResult = m_core.addBlock(block->cachedBlock, std::move(block->rawBlock));
+      if (addResult == error::AddBlockErrorCondition::BLOCK_VALIDATION_FAILED ||
+          addResult == error::AddBlockErrorCondition::TRANSACTION_VALIDATION_FAILED ||
+          addResult == error::AddBlockErrorCondition::DESERIALIZATION_FAILED ||
+          addResult == error::AddBlockErrorCondition::BLOCK_REJECTED) {
+        logger(Logging::DEBUGGING) << "Block " << Common::podToHex(block->cachedBlock.getBlockHash())
+          << " verification failed, dropping the connection it came from: " << addResult.message();
+        dropConnection(block->peer, true);
+
+        // blocks above the bad one are useless, start over from the current chain
+        std::vector<boost::uuids::uuid> peers = m_blockDownloads.reset();
+        m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+          if (context.m_state == CryptoNoteConnectionContext::state_synchronizing &&
+              std::find(peers.begin(), peers.end(), context.m_connection_id) != peers.end()) {
+            requestChain(context);
+          }
+        });
+        break;
+      }
+
+      if (addResult != error::AddBlockErrorCode::ALREADY_EXISTS) {
+        ++added;
+      }
+
+      m_dispatcher.yield();
+    }
+  } catch (...) {
+    m_applyingBlocks = false;
+    throw;
+  }
+
+  m_applyingBlocks = false;
+
+  if (added != 0) {
+    logger(DEBUGGING, BRIGHT_GREEN) << "Local blockchain updated, new index = " << m_core.getTopBlockIndex();
+  }
+
+  requestScheduledBlocksFromAll();
+}
+
 bool CryptoNoteProtocolHandler::select_dandelion_stem() {
   m_dandelion_stem.clear();
 
@@ -720,6 +1032,9 @@ bool CryptoNoteProtocolHandler::on_idle() {
   m_dandelionStemSelectInterval.call([&]() { return select_dandelion_stem(); });
   m_dandelionStemFluffInterval.call([&]() { return fluffStemPool(); });
 
+  // overdue blocks are requested from the idle peers
+  requestScheduledBlocksFromAll();
+
   return m_core.on_idle();
 }
 
@@ -963,18 +1278,24 @@ int CryptoNoteProtocolHandler::handle_response_chain_entry(int command, NOTIFY_R
     m_p2p->drop_connection(context, true);
   }
 
-  bool allBlocksKnown = true;
-  for (auto& bl_id : arg.m_block_ids) {
-    if (allBlocksKnown) {
-      if (!m_core.hasBlock(bl_id)) {
-        context.m_needed_objects.push_back(bl_id);
-        allBlocksKnown = false;
-      }
-    } else {
-      context.m_needed_objects.push_back(bl_id);
-    }
+  auto firstUnknown = std::find_if(arg.m_block_ids.begin(), arg.m_block_ids.end(), [this](const Crypto::Hash& hash) {
+    return !m_core.hasBlock(hash);
+  });
+
+  uint32_t neededStartIndex = arg.start_height + static_cast<uint32_t>(std::distance(arg.m_block_ids.begin(), firstUnknown));
+  std::vector<Crypto::Hash> neededBlocks(firstUnknown, arg.m_block_ids.end());
+
+  // blocks of the same chain are downloaded from all synchronizing peers at once
+  if (context.m_state == CryptoNoteConnectionContext::state_synchronizing &&
+      m_blockDownloads.addChain(context.m_connection_id, neededStartIndex, neededBlocks)) {
+    requestScheduledBlocks(context);
+    return 1;
   }
 
+  // on another chain, or nothing to download: download by itself
+  m_blockDownloads.removePeer(context.m_connection_id);
+  context.m_needed_objects.insert(context.m_needed_objects.end(), neededBlocks.begin(), neededBlocks.end());
+
   if (!request_missing_objects(context, false)) {
     logger(Logging::DEBUGGING) << context << "Failed to request missing objects, dropping connection";
     m_p2p->drop_connection(context, true);
@@ -22,10 +22,12 @@
 #include <atomic>
 
 #include <Common/ObserverManager.h>
+#include <Common/ThreadPool.h>
 
 #include "CryptoNoteCore/ICore.h"
 #include "CryptoNoteCore/OnceInInterval.h"
 
+#include "CryptoNoteProtocol/BlockDownloadScheduler.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandlerCommon.h"
 #include "CryptoNoteProtocol/ICryptoNoteProtocolObserver.h"
@@ -37,6 +39,10 @@
 
 #include <Logging/LoggerRef.h>
 
+namespace Crypto {
+  class NumaNodeBinding;
+}
+
 namespace System {
   class Dispatcher;
 }
@@ -115,6 +121,8 @@ namespace CryptoNote
     virtual bool removeObserver(ICryptoNoteProtocolObserver* observer) override;
 
     void set_p2p_endpoint(IP2pEndpoint* p2p);
+    // block preparation jobs are spread over NUMA nodes, each hashing on its node
+    void setNumaAffinity(bool enabled);
     // ICore& get_core() { return m_core; }
     virtual bool isSynchronized() const override { return m_synchronized; }
     void log_connections();
@@ -159,6 +167,16 @@ namespace CryptoNote
     void updateObservedHeight(uint32_t peerHeight, const CryptoNoteConnectionContext& context);
     void recalculateMaxObservedHeight(const CryptoNoteConnectionContext& context);
     int processObjects(CryptoNoteConnectionContext& context, std::vector<RawBlock>&& rawBlocks, const std::vector<CachedBlock>& cachedBlocks);
+    int processScheduledObjects(NOTIFY_RESPONSE_GET_OBJECTS::request& arg, CryptoNoteConnectionContext& context);
+    bool prepareBlocks(std::vector<RawBlock>& rawBlocks, std::vector<std::unique_ptr<DownloadedBlock>>& blocks, uint32_t proofOfWorkFrom,
+      const boost::uuids::uuid& peer);
+    void computeProofOfWork(const std::vector<CachedBlock>& cachedBlocks);
+    std::unique_ptr<Crypto::NumaNodeBinding> bindPreparationJob(size_t job);
+    void requestScheduledBlocks(CryptoNoteConnectionContext& context);
+    void requestScheduledBlocksFromAll();
+    void applyDownloadedBlocks();
+    void requestChain(CryptoNoteConnectionContext& context);
+    void dropConnection(const boost::uuids::uuid& connectionId, bool addFail);
     Logging::LoggerRef logger;
 
   private:
@@ -184,5 +202,11 @@ namespace CryptoNote
     std::vector<CryptoNoteConnectionContext> m_dandelion_stem;
 
     StemPool m_stemPool;
+
+    BlockDownloadScheduler m_blockDownloads;
+    bool m_applyingBlocks;
+    const size_t m_blockPreparationThreads;
+    Utilities::ThreadPool<bool> m_blockPreparationPool;
+    std::atomic<bool> m_numaAffinity;
   };
 }
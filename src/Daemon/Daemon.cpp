@@ -80,6 +80,7 @@ namespace
   const command_line::arg_descriptor<bool>                     arg_disable_checkpoints = { "without-checkpoints", "Synchronize without checkpoints" };
   const command_line::arg_descriptor<std::string>              arg_rollback            = { "rollback", "Rollback blockchain to <height>", "", true };
   const command_line::arg_descriptor<bool>                     arg_level_db            = { "level-db", "Use LevelDB instead of RocksDB" };
+  const command_line::arg_descriptor<bool>                     arg_verification_numa_affinity = { "verification-numa-affinity", "Spread block verification threads over NUMA nodes and keep each on its node" };
 }
 
 bool command_line_preprocessor(const boost::program_options::variables_map& vm, LoggerRef& logger);
@@ -95,6 +96,7 @@ void print_genesis_tx_hex(const po::variables_map& vm, LoggerManager& logManager
 JsonValue buildLoggerConfiguration(Level level, const std::string& logfile) {
   JsonValue loggerConfiguration(JsonValue::OBJECT);
   loggerConfiguration.insert("globalLevel", static_cast<int64_t>(level));
+  loggerConfiguration.insert("async", JsonValue(true));
 
   JsonValue& cfgLoggers = loggerConfiguration.insert("loggers", JsonValue::ARRAY);
 
@@ -140,6 +142,7 @@ int main(int argc, char* argv[])
     command_line::add_arg(desc_cmd_sett, arg_disable_checkpoints);
     command_line::add_arg(desc_cmd_sett, arg_rollback);
     command_line::add_arg(desc_cmd_sett, arg_level_db);
+    command_line::add_arg(desc_cmd_sett, arg_verification_numa_affinity);
 
     RpcServerConfig::initOptions(desc_cmd_sett);
     NetNodeConfig::initOptions(desc_cmd_sett);
@@ -327,7 +330,7 @@ int main(int argc, char* argv[])
       logManager,
       std::move(checkpoints),
       dispatcher,
-      std::unique_ptr<IBlockchainCacheFactory>(new DatabaseBlockchainCacheFactory(*database, logger.getLogger())),
+      std::unique_ptr<IBlockchainCacheFactory>(new DatabaseBlockchainCacheFactory(*database, logger.getLogger(), dbConfig.getDataDir())),
       transactionValidationThreads);
     ccore.load(minerConfig);
     logger(INFO) << "Core initialized OK";
@@ -353,6 +356,7 @@ int main(int argc, char* argv[])
     CryptoNote::RpcServer rpcServer(dispatcher, logManager, ccore, p2psrv, cprotocol);
 
     cprotocol.set_p2p_endpoint(&p2psrv);
+    cprotocol.setNumaAffinity(command_line::get_arg(vm, arg_verification_numa_affinity));
     DaemonCommandsHandler dch(ccore, p2psrv, logManager, cprotocol, &rpcServer);
 
     logger(INFO) << "Initializing p2p server...";
@@ -395,6 +399,7 @@ int main(int argc, char* argv[])
     std::string ssl_info = "";
     if (server_ssl_enable) ssl_info += ", SSL on address " + rpcConfig.getBindAddressSSL();
     logger(INFO) << "Starting core rpc server on address " << rpcConfig.getBindAddress() << ssl_info;
+    rpcServer.setWorkerThreads(rpcConfig.getWorkerThreads());
     rpcServer.start(rpcConfig.getBindIP(), rpcConfig.getBindPort(), rpcConfig.getBindPortSSL(), server_ssl_enable);
     rpcServer.restrictRPC(rpcConfig.restrictedRPC);
     rpcServer.enableCors(rpcConfig.enableCors);
@@ -403,27 +403,20 @@ std::error_code InProcessNode::doGetRandomOutsByAmounts(
   try {
     CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response res;
 
-    std::vector<uint32_t> indices;
-    std::vector<Crypto::PublicKey> keys;
+    std::vector<CryptoNote::RandomOutputsForAmount> outs;
+    if (!core.getRandomOutputs(amounts, outsCount, outs)) {
+      return make_error_code(CryptoNote::error::REQUEST_ERROR);
+    }
 
     std::vector<CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount> tmpResult;
-    for (auto amount : amounts) {
-      indices.clear();
-      keys.clear();
-
-      if (!core.getRandomOutputs(amount, outsCount, indices, keys)) {
-        return make_error_code(CryptoNote::error::REQUEST_ERROR);
-      }
-
-      assert(indices.size() == keys.size());
-
-      CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount outsForAmount;
-      outsForAmount.amount = amount;
-      for (size_t i = 0; i < indices.size(); ++i) {
-        outsForAmount.outs.push_back( {indices[i], keys[i]} );
+    for (const auto& outsForAmount : outs) {
+      CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount tmpOuts;
+      tmpOuts.amount = outsForAmount.amount;
+      for (size_t i = 0; i < outsForAmount.globalIndexes.size(); ++i) {
+        tmpOuts.outs.push_back( {outsForAmount.globalIndexes[i], outsForAmount.publicKeys[i]} );
       }
 
-      tmpResult.push_back(std::move(outsForAmount));
+      tmpResult.push_back(std::move(tmpOuts));
     }
 
     result = std::move(tmpResult);
@@ -75,6 +75,10 @@ void CommonLogger::operator()(const std::string& category, Level level, boost::p
   }
 }
 
+bool CommonLogger::isEnabled(const std::string& category, Level level) const {
+  return level <= logLevel && disabledCategories.count(category) == 0;
+}
+
 void CommonLogger::setPattern(const std::string& pattern) {
   this->pattern = pattern;
 }
@@ -91,7 +95,14 @@ void CommonLogger::setMaxLevel(Level level) {
   logLevel = level;
 }
 
-CommonLogger::CommonLogger(Level level) : logLevel(level), pattern("%D %T %L [%C] ") {
+void CommonLogger::setAutoFlush(bool autoFlush) {
+  this->autoFlush = autoFlush;
+}
+
+void CommonLogger::flush() {
+}
+
+CommonLogger::CommonLogger(Level level) : logLevel(level), pattern("%D %T %L [%C] "), autoFlush(true) {
 }
 
 void CommonLogger::doLogString(const std::string& message) {
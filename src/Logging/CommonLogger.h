@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <set>
 #include "ILogger.h"
 
@@ -27,17 +28,22 @@ class CommonLogger : public ILogger {
 public:
 
   virtual void operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) override;
+  virtual bool isEnabled(const std::string& category, Level level) const override;
   virtual void enableCategory(const std::string& category);
   virtual void disableCategory(const std::string& category);
   virtual void setMaxLevel(Level level);
 
   void setPattern(const std::string& pattern);
+  // without auto flush written messages may stay buffered until flush()
+  void setAutoFlush(bool autoFlush);
+  virtual void flush();
   virtual ~CommonLogger() {}
 
 protected:
   std::set<std::string> disabledCategories;
-  Level logLevel;
+  std::atomic<Level> logLevel;
   std::string pattern;
+  bool autoFlush;
 
   CommonLogger(Level level);
   virtual void doLogString(const std::string& message);
@@ -55,20 +55,20 @@ void ConsoleLogger::doLogString(const std::string& message) {
     { DEFAULT, Color::Default }
   };
 
-  for (size_t charPos = 0; charPos < message.size(); ++charPos) {
-    if (message[charPos] == ILogger::COLOR_DELIMETER) {
-      readingText = !readingText;
-      color += message[charPos];
+  size_t runStart = 0;
+  for (size_t charPos = 0; charPos <= message.size(); ++charPos) {
+    if (charPos == message.size() || message[charPos] == ILogger::COLOR_DELIMETER) {
       if (readingText) {
+        std::cout.write(message.data() + runStart, charPos - runStart);
+      } else if (charPos < message.size()) {
+        color.assign(message, runStart - 1, charPos - runStart + 2);
         auto it = colorMapping.find(color);
         Common::Console::setTextColor(it == colorMapping.end() ? Color::Default : it->second);
         changedColor = true;
-        color.clear();
       }
-    } else if (readingText) {
-      std::cout << message[charPos];
-    } else {
-      color += message[charPos];
+
+      readingText = !readingText;
+      runStart = charPos + 1;
     }
   }
 
@@ -77,4 +77,9 @@ void ConsoleLogger::doLogString(const std::string& message) {
   }
 }
 
+void ConsoleLogger::flush() {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::cout.flush();
+}
+
 }
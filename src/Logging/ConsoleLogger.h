@@ -27,6 +27,8 @@ class ConsoleLogger : public CommonLogger {
 public:
   ConsoleLogger(Level level = DEBUGGING);
 
+  virtual void flush() override;
+
 protected:
   virtual void doLogString(const std::string& message) override;
 
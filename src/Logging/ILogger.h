@@ -61,6 +61,9 @@ public:
   const static std::array<std::string, 6> LEVEL_NAMES;
 
   virtual void operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) = 0;
+
+  // checked before a message is formatted, false if the logger would drop it anyway
+  virtual bool isEnabled(const std::string& category, Level level) const { return true; }
 };
 
 #ifndef ENDL
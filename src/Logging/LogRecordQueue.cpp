@@ -0,0 +1,80 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "LogRecordQueue.h"
+
+#include <cstdint>
+
+namespace Logging {
+
+LogRecordQueue::LogRecordQueue(size_t capacity) : m_pushPosition(0), m_popPosition(0) {
+  size_t size = 2;
+  while (size < capacity) {
+    size <<= 1;
+  }
+
+  m_slots.reset(new Slot[size]);
+  m_mask = size - 1;
+  for (size_t i = 0; i < size; ++i) {
+    m_slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool LogRecordQueue::push(LogRecord&& record) {
+  size_t position = m_pushPosition.load(std::memory_order_relaxed);
+  Slot* slot;
+  for (;;) {
+    slot = &m_slots[position & m_mask];
+    size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    if (difference == 0) {
+      if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // the slot still holds the record pushed a whole ring ago
+      return false;
+    } else {
+      position = m_pushPosition.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->record = std::move(record);
+  slot->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+bool LogRecordQueue::pop(LogRecord& record) {
+  size_t position = m_popPosition.load(std::memory_order_relaxed);
+  Slot& slot = m_slots[position & m_mask];
+  if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+    return false;
+  }
+
+  record = std::move(slot.record);
+  slot.sequence.store(position + m_mask + 1, std::memory_order_release);
+  m_popPosition.store(position + 1, std::memory_order_relaxed);
+  return true;
+}
+
+bool LogRecordQueue::empty() const {
+  size_t position = m_popPosition.load(std::memory_order_relaxed);
+  return m_slots[position & m_mask].sequence.load(std::memory_order_acquire) != position + 1;
+}
+
+}
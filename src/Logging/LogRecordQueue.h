@@ -0,0 +1,63 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include "ILogger.h"
+
+namespace Logging {
+
+struct LogRecord {
+  std::string category;
+  Level level;
+  boost::posix_time::ptime time;
+  std::string body;
+};
+
+// Bounded ring of log records, any thread may push and a single thread pops.
+// Push and pop don't lock: every slot carries a sequence number telling whose turn it is.
+class LogRecordQueue {
+public:
+  // the capacity is rounded up to a power of two
+  explicit LogRecordQueue(size_t capacity);
+  LogRecordQueue(const LogRecordQueue&) = delete;
+  LogRecordQueue& operator=(const LogRecordQueue&) = delete;
+
+  // false if the queue is full
+  bool push(LogRecord&& record);
+  // false if the queue is empty, may only be called by one thread at a time
+  bool pop(LogRecord& record);
+  bool empty() const;
+
+private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    LogRecord record;
+  };
+
+  std::unique_ptr<Slot[]> m_slots;
+  size_t m_mask;
+  // producers and the consumer write different ends, keep them off a shared cache line
+  alignas(64) std::atomic<size_t> m_pushPosition;
+  alignas(64) std::atomic<size_t> m_popPosition;
+};
+
+}
@@ -40,4 +40,12 @@ void LoggerGroup::operator()(const std::string& category, Level level, boost::po
   }
 }
 
+bool LoggerGroup::isEnabled(const std::string& category, Level level) const {
+  if (!CommonLogger::isEnabled(category, level)) {
+    return false;
+  }
+
+  return std::any_of(loggers.begin(), loggers.end(), [&](const ILogger* logger) { return logger->isEnabled(category, level); });
+}
+
 }
@@ -25,15 +25,53 @@ namespace Logging {
 
 using Common::JsonValue;
 
-LoggerManager::LoggerManager() {
+namespace {
+
+const size_t LOG_QUEUE_CAPACITY = 8192;
+const size_t LOG_WRITER_BATCH_SIZE = 256;
+
+}
+
+LoggerManager::LoggerManager() : async(false), droppedCount(0), writerSleeping(false), stopWriting(false) {
+}
+
+LoggerManager::~LoggerManager() {
+  stopWriter();
 }
 
 void LoggerManager::operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) {
-  std::unique_lock<std::mutex> lock(reconfigureLock);
-  LoggerGroup::operator()(category, level, time, body);
+  if (!async.load(std::memory_order_acquire)) {
+    std::unique_lock<std::mutex> lock(reconfigureLock);
+    LoggerGroup::operator()(category, level, time, body);
+    return;
+  }
+
+  if (level > logLevel) {
+    return;
+  }
+
+  if (!queue->push(LogRecord{category, level, time, body})) {
+    ++droppedCount;
+    return;
+  }
+
+  // pairs with the fence in writerLoop: either the writer sees the record or we see it sleeping
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (writerSleeping.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    writerSleeping = false;
+    writerWakeUp.notify_one();
+  }
+}
+
+bool LoggerManager::isEnabled(const std::string& category, Level level) const {
+  return level <= logLevel;
 }
 
 void LoggerManager::configure(const JsonValue& val) {
+  // the writer takes the reconfigure lock for every batch, let it finish the queued messages first
+  stopWriter();
+
   std::unique_lock<std::mutex> lock(reconfigureLock);
   loggers.clear();
   LoggerGroup::loggers.clear();
@@ -119,10 +157,102 @@ void LoggerManager::configure(const JsonValue& val) {
   } else {
     throw std::runtime_error("loggers parameter missing");
   }
+  bool asyncWriting = false;
+  if (val.contains("async")) {
+    auto asyncVal = val("async");
+    if (asyncVal.isBool()) {
+      asyncWriting = asyncVal.getBool();
+    } else {
+      throw std::runtime_error("parameter async has wrong type");
+    }
+  }
+
+  for (auto& logger : loggers) {
+    logger->setAutoFlush(!asyncWriting);
+  }
+
   setMaxLevel(globalLevel);
   for (const auto& category : globalDisabledCategories) {
     disableCategory(category);
   }
+
+  lock.unlock();
+  if (asyncWriting) {
+    startWriter();
+  }
+}
+
+void LoggerManager::startWriter() {
+  if (!queue) {
+    queue.reset(new LogRecordQueue(LOG_QUEUE_CAPACITY));
+  }
+
+  stopWriting = false;
+  writerSleeping = false;
+  writer = std::thread(&LoggerManager::writerLoop, this);
+  async.store(true, std::memory_order_release);
+}
+
+void LoggerManager::stopWriter() {
+  if (!writer.joinable()) {
+    return;
+  }
+
+  async = false;
+  {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    stopWriting = true;
+  }
+
+  writerWakeUp.notify_one();
+  writer.join();
+}
+
+void LoggerManager::writerLoop() {
+  for (;;) {
+    if (writeQueuedRecords() == LOG_WRITER_BATCH_SIZE) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(writerMutex);
+    writerSleeping = true;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!queue->empty()) {
+      writerSleeping = false;
+      continue;
+    }
+
+    if (stopWriting) {
+      break;
+    }
+
+    writerWakeUp.wait(lock, [this] { return !writerSleeping || stopWriting; });
+    writerSleeping = false;
+  }
+}
+
+size_t LoggerManager::writeQueuedRecords() {
+  std::unique_lock<std::mutex> lock(reconfigureLock);
+  LogRecord record;
+  size_t count = 0;
+  while (count < LOG_WRITER_BATCH_SIZE && queue->pop(record)) {
+    LoggerGroup::operator()(record.category, record.level, record.time, record.body);
+    ++count;
+  }
+
+  size_t dropped = droppedCount.exchange(0);
+  if (dropped != 0) {
+    LoggerGroup::operator()("logging", WARNING, boost::posix_time::microsec_clock::local_time(),
+      YELLOW + std::to_string(dropped) + " log messages dropped, the log writer couldn't keep up\n");
+  }
+
+  if (count != 0 || dropped != 0) {
+    for (auto& logger : loggers) {
+      logger->flush();
+    }
+  }
+
+  return count;
 }
 
 }
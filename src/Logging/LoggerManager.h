@@ -18,24 +18,47 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include "../Common/JsonValue.h"
 #include "LoggerGroup.h"
+#include "LogRecordQueue.h"
 
 namespace Logging {
 
+// With "async": true in the configuration, messages are queued and the configured loggers are
+// called on a writer thread, which flushes them once per batch. When the queue is full new
+// messages are dropped and the writer reports how many.
 class LoggerManager : public LoggerGroup {
 public:
   LoggerManager();
-  virtual ~LoggerManager() override {}
+  virtual ~LoggerManager() override;
   void configure(const Common::JsonValue& val);
   virtual void operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) override;
+  // checks the level only, categories are checked once the message is written
+  virtual bool isEnabled(const std::string& category, Level level) const override;
 
 private:
   std::vector<std::unique_ptr<CommonLogger>> loggers;
   std::mutex reconfigureLock;
+
+  std::atomic<bool> async;
+  std::unique_ptr<LogRecordQueue> queue;
+  std::atomic<size_t> droppedCount;
+  std::thread writer;
+  std::mutex writerMutex;
+  std::condition_variable writerWakeUp;
+  std::atomic<bool> writerSleeping;
+  bool stopWriting;
+
+  void startWriter();
+  void stopWriter();
+  void writerLoop();
+  size_t writeQueuedRecords();
 };
 
 }
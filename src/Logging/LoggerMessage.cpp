@@ -37,10 +37,16 @@ LoggerMessage::LoggerMessage(ILogger& logger, const std::string& category, Level
 	, m_logger(logger)
 	, m_sCategory(category)
 	, m_nLogLevel(level)
-	, m_sMessage(color)
-	, m_tmTimeStamp(boost::posix_time::microsec_clock::local_time())
 	, m_bGotText(false)
-{}
+	, m_bEnabled(logger.isEnabled(category, level))
+{
+	if (m_bEnabled) {
+		m_sMessage = color;
+		m_tmTimeStamp = boost::posix_time::microsec_clock::local_time();
+	} else {
+		setstate(std::ios::badbit);
+	}
+}
 
 #if !defined(__linux__) || defined(__ANDROID__)
 LoggerMessage::LoggerMessage(LoggerMessage&& other)
@@ -50,10 +56,14 @@ LoggerMessage::LoggerMessage(LoggerMessage&& other)
 	, m_sCategory(other.m_sCategory)
 	, m_nLogLevel(other.m_nLogLevel)
 	, m_sMessage(other.m_sMessage)
-	, m_tmTimeStamp(boost::posix_time::microsec_clock::local_time())
+	, m_tmTimeStamp(other.m_tmTimeStamp)
 	, m_bGotText(false)
+	, m_bEnabled(other.m_bEnabled)
 {
 	std::ostream::rdbuf(this);
+	if (!m_bEnabled) {
+		setstate(std::ios::badbit);
+	}
 }
 #else
 LoggerMessage::LoggerMessage(LoggerMessage&& other)
@@ -63,8 +73,9 @@ LoggerMessage::LoggerMessage(LoggerMessage&& other)
   , m_nLogLevel(other.m_nLogLevel)
   , m_logger(other.m_logger)
   , m_sMessage(other.m_sMessage)
-  , m_tmTimeStamp(boost::posix_time::microsec_clock::local_time())
-  , m_bGotText(false) {
+  , m_tmTimeStamp(other.m_tmTimeStamp)
+  , m_bGotText(false)
+  , m_bEnabled(other.m_bEnabled) {
   if (this != &other) {
     _M_tie = nullptr;
     _M_streambuf = nullptr;
@@ -113,6 +124,10 @@ LoggerMessage::~LoggerMessage()
 
 int LoggerMessage::sync()
 {
+	if (!m_bEnabled) {
+		return 0;
+	}
+
 	m_logger(m_sCategory, m_nLogLevel, m_tmTimeStamp, m_sMessage);
 	m_bGotText = false;
 	m_sMessage = Logging::DEFAULT;
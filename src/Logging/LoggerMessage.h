@@ -34,6 +34,9 @@
 
 namespace Logging {
 
+// Collects a message and passes it to the logger on std::endl or when destroyed.
+// A message the logger would drop isn't collected at all: the stream is bad from the start,
+// so nothing streamed into it is formatted.
 class LoggerMessage : public std::ostream, std::streambuf
 {
 public:
@@ -55,6 +58,7 @@ private:
 	std::string m_sMessage;
 	boost::posix_time::ptime m_tmTimeStamp;
 	bool m_bGotText;
+	bool m_bEnabled;
 };
 
 } //Logging
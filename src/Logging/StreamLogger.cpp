@@ -35,16 +35,30 @@ void StreamLogger::attachToStream(std::ostream& stream) {
 void StreamLogger::doLogString(const std::string& message) {
   if (stream != nullptr && stream->good()) {
     std::lock_guard<std::mutex> lock(mutex);
+    // text and color names alternate between the delimiters, write the text runs only
     bool readingText = true;
-    for (size_t charPos = 0; charPos < message.size(); ++charPos) {
-      if (message[charPos] == ILogger::COLOR_DELIMETER) {
+    size_t runStart = 0;
+    for (size_t charPos = 0; charPos <= message.size(); ++charPos) {
+      if (charPos == message.size() || message[charPos] == ILogger::COLOR_DELIMETER) {
+        if (readingText && charPos > runStart) {
+          stream->write(message.data() + runStart, charPos - runStart);
+        }
+
         readingText = !readingText;
-      } else if (readingText) {
-        *stream << message[charPos];
+        runStart = charPos + 1;
       }
     }
 
-    *stream << std::flush;
+    if (autoFlush) {
+      *stream << std::flush;
+    }
+  }
+}
+
+void StreamLogger::flush() {
+  if (stream != nullptr) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stream->flush();
   }
 }
 
@@ -28,6 +28,7 @@ public:
   StreamLogger(Level level = DEBUGGING);
   StreamLogger(std::ostream& stream, Level level = DEBUGGING);
   void attachToStream(std::ostream& stream);
+  virtual void flush() override;
   virtual ~StreamLogger() override {}
 
 protected:
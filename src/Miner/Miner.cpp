@@ -21,9 +21,11 @@
 #include "Miner.h"
 
 #include <functional>
+#include <vector>
 
 #include "crypto/crypto.h"
 #include <crypto/random.h>
+#include "crypto/scratchpad-pool.h"
 #include "CryptoNoteCore/CachedBlock.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 
@@ -35,6 +37,8 @@ Miner::Miner(System::Dispatcher& dispatcher, Logging::ILogger& logger) :
   m_dispatcher(dispatcher),
   m_miningStopped(dispatcher),
   m_state(MiningState::MINING_STOPPED),
+  m_numaAffinity(false),
+  m_scratchpadsReported(false),
   m_logger(logger, "Miner") {
 }
 
@@ -66,6 +70,10 @@ BlockTemplate Miner::mine(const BlockMiningParameters& blockMiningParameters, si
   return m_block;
 }
 
+void Miner::setNumaAffinity(bool enabled) {
+  m_numaAffinity = enabled;
+}
+
 void Miner::stop() {
   MiningState state = MiningState::MINING_IN_PROGRESS;
 
@@ -84,7 +92,7 @@ void Miner::runWorkers(BlockMiningParameters blockMiningParameters, size_t threa
 
     for (size_t i = 0; i < threadCount; ++i) {
       m_workers.emplace_back(std::unique_ptr<System::RemoteContext<void>> (
-        new System::RemoteContext<void>(m_dispatcher, std::bind(&Miner::workerFunc, this, blockMiningParameters.blockTemplate, blockMiningParameters.difficulty, static_cast<uint32_t>(threadCount))))
+        new System::RemoteContext<void>(m_dispatcher, std::bind(&Miner::workerFunc, this, blockMiningParameters.blockTemplate, blockMiningParameters.difficulty, static_cast<uint32_t>(threadCount), static_cast<uint32_t>(i))))
       );
 
       blockMiningParameters.blockTemplate.nonce++;
@@ -100,27 +108,55 @@ void Miner::runWorkers(BlockMiningParameters blockMiningParameters, size_t threa
   m_miningStopped.set();
 }
 
-void Miner::workerFunc(const BlockTemplate& blockTemplate, Difficulty difficulty, uint32_t nonceStep) {
+void Miner::workerFunc(const BlockTemplate& blockTemplate, Difficulty difficulty, uint32_t nonceStep, uint32_t workerIndex) {
   try {
-    BlockTemplate block = blockTemplate;
+    if (m_numaAffinity) {
+      // the context below then takes its scratchpads from this node too
+      unsigned node = workerIndex % Crypto::numaNodeCount();
+      if (!Crypto::bindThreadToNumaNode(node)) {
+        m_logger(Logging::WARNING) << "Failed to bind worker " << workerIndex << " to NUMA node " << node;
+      }
+    }
+
+    // each worker tries as many nonces at once as the hash function can interleave
+    std::vector<BlockTemplate> blocks(Crypto::cn_slow_hash_lanes_count(), blockTemplate);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      blocks[i].nonce += static_cast<uint32_t>(i) * nonceStep;
+    }
+
+    uint32_t batchNonceStep = static_cast<uint32_t>(blocks.size()) * nonceStep;
     Crypto::cn_context cryptoContext;
 
     while (m_state == MiningState::MINING_IN_PROGRESS) {
-      CachedBlock cachedBlock(block);
-      Crypto::Hash hash = cachedBlock.getBlockLongHash(cryptoContext);
-      if (check_hash(hash, difficulty)) {
-        m_logger(Logging::INFO) << "Found block for difficulty " << difficulty;
+      std::vector<CachedBlock> cachedBlocks(blocks.begin(), blocks.end());
+      std::vector<const CachedBlock*> cachedBlockPointers;
+      for (const auto& cachedBlock : cachedBlocks) {
+        cachedBlockPointers.push_back(&cachedBlock);
+      }
+
+      CachedBlock::getBlockLongHashes(cachedBlockPointers.data(), cachedBlockPointers.size(), cryptoContext);
+      if (!m_scratchpadsReported.exchange(true)) {
+        Crypto::ScratchpadPoolStatistics statistics = Crypto::ScratchpadPool::instance().getStatistics();
+        m_logger(Logging::INFO) << "Hashing scratchpads: " << statistics.scratchpads << ", on huge pages: " << statistics.hugePageScratchpads;
+      }
+
+      for (size_t i = 0; i < blocks.size(); ++i) {
+        if (check_hash(cachedBlocks[i].getBlockLongHash(cryptoContext), difficulty)) {
+          m_logger(Logging::INFO) << "Found block for difficulty " << difficulty;
 
-        if (!setStateBlockFound()) {
-          m_logger(Logging::DEBUGGING) << "block is already found or mining stopped";
+          if (!setStateBlockFound()) {
+            m_logger(Logging::DEBUGGING) << "block is already found or mining stopped";
+            return;
+          }
+
+          m_block = blocks[i];
           return;
         }
-
-        m_block = block;
-        return;
       }
 
-      block.nonce += nonceStep;
+      for (auto& block : blocks) {
+        block.nonce += batchNonceStep;
+      }
     }
   } catch (std::exception& e) {
     m_logger(Logging::ERROR) << "Miner got error: " << e.what();
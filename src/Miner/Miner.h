@@ -47,6 +47,9 @@ public:
   //NOTE! this is blocking method
   void stop();
 
+  // worker threads are spread over NUMA nodes and kept on them
+  void setNumaAffinity(bool enabled);
+
 private:
   System::Dispatcher& m_dispatcher;
   System::Event m_miningStopped;
@@ -57,11 +60,13 @@ private:
   std::vector<std::unique_ptr<System::RemoteContext<void>>>  m_workers;
 
   BlockTemplate m_block;
+  bool m_numaAffinity;
+  std::atomic<bool> m_scratchpadsReported;
 
   Logging::LoggerRef m_logger;
 
   void runWorkers(BlockMiningParameters blockMiningParameters, size_t threadCount);
-  void workerFunc(const BlockTemplate& blockTemplate, Difficulty difficulty, uint32_t nonceStep);
+  void workerFunc(const BlockTemplate& blockTemplate, Difficulty difficulty, uint32_t nonceStep, uint32_t workerIndex);
   bool setStateBlockFound();
 };
 
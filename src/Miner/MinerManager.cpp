@@ -81,6 +81,7 @@ MinerManager::MinerManager(System::Dispatcher& dispatcher, const CryptoNote::Min
   m_httpEvent(dispatcher),
   m_lastBlockTimestamp(0) {
 
+  m_miner.setNumaAffinity(m_config.numaAffinity);
   m_httpEvent.set();
 }
 
@@ -64,7 +64,7 @@ void parseDaemonAddress(const std::string& daemonAddress, std::string& daemonHos
 
 }
 
-MiningConfig::MiningConfig(): help(false) {
+MiningConfig::MiningConfig(): numaAffinity(false), help(false) {
   cmdOptions.add_options()
       ("help,h", "produce this help message and exit")
       ("address", po::value<std::string>(), "Valid cryptonote miner's address")
@@ -75,6 +75,7 @@ MiningConfig::MiningConfig(): help(false) {
       ("scan-time", po::value<size_t>()->default_value(DEFAULT_SCANT_PERIOD), "Blockchain polling interval (seconds). How often miner will check blockchain for updates")
       ("log-level", po::value<int>()->default_value(1), "Log level. Must be 0..5")
       ("limit", po::value<size_t>()->default_value(0), "Mine exact quantity of blocks. 0 means no limit")
+      ("numa-affinity", po::bool_switch(), "Spread mining threads over NUMA nodes and keep each on its node")
       ("first-block-timestamp", po::value<uint64_t>()->default_value(0), "Set timestamp to the first mined block. 0 means leave timestamp unchanged")
       ("block-timestamp-interval", po::value<int64_t>()->default_value(0), "Timestamp step for each subsequent block. May be set only if --first-block-timestamp has been set."
                                                          " If not set blocks' timestamps remain unchanged");
@@ -130,6 +131,7 @@ void MiningConfig::parse(int argc, char** argv) {
 
   firstBlockTimestamp = options["first-block-timestamp"].as<uint64_t>();
   blockTimestampInterval = options["block-timestamp-interval"].as<int64_t>();
+  numaAffinity = options["numa-affinity"].as<bool>();
 }
 
 void MiningConfig::printHelp() {
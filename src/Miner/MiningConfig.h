@@ -38,6 +38,7 @@ struct MiningConfig {
   size_t blocksLimit;
   uint64_t firstBlockTimestamp;
   int64_t blockTimestampInterval;
+  bool numaAffinity;
   bool help;
 };
 
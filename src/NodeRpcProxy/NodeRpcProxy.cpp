@@ -32,6 +32,7 @@
 #include <System/Dispatcher.h>
 #include <System/Event.h>
 #include <System/EventLock.h>
+#include <System/InterruptedException.h>
 #include <System/Timer.h>
 #include <CryptoNoteCore/TransactionApi.h>
 #include "Common/FormatTools.h"
@@ -71,6 +72,7 @@ NodeRpcProxy::NodeRpcProxy(const std::string& nodeHost, unsigned short nodePort,
     m_logger(logger, "NodeRpcProxy"),
     m_rpcTimeout(10000),
     m_pullInterval(5000),
+    m_waitTimeout(20000),
     m_nodeHost(nodeHost),
     m_nodePort(nodePort),
     m_connected(false),
@@ -128,6 +130,9 @@ void NodeRpcProxy::resetInternalState() {
   lastLocalBlockHeaderInfo.difficulty = 0;
   lastLocalBlockHeaderInfo.reward = 0;
   m_knownTxs.clear();
+  // the TLS client blocks the whole dispatcher while it reads, a long poll over it would stall every other request
+  m_waitForChangesSupported = !m_daemon_ssl;
+  m_knownPoolVersion = 0;
 }
 
 void NodeRpcProxy::init(const INode::Callback& callback) {
@@ -162,6 +167,8 @@ bool NodeRpcProxy::shutdown() {
 
   m_dispatcher->remoteSpawn([this]() {
     m_stop = true;
+    // don't wait for a pending long poll or the pull interval to run out
+    m_pull_group->interrupt();
     // Run all spawned contexts
     m_dispatcher->yield();
   });
@@ -188,6 +195,10 @@ void NodeRpcProxy::workerThread(const INode::Callback& initialized_callback) {
     Event httpEvent(dispatcher);
     m_httpEvent = &httpEvent;
     m_httpEvent->set();
+    HttpClient waitClient(dispatcher, m_nodeHost, m_nodePort, m_daemon_ssl);
+    m_waitClient = &waitClient;
+    ContextGroup pullGroup(dispatcher);
+    m_pull_group = &pullGroup;
 
     {
       std::lock_guard<std::mutex> lock(m_mutex);
@@ -198,16 +209,32 @@ void NodeRpcProxy::workerThread(const INode::Callback& initialized_callback) {
 
     initialized_callback(std::error_code());
 
-    contextGroup.spawn([this]() {
-      Timer pullTimer(*m_dispatcher);
-      while (!m_stop) {
-        updateNodeStatus();
-        if (!m_stop) {
-          pullTimer.sleep(std::chrono::milliseconds(m_pullInterval));
+    pullGroup.spawn([this]() {
+      try {
+        Timer pullTimer(*m_dispatcher);
+        bool changed = true;
+        while (!m_stop) {
+          if (changed) {
+            updateNodeStatus();
+          } else {
+            updateNodeInfo();
+          }
+
+          if (!m_stop && m_waitForChangesSupported && !waitForChanges(changed)) {
+            continue;
+          }
+
+          // the daemon can't tell us about changes, ask it again after a while
+          changed = true;
+          if (!m_stop) {
+            pullTimer.sleep(std::chrono::milliseconds(m_pullInterval));
+          }
         }
+      } catch (InterruptedException&) {
       }
     });
 
+    pullGroup.wait();
     contextGroup.wait();
     // Make sure all remote spawns are executed
     m_dispatcher->yield();
@@ -216,8 +243,10 @@ void NodeRpcProxy::workerThread(const INode::Callback& initialized_callback) {
 
   m_dispatcher = nullptr;
   m_context_group = nullptr;
+  m_pull_group = nullptr;
   m_httpClient = nullptr;
   m_httpEvent = nullptr;
+  m_waitClient = nullptr;
   m_connected = false;
   m_rpcProxyObserverManager.notify(&INodeRpcProxyObserver::connectionStatusUpdated, m_connected);
 }
@@ -288,10 +317,14 @@ void NodeRpcProxy::updateBlockchainStatus() {
     }
   }
 
+  updateNodeInfo();
+}
+
+void NodeRpcProxy::updateNodeInfo() {
   CryptoNote::COMMAND_RPC_GET_INFO::request getInfoReq = AUTO_VAL_INIT(getInfoReq);
   CryptoNote::COMMAND_RPC_GET_INFO::response getInfoResp = AUTO_VAL_INIT(getInfoResp);
 
-  ec = jsonCommand("getinfo", getInfoReq, getInfoResp);
+  std::error_code ec = jsonCommand("getinfo", getInfoReq, getInfoResp);
   if (!ec) {
     //a quirk to let wallets work with previous versions daemons.
     //Previous daemons didn't have the 'last_known_block_index' parameter in RPC so it may have zero value.
@@ -330,6 +363,52 @@ void NodeRpcProxy::updateBlockchainStatus() {
   }
 }
 
+std::error_code NodeRpcProxy::waitForChanges(bool& changed) {
+  CryptoNote::COMMAND_RPC_WAIT_FOR_CHANGES::request req = AUTO_VAL_INIT(req);
+  CryptoNote::COMMAND_RPC_WAIT_FOR_CHANGES::response rsp = AUTO_VAL_INIT(rsp);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  req.tailBlockId = lastLocalBlockHeaderInfo.hash;
+  lock.unlock();
+  req.poolVersion = m_knownPoolVersion;
+  req.timeout = m_waitTimeout;
+
+  std::error_code ec;
+  try {
+    HttpRequest httpReq;
+    HttpResponse httpRes;
+
+    httpReq.addHeader("Content-Type", "application/json");
+    httpReq.setUrl(this->m_daemon_path + "wait_for_changes");
+    httpReq.setBody(storeToJson(req));
+
+    m_waitClient->request(httpReq, httpRes);
+
+    if (httpRes.getStatus() == HttpResponse::STATUS_404) {
+      m_logger(DEBUGGING) << "Daemon doesn't support wait_for_changes, polling it every " << m_pullInterval << " ms";
+      m_waitForChangesSupported = false;
+      ec = make_error_code(error::REQUEST_ERROR);
+    } else if (httpRes.getStatus() != HttpResponse::STATUS_200 || !loadFromJson(rsp, httpRes.getBody())) {
+      ec = make_error_code(error::INTERNAL_NODE_ERROR);
+    } else {
+      ec = interpretResponseStatus(rsp.status);
+    }
+  } catch (const ConnectException&) {
+    ec = make_error_code(error::CONNECT_ERROR);
+  } catch (const std::exception&) {
+    ec = make_error_code(error::NETWORK_ERROR);
+  }
+
+  if (ec) {
+    m_logger(TRACE) << "wait_for_changes request failed: " << ec << ", " << ec.message();
+    return ec;
+  }
+
+  changed = rsp.tailBlockId != req.tailBlockId || rsp.poolVersion != req.poolVersion;
+  m_knownPoolVersion = rsp.poolVersion;
+  return ec;
+}
+
 void NodeRpcProxy::updatePeerCount(size_t peerCount) {
   if (peerCount != m_peerCount) {
     m_peerCount = peerCount;
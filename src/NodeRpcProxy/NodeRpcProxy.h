@@ -128,7 +128,9 @@ private:
   void pullNodeStatusAndScheduleTheNext();
   void updateNodeStatus();
   void updateBlockchainStatus();
+  void updateNodeInfo();
   bool updatePoolStatus();
+  std::error_code waitForChanges(bool& changed);
   void updatePeerCount(size_t peerCount);
   void updatePoolState(const std::vector<std::unique_ptr<ITransactionReader>>& addedTxs, const std::vector<Crypto::Hash>& deletedTxsIds);
   void getFeeAddress();
@@ -174,20 +176,26 @@ private:
   std::thread m_workerThread;
   System::Dispatcher* m_dispatcher = nullptr;
   System::ContextGroup* m_context_group = nullptr;
+  System::ContextGroup* m_pull_group = nullptr;
   Tools::ObserverManager<CryptoNote::INodeObserver> m_observerManager;
   Tools::ObserverManager<CryptoNote::INodeRpcProxyObserver> m_rpcProxyObserverManager;
 
   unsigned int m_rpcTimeout;
   HttpClient* m_httpClient = nullptr;
   System::Event* m_httpEvent = nullptr;
+  // a connection of its own, so a pending long poll doesn't hold up the requests on m_httpClient
+  HttpClient* m_waitClient = nullptr;
 
   uint64_t m_pullInterval;
+  uint32_t m_waitTimeout;
 
   // Internal state
   bool m_stop = false;
   bool m_connected;
   bool m_daemon_no_verify;
   bool m_node_synced;
+  bool m_waitForChangesSupported;
+  uint64_t m_knownPoolVersion;
   std::atomic<size_t> m_peerCount;
   std::atomic<uint32_t> m_networkHeight;
   std::atomic<uint32_t> m_nodeHeight;
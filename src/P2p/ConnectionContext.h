@@ -55,6 +55,11 @@ struct CryptoNoteConnectionContext {
   std::unordered_set<Crypto::Hash> m_requested_objects;
   uint32_t m_remote_blockchain_height = 0;
   uint32_t m_last_response_height = 0;
+
+  // payload bytes queued for sending, shared ones are referenced by other connections as well
+  size_t m_send_queue_size = 0;
+  size_t m_send_queue_shared_size = 0;
+  size_t m_send_queue_peak_size = 0;
 };
 
 inline std::string get_protocol_state_string(CryptoNoteConnectionContext::state s) {
@@ -61,15 +61,7 @@ void LevinProtocol::sendMessage(uint32_t command, const BinaryArray& out, bool n
   head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
   head.m_flags = LEVIN_PACKET_REQUEST;
 
-  // write header and body in one operation
-  BinaryArray writeBuffer;
-  writeBuffer.reserve(sizeof(head) + out.size());
-
-  Common::VectorOutputStream stream(writeBuffer);
-  stream.writeSome(&head, sizeof(head));
-  stream.writeSome(out.data(), out.size());
-
-  writeStrict(writeBuffer.data(), writeBuffer.size());
+  writeMessage(reinterpret_cast<const uint8_t*>(&head), sizeof(head), out);
 }
 
 bool LevinProtocol::readCommand(Command& cmd) {
@@ -114,20 +106,26 @@ void LevinProtocol::sendReply(uint32_t command, const BinaryArray& out, int32_t
   head.m_flags = LEVIN_PACKET_RESPONSE;
   head.m_return_code = returnCode;
 
-  BinaryArray writeBuffer;
-  writeBuffer.reserve(sizeof(head) + out.size());
-
-  Common::VectorOutputStream stream(writeBuffer);
-  stream.writeSome(&head, sizeof(head));
-  stream.writeSome(out.data(), out.size());
-
-  writeStrict(writeBuffer.data(), writeBuffer.size());
+  writeMessage(reinterpret_cast<const uint8_t*>(&head), sizeof(head), out);
 }
 
-void LevinProtocol::writeStrict(const uint8_t* ptr, size_t size) {
-  size_t offset = 0;
-  while (offset < size) {
-    offset += m_conn.write(ptr + offset, size - offset);
+void LevinProtocol::writeMessage(const uint8_t* head, size_t headSize, const BinaryArray& body) {
+  // header and body go out in one operation, the body is not copied
+  System::TcpConnection::Buffer buffers[] = { { head, headSize }, { body.data(), body.size() } };
+  size_t count = body.empty() ? 1 : 2;
+  size_t index = 0;
+
+  while (index < count) {
+    size_t written = m_conn.writeBuffers(buffers + index, count - index);
+    while (index < count && written >= buffers[index].size) {
+      written -= buffers[index].size;
+      ++index;
+    }
+
+    if (index < count) {
+      buffers[index].data += written;
+      buffers[index].size -= written;
+    }
   }
 }
 
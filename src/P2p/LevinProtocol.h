@@ -19,9 +19,8 @@
 #pragma once
 
 #include "CryptoNote.h"
-#include <Common/MemoryInputStream.h>
 #include <Common/VectorOutputStream.h>
-#include "Serialization/KVBinaryInputStreamSerializer.h"
+#include "Serialization/KVBinaryStreamingInputSerializer.h"
 #include "Serialization/KVBinaryOutputStreamSerializer.h"
 
 namespace System {
@@ -84,8 +83,7 @@ public:
   template <typename T>
   static bool decode(const BinaryArray& buf, T& value) {
     try {
-      Common::MemoryInputStream stream(buf.data(), buf.size());
-      KVBinaryInputStreamSerializer serializer(stream);
+      KVBinaryStreamingInputSerializer serializer(buf.data(), buf.size());
       serialize(value, serializer);
     } catch (std::exception&) {
       return false;
@@ -107,7 +105,7 @@ public:
 private:
 
   bool readStrict(uint8_t* ptr, size_t size);
-  void writeStrict(const uint8_t* ptr, size_t size);
+  void writeMessage(const uint8_t* head, size_t headSize, const BinaryArray& body);
   System::TcpConnection& m_conn;
 };
 
@@ -176,11 +176,25 @@ std::string print_banlist_to_string(std::map<uint32_t, time_t> list) {
       return false;
     }
 
+    m_send_queue_size += msg.size();
+    if (msg.shared) {
+      m_send_queue_shared_size += msg.size();
+    }
+
+    m_send_queue_peak_size = std::max(m_send_queue_peak_size, m_send_queue_size);
+
     writeQueue.push_back(std::move(msg));
     queueEvent.set();
     return true;
   }
 
+  void P2pConnectionContext::onMessageSent(const P2pMessage& msg) {
+    m_send_queue_size -= msg.size();
+    if (msg.shared) {
+      m_send_queue_shared_size -= msg.size();
+    }
+  }
+
   std::vector<P2pMessage> P2pConnectionContext::popBuffer() {
     writeOperationStartTime = TimePoint();
 
@@ -354,10 +368,11 @@ std::string print_banlist_to_string(std::map<uint32_t, time_t> list) {
   //----------------------------------------------------------------------------------- 
   void NodeServer::externalRelayNotifyToList(int command, const BinaryArray &data_buff, const std::list<boost::uuids::uuid> relayList) {
     m_dispatcher.remoteSpawn([this, command, data_buff, relayList] {
+      auto buffer = std::make_shared<const BinaryArray>(data_buff);
       forEachConnection([&](P2pConnectionContext &conn) {
         if (std::find(relayList.begin(), relayList.end(), conn.m_connection_id) != relayList.end()) {
           if (conn.peerId && (conn.m_state == CryptoNoteConnectionContext::state_normal || conn.m_state == CryptoNoteConnectionContext::state_synchronizing)) {
-            conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, data_buff));
+            conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, buffer));
           }
         }
       });
@@ -733,7 +748,7 @@ std::string print_banlist_to_string(std::map<uint32_t, time_t> list) {
   bool NodeServer::timedSync() {
     COMMAND_TIMED_SYNC::request arg = boost::value_initialized<COMMAND_TIMED_SYNC::request>();
     m_payload_handler.get_payload_sync_data(arg.payload_data);
-    auto cmdBuf = LevinProtocol::encode<COMMAND_TIMED_SYNC::request>(arg);
+    auto cmdBuf = std::make_shared<const BinaryArray>(LevinProtocol::encode<COMMAND_TIMED_SYNC::request>(arg));
 
     forEachConnection([&](P2pConnectionContext& conn) {
       if (conn.peerId && 
@@ -1257,12 +1272,13 @@ std::string print_banlist_to_string(std::map<uint32_t, time_t> list) {
   //-----------------------------------------------------------------------------------
   void NodeServer::relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) {
     net_connection_id excludeId = excludeConnection ? *excludeConnection : boost::value_initialized<net_connection_id>();
+    auto buffer = std::make_shared<const BinaryArray>(data_buff);
 
     forEachConnection([&](P2pConnectionContext& conn) {
       if (conn.peerId && conn.m_connection_id != excludeId &&
           (conn.m_state == CryptoNoteConnectionContext::state_normal ||
            conn.m_state == CryptoNoteConnectionContext::state_synchronizing)) {
-        conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, data_buff));
+        conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, buffer));
       }
     });
   }
@@ -1727,17 +1743,19 @@ std::string print_banlist_to_string(std::map<uint32_t, time_t> list) {
           logger(DEBUGGING) << ctx << "msg " << msg.type << ':' << msg.command;
           switch (msg.type) {
           case P2pMessage::COMMAND:
-            proto.sendMessage(msg.command, msg.buffer, true);
+            proto.sendMessage(msg.command, *msg.buffer, true);
             break;
           case P2pMessage::NOTIFY:
-            proto.sendMessage(msg.command, msg.buffer, false);
+            proto.sendMessage(msg.command, *msg.buffer, false);
             break;
           case P2pMessage::REPLY:
-            proto.sendReply(msg.command, msg.buffer, msg.returnCode);
+            proto.sendReply(msg.command, *msg.buffer, msg.returnCode);
             break;
           default:
             assert(false);
           }
+
+          ctx.onMessageSent(msg);
         }
       }
     } catch (System::InterruptedException&) {
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <unordered_map>
 
 #include <boost/functional/hash.hpp>
@@ -64,21 +65,31 @@ namespace CryptoNote
     };
 
     P2pMessage(Type type, uint32_t command, const BinaryArray& buffer, int32_t returnCode = 0) :
-      type(type), command(command), buffer(buffer), returnCode(returnCode) {
+      type(type), command(command), buffer(std::make_shared<const BinaryArray>(buffer)), returnCode(returnCode), shared(false) {
+    }
+
+    P2pMessage(Type type, uint32_t command, BinaryArray&& buffer, int32_t returnCode = 0) :
+      type(type), command(command), buffer(std::make_shared<const BinaryArray>(std::move(buffer))), returnCode(returnCode), shared(false) {
+    }
+
+    // the payload is shared by all connections the message is relayed to
+    P2pMessage(Type type, uint32_t command, const std::shared_ptr<const BinaryArray>& buffer) :
+      type(type), command(command), buffer(buffer), returnCode(0), shared(true) {
     }
 
     P2pMessage(P2pMessage&& msg) :
-      type(msg.type), command(msg.command), buffer(std::move(msg.buffer)), returnCode(msg.returnCode) {
+      type(msg.type), command(msg.command), buffer(std::move(msg.buffer)), returnCode(msg.returnCode), shared(msg.shared) {
     }
 
-    size_t size() {
-      return buffer.size();
+    size_t size() const {
+      return buffer->size();
     }
 
     Type type;
     uint32_t command;
-    const BinaryArray buffer;
+    std::shared_ptr<const BinaryArray> buffer;
     int32_t returnCode;
+    bool shared;
   };
 
   struct P2pConnectionContext : public CryptoNoteConnectionContext {
@@ -112,6 +123,7 @@ namespace CryptoNote
 
     bool pushMessage(P2pMessage&& msg);
     std::vector<P2pMessage> popBuffer();
+    void onMessageSent(const P2pMessage& msg);
     void interrupt();
 
     uint64_t writeDuration(TimePoint now) const;
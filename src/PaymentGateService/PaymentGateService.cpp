@@ -259,7 +259,7 @@ void PaymentGateService::runInProcess(Logging::LoggerRef& log) {
     logger,
     std::move(checkpoints),
     *dispatcher,
-    std::unique_ptr<CryptoNote::IBlockchainCacheFactory>(new CryptoNote::DatabaseBlockchainCacheFactory(*database, log.getLogger())),
+    std::unique_ptr<CryptoNote::IBlockchainCacheFactory>(new CryptoNote::DatabaseBlockchainCacheFactory(*database, log.getLogger(), dbConfig.getDataDir())),
     transactionValidationThreads);
 
   core.load(emptyMiner);
@@ -28,6 +28,11 @@ class Ipv4Address;
 
 class TcpConnection {
 public:
+  struct Buffer {
+    const uint8_t* data;
+    std::size_t size;
+  };
+
   TcpConnection();
   TcpConnection(const TcpConnection&) = delete;
   TcpConnection(TcpConnection&& other);
@@ -36,6 +41,8 @@ public:
   TcpConnection& operator=(TcpConnection&& other);
   std::size_t read(uint8_t* data, std::size_t size);
   std::size_t write(const uint8_t* data, std::size_t size);
+  // one gather write of the buffers, returns the number of bytes written
+  std::size_t writeBuffers(const Buffer* buffers, std::size_t count);
   std::pair<Ipv4Address, uint16_t> getPeerAddressAndPort() const;
 
 private:
@@ -23,7 +23,10 @@
 #include <cstdint>
 #include <stdexcept>
 #include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <vector>
 
 #include <System/ErrorMessage.h>
 #include <System/InterruptedException.h>
@@ -31,6 +34,23 @@
 
 namespace System {
 
+namespace {
+
+ssize_t sendBuffers(int connection, const TcpConnection::Buffer* buffers, std::size_t count, int flags) {
+  std::vector<iovec> vectors(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    vectors[i].iov_base = const_cast<uint8_t*>(buffers[i].data);
+    vectors[i].iov_len = buffers[i].size;
+  }
+
+  msghdr message = {};
+  message.msg_iov = vectors.data();
+  message.msg_iovlen = vectors.size();
+  return ::sendmsg(connection, &message, flags);
+}
+
+}
+
 TcpConnection::TcpConnection() : dispatcher(nullptr) {
 }
 
@@ -167,6 +187,16 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
 }
 
 std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
+  Buffer buffer = { data, size };
+  return writeBuffers(&buffer, 1);
+}
+
+std::size_t TcpConnection::writeBuffers(const Buffer* buffers, std::size_t count) {
+  std::size_t size = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    size += buffers[i].size;
+  }
+
   assert(dispatcher != nullptr);
   assert(contextPair.writeContext == nullptr);
   if (dispatcher->interrupted()) {
@@ -182,7 +212,7 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
-  ssize_t transferred = ::send(connection, (void *)data, size, MSG_NOSIGNAL);
+  ssize_t transferred = sendBuffers(connection, buffers, count, MSG_NOSIGNAL);
   if (transferred == -1) {
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wlogical-op"
@@ -248,7 +278,7 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
           throw std::runtime_error("TcpConnection::write, events & (EPOLLERR | EPOLLHUP) != 0");
         }
 
-        ssize_t transferred = ::send(connection, (void *)data, size, 0);
+        ssize_t transferred = sendBuffers(connection, buffers, count, 0);
         if (transferred == -1) {
           message = "send failed, "  + lastErrorMessage();
         } else {
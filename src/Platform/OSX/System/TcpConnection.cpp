@@ -23,7 +23,9 @@
 #include <sys/event.h>
 #include <sys/errno.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <vector>
 
 #include "Dispatcher.h"
 #include <System/ErrorMessage.h>
@@ -32,6 +34,23 @@
 
 namespace System {
 
+namespace {
+
+ssize_t sendBuffers(int connection, const TcpConnection::Buffer* buffers, std::size_t count, int flags) {
+  std::vector<iovec> vectors(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    vectors[i].iov_base = const_cast<uint8_t*>(buffers[i].data);
+    vectors[i].iov_len = buffers[i].size;
+  }
+
+  msghdr message = {};
+  message.msg_iov = vectors.data();
+  message.msg_iovlen = vectors.size();
+  return ::sendmsg(connection, &message, flags);
+}
+
+}
+
 TcpConnection::TcpConnection() : dispatcher(nullptr) {
 }
 
@@ -145,7 +164,17 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
   return transferred;
 }
 
-size_t TcpConnection::write(const uint8_t* data, size_t size) {
+std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
+  Buffer buffer = { data, size };
+  return writeBuffers(&buffer, 1);
+}
+
+std::size_t TcpConnection::writeBuffers(const Buffer* buffers, std::size_t count) {
+  std::size_t size = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    size += buffers[i].size;
+  }
+
   assert(dispatcher != nullptr);
   assert(writeContext == nullptr);
   if (dispatcher->interrupted()) {
@@ -161,7 +190,7 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
-  ssize_t transferred = ::send(connection, (void *)data, size, 0);
+  ssize_t transferred = sendBuffers(connection, buffers, count, 0);
   if (transferred == -1) {
     if (errno != EAGAIN  && errno != EWOULDBLOCK) {
       message = "send failed, " + lastErrorMessage();
@@ -203,7 +232,7 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
           throw InterruptedException();
         }
 
-        ssize_t transferred = ::send(connection, (void *)data, size, 0);
+        ssize_t transferred = sendBuffers(connection, buffers, count, 0);
         if (transferred == -1) {
           message = "send failed, " + lastErrorMessage();
         } else {
@@ -19,6 +19,7 @@
 #include "TcpConnection.h"
 #include <cassert>
 #include <stdexcept>
+#include <vector>
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
@@ -152,6 +153,16 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
 }
 
 size_t TcpConnection::write(const uint8_t* data, size_t size) {
+  Buffer buffer = { data, size };
+  return writeBuffers(&buffer, 1);
+}
+
+size_t TcpConnection::writeBuffers(const Buffer* buffers, size_t count) {
+  size_t size = 0;
+  for (size_t i = 0; i < count; ++i) {
+    size += buffers[i].size;
+  }
+
   assert(dispatcher != nullptr);
   assert(writeContext == nullptr);
   if (dispatcher->interrupted()) {
@@ -166,10 +177,14 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
-  WSABUF buf{static_cast<ULONG>(size), reinterpret_cast<char*>(const_cast<uint8_t*>(data))};
+  std::vector<WSABUF> bufs(count);
+  for (size_t i = 0; i < count; ++i) {
+    bufs[i] = WSABUF{static_cast<ULONG>(buffers[i].size), reinterpret_cast<char*>(const_cast<uint8_t*>(buffers[i].data))};
+  }
+
   TcpConnectionContext context;
   context.hEvent = NULL;
-  if (WSASend(connection, &buf, 1, NULL, 0, &context, NULL) != 0) {
+  if (WSASend(connection, bufs.data(), static_cast<DWORD>(bufs.size()), NULL, 0, &context, NULL) != 0) {
     int lastError = WSAGetLastError();
     if (lastError != WSA_IO_PENDING) {
       throw std::runtime_error("TcpConnection::write, WSASend failed, " + errorMessage(lastError));
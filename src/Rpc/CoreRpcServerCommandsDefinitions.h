@@ -159,6 +159,35 @@ struct COMMAND_RPC_GET_POOL_CHANGES_LITE {
   };
 };
 
+//-----------------------------------------------
+// Long poll: answers as soon as the tail block differs from tailBlockId or the pool from poolVersion,
+// or once timeout milliseconds have passed without a change
+struct COMMAND_RPC_WAIT_FOR_CHANGES {
+  struct request {
+    Crypto::Hash tailBlockId;
+    uint64_t poolVersion; // 0 if not known yet
+    uint32_t timeout;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(tailBlockId)
+      KV_MEMBER(poolVersion)
+      KV_MEMBER(timeout)
+    }
+  };
+
+  struct response {
+    Crypto::Hash tailBlockId;
+    uint64_t poolVersion;
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(tailBlockId)
+      KV_MEMBER(poolVersion)
+      KV_MEMBER(status)
+    }
+  };
+};
+
 //-----------------------------------------------
 struct COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES {
   
@@ -369,6 +398,9 @@ struct p2p_connection_entry
   uint64_t started = 0;
   uint32_t remote_blockchain_height = 0;
   uint32_t last_response_height = 0;
+  uint64_t send_queue_size = 0;
+  uint64_t send_queue_shared_size = 0;
+  uint64_t send_queue_peak_size = 0;
 
   void serialize(ISerializer& s)
   {
@@ -381,6 +413,9 @@ struct p2p_connection_entry
     KV_MEMBER(started)
     KV_MEMBER(remote_blockchain_height)
     KV_MEMBER(last_response_height)
+    KV_MEMBER(send_queue_size)
+    KV_MEMBER(send_queue_shared_size)
+    KV_MEMBER(send_queue_peak_size)
   }
 };
 
@@ -398,6 +433,40 @@ struct COMMAND_RPC_GET_CONNECTIONS {
   };
 };
 
+//-----------------------------------------------
+struct rpc_endpoint_stats
+{
+  std::string endpoint;
+  uint64_t calls = 0;
+  uint64_t total_us = 0;
+  uint64_t max_us = 0;
+  // histogram[0] counts calls which took under 1 us, histogram[i] the ones in [2^(i-1), 2^i) us
+  std::vector<uint64_t> histogram;
+
+  void serialize(ISerializer& s)
+  {
+    KV_MEMBER(endpoint)
+    KV_MEMBER(calls)
+    KV_MEMBER(total_us)
+    KV_MEMBER(max_us)
+    KV_MEMBER(histogram)
+  }
+};
+
+struct COMMAND_RPC_GET_RPC_STATS {
+  typedef EMPTY_STRUCT request;
+
+  struct response {
+    std::vector<rpc_endpoint_stats> endpoints;
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(endpoints)
+      KV_MEMBER(status)
+    }
+  };
+};
+
 //-----------------------------------------------
 struct COMMAND_RPC_GET_FEE_ADDRESS {
   typedef EMPTY_STRUCT request;
@@ -20,14 +20,13 @@
 
 #pragma once 
 
+#include <memory>
 #include <unordered_set>
 #include <string.h>
 
 #include <HTTP/HttpRequest.h>
 #include <HTTP/HttpResponse.h>
-#include <boost/asio.hpp>
-#include <boost/asio/ssl/stream.hpp>
-#include <boost/thread/thread.hpp>
+#include <boost/asio/ssl/context.hpp>
 
 #include <System/ContextGroup.h>
 #include <System/Dispatcher.h>
@@ -57,31 +56,24 @@ protected:
   System::Dispatcher& m_dispatcher;
 
 private:
-  bool m_server_ssl_do;
-  bool m_server_ssl_is_run;
-  uint16_t m_server_ssl_port;
-  unsigned int m_server_ssl_clients;
-  std::string m_address;
   std::string m_chain_file;
   std::string m_dh_file;
   std::string m_key_file;
   std::string m_credentials;
   std::unordered_set<System::TcpConnection*> m_connections;
-  boost::thread m_ssl_server_thread;
+  // one group per TLS connection, so a request timeout only interrupts its own connection
+  std::unordered_set<System::ContextGroup*> m_sslSessions;
+  std::unique_ptr<boost::asio::ssl::context> m_sslContext;
   System::ContextGroup workingContextGroup;
   System::TcpListener m_listener;
+  System::TcpListener m_sslListener;
   Logging::LoggerRef logger;
   void acceptLoop();
+  void sslAcceptLoop();
+  void sslSessionHandler(System::TcpConnection& connection, System::ContextGroup& sessionGroup, const std::string& peer);
+  void serveRequests(std::iostream& stream, const std::string& peer, System::ContextGroup* timeoutGroup);
   bool authenticate(const HttpRequest& request) const;
   void connectionHandler(System::TcpConnection&& conn);
-  void sslServerUnitControl(boost::asio::ssl::stream<boost::asio::ip::tcp::socket&> &stream,
-                            boost::system::error_code &ec,
-                            bool &unit_do,
-                            bool &unit_control_do,
-                            size_t &stream_timeout_n);
-  void sslServerUnit(boost::asio::ip::tcp::socket &socket, boost::asio::ssl::context &ctx);
-  void sslServerControl(boost::asio::ip::tcp::acceptor &accept);
-  void sslServer();
 
 };
 
@@ -31,6 +31,7 @@
 #include "Common/Base58.h"
 #include "Common/DnsTools.h"
 #include "Common/Math.h"
+#include "Common/ScopeExit.h"
 #include "Common/StringTools.h"
 #include "CryptoNoteCore/TransactionUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
@@ -43,6 +44,9 @@
 #include "CryptoNoteProtocol/ICryptoNoteProtocolQuery.h"
 #include "P2p/ConnectionContext.h"
 #include "P2p/NetNode.h"
+#include <System/Event.h>
+#include <System/InterruptedException.h>
+#include <System/Timer.h>
 
 #include "CoreRpcServerErrorCodes.h"
 #include "JsonRpc.h"
@@ -54,6 +58,7 @@ using namespace Crypto;
 using namespace Common;
 
 const uint64_t BLOCK_LIST_MAX_COUNT = 1000;
+const uint32_t WAIT_FOR_CHANGES_MAX_TIMEOUT = 30000;
 
 namespace CryptoNote {
 
@@ -161,62 +166,99 @@ RpcServer::HandlerFunction httpMethod(bool (RpcServer::*handler)(typename Comman
 std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction>> RpcServer::s_handlers = {
   
   // binary handlers
-  { "/getblocks.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::onGetBlocks), true } },
-  { "/queryblocks.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::onQueryBlocks), true } },
-  { "/queryblockslite.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::onQueryBlocksLite), true } },
-  { "/get_o_indexes.bin", { binMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::onGetIndexes), true } },
-  { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::onGetRandomOuts), true } },
-  { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), true } },
-  { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), true } },
+  { "/getblocks.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::onGetBlocks), true, Execution::ON_SNAPSHOT } },
+  { "/queryblocks.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::onQueryBlocks), true, Execution::READ_LOCKED } },
+  { "/queryblockslite.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::onQueryBlocksLite), true, Execution::READ_LOCKED } },
+  { "/get_o_indexes.bin", { binMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::onGetIndexes), true, Execution::ON_SNAPSHOT } },
+  { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::onGetRandomOuts), true, Execution::READ_LOCKED } },
+  { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), true, Execution::READ_LOCKED } },
+  { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), true, Execution::READ_LOCKED } },
 
   // plain text/html handlers
-  { "/", { httpMethod<COMMAND_HTTP>(&RpcServer::onGetIndex), true } },
-  { "/supply", { httpMethod<COMMAND_HTTP>(&RpcServer::onGetSupply), false } },
-  { "/paymentid", { httpMethod<COMMAND_HTTP>(&RpcServer::onGeneratePaymentId), true } },
+  { "/", { httpMethod<COMMAND_HTTP>(&RpcServer::onGetIndex), true, Execution::ON_DISPATCHER } },
+  { "/supply", { httpMethod<COMMAND_HTTP>(&RpcServer::onGetSupply), false, Execution::READ_LOCKED } },
+  { "/paymentid", { httpMethod<COMMAND_HTTP>(&RpcServer::onGeneratePaymentId), true, Execution::ON_DISPATCHER } },
 
   // get json handlers
-  { "/getinfo", { jsonMethod<COMMAND_RPC_GET_INFO>(&RpcServer::onGetInfo), true } },
-  { "/getheight", { jsonMethod<COMMAND_RPC_GET_HEIGHT>(&RpcServer::onGetHeight), true } },
-  { "/feeaddress", { jsonMethod<COMMAND_RPC_GET_FEE_ADDRESS>(&RpcServer::onGetFeeAddress), true } },
-  { "/gettransactionspool", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_POOL_SHORT>(&RpcServer::onGetTransactionsPoolShort), true } },
-  { "/gettransactionsinpool", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_POOL>(&RpcServer::onGetTransactionsPool), true } },
-  { "/getrawtransactionspool", { jsonMethod<COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL>(&RpcServer::onGetTransactionsPoolRaw), true } },
+  { "/getinfo", { jsonMethod<COMMAND_RPC_GET_INFO>(&RpcServer::onGetInfo), true, Execution::ON_DISPATCHER } },
+  { "/getheight", { jsonMethod<COMMAND_RPC_GET_HEIGHT>(&RpcServer::onGetHeight), true, Execution::READ_LOCKED } },
+  { "/feeaddress", { jsonMethod<COMMAND_RPC_GET_FEE_ADDRESS>(&RpcServer::onGetFeeAddress), true, Execution::ON_DISPATCHER } },
+  { "/gettransactionspool", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_POOL_SHORT>(&RpcServer::onGetTransactionsPoolShort), true, Execution::READ_LOCKED } },
+  { "/gettransactionsinpool", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_POOL>(&RpcServer::onGetTransactionsPool), true, Execution::READ_LOCKED } },
+  { "/getrawtransactionspool", { jsonMethod<COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL>(&RpcServer::onGetTransactionsPoolRaw), true, Execution::READ_LOCKED } },
 
   // disabled in restricted rpc mode
-  { "/getpeers", { jsonMethod<COMMAND_RPC_GET_PEER_LIST>(&RpcServer::onGetPeerList), true } },
-  { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::onStopDaemon), true } },
-  { "/getconnections", { jsonMethod<COMMAND_RPC_GET_CONNECTIONS>(&RpcServer::onGetConnections), true } },
+  { "/getpeers", { jsonMethod<COMMAND_RPC_GET_PEER_LIST>(&RpcServer::onGetPeerList), true, Execution::ON_DISPATCHER } },
+  { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::onStopDaemon), true, Execution::ON_DISPATCHER } },
+  { "/getconnections", { jsonMethod<COMMAND_RPC_GET_CONNECTIONS>(&RpcServer::onGetConnections), true, Execution::ON_DISPATCHER } },
+  { "/getrpcstats", { jsonMethod<COMMAND_RPC_GET_RPC_STATS>(&RpcServer::onGetRpcStats), true, Execution::ON_DISPATCHER } },
 
   // post json handlers
-  { "/gettransactions", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS>(&RpcServer::onGetTransactions), false } },
-  { "/sendrawtransaction", { jsonMethod<COMMAND_RPC_SEND_RAW_TX>(&RpcServer::onSendRawTx), false } },
-  { "/getblocks", { jsonMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::onGetBlocks), false } },
-  { "/queryblocks", { jsonMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::onQueryBlocks), false } },
-  { "/queryblockslite", { jsonMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::onQueryBlocksLite), false } },
-  { "/get_o_indexes", { jsonMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::onGetIndexes), false } },
-  { "/getrandom_outs", { jsonMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::onGetRandomOuts), false } },
-  { "/get_pool_changes", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), true } },
-  { "/get_pool_changes_lite", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), true } },
-  { "/get_block_details_by_height", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT>(&RpcServer::onGetBlockDetailsByHeight), false } },
-  { "/get_block_details_by_hash", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HASH>(&RpcServer::onGetBlockDetailsByHash), false } },
-  { "/get_blocks_details_by_heights", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS>(&RpcServer::onGetBlocksDetailsByHeights), false } },
-  { "/get_blocks_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES>(&RpcServer::onGetBlocksDetailsByHashes), false } },
-  { "/get_blocks_hashes_by_timestamps", { jsonMethod<COMMAND_RPC_GET_BLOCKS_HASHES_BY_TIMESTAMPS>(&RpcServer::onGetBlocksHashesByTimestamps), false } },
-  { "/get_transaction_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASHES>(&RpcServer::onGetTransactionDetailsByHashes), false } },
-  { "/get_transaction_details_by_hash", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASH>(&RpcServer::onGetTransactionDetailsByHash), false } },
-  { "/get_transaction_details_by_heights", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HEIGHTS>(&RpcServer::onGetTransactionDetailsByHeights), false } },
-  { "/get_raw_transactions_by_heights", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_WITH_OUTPUT_GLOBAL_INDEXES_BY_HEIGHTS>(&RpcServer::onGetTransactionsWithOutputGlobalIndexesByHeights), false } },
-  { "/get_transaction_hashes_by_payment_id", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID>(&RpcServer::onGetTransactionHashesByPaymentId), false } },
+  { "/gettransactions", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS>(&RpcServer::onGetTransactions), false, Execution::READ_LOCKED } },
+  { "/sendrawtransaction", { jsonMethod<COMMAND_RPC_SEND_RAW_TX>(&RpcServer::onSendRawTx), false, Execution::ON_DISPATCHER } },
+  { "/getblocks", { jsonMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::onGetBlocks), false, Execution::ON_SNAPSHOT } },
+  { "/queryblocks", { jsonMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::onQueryBlocks), false, Execution::READ_LOCKED } },
+  { "/queryblockslite", { jsonMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::onQueryBlocksLite), false, Execution::READ_LOCKED } },
+  { "/get_o_indexes", { jsonMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::onGetIndexes), false, Execution::ON_SNAPSHOT } },
+  { "/getrandom_outs", { jsonMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::onGetRandomOuts), false, Execution::READ_LOCKED } },
+  { "/get_pool_changes", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), true, Execution::READ_LOCKED } },
+  { "/get_pool_changes_lite", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), true, Execution::READ_LOCKED } },
+  { "/wait_for_changes", { jsonMethod<COMMAND_RPC_WAIT_FOR_CHANGES>(&RpcServer::onWaitForChanges), true, Execution::ON_DISPATCHER } },
+  { "/get_block_details_by_height", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT>(&RpcServer::onGetBlockDetailsByHeight), false, Execution::READ_LOCKED } },
+  { "/get_block_details_by_hash", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HASH>(&RpcServer::onGetBlockDetailsByHash), false, Execution::READ_LOCKED } },
+  { "/get_blocks_details_by_heights", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS>(&RpcServer::onGetBlocksDetailsByHeights), false, Execution::READ_LOCKED } },
+  { "/get_blocks_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES>(&RpcServer::onGetBlocksDetailsByHashes), false, Execution::READ_LOCKED } },
+  { "/get_blocks_hashes_by_timestamps", { jsonMethod<COMMAND_RPC_GET_BLOCKS_HASHES_BY_TIMESTAMPS>(&RpcServer::onGetBlocksHashesByTimestamps), false, Execution::READ_LOCKED } },
+  { "/get_transaction_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASHES>(&RpcServer::onGetTransactionDetailsByHashes), false, Execution::READ_LOCKED } },
+  { "/get_transaction_details_by_hash", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASH>(&RpcServer::onGetTransactionDetailsByHash), false, Execution::READ_LOCKED } },
+  { "/get_transaction_details_by_heights", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HEIGHTS>(&RpcServer::onGetTransactionDetailsByHeights), false, Execution::READ_LOCKED } },
+  { "/get_raw_transactions_by_heights", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_WITH_OUTPUT_GLOBAL_INDEXES_BY_HEIGHTS>(&RpcServer::onGetTransactionsWithOutputGlobalIndexesByHeights), false, Execution::READ_LOCKED } },
+  { "/get_transaction_hashes_by_payment_id", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID>(&RpcServer::onGetTransactionHashesByPaymentId), false, Execution::READ_LOCKED } },
 
   // json rpc
-  { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } }
+  { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true, Execution::ON_DISPATCHER } }
 };
 
 RpcServer::RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, Core& c, NodeServer& p2p, ICryptoNoteProtocolHandler& protocol) :
-  HttpServer(dispatcher, log), logger(log, "RpcServer"), m_core(c), m_p2p(p2p), m_protocol(protocol) {
+  HttpServer(dispatcher, log), logger(log, "RpcServer"), m_core(c), m_p2p(p2p), m_protocol(protocol),
+  m_blockchainMessages(dispatcher), m_watchContext(dispatcher), m_poolVersion(1) {
+  m_core.addMessageQueue(m_blockchainMessages);
+  m_watchContext.spawn([this] { watchBlockchain(); });
+}
+
+RpcServer::~RpcServer() {
+  m_core.removeMessageQueue(m_blockchainMessages);
+  m_blockchainMessages.stop();
+  m_watchContext.interrupt();
+  m_watchContext.wait();
+}
+
+void RpcServer::watchBlockchain() {
+  try {
+    for (;;) {
+      BlockchainMessage::Type type = m_blockchainMessages.front().getType();
+      m_blockchainMessages.pop();
+      if (type == BlockchainMessage::Type::AddTransaction || type == BlockchainMessage::Type::DeleteTransaction) {
+        ++m_poolVersion;
+      }
+
+      // every waiter compares its own state, a burst of messages wakes it only once
+      for (System::Event* waiter : m_changeWaiters) {
+        waiter->set();
+      }
+    }
+  } catch (System::InterruptedException&) {
+  }
 }
 
 void RpcServer::processRequest(const HttpRequest& request, HttpResponse& response) {
+  auto start = std::chrono::steady_clock::now();
+  std::string endpoint;
+  Tools::ScopeExit recordLatency([&] {
+    if (!endpoint.empty()) {
+      addLatency(endpoint, start);
+    }
+  });
 
   try {
 
@@ -250,7 +292,8 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
         COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT::request req;
         req.blockHeight = height;
         COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT::response rsp;
-        bool r = onGetBlockDetailsByHeight(req, rsp);
+        endpoint = block_height_method;
+        bool r = runReadOnly(Execution::READ_LOCKED, [&] { return onGetBlockDetailsByHeight(req, rsp); });
         if (r) {
           response.addHeader("Content-Type", "application/json");
           response.setStatus(HttpResponse::HTTP_STATUS::STATUS_200);
@@ -275,7 +318,8 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
         COMMAND_RPC_GET_BLOCK_DETAILS_BY_HASH::request req;
         req.hash = hash_str;
         COMMAND_RPC_GET_BLOCK_DETAILS_BY_HASH::response rsp;
-        bool r = onGetBlockDetailsByHash(req, rsp);
+        endpoint = block_hash_method;
+        bool r = runReadOnly(Execution::READ_LOCKED, [&] { return onGetBlockDetailsByHash(req, rsp); });
         if (r) {
           response.addHeader("Content-Type", "application/json");
           response.setStatus(HttpResponse::HTTP_STATUS::STATUS_200);
@@ -300,7 +344,8 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
         COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASH::request req;
         req.hash = hash_str;
         COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASH::response rsp;
-        bool r = onGetTransactionDetailsByHash(req, rsp);
+        endpoint = tx_hash_method;
+        bool r = runReadOnly(Execution::READ_LOCKED, [&] { return onGetTransactionDetailsByHash(req, rsp); });
         if (r) {
           response.addHeader("Content-Type", "application/json");
           response.setStatus(HttpResponse::HTTP_STATUS::STATUS_200);
@@ -325,7 +370,8 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
         COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID::request req;
         req.paymentId = pid_str;
         COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID::response rsp;
-        bool r = onGetTransactionHashesByPaymentId(req, rsp);
+        endpoint = payment_id_method;
+        bool r = runReadOnly(Execution::READ_LOCKED, [&] { return onGetTransactionHashesByPaymentId(req, rsp); });
         if (r) {
           response.addHeader("Content-Type", "application/json");
           response.setStatus(HttpResponse::HTTP_STATUS::STATUS_200);
@@ -349,7 +395,8 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
 
         COMMAND_RPC_GET_TRANSACTIONS_POOL::request req;
         COMMAND_RPC_GET_TRANSACTIONS_POOL::response rsp;
-        bool r = onGetTransactionsPool(req, rsp);
+        endpoint = tx_mempool_method;
+        bool r = runReadOnly(Execution::READ_LOCKED, [&] { return onGetTransactionsPool(req, rsp); });
         if (r) {
           response.addHeader("Content-Type", "application/json");
           response.setStatus(HttpResponse::HTTP_STATUS::STATUS_200);
@@ -378,7 +425,16 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
     return;
   }
 
-  it->second.handler(this, request, response);
+  // json_rpc accounts every method separately
+  if (it->first != "/json_rpc") {
+    endpoint = it->first;
+  }
+
+  if (it->second.execution != Execution::ON_DISPATCHER) {
+    runReadOnly(it->second.execution, [&] { return it->second.handler(this, request, response); });
+  } else {
+    it->second.handler(this, request, response);
+  }
 
   }
   catch (const JsonRpc::JsonRpcError& err) {
@@ -408,6 +464,14 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
   JsonRpcRequest jsonRequest;
   JsonRpcResponse jsonResponse;
 
+  auto start = std::chrono::steady_clock::now();
+  std::string endpoint;
+  Tools::ScopeExit recordLatency([&] {
+    if (!endpoint.empty()) {
+      addLatency(endpoint, start);
+    }
+  });
+
   try {
     logger(TRACE) << "JSON-RPC request: " << request.getBody();
     jsonRequest.parseRequest(request.getBody());
@@ -415,38 +479,38 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
 
     static std::unordered_map<std::string, RpcServer::RpcHandler<JsonMemberMethod>> jsonRpcHandlers = {
 
-      { "getblockcount", { makeMemberMethod(&RpcServer::onGetBlockCount), true } },
-      { "getblockhash", { makeMemberMethod(&RpcServer::onGetBlockHash), false } },
-      { "getblocktemplate", { makeMemberMethod(&RpcServer::onGetBlockTemplate), false } },
-      { "getblockheaderbyhash", { makeMemberMethod(&RpcServer::onGetBlockHeaderByHash), false } },
-      { "getblockheaderbyheight", { makeMemberMethod(&RpcServer::onGetBlockHeaderByHeight), false } },
-      { "getblocktimestamp", { makeMemberMethod(&RpcServer::onGetBlockTimestampByHeight), true } },
-      { "getblockbyheight", { makeMemberMethod(&RpcServer::onGetBlockDetailsByHeight), false } },
-      { "getblockbyhash", { makeMemberMethod(&RpcServer::onGetBlockDetailsByHash), false } },
-      { "getblocksbyheights", { makeMemberMethod(&RpcServer::onGetBlocksDetailsByHeights), false } },
-      { "getblocksbyhashes", { makeMemberMethod(&RpcServer::onGetBlocksDetailsByHashes), false } },
-      { "getblockshashesbytimestamps", { makeMemberMethod(&RpcServer::onGetBlocksHashesByTimestamps), false } },
-      { "getblockslist", { makeMemberMethod(&RpcServer::onGetBocksList), false } },
-      { "getaltblockslist", { makeMemberMethod(&RpcServer::onGetAltBlocksList), true } },
-      { "getlastblockheader", { makeMemberMethod(&RpcServer::onGetLastBlockHeader), true } },
-      { "gettransaction", { makeMemberMethod(&RpcServer::onGetTransactionDetailsByHash), false } },
-      { "gettransactionspool", { makeMemberMethod(&RpcServer::onGetTransactionsPoolShort), false } },
-      { "gettransactionsinpool", { makeMemberMethod(&RpcServer::onGetTransactionsPool), false } },
-      { "getrawtransactionspool", { makeMemberMethod(&RpcServer::onGetTransactionsPoolRaw), false } },
-      { "gettransactionsbypaymentid", { makeMemberMethod(&RpcServer::onGetTransactionsByPaymentId), false } },
-      { "gettransactionhashesbypaymentid", { makeMemberMethod(&RpcServer::onGetTransactionHashesByPaymentId), false } },
-      { "gettransactionsbyhashes", { makeMemberMethod(&RpcServer::onGetTransactionDetailsByHashes), false } },
-      { "gettransactionsbyheights", { makeMemberMethod(&RpcServer::onGetTransactionDetailsByHeights), false } },
-      { "getrawtransactionsbyheights", { makeMemberMethod(&RpcServer::onGetTransactionsWithOutputGlobalIndexesByHeights), false } },
-      { "getcurrencyid", { makeMemberMethod(&RpcServer::onGetCurrencyId), true } },
-      { "checktransactionkey", { makeMemberMethod(&RpcServer::onCheckTxSecretKey), false } },
-      { "checktransactionbyviewkey", { makeMemberMethod(&RpcServer::onCheckTxWithViewKey), false } },
-      { "checktransactionproof", { makeMemberMethod(&RpcServer::onCheckTxProof), false } },
-      { "checkreserveproof", { makeMemberMethod(&RpcServer::onCheckReserveProof), false } },
-      { "validateaddress", { makeMemberMethod(&RpcServer::onValidateAddress), false } },
-      { "verifymessage", { makeMemberMethod(&RpcServer::onVerifyMessage), false } },
-      { "submitblock", { makeMemberMethod(&RpcServer::onSubmitBlock), false } },
-      { "resolveopenalias", { makeMemberMethod(&RpcServer::onResolveOpenAlias), true } }
+      { "getblockcount", { makeMemberMethod(&RpcServer::onGetBlockCount), true, Execution::READ_LOCKED } },
+      { "getblockhash", { makeMemberMethod(&RpcServer::onGetBlockHash), false, Execution::READ_LOCKED } },
+      { "getblocktemplate", { makeMemberMethod(&RpcServer::onGetBlockTemplate), false, Execution::ON_DISPATCHER } },
+      { "getblockheaderbyhash", { makeMemberMethod(&RpcServer::onGetBlockHeaderByHash), false, Execution::READ_LOCKED } },
+      { "getblockheaderbyheight", { makeMemberMethod(&RpcServer::onGetBlockHeaderByHeight), false, Execution::READ_LOCKED } },
+      { "getblocktimestamp", { makeMemberMethod(&RpcServer::onGetBlockTimestampByHeight), true, Execution::READ_LOCKED } },
+      { "getblockbyheight", { makeMemberMethod(&RpcServer::onGetBlockDetailsByHeight), false, Execution::READ_LOCKED } },
+      { "getblockbyhash", { makeMemberMethod(&RpcServer::onGetBlockDetailsByHash), false, Execution::READ_LOCKED } },
+      { "getblocksbyheights", { makeMemberMethod(&RpcServer::onGetBlocksDetailsByHeights), false, Execution::READ_LOCKED } },
+      { "getblocksbyhashes", { makeMemberMethod(&RpcServer::onGetBlocksDetailsByHashes), false, Execution::READ_LOCKED } },
+      { "getblockshashesbytimestamps", { makeMemberMethod(&RpcServer::onGetBlocksHashesByTimestamps), false, Execution::READ_LOCKED } },
+      { "getblockslist", { makeMemberMethod(&RpcServer::onGetBocksList), false, Execution::READ_LOCKED } },
+      { "getaltblockslist", { makeMemberMethod(&RpcServer::onGetAltBlocksList), true, Execution::READ_LOCKED } },
+      { "getlastblockheader", { makeMemberMethod(&RpcServer::onGetLastBlockHeader), true, Execution::READ_LOCKED } },
+      { "gettransaction", { makeMemberMethod(&RpcServer::onGetTransactionDetailsByHash), false, Execution::READ_LOCKED } },
+      { "gettransactionspool", { makeMemberMethod(&RpcServer::onGetTransactionsPoolShort), false, Execution::READ_LOCKED } },
+      { "gettransactionsinpool", { makeMemberMethod(&RpcServer::onGetTransactionsPool), false, Execution::READ_LOCKED } },
+      { "getrawtransactionspool", { makeMemberMethod(&RpcServer::onGetTransactionsPoolRaw), false, Execution::READ_LOCKED } },
+      { "gettransactionsbypaymentid", { makeMemberMethod(&RpcServer::onGetTransactionsByPaymentId), false, Execution::READ_LOCKED } },
+      { "gettransactionhashesbypaymentid", { makeMemberMethod(&RpcServer::onGetTransactionHashesByPaymentId), false, Execution::READ_LOCKED } },
+      { "gettransactionsbyhashes", { makeMemberMethod(&RpcServer::onGetTransactionDetailsByHashes), false, Execution::READ_LOCKED } },
+      { "gettransactionsbyheights", { makeMemberMethod(&RpcServer::onGetTransactionDetailsByHeights), false, Execution::READ_LOCKED } },
+      { "getrawtransactionsbyheights", { makeMemberMethod(&RpcServer::onGetTransactionsWithOutputGlobalIndexesByHeights), false, Execution::READ_LOCKED } },
+      { "getcurrencyid", { makeMemberMethod(&RpcServer::onGetCurrencyId), true, Execution::READ_LOCKED } },
+      { "checktransactionkey", { makeMemberMethod(&RpcServer::onCheckTxSecretKey), false, Execution::ON_WORKER } },
+      { "checktransactionbyviewkey", { makeMemberMethod(&RpcServer::onCheckTxWithViewKey), false, Execution::ON_WORKER } },
+      { "checktransactionproof", { makeMemberMethod(&RpcServer::onCheckTxProof), false, Execution::ON_WORKER } },
+      { "checkreserveproof", { makeMemberMethod(&RpcServer::onCheckReserveProof), false, Execution::ON_WORKER } },
+      { "validateaddress", { makeMemberMethod(&RpcServer::onValidateAddress), false, Execution::ON_DISPATCHER } },
+      { "verifymessage", { makeMemberMethod(&RpcServer::onVerifyMessage), false, Execution::ON_WORKER } },
+      { "submitblock", { makeMemberMethod(&RpcServer::onSubmitBlock), false, Execution::ON_DISPATCHER } },
+      { "resolveopenalias", { makeMemberMethod(&RpcServer::onResolveOpenAlias), true, Execution::ON_WORKER } }
 
     };
 
@@ -459,7 +523,12 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
       throw JsonRpcError(CORE_RPC_ERROR_CODE_CORE_BUSY, "Core is busy");
     }
 
-    it->second.handler(this, jsonRequest, jsonResponse);
+    endpoint = "/json_rpc/" + it->first;
+    if (it->second.execution != Execution::ON_DISPATCHER) {
+      runReadOnly(it->second.execution, [&] { return it->second.handler(this, jsonRequest, jsonResponse); });
+    } else {
+      it->second.handler(this, jsonRequest, jsonResponse);
+    }
 
   } catch (const JsonRpcError& err) {
     jsonResponse.setError(err);
@@ -513,6 +582,78 @@ bool RpcServer::setContactInfo(const std::string& contact) {
   return true;
 }
 
+void RpcServer::setWorkerThreads(size_t threadCount) {
+  if (threadCount == 0) {
+    m_workers.reset();
+  } else {
+    m_workers.reset(new Utilities::ThreadPool<bool>(threadCount));
+  }
+}
+
+bool RpcServer::runReadOnly(Execution execution, const std::function<bool()>& handler) {
+  if (!m_workers) {
+    return handler();
+  }
+
+  System::Dispatcher& dispatcher = m_dispatcher;
+  System::Event done(dispatcher);
+  bool result = false;
+  std::exception_ptr error;
+
+  m_workers->addJob([this, execution, &handler, &result, &error, &dispatcher, &done] {
+    try {
+      std::shared_lock<Common::RecursiveSharedMutex> lock;
+      if (execution == Execution::READ_LOCKED) {
+        lock = m_core.lockForReading();
+      }
+
+      result = handler();
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    // the waiting context owns everything captured, so nothing may be touched after this
+    auto event = &done;
+    dispatcher.remoteSpawn([event] { event->set(); });
+    return true;
+  });
+
+  // the job refers to the request and response, keep waiting even when interrupted
+  bool interrupted = false;
+  while (!done.get()) {
+    try {
+      done.wait();
+    } catch (System::InterruptedException&) {
+      interrupted = true;
+    }
+  }
+
+  if (interrupted) {
+    dispatcher.interrupt();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  return result;
+}
+
+void RpcServer::addLatency(const std::string& endpoint, std::chrono::steady_clock::time_point start) {
+  uint64_t microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  size_t bucket = 0;
+  while (bucket + 1 < LatencyHistogram().buckets.size() && (microseconds >> bucket) != 0) {
+    ++bucket;
+  }
+
+  auto& histogram = m_latencies[endpoint];
+  ++histogram.calls;
+  histogram.totalMicroseconds += microseconds;
+  histogram.maxMicroseconds = std::max(histogram.maxMicroseconds, microseconds);
+  ++histogram.buckets[bucket];
+}
+
 bool RpcServer::isCoreReady() {
   return m_core.getCurrency().isTestnet() || m_p2p.get_payload_object().isSynchronized();
 }
@@ -563,20 +704,21 @@ bool RpcServer::onGetBlocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COM
     return false;
   }
 
-  if (req.block_ids.back() != m_core.getBlockHashByIndex(0)) {
+  auto snapshot = m_core.getChainSnapshot();
+  if (req.block_ids.back() != snapshot->getBlockHashByIndex(0)) {
     res.status = "Failed";
     return false;
   }
 
   uint32_t totalBlockCount;
   uint32_t startBlockIndex;
-  std::vector<Crypto::Hash> supplement = m_core.findBlockchainSupplement(req.block_ids, COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT, totalBlockCount, startBlockIndex);
+  std::vector<Crypto::Hash> supplement = snapshot->findBlockchainSupplement(req.block_ids, COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT, totalBlockCount, startBlockIndex);
 
   res.current_height = totalBlockCount;
   res.start_height = startBlockIndex;
 
   std::vector<Crypto::Hash> missedHashes;
-  m_core.getBlocks(supplement, res.blocks, missedHashes);
+  snapshot->getBlocks(supplement, res.blocks, missedHashes);
   assert(missedHashes.empty());
 
   res.status = CORE_RPC_STATUS_OK;
@@ -619,7 +761,7 @@ bool RpcServer::onQueryBlocksLite(const COMMAND_RPC_QUERY_BLOCKS_LITE::request&
 
 bool RpcServer::onGetIndexes(const COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::request& req, COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::response& res) {
   std::vector<uint32_t> outputIndexes;
-  if (!m_core.getTransactionGlobalIndexes(req.txid, outputIndexes)) {
+  if (!m_core.getChainSnapshot()->getTransactionGlobalIndexes(req.txid, outputIndexes)) {
     res.status = "Failed";
     return true;
   }
@@ -633,17 +775,17 @@ bool RpcServer::onGetIndexes(const COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::re
 bool RpcServer::onGetRandomOuts(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res) {
   res.status = "Failed";
 
-  for (uint64_t amount : req.amounts) {
-    std::vector<uint32_t> globalIndexes;
-    std::vector<Crypto::PublicKey> publicKeys;
-    if (!m_core.getRandomOutputs(amount, static_cast<uint16_t>(req.outs_count), globalIndexes, publicKeys)) {
-      return true;
-    }
+  std::vector<RandomOutputsForAmount> outs;
+  if (!m_core.getRandomOutputs(req.amounts, static_cast<uint16_t>(req.outs_count), outs)) {
+    return true;
+  }
 
-    assert(globalIndexes.size() == publicKeys.size());
-    res.outs.emplace_back(COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount{amount, {}});
-    for (size_t i = 0; i < globalIndexes.size(); ++i) {
-      res.outs.back().outs.push_back({globalIndexes[i], publicKeys[i]});
+  res.outs.reserve(outs.size());
+  for (const auto& outsForAmount : outs) {
+    res.outs.emplace_back(COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount{outsForAmount.amount, {}});
+    res.outs.back().outs.reserve(outsForAmount.globalIndexes.size());
+    for (size_t i = 0; i < outsForAmount.globalIndexes.size(); ++i) {
+      res.outs.back().outs.push_back({outsForAmount.globalIndexes[i], outsForAmount.publicKeys[i]});
     }
   }
 
@@ -684,6 +826,39 @@ bool RpcServer::onGetPoolChangesLite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::re
   return true;
 }
 
+bool RpcServer::onWaitForChanges(const COMMAND_RPC_WAIT_FOR_CHANGES::request& req, COMMAND_RPC_WAIT_FOR_CHANGES::response& rsp) {
+  auto changed = [&] {
+    return m_core.getTopBlockHash() != req.tailBlockId || m_poolVersion != req.poolVersion;
+  };
+
+  if (!changed() && req.timeout > 0) {
+    System::Event wakeUp(m_dispatcher);
+    auto waiter = m_changeWaiters.insert(m_changeWaiters.end(), &wakeUp);
+    Tools::ScopeExit removeWaiter([&] { m_changeWaiters.erase(waiter); });
+
+    bool timedOut = false;
+    System::ContextGroup timeoutContext(m_dispatcher);
+    timeoutContext.spawn([&] {
+      try {
+        System::Timer(m_dispatcher).sleep(std::chrono::milliseconds(std::min(req.timeout, WAIT_FOR_CHANGES_MAX_TIMEOUT)));
+        timedOut = true;
+        wakeUp.set();
+      } catch (System::InterruptedException&) {
+      }
+    });
+
+    do {
+      wakeUp.wait();
+      wakeUp.clear();
+    } while (!timedOut && !changed());
+  }
+
+  rsp.tailBlockId = m_core.getTopBlockHash();
+  rsp.poolVersion = m_poolVersion;
+  rsp.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
 
 //
 // HTTP handlers
@@ -1284,6 +1459,32 @@ bool RpcServer::onGetPeerList(const COMMAND_RPC_GET_PEER_LIST::request& req, COM
   return true;
 }
 
+bool RpcServer::onGetRpcStats(const COMMAND_RPC_GET_RPC_STATS::request& req, COMMAND_RPC_GET_RPC_STATS::response& res) {
+  if (m_restricted_rpc) {
+    res.status = "Method disabled";
+    return false;
+  }
+
+  for (const auto& latency : m_latencies) {
+    rpc_endpoint_stats stats;
+    stats.endpoint = latency.first;
+    stats.calls = latency.second.calls;
+    stats.total_us = latency.second.totalMicroseconds;
+    stats.max_us = latency.second.maxMicroseconds;
+
+    auto last = std::find_if(latency.second.buckets.rbegin(), latency.second.buckets.rend(), [](uint64_t count) { return count != 0; });
+    stats.histogram.assign(latency.second.buckets.begin(), last.base());
+    res.endpoints.push_back(std::move(stats));
+  }
+
+  std::sort(res.endpoints.begin(), res.endpoints.end(), [](const rpc_endpoint_stats& a, const rpc_endpoint_stats& b) {
+    return a.endpoint < b.endpoint;
+  });
+
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
 bool RpcServer::onGetConnections(const COMMAND_RPC_GET_CONNECTIONS::request& req, COMMAND_RPC_GET_CONNECTIONS::response& res) {
   if (m_restricted_rpc) {
     res.status = "Method disabled";
@@ -1306,6 +1507,9 @@ bool RpcServer::onGetConnections(const COMMAND_RPC_GET_CONNECTIONS::request& req
     c.started = static_cast<uint64_t>(p.m_started);
     c.remote_blockchain_height = p.m_remote_blockchain_height;
     c.last_response_height = p.m_last_response_height;
+    c.send_queue_size = p.m_send_queue_size;
+    c.send_queue_shared_size = p.m_send_queue_shared_size;
+    c.send_queue_peak_size = p.m_send_queue_peak_size;
     res.connections.push_back(c);
   }
 
@@ -1736,7 +1940,10 @@ bool RpcServer::onCheckTxSecretKey(const COMMAND_RPC_CHECK_TX_KEY::request& req,
   tx_ids.push_back(txid);
   std::vector<Crypto::Hash> missed_txs;
   std::vector<BinaryArray> txs;
-  m_core.getTransactions(tx_ids, txs, missed_txs);
+  {
+    auto lock = m_core.lockForReading();
+    m_core.getTransactions(tx_ids, txs, missed_txs);
+  }
 
   if (1 == txs.size()) {
     if (!fromBinaryArray(tx, txs.front())) {
@@ -1811,7 +2018,10 @@ bool RpcServer::onCheckTxWithViewKey(const COMMAND_RPC_CHECK_TX_WITH_PRIVATE_VIE
   tx_ids.push_back(txid);
   std::vector<Crypto::Hash> missed_txs;
   std::vector<BinaryArray> txs;
-  m_core.getTransactions(tx_ids, txs, missed_txs);
+  {
+    auto lock = m_core.lockForReading();
+    m_core.getTransactions(tx_ids, txs, missed_txs);
+  }
 
   if (1 == txs.size()) {
     if (!fromBinaryArray(tx, txs.front())) {
@@ -1898,7 +2108,10 @@ bool RpcServer::onCheckTxProof(const COMMAND_RPC_CHECK_TX_PROOF::request& req, C
   tx_ids.push_back(txid);
   std::vector<Crypto::Hash> missed_txs;
   std::vector<BinaryArray> txs;
-  m_core.getTransactions(tx_ids, txs, missed_txs);
+  {
+    auto lock = m_core.lockForReading();
+    m_core.getTransactions(tx_ids, txs, missed_txs);
+  }
 
   if (1 == txs.size()) {
     if (!fromBinaryArray(tx, txs.front())) {
@@ -1957,7 +2170,11 @@ bool RpcServer::onCheckTxProof(const COMMAND_RPC_CHECK_TX_PROOF::request& req, C
     res.received_amount = received;
     res.outputs = outputs;
 
-    TransactionDetails transactionDetails = m_core.getTransactionDetails(txid);
+    TransactionDetails transactionDetails;
+    {
+      auto lock = m_core.lockForReading();
+      transactionDetails = m_core.getTransactionDetails(txid);
+    }
     res.confirmations = m_protocol.getObservedHeight() - transactionDetails.blockIndex;
   }
   else {
@@ -2004,26 +2221,31 @@ bool RpcServer::onCheckReserveProof(const COMMAND_RPC_CHECK_RESERVE_PROOF::reque
     transactionHashes.push_back(proofs[i].transaction_id);
   }
 
-  // first check against height if provided to spare further checks
-  // in case request is to check proof of funds that didn't exist yet at this height
-  if (req.height != 0) {
-    for (const auto& h : transactionHashes) {
-      uint32_t txBlockIndex;
-      if (!m_core.getBlockIndexContainingTransaction(h, txBlockIndex)) {
-        throw JsonRpc::JsonRpcError(CORE_RPC_ERROR_CODE_WRONG_PARAM, 
-          std::string("Couldn't find block index containing transaction ") + Common::podToHex(h) + std::string(" of reserve proof"));
-      }
+  std::vector<Hash> missed_txs;
+  std::vector<BinaryArray> txs;
+  {
+    auto lock = m_core.lockForReading();
+
+    // first check against height if provided to spare further checks
+    // in case request is to check proof of funds that didn't exist yet at this height
+    if (req.height != 0) {
+      for (const auto& h : transactionHashes) {
+        uint32_t txBlockIndex;
+        if (!m_core.getBlockIndexContainingTransaction(h, txBlockIndex)) {
+          throw JsonRpc::JsonRpcError(CORE_RPC_ERROR_CODE_WRONG_PARAM, 
+            std::string("Couldn't find block index containing transaction ") + Common::podToHex(h) + std::string(" of reserve proof"));
+        }
 
-      if (req.height < txBlockIndex) {
-        throw JsonRpc::JsonRpcError(CORE_RPC_ERROR_CODE_WRONG_PARAM, std::string("Funds from transaction ")
-          + Common::podToHex(h) + std::string(" in block ") + std::to_string(txBlockIndex) + std::string(" didn't exist at requested height"));
+        if (req.height < txBlockIndex) {
+          throw JsonRpc::JsonRpcError(CORE_RPC_ERROR_CODE_WRONG_PARAM, std::string("Funds from transaction ")
+            + Common::podToHex(h) + std::string(" in block ") + std::to_string(txBlockIndex) + std::string(" didn't exist at requested height"));
+        }
       }
     }
+
+    m_core.getTransactions(transactionHashes, txs, missed_txs);
   }
 
-  std::vector<Hash> missed_txs;
-  std::vector<BinaryArray> txs;
-  m_core.getTransactions(transactionHashes, txs, missed_txs);
   if (!missed_txs.empty()) {
     throw JsonRpc::JsonRpcError(CORE_RPC_ERROR_CODE_WRONG_PARAM, std::string("Couldn't find some transactions of reserve proof"));
   }
@@ -2078,6 +2300,7 @@ bool RpcServer::onCheckReserveProof(const COMMAND_RPC_CHECK_RESERVE_PROOF::reque
         uint64_t amount = txp.outputs[proof.index_in_transaction].amount;
         res.total += amount;
 
+        auto lock = m_core.lockForReading();
         if (req.height != 0) {
           if (m_core.isKeyImageSpent(proof.key_image, req.height)) {
             res.spent += amount;
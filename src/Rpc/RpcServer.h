@@ -21,12 +21,19 @@
 
 #include "HttpServer.h"
 
+#include <array>
+#include <chrono>
 #include <functional>
+#include <list>
+#include <memory>
 #include <unordered_map>
 
 #include <Logging/LoggerRef.h>
 
 #include "Common/Math.h"
+#include "Common/ThreadPool.h"
+#include "CryptoNoteCore/BlockchainMessages.h"
+#include "CryptoNoteCore/MessageQueue.h"
 #include "CoreRpcServerCommandsDefinitions.h"
 
 namespace CryptoNote {
@@ -38,6 +45,7 @@ struct ICryptoNoteProtocolHandler;
 class RpcServer : public HttpServer {
 public:
   RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, Core& c, NodeServer& p2p, ICryptoNoteProtocolHandler& protocol);
+  ~RpcServer();
 
   typedef std::function<bool(RpcServer*, const HttpRequest& request, HttpResponse& response)> HandlerFunction;
   bool restrictRPC(const bool is_resctricted);
@@ -49,12 +57,32 @@ public:
   bool checkIncomingTransactionForFee(const BinaryArray& tx_blob);
   std::vector<std::string> getCorsDomains();
 
+  // Read-only handlers run on this many worker threads, either on a chain snapshot or under the
+  // shared side of the core lock, everything else stays on the dispatcher. 0 runs all handlers on the dispatcher. Call before start().
+  void setWorkerThreads(size_t threadCount);
+
 private:
 
+  enum class Execution {
+    ON_DISPATCHER,
+    ON_WORKER,   // on a worker without the core lock, the handler takes it only around its reads of the core
+    READ_LOCKED, // on a worker under the shared core lock
+    ON_SNAPSHOT  // on a worker, reads the chain only through Core::getChainSnapshot()
+  };
+
   template <class Handler>
   struct RpcHandler {
     const Handler handler;
     const bool allowBusyCore;
+    const Execution execution;
+  };
+
+  // bucket 0 counts calls which took under 1 us, bucket i the ones in [2^(i-1), 2^i) us
+  struct LatencyHistogram {
+    uint64_t calls = 0;
+    uint64_t totalMicroseconds = 0;
+    uint64_t maxMicroseconds = 0;
+    std::array<uint64_t, 32> buckets = {};
   };
 
   typedef void (RpcServer::*HandlerPtr)(const HttpRequest& request, HttpResponse& response);
@@ -63,6 +91,9 @@ private:
   virtual void processRequest(const HttpRequest& request, HttpResponse& response) override;
   bool processJsonRpcRequest(const HttpRequest& request, HttpResponse& response);
   bool isCoreReady();
+  bool runReadOnly(Execution execution, const std::function<bool()>& handler);
+  void addLatency(const std::string& endpoint, std::chrono::steady_clock::time_point start);
+  void watchBlockchain();
 
   // binary handlers
   bool onGetBlocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COMMAND_RPC_GET_BLOCKS_FAST::response& res);
@@ -72,6 +103,7 @@ private:
   bool onGetRandomOuts(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res);
   bool onGetPoolChanges(const COMMAND_RPC_GET_POOL_CHANGES::request& req, COMMAND_RPC_GET_POOL_CHANGES::response& rsp);
   bool onGetPoolChangesLite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::request& req, COMMAND_RPC_GET_POOL_CHANGES_LITE::response& rsp);
+  bool onWaitForChanges(const COMMAND_RPC_WAIT_FOR_CHANGES::request& req, COMMAND_RPC_WAIT_FOR_CHANGES::response& rsp);
 
   // http handlers
   bool onGetIndex(const COMMAND_HTTP::request& req, COMMAND_HTTP::response& res);
@@ -123,6 +155,7 @@ private:
   bool onStopDaemon(const COMMAND_RPC_STOP_DAEMON::request& req, COMMAND_RPC_STOP_DAEMON::response& res);
   bool onGetPeerList(const COMMAND_RPC_GET_PEER_LIST::request& req, COMMAND_RPC_GET_PEER_LIST::response& res);
   bool onGetConnections(const COMMAND_RPC_GET_CONNECTIONS::request& req, COMMAND_RPC_GET_CONNECTIONS::response& res);
+  bool onGetRpcStats(const COMMAND_RPC_GET_RPC_STATS::request& req, COMMAND_RPC_GET_RPC_STATS::response& res);
 
 
   void fillBlockHeaderResponse(const BlockTemplate& blk, bool orphan_status, uint32_t index, const Crypto::Hash& hash, block_header_response& responce);
@@ -143,6 +176,16 @@ private:
   bool m_restricted_rpc;
   std::vector<std::string> m_cors_domains;
 
+  std::unique_ptr<Utilities::ThreadPool<bool>> m_workers;
+  // only touched on the dispatcher thread
+  std::unordered_map<std::string, LatencyHistogram> m_latencies;
+
+  // core notifications drive the wait_for_changes long polls, all of it lives on the dispatcher thread
+  MessageQueue<BlockchainMessage> m_blockchainMessages;
+  System::ContextGroup m_watchContext;
+  uint64_t m_poolVersion;
+  std::list<System::Event*> m_changeWaiters;
+
 };
 
 }
@@ -28,6 +28,7 @@ namespace CryptoNote {
     const std::string DEFAULT_RPC_IP = "127.0.0.1";
     const uint16_t DEFAULT_RPC_PORT = RPC_DEFAULT_PORT;
     const uint16_t DEFAULT_RPC_SSL_PORT = RPC_DEFAULT_SSL_PORT;
+    const uint32_t DEFAULT_RPC_WORKER_THREADS = 2;
     const std::string DEFAULT_RPC_CHAIN_FILE = std::string(RPC_DEFAULT_CHAIN_FILE);
     const std::string DEFAULT_RPC_KEY_FILE = std::string(RPC_DEFAULT_KEY_FILE);
     const std::string DEFAULT_RPC_DH_FILE = std::string(RPC_DEFAULT_DH_FILE);
@@ -45,6 +46,7 @@ namespace CryptoNote {
     const command_line::arg_descriptor<std::string> arg_set_fee_address          = { "fee-address", "Sets fee address for light wallets.", "" };
     const command_line::arg_descriptor<std::string> arg_set_fee_amount           = { "fee-amount", "Sets flat rate fee for light wallets.", "" };
     const command_line::arg_descriptor<std::string> arg_set_view_key             = { "view-key", "Sets private view key to check for node's fee.", "" };
+    const command_line::arg_descriptor<uint32_t>    arg_rpc_worker_threads       = { "rpc-worker-threads", "Number of threads serving read-only RPC requests, 0 serves them on the main thread", DEFAULT_RPC_WORKER_THREADS };
   }
 
 
@@ -58,7 +60,8 @@ namespace CryptoNote {
     nodeFeeAddress(""),
     nodeFeeAmountStr(""),
     nodeFeeViewKey(""),
-    bindPortSSL(RPC_DEFAULT_SSL_PORT) {
+    bindPortSSL(RPC_DEFAULT_SSL_PORT),
+    workerThreads(DEFAULT_RPC_WORKER_THREADS) {
   }
 
   bool RpcServerConfig::isEnabledSSL() const { return enableSSL; }
@@ -68,6 +71,7 @@ namespace CryptoNote {
   std::string RpcServerConfig::getDhFile() const { return dhFile; }
   std::string RpcServerConfig::getChainFile() const { return chainFile; }
   std::string RpcServerConfig::getKeyFile() const { return keyFile; }
+  uint32_t RpcServerConfig::getWorkerThreads() const { return workerThreads; }
   std::string RpcServerConfig::getBindAddress() const { return bindIp + ":" + std::to_string(bindPort); }
   std::string RpcServerConfig::getBindAddressSSL() const { return bindIp + ":" + std::to_string(bindPortSSL); }
   
@@ -85,6 +89,7 @@ namespace CryptoNote {
     command_line::add_arg(desc, arg_set_fee_address);
     command_line::add_arg(desc, arg_set_fee_amount);
     command_line::add_arg(desc, arg_set_view_key);
+    command_line::add_arg(desc, arg_rpc_worker_threads);
   }
 
   void RpcServerConfig::init(const boost::program_options::variables_map& vm)  {
@@ -101,6 +106,7 @@ namespace CryptoNote {
     nodeFeeAddress = command_line::get_arg(vm, arg_set_fee_address);
     nodeFeeAmountStr = command_line::get_arg(vm, arg_set_fee_amount);
     nodeFeeViewKey = command_line::get_arg(vm, arg_set_view_key);
+    workerThreads = command_line::get_arg(vm, arg_rpc_worker_threads);
   }
 
 }
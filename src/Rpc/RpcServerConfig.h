@@ -39,6 +39,7 @@ public:
   std::string getDhFile() const;
   std::string getChainFile() const;
   std::string getKeyFile() const;
+  uint32_t getWorkerThreads() const;
 
 //private:
   bool        restrictedRPC;
@@ -54,6 +55,7 @@ public:
   std::string nodeFeeAmountStr;
   std::string nodeFeeViewKey;
   std::vector<std::string> enableCors;
+  uint32_t    workerThreads;
 };
 
 }
@@ -0,0 +1,188 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "TlsStream.h"
+
+#include <stdexcept>
+
+#include <System/InterruptedException.h>
+#include <System/TcpConnection.h>
+
+namespace {
+  // the largest TLS record payload, plus room for the record header and MAC on the wire
+  const size_t PLAINTEXT_BUFFER_SIZE = 16 * 1024;
+  const size_t TRANSPORT_BUFFER_SIZE = PLAINTEXT_BUFFER_SIZE + 512;
+}
+
+namespace CryptoNote {
+
+TlsStreambuf::TlsStreambuf(System::TcpConnection& connection, SSL_CTX* context) :
+  connection(connection),
+  ssl(SSL_new(context)),
+  readBuf(PLAINTEXT_BUFFER_SIZE),
+  writeBuf(PLAINTEXT_BUFFER_SIZE),
+  transportBuf(TRANSPORT_BUFFER_SIZE) {
+  if (ssl == nullptr) {
+    throw std::runtime_error("Failed to create TLS session");
+  }
+
+  inputBio = BIO_new(BIO_s_mem());
+  outputBio = BIO_new(BIO_s_mem());
+  // the session takes ownership of both BIOs
+  SSL_set_bio(ssl, inputBio, outputBio);
+  SSL_set_accept_state(ssl);
+
+  setg(readBuf.data(), readBuf.data(), readBuf.data());
+  setp(writeBuf.data(), writeBuf.data() + writeBuf.size());
+}
+
+TlsStreambuf::~TlsStreambuf() {
+  // no I/O here, unsent data and close_notify go out through shutdown()
+  SSL_free(ssl);
+}
+
+void TlsStreambuf::handshake() {
+  for (;;) {
+    int result = SSL_do_handshake(ssl);
+    if (result == 1) {
+      if (!sendRecords()) {
+        throw std::runtime_error("TLS handshake failed: connection closed");
+      }
+
+      return;
+    }
+
+    if (!handleError(result)) {
+      throw std::runtime_error("TLS handshake failed");
+    }
+  }
+}
+
+void TlsStreambuf::shutdown() {
+  if (dumpBuffer()) {
+    SSL_shutdown(ssl);
+    sendRecords();
+  }
+}
+
+std::streambuf::int_type TlsStreambuf::overflow(std::streambuf::int_type ch) {
+  if (ch == traits_type::eof()) {
+    return traits_type::eof();
+  }
+
+  if (pptr() == epptr()) {
+    if (!dumpBuffer()) {
+      return traits_type::eof();
+    }
+  }
+
+  *pptr() = static_cast<char>(ch);
+  pbump(1);
+  return ch;
+}
+
+int TlsStreambuf::sync() {
+  return dumpBuffer() ? 0 : -1;
+}
+
+std::streambuf::int_type TlsStreambuf::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+
+  // pipelined requests stay decrypted in readBuf until the parser gets to them
+  for (;;) {
+    int result = SSL_read(ssl, readBuf.data(), static_cast<int>(readBuf.size()));
+    if (result > 0) {
+      setg(readBuf.data(), readBuf.data(), readBuf.data() + result);
+      return traits_type::to_int_type(*gptr());
+    }
+
+    if (!handleError(result)) {
+      return traits_type::eof();
+    }
+  }
+}
+
+bool TlsStreambuf::dumpBuffer() {
+  size_t count = pptr() - pbase();
+  size_t offset = 0;
+  while (offset < count) {
+    int result = SSL_write(ssl, pbase() + offset, static_cast<int>(count - offset));
+    if (result > 0) {
+      offset += result;
+    } else if (!handleError(result)) {
+      return false;
+    }
+  }
+
+  pbump(-static_cast<int>(count));
+  return sendRecords();
+}
+
+bool TlsStreambuf::receiveRecords() {
+  size_t bytesRead;
+  try {
+    bytesRead = connection.read(transportBuf.data(), transportBuf.size());
+  } catch (System::InterruptedException&) {
+    throw;
+  } catch (std::exception&) {
+    return false;
+  }
+
+  if (bytesRead == 0) {
+    return false;
+  }
+
+  return BIO_write(inputBio, transportBuf.data(), static_cast<int>(bytesRead)) == static_cast<int>(bytesRead);
+}
+
+bool TlsStreambuf::sendRecords() {
+  while (BIO_ctrl_pending(outputBio) > 0) {
+    int pending = BIO_read(outputBio, transportBuf.data(), static_cast<int>(transportBuf.size()));
+    if (pending <= 0) {
+      return false;
+    }
+
+    try {
+      size_t offset = 0;
+      while (offset < static_cast<size_t>(pending)) {
+        offset += connection.write(transportBuf.data() + offset, pending - offset);
+      }
+    } catch (System::InterruptedException&) {
+      throw;
+    } catch (std::exception&) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool TlsStreambuf::handleError(int result) {
+  switch (SSL_get_error(ssl, result)) {
+  case SSL_ERROR_WANT_READ:
+    return sendRecords() && receiveRecords();
+  case SSL_ERROR_WANT_WRITE:
+    return sendRecords();
+  default:
+    return false;
+  }
+}
+
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <streambuf>
+#include <vector>
+
+#include <openssl/ssl.h>
+
+namespace System {
+class TcpConnection;
+}
+
+namespace CryptoNote {
+
+// Server side TLS over a System::TcpConnection. OpenSSL works on memory BIOs only and all
+// network I/O goes through the connection, so a session blocks just its own context and the
+// dispatcher keeps serving everything else, the same as TcpStreambuf.
+class TlsStreambuf : public std::streambuf {
+public:
+  TlsStreambuf(System::TcpConnection& connection, SSL_CTX* context);
+  TlsStreambuf(const TlsStreambuf&) = delete;
+  ~TlsStreambuf();
+  TlsStreambuf& operator=(const TlsStreambuf&) = delete;
+
+  // throws std::runtime_error if the handshake fails or the peer goes away
+  void handshake();
+  // flushes pending data and sends close_notify, doesn't wait for the peer's one;
+  // the destructor does no I/O, so call this to close the session cleanly
+  void shutdown();
+
+private:
+  System::TcpConnection& connection;
+  SSL* ssl;
+  BIO* inputBio;
+  BIO* outputBio;
+  std::vector<char> readBuf;
+  std::vector<char> writeBuf;
+  std::vector<uint8_t> transportBuf;
+
+  std::streambuf::int_type overflow(std::streambuf::int_type ch) override;
+  int sync() override;
+  std::streambuf::int_type underflow() override;
+
+  bool dumpBuffer();
+  bool receiveRecords();
+  bool sendRecords();
+  bool handleError(int result);
+};
+
+}
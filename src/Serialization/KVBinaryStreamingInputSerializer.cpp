@@ -0,0 +1,527 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "KVBinaryStreamingInputSerializer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "KVBinaryCommon.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t MAX_STRING_SIZE = 100 * 1024 * 1024;
+const size_t MAX_NESTING_DEPTH = 100;
+
+// size of a value of the type, 0 if it isn't fixed
+size_t getFixedSize(uint8_t type) {
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:
+  case BIN_KV_SERIALIZE_TYPE_UINT64:
+  case BIN_KV_SERIALIZE_TYPE_DOUBLE:
+    return 8;
+  case BIN_KV_SERIALIZE_TYPE_INT32:
+  case BIN_KV_SERIALIZE_TYPE_UINT32:
+    return 4;
+  case BIN_KV_SERIALIZE_TYPE_INT16:
+  case BIN_KV_SERIALIZE_TYPE_UINT16:
+    return 2;
+  case BIN_KV_SERIALIZE_TYPE_INT8:
+  case BIN_KV_SERIALIZE_TYPE_UINT8:
+  case BIN_KV_SERIALIZE_TYPE_BOOL:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+}
+
+KVBinaryStreamingInputSerializer::KVBinaryStreamingInputSerializer(const void* data, size_t size) :
+  m_data(static_cast<const uint8_t*>(data)),
+  m_size(size) {
+  size_t pos = 0;
+  auto hdr = readPod<KVBinaryStorageBlockHeader>(pos);
+
+  if (hdr.m_signature_a != PORTABLE_STORAGE_SIGNATUREA || hdr.m_signature_b != PORTABLE_STORAGE_SIGNATUREB) {
+    throw std::runtime_error("Invalid binary storage signature");
+  }
+
+  if (hdr.m_ver != PORTABLE_STORAGE_FORMAT_VER) {
+    throw std::runtime_error("Unknown binary storage format version");
+  }
+
+  pushSection(pos, NO_ENTRY);
+}
+
+ISerializer::SerializerType KVBinaryStreamingInputSerializer::type() const {
+  return ISerializer::INPUT;
+}
+
+bool KVBinaryStreamingInputSerializer::beginObject(Common::StringView name) {
+  uint8_t type;
+  size_t pos;
+  size_t entry;
+  if (!findValue(name, type, pos, entry)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_OBJECT) {
+    throw std::runtime_error("Object expected");
+  }
+
+  pushSection(pos, entry);
+  return true;
+}
+
+void KVBinaryStreamingInputSerializer::endObject() {
+  assert(m_frames.size() > 1 && !m_frames.back().isArray);
+
+  Frame& frame = m_frames.back();
+  bool parentIsArray = m_frames[m_frames.size() - 2].isArray;
+
+  // the next array item starts where the object ends, a parent object may scan on from there later
+  bool endKnown = parentIsArray || frame.unscanned == 0;
+  size_t end = endKnown ? finishSection(frame) : 0;
+  size_t parentEntry = frame.parentEntry;
+
+  m_entries.erase(m_entries.begin() + frame.firstEntry, m_entries.end());
+  m_frames.pop_back();
+
+  if (endKnown) {
+    valueRead(parentEntry, end);
+  }
+}
+
+bool KVBinaryStreamingInputSerializer::beginArray(size_t& size, Common::StringView name) {
+  if (m_frames.back().isArray) {
+    throw std::runtime_error("Nested arrays are not supported");
+  }
+
+  size_t entry = findEntry(name);
+  if (entry == NO_ENTRY) {
+    size = 0;
+    return false;
+  }
+
+  uint8_t type = m_entries[entry].type;
+  uint8_t itemType;
+  if (type & BIN_KV_SERIALIZE_FLAG_ARRAY) {
+    itemType = type & ~BIN_KV_SERIALIZE_FLAG_ARRAY;
+  } else if (type == BIN_KV_SERIALIZE_TYPE_ARRAY) {
+    itemType = BIN_KV_SERIALIZE_TYPE_ARRAY;
+  } else {
+    throw std::runtime_error("Array expected");
+  }
+
+  size_t pos = m_entries[entry].valuePos;
+  size_t count = readVarint(pos);
+
+  // every item takes at least a byte, don't let the caller allocate for items which aren't there
+  size_t itemSize = std::max<size_t>(getFixedSize(itemType), 1);
+  if (count > (m_size - pos) / itemSize) {
+    throw std::runtime_error("Unexpected end of KV binary data");
+  }
+
+  Frame frame = Frame();
+  frame.isArray = true;
+  frame.parentEntry = entry;
+  frame.itemType = itemType;
+  frame.count = count;
+  frame.index = 0;
+  frame.cursor = pos;
+  m_frames.push_back(frame);
+
+  size = count;
+  return true;
+}
+
+void KVBinaryStreamingInputSerializer::endArray() {
+  assert(m_frames.size() > 1 && m_frames.back().isArray);
+
+  Frame frame = m_frames.back();
+  m_frames.pop_back();
+
+  if (frame.index == frame.count) {
+    valueRead(frame.parentEntry, frame.cursor);
+  }
+}
+
+bool KVBinaryStreamingInputSerializer::operator()(uint8_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryStreamingInputSerializer::operator()(int16_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryStreamingInputSerializer::operator()(uint16_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryStreamingInputSerializer::operator()(int32_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryStreamingInputSerializer::operator()(uint32_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryStreamingInputSerializer::operator()(int64_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryStreamingInputSerializer::operator()(uint64_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryStreamingInputSerializer::operator()(double& value, Common::StringView name) {
+  uint8_t type;
+  size_t pos;
+  size_t entry;
+  if (!findValue(name, type, pos, entry)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_DOUBLE) {
+    throw std::runtime_error("Real value expected");
+  }
+
+  value = readPod<double>(pos);
+  valueRead(entry, pos);
+  return true;
+}
+
+bool KVBinaryStreamingInputSerializer::operator()(bool& value, Common::StringView name) {
+  uint8_t type;
+  size_t pos;
+  size_t entry;
+  if (!findValue(name, type, pos, entry)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_BOOL) {
+    throw std::runtime_error("Bool value expected");
+  }
+
+  value = readByte(pos) != 0;
+  valueRead(entry, pos);
+  return true;
+}
+
+bool KVBinaryStreamingInputSerializer::operator()(std::string& value, Common::StringView name) {
+  uint8_t type;
+  size_t pos;
+  size_t entry;
+  if (!findValue(name, type, pos, entry)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_STRING) {
+    throw std::runtime_error("String value expected");
+  }
+
+  size_t size = readStringSize(pos);
+  value.assign(reinterpret_cast<const char*>(m_data + pos), size);
+  valueRead(entry, pos + size);
+  return true;
+}
+
+bool KVBinaryStreamingInputSerializer::binary(void* value, size_t size, Common::StringView name) {
+  uint8_t type;
+  size_t pos;
+  size_t entry;
+  if (!findValue(name, type, pos, entry)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_STRING) {
+    throw std::runtime_error("String value expected");
+  }
+
+  if (readStringSize(pos) != size) {
+    throw std::runtime_error("Binary block size mismatch");
+  }
+
+  if (size != 0) {
+    memcpy(value, m_data + pos, size);
+  }
+
+  valueRead(entry, pos + size);
+  return true;
+}
+
+bool KVBinaryStreamingInputSerializer::binary(std::string& value, Common::StringView name) {
+  return (*this)(value, name); // load as string
+}
+
+bool KVBinaryStreamingInputSerializer::findValue(Common::StringView name, uint8_t& type, size_t& pos, size_t& entry) {
+  Frame& frame = m_frames.back();
+  if (frame.isArray) {
+    if (frame.index >= frame.count) {
+      throw std::runtime_error("Array index is out of range");
+    }
+
+    type = frame.itemType;
+    pos = frame.cursor;
+    entry = NO_ENTRY;
+    return true;
+  }
+
+  entry = findEntry(name);
+  if (entry == NO_ENTRY) {
+    return false;
+  }
+
+  type = m_entries[entry].type;
+  pos = m_entries[entry].valuePos;
+  return true;
+}
+
+// the value found by findValue ends at the position, so the current frame can go on from there
+void KVBinaryStreamingInputSerializer::valueRead(size_t entry, size_t end) {
+  Frame& frame = m_frames.back();
+  if (frame.isArray) {
+    frame.cursor = end;
+    ++frame.index;
+  } else if (frame.valuePending && entry == m_entries.size() - 1) {
+    frame.scanPos = end;
+    frame.valuePending = false;
+  }
+}
+
+size_t KVBinaryStreamingInputSerializer::findEntry(Common::StringView name) {
+  Frame& frame = m_frames.back();
+  assert(!frame.isArray);
+
+  auto matches = [&name](const Entry& entry) {
+    return entry.nameSize == name.getSize() && memcmp(entry.name, name.getData(), entry.nameSize) == 0;
+  };
+
+  for (size_t i = frame.firstEntry; i < m_entries.size(); ++i) {
+    if (matches(m_entries[i])) {
+      return i;
+    }
+  }
+
+  while (frame.unscanned > 0) {
+    if (frame.valuePending) {
+      skipEntryValue(m_entries.back().type, frame.scanPos, 0);
+      frame.valuePending = false;
+    }
+
+    size_t pos = frame.scanPos;
+    Entry entry;
+    entry.nameSize = readByte(pos);
+    check(pos, entry.nameSize);
+    entry.name = reinterpret_cast<const char*>(m_data + pos);
+    pos += entry.nameSize;
+    entry.type = readByte(pos);
+    entry.valuePos = pos;
+
+    m_entries.push_back(entry);
+    frame.scanPos = pos;
+    frame.valuePending = true;
+    --frame.unscanned;
+
+    if (matches(entry)) {
+      return m_entries.size() - 1;
+    }
+  }
+
+  return NO_ENTRY;
+}
+
+// skips the entries not scanned yet and returns the end of the object
+size_t KVBinaryStreamingInputSerializer::finishSection(Frame& frame) {
+  if (frame.valuePending) {
+    skipEntryValue(m_entries.back().type, frame.scanPos, 0);
+    frame.valuePending = false;
+  }
+
+  for (; frame.unscanned > 0; --frame.unscanned) {
+    uint8_t nameSize = readByte(frame.scanPos);
+    check(frame.scanPos, nameSize);
+    frame.scanPos += nameSize;
+    uint8_t type = readByte(frame.scanPos);
+    skipEntryValue(type, frame.scanPos, 0);
+  }
+
+  return frame.scanPos;
+}
+
+void KVBinaryStreamingInputSerializer::pushSection(size_t pos, size_t parentEntry) {
+  Frame frame = Frame();
+  frame.isArray = false;
+  frame.parentEntry = parentEntry;
+  frame.firstEntry = m_entries.size();
+  frame.unscanned = readVarint(pos);
+  frame.scanPos = pos;
+  frame.valuePending = false;
+  m_frames.push_back(frame);
+}
+
+template<typename T>
+bool KVBinaryStreamingInputSerializer::getInteger(Common::StringView name, T& value) {
+  uint8_t type;
+  size_t pos;
+  size_t entry;
+  if (!findValue(name, type, pos, entry)) {
+    return false;
+  }
+
+  value = static_cast<T>(readInteger(type, pos));
+  valueRead(entry, pos);
+  return true;
+}
+
+void KVBinaryStreamingInputSerializer::check(size_t pos, size_t size) const {
+  if (pos > m_size || size > m_size - pos) {
+    throw std::runtime_error("Unexpected end of KV binary data");
+  }
+}
+
+template<typename T>
+T KVBinaryStreamingInputSerializer::readPod(size_t& pos) const {
+  check(pos, sizeof(T));
+  T value;
+  memcpy(&value, m_data + pos, sizeof(T));
+  pos += sizeof(T);
+  return value;
+}
+
+uint8_t KVBinaryStreamingInputSerializer::readByte(size_t& pos) const {
+  check(pos, 1);
+  return m_data[pos++];
+}
+
+size_t KVBinaryStreamingInputSerializer::readVarint(size_t& pos) const {
+  uint8_t b = readByte(pos);
+  size_t bytesLeft = 0;
+
+  switch (b & PORTABLE_RAW_SIZE_MARK_MASK) {
+  case PORTABLE_RAW_SIZE_MARK_BYTE:
+    bytesLeft = 0;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_WORD:
+    bytesLeft = 1;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_DWORD:
+    bytesLeft = 3;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_INT64:
+    bytesLeft = 7;
+    break;
+  }
+
+  size_t value = b;
+  for (size_t i = 1; i <= bytesLeft; ++i) {
+    size_t n = readByte(pos);
+    value |= n << (i * 8);
+  }
+
+  return value >> 2;
+}
+
+// reads the size of a string and checks that the string is there
+size_t KVBinaryStreamingInputSerializer::readStringSize(size_t& pos) const {
+  size_t size = readVarint(pos);
+  if (size > MAX_STRING_SIZE) {
+    throw std::runtime_error("string size is too big");
+  }
+
+  check(pos, size);
+  return size;
+}
+
+int64_t KVBinaryStreamingInputSerializer::readInteger(uint8_t type, size_t& pos) const {
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:  return readPod<int64_t>(pos);
+  case BIN_KV_SERIALIZE_TYPE_INT32:  return readPod<int32_t>(pos);
+  case BIN_KV_SERIALIZE_TYPE_INT16:  return readPod<int16_t>(pos);
+  case BIN_KV_SERIALIZE_TYPE_INT8:   return readPod<int8_t>(pos);
+  case BIN_KV_SERIALIZE_TYPE_UINT64: return static_cast<int64_t>(readPod<uint64_t>(pos));
+  case BIN_KV_SERIALIZE_TYPE_UINT32: return readPod<uint32_t>(pos);
+  case BIN_KV_SERIALIZE_TYPE_UINT16: return readPod<uint16_t>(pos);
+  case BIN_KV_SERIALIZE_TYPE_UINT8:  return readPod<uint8_t>(pos);
+  default:
+    throw std::runtime_error("Integer value expected");
+  }
+}
+
+void KVBinaryStreamingInputSerializer::skipEntryValue(uint8_t type, size_t& pos, size_t depth) const {
+  if ((type & BIN_KV_SERIALIZE_FLAG_ARRAY) == 0) {
+    skipValue(type, pos, depth);
+    return;
+  }
+
+  uint8_t itemType = type & ~BIN_KV_SERIALIZE_FLAG_ARRAY;
+  size_t count = readVarint(pos);
+  size_t itemSize = getFixedSize(itemType);
+  if (itemSize != 0) {
+    if (count > (m_size - pos) / itemSize) {
+      throw std::runtime_error("Unexpected end of KV binary data");
+    }
+
+    pos += count * itemSize;
+    return;
+  }
+
+  while (count--) {
+    skipValue(itemType, pos, depth + 1);
+  }
+}
+
+void KVBinaryStreamingInputSerializer::skipValue(uint8_t type, size_t& pos, size_t depth) const {
+  if (depth > MAX_NESTING_DEPTH) {
+    throw std::runtime_error("KV binary data is nested too deep");
+  }
+
+  size_t size = getFixedSize(type);
+  if (size != 0) {
+    check(pos, size);
+    pos += size;
+    return;
+  }
+
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_STRING:
+    size = readStringSize(pos);
+    pos += size;
+    break;
+  case BIN_KV_SERIALIZE_TYPE_OBJECT:
+    for (size_t count = readVarint(pos); count > 0; --count) {
+      uint8_t nameSize = readByte(pos);
+      check(pos, nameSize);
+      pos += nameSize;
+      skipEntryValue(readByte(pos), pos, depth + 1);
+    }
+    break;
+  case BIN_KV_SERIALIZE_TYPE_ARRAY:
+    for (size_t count = readVarint(pos); count > 0; --count) {
+      skipValue(BIN_KV_SERIALIZE_TYPE_ARRAY, pos, depth + 1);
+    }
+    break;
+  default:
+    throw std::runtime_error("Unknown data type");
+  }
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ISerializer.h"
+
+namespace CryptoNote {
+
+// Reads KV binary storage in place, without building a JsonValue tree first.
+//
+// Entries of an object are located on demand: the entries scanned so far are kept as
+// name views into the buffer, and a lookup for a name not seen yet scans further, skipping
+// the values in between. Fields read in the order they were written are thus found without
+// any search, and strings and blobs are copied once, straight into the target.
+// The buffer must outlive the serializer.
+//
+// Gives the same results as KVBinaryInputStreamSerializer, except that malformed data past
+// the last entry read may go unnoticed.
+class KVBinaryStreamingInputSerializer : public ISerializer {
+public:
+  KVBinaryStreamingInputSerializer(const void* data, size_t size);
+
+  virtual ISerializer::SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
+  virtual bool binary(void* value, size_t size, Common::StringView name) override;
+  virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+private:
+  struct Entry {
+    const char* name;
+    uint8_t nameSize;
+    uint8_t type;
+    size_t valuePos;
+  };
+
+  struct Frame {
+    bool isArray;
+    // entry of the parent object this frame reads, NO_ENTRY for array items and the root
+    size_t parentEntry;
+
+    // object: its entries are m_entries[firstEntry..], unscanned ones start at scanPos
+    size_t firstEntry;
+    size_t unscanned;
+    size_t scanPos;
+    // scanPos still points at the value of the last scanned entry
+    bool valuePending;
+
+    // array
+    uint8_t itemType;
+    size_t count;
+    size_t index;
+    size_t cursor;
+  };
+
+  static const size_t NO_ENTRY = static_cast<size_t>(-1);
+
+  const uint8_t* m_data;
+  size_t m_size;
+  std::vector<Frame> m_frames;
+  std::vector<Entry> m_entries;
+
+  bool findValue(Common::StringView name, uint8_t& type, size_t& pos, size_t& entry);
+  void valueRead(size_t entry, size_t end);
+  size_t findEntry(Common::StringView name);
+  size_t finishSection(Frame& frame);
+  void pushSection(size_t pos, size_t parentEntry);
+
+  template<typename T>
+  bool getInteger(Common::StringView name, T& value);
+
+  void check(size_t pos, size_t size) const;
+  template<typename T>
+  T readPod(size_t& pos) const;
+  uint8_t readByte(size_t& pos) const;
+  size_t readVarint(size_t& pos) const;
+  size_t readStringSize(size_t& pos) const;
+  int64_t readInteger(uint8_t type, size_t& pos) const;
+  void skipEntryValue(uint8_t type, size_t& pos, size_t depth) const;
+  void skipValue(uint8_t type, size_t& pos, size_t depth) const;
+};
+
+}
@@ -25,6 +25,7 @@
 #include "JsonInputStreamSerializer.h"
 #include "JsonOutputStreamSerializer.h"
 #include "KVBinaryInputStreamSerializer.h"
+#include "KVBinaryStreamingInputSerializer.h"
 #include "KVBinaryOutputStreamSerializer.h"
 #include "GreenWallet/Types.h"
 
@@ -145,8 +146,7 @@ std::string storeToBinaryKeyValue(const T& v) {
 template <typename T>
 bool loadFromBinaryKeyValue(T& v, const std::string& buf) {
   try {
-    Common::MemoryInputStream stream(buf.data(), buf.size());
-    KVBinaryInputStreamSerializer s(stream);
+    KVBinaryStreamingInputSerializer s(buf.data(), buf.size());
     serialize(v, s);
     return true;
   } catch (std::exception&) {
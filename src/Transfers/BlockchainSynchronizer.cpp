@@ -335,6 +335,7 @@ void BlockchainSynchronizer::workingProcedure() {
   }
 
   actualizeFutureState();
+  m_prefetchedBlocks.reset();
 
   m_logger(DEBUGGING) << "Working thread stopped";
 }
@@ -450,48 +451,131 @@ BlockchainSynchronizer::GetBlocksRequest BlockchainSynchronizer::getCommonHistor
   return request;
 }
 
+std::unique_ptr<BlockchainSynchronizer::BlocksQuery> BlockchainSynchronizer::sendBlocksQuery(GetBlocksRequest&& request, bool prefetched) {
+  std::unique_ptr<BlocksQuery> query(new BlocksQuery);
+  query->request = std::move(request);
+  query->prefetched = prefetched;
+  query->completed = query->promise.get_future();
+  query->sendTime = std::chrono::steady_clock::now();
+
+  BlocksQuery* pending = query.get();
+  try {
+    m_node.queryBlocks(
+      std::vector<Crypto::Hash>(pending->request.knownBlocks),
+      pending->request.syncStart.timestamp,
+      pending->response.newBlocks,
+      pending->response.startHeight,
+      [pending](std::error_code ec) {
+        pending->queryTime = std::chrono::steady_clock::now() - pending->sendTime;
+        auto detachedPromise = std::move(pending->promise);
+        detachedPromise.set_value(ec);
+      });
+  } catch (const std::exception& e) {
+    m_logger(ERROR, BRIGHT_RED) << "Failed to query blocks: " << e.what();
+    pending->queryTime = std::chrono::steady_clock::duration::zero();
+    pending->promise.set_value(std::make_error_code(std::errc::invalid_argument));
+  }
+
+  return query;
+}
+
+void BlockchainSynchronizer::prefetchNextBlocks(const BlocksQuery& query) {
+  const GetBlocksResponse& response = query.response;
+  if (response.newBlocks.empty()) {
+    return;
+  }
+
+  // at the node's top a new block comes with localBlockchainUpdated, there is nothing to prefetch
+  uint32_t endHeight = response.startHeight + static_cast<uint32_t>(response.newBlocks.size());
+  if (endHeight >= m_node.getLocalBlockCount()) {
+    return;
+  }
+
+  // the node answers from the newest block it finds in the history, so the last block of this range
+  // makes it continue right after it, and the older history still covers a switch of the chain
+  GetBlocksRequest request;
+  request.syncStart = query.request.syncStart;
+  request.knownBlocks.reserve(query.request.knownBlocks.size() + 1);
+  request.knownBlocks.push_back(response.newBlocks.back().blockHash);
+  request.knownBlocks.insert(request.knownBlocks.end(), query.request.knownBlocks.begin(), query.request.knownBlocks.end());
+
+  m_logger(DEBUGGING) << "Prefetching blocks after index " << (endHeight - 1);
+  m_prefetchedBlocks = sendBlocksQuery(std::move(request), true);
+}
+
+bool BlockchainSynchronizer::consumersReached(uint32_t height) const {
+  std::unique_lock<std::mutex> lk(m_consumersMutex);
+  for (auto& kv : m_consumers) {
+    if (kv.second->getHeight() < height) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 void BlockchainSynchronizer::startBlockchainSync() {
   m_logger(DEBUGGING) << "Starting blockchain synchronization...";
 
-  GetBlocksResponse response;
-  GetBlocksRequest req = getCommonHistory();
-
   try {
-    if (!req.knownBlocks.empty()) {
-      auto queryBlocksCompleted = std::promise<std::error_code>();
-      auto queryBlocksWaitFuture = queryBlocksCompleted.get_future();
-
-      m_node.queryBlocks(
-        std::move(req.knownBlocks),
-        req.syncStart.timestamp,
-        response.newBlocks,
-        response.startHeight,
-        [&queryBlocksCompleted](std::error_code ec) {
-          auto detachedPromise = std::move(queryBlocksCompleted);
-          detachedPromise.set_value(ec);
-        });
-
-      std::error_code ec = queryBlocksWaitFuture.get();
+    std::unique_ptr<BlocksQuery> query = std::move(m_prefetchedBlocks);
+    if (!query) {
+      GetBlocksRequest req = getCommonHistory();
+      if (req.knownBlocks.empty()) {
+        return;
+      }
 
-      if (ec) {
-        m_logger(ERROR, BRIGHT_RED) << "Failed to query blocks: " << ec << ", " << ec.message();
-        setFutureStateIf(State::idle, [this] { return m_futureState != State::stopped; });
-        m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, ec);
-      } else {
-        m_logger(DEBUGGING) << "Blocks received, start index " << response.startHeight << ", count " << response.newBlocks.size();
-        processBlocks(response);
+      query = sendBlocksQuery(std::move(req), false);
+    }
+
+    auto waitStart = std::chrono::steady_clock::now();
+    std::error_code ec = query->completed.get();
+
+    BlockchainSynchronizationTimings timings;
+    timings.startHeight = query->response.startHeight;
+    timings.blockCount = static_cast<uint32_t>(query->response.newBlocks.size());
+    timings.prefetched = query->prefetched;
+    timings.queryTime = std::chrono::duration_cast<std::chrono::microseconds>(query->queryTime);
+    timings.waitTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - waitStart);
+    timings.prepareTime = std::chrono::microseconds::zero();
+    timings.consumersTime = std::chrono::microseconds::zero();
+
+    if (ec) {
+      m_logger(ERROR, BRIGHT_RED) << "Failed to query blocks: " << ec << ", " << ec.message();
+      setFutureStateIf(State::idle, [this] { return m_futureState != State::stopped; });
+      m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, ec);
+    } else if (query->prefetched && !consumersReached(query->response.startHeight)) {
+      // consumers stopped short of the range the prefetch was sent for, ask again from their own history
+      m_logger(DEBUGGING) << "Prefetched blocks don't continue consumers chain, start index " << query->response.startHeight;
+      setFutureState(State::blockchainSync);
+    } else {
+      m_logger(DEBUGGING) << "Blocks received, start index " << query->response.startHeight << ", count " << query->response.newBlocks.size() <<
+        (query->prefetched ? ", prefetched" : "");
+      prefetchNextBlocks(*query);
+      if (processBlocks(query->response, timings) != UpdateConsumersResult::addedNewBlocks) {
+        m_prefetchedBlocks.reset();
       }
     }
   } catch (const std::exception& e) {
     m_logger(ERROR, BRIGHT_RED) << "Failed to query and process blocks: " << e.what();
+    m_prefetchedBlocks.reset();
     setFutureStateIf(State::idle,  [this] { return m_futureState != State::stopped; });
     m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, std::make_error_code(std::errc::invalid_argument));
   }
 }
 
-void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
+void BlockchainSynchronizer::waitForNodeUpdate() {
+  // poolSync is already scheduled, an event of the node raises it to blockchainSync
+  std::unique_lock<std::mutex> lk(m_stateMutex);
+  m_hasWork.wait_for(lk, std::chrono::seconds(RETRY_TIMEOUT), [this] {
+    return m_futureState != State::poolSync || !m_removeTransactionTasks.empty() || !m_addTransactionTasks.empty();
+  });
+}
+
+BlockchainSynchronizer::UpdateConsumersResult BlockchainSynchronizer::processBlocks(GetBlocksResponse& response, BlockchainSynchronizationTimings& timings) {
   m_logger(DEBUGGING) << "Process blocks, start index " << response.startHeight << ", count " << response.newBlocks.size();
 
+  auto prepareStart = std::chrono::steady_clock::now();
   BlockchainInterval interval;
   interval.startHeight = response.startHeight;
   std::vector<CompleteBlock> blocks;
@@ -515,7 +599,7 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
         m_logger(ERROR, BRIGHT_RED) << "Failed to process blocks: " << e.what();
         setFutureStateIf(State::idle, [this] { return m_futureState != State::stopped; });
         m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, std::make_error_code(std::errc::invalid_argument));
-        return;
+        return UpdateConsumersResult::errorOccurred;
       }
     }
 
@@ -523,12 +607,22 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
     blocks.push_back(std::move(completeBlock));
   }
 
+  timings.prepareTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - prepareStart);
+
+  auto result = UpdateConsumersResult::errorOccurred;
   uint32_t processedBlockCount = response.startHeight + static_cast<uint32_t>(response.newBlocks.size());
   if (!checkIfShouldStop()) {
     response.newBlocks.clear();
+    auto consumersStart = std::chrono::steady_clock::now();
     std::unique_lock<std::mutex> lk(m_consumersMutex);
-    auto result = updateConsumers(interval, blocks);
+    result = updateConsumers(interval, blocks);
     lk.unlock();
+    timings.consumersTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - consumersStart);
+
+    m_logger(DEBUGGING) << "Blocks processed, start index " << timings.startHeight << ", count " << timings.blockCount <<
+      ", query " << timings.queryTime.count() << " us, waited " << timings.waitTime.count() <<
+      " us, prepared " << timings.prepareTime.count() << " us, consumers " << timings.consumersTime.count() << " us";
+    m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationTimingsUpdated, timings);
 
     switch (result) {
     case UpdateConsumersResult::errorOccurred:
@@ -539,20 +633,24 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
 
     case UpdateConsumersResult::nothingChanged:
       if (m_node.getKnownBlockCount() != m_node.getLocalBlockCount()) {
-        m_logger(DEBUGGING) << "Blockchain updated, resume blockchain synchronization";
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        m_logger(DEBUGGING) << "Node is behind the network, resume blockchain synchronization on its next block";
+        waitForNodeUpdate();
       } else {
         break;
       }
 
     case UpdateConsumersResult::addedNewBlocks:
-      setFutureState(State::blockchainSync);
-      m_observerManager.notify(
-        &IBlockchainSynchronizerObserver::synchronizationProgressUpdated,
-        processedBlockCount,
-        std::max(m_node.getKnownBlockCount(), m_node.getLocalBlockCount()));
+    {
+      // a range that reached the top needs no second look, a new block comes with localBlockchainUpdated
+      uint32_t totalBlockCount = std::max(m_node.getKnownBlockCount(), m_node.getLocalBlockCount());
+      if (m_prefetchedBlocks || result == UpdateConsumersResult::nothingChanged || processedBlockCount < totalBlockCount) {
+        setFutureState(State::blockchainSync);
+      }
+
+      m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationProgressUpdated, processedBlockCount, totalBlockCount);
       break;
     }
+    }
 
     if (!blocks.empty()) {
       lastBlockId = blocks.back().blockHash;
@@ -564,6 +662,8 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
     m_logger(WARNING, BRIGHT_YELLOW) << "Block processing is interrupted";
     m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, std::make_error_code(std::errc::interrupted));
   }
+
+  return result;
 }
 
 /// \pre m_consumersMutex is locked
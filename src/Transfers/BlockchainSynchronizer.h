@@ -24,6 +24,7 @@
 #include "IObservableImpl.h"
 #include "IStreamSerializable.h"
 
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <atomic>
@@ -78,6 +79,24 @@ private:
     std::vector<Crypto::Hash> knownBlocks;
   };
 
+  // One queryBlocks call. The node fills the response from its own thread until the future is ready,
+  // so the query stays on the heap and its destructor waits for an answer still in flight.
+  struct BlocksQuery {
+    ~BlocksQuery() {
+      if (completed.valid()) {
+        completed.wait();
+      }
+    }
+
+    GetBlocksRequest request;
+    GetBlocksResponse response;
+    bool prefetched = false;
+    std::promise<std::error_code> promise;
+    std::future<std::error_code> completed;
+    std::chrono::steady_clock::time_point sendTime;
+    std::chrono::steady_clock::duration queryTime;
+  };
+
   struct GetPoolResponse {
     bool isLastKnownBlockActual;
     std::vector<std::unique_ptr<ITransactionReader>> newTxs;
@@ -108,7 +127,11 @@ private:
   void startPoolSync();
   void startBlockchainSync();
 
-  void processBlocks(GetBlocksResponse& response);
+  std::unique_ptr<BlocksQuery> sendBlocksQuery(GetBlocksRequest&& request, bool prefetched);
+  void prefetchNextBlocks(const BlocksQuery& query);
+  bool consumersReached(uint32_t height) const;
+  void waitForNodeUpdate();
+  UpdateConsumersResult processBlocks(GetBlocksResponse& response, BlockchainSynchronizationTimings& timings);
   UpdateConsumersResult updateConsumers(const BlockchainInterval& interval, const std::vector<CompleteBlock>& blocks);
   std::error_code processPoolTxs(GetPoolResponse& response);
   std::error_code getPoolSymmetricDifferenceSync(GetPoolRequest&& request, GetPoolResponse& response);
@@ -143,6 +166,8 @@ private:
   std::unique_ptr<std::thread> workingThread;
   std::list<std::pair<const ITransactionReader*, std::promise<std::error_code>>> m_addTransactionTasks;
   std::list<std::pair<const Crypto::Hash*, std::promise<void>>> m_removeTransactionTasks;
+  // the range after the one being processed, only touched by the working thread
+  std::unique_ptr<BlocksQuery> m_prefetchedBlocks;
 
   mutable std::mutex m_consumersMutex;
   mutable std::mutex m_stateMutex;
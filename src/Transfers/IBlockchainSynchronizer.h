@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <future>
 #include <system_error>
@@ -34,10 +35,23 @@ namespace CryptoNote {
 
 struct CompleteBlock;
 
+// Where the time went for one range of blocks. The next range is usually requested before this
+// one is scanned, so waitTime is the part of queryTime the consumers didn't cover.
+struct BlockchainSynchronizationTimings {
+  uint32_t startHeight;
+  uint32_t blockCount;
+  bool prefetched;
+  std::chrono::microseconds queryTime;     // from sending queryBlocks to the node's answer
+  std::chrono::microseconds waitTime;      // spent blocked on that answer
+  std::chrono::microseconds prepareTime;   // building the transaction prefixes
+  std::chrono::microseconds consumersTime; // consumers scanning the blocks
+};
+
 class IBlockchainSynchronizerObserver {
 public:
   virtual void synchronizationProgressUpdated(uint32_t processedBlockCount, uint32_t totalBlockCount) {}
   virtual void synchronizationCompleted(std::error_code result) {}
+  virtual void synchronizationTimingsUpdated(const BlockchainSynchronizationTimings& timings) {}
   virtual ~IBlockchainSynchronizerObserver() {}
 };
 
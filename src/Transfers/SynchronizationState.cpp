@@ -92,6 +92,7 @@ SynchronizationState::CheckResult SynchronizationState::checkInterval(const Bloc
 void SynchronizationState::detach(uint32_t height) {
   assert(height < m_blockchain.size());
   m_blockchain.resize(height);
+  m_changedHeight = std::min(m_changedHeight, height);
 }
 
 void SynchronizationState::addBlocks(const Crypto::Hash* blockHashes, uint32_t height, uint32_t count) {
@@ -99,6 +100,7 @@ void SynchronizationState::addBlocks(const Crypto::Hash* blockHashes, uint32_t h
   auto size = m_blockchain.size();
   if (size) {}
   assert( size == height);
+  m_changedHeight = std::min(m_changedHeight, static_cast<uint32_t>(m_blockchain.size()));
   m_blockchain.insert(m_blockchain.end(), blockHashes, blockHashes + count);
 }
 
@@ -114,12 +116,50 @@ void SynchronizationState::save(std::ostream& os) {
   StdOutputStream stream(os);
   CryptoNote::BinaryOutputStreamSerializer s(stream);
   serialize(s, "state");
+  m_changedHeight = getHeight();
 }
 
 void SynchronizationState::load(std::istream& in) {
   StdInputStream stream(in);
   CryptoNote::BinaryInputStreamSerializer s(stream);
   serialize(s, "state");
+  m_changedHeight = getHeight();
+}
+
+void SynchronizationState::saveChanges(std::ostream& os) {
+  StdOutputStream stream(os);
+  CryptoNote::BinaryOutputStreamSerializer s(stream);
+
+  uint32_t height = std::min(m_changedHeight, getHeight());
+  std::vector<Crypto::Hash> blocks(std::next(m_blockchain.begin(), height), m_blockchain.end());
+
+  s.beginObject("state");
+  s(height, "height");
+  s(blocks, "blockchain");
+  s.endObject();
+
+  m_changedHeight = getHeight();
+}
+
+void SynchronizationState::loadChanges(std::istream& in) {
+  StdInputStream stream(in);
+  CryptoNote::BinaryInputStreamSerializer s(stream);
+
+  uint32_t height = 0;
+  std::vector<Crypto::Hash> blocks;
+
+  s.beginObject("state");
+  s(height, "height");
+  s(blocks, "blockchain");
+  s.endObject();
+
+  if (height > m_blockchain.size()) {
+    throw std::runtime_error("Failed to load synchronization state changes: height is beyond the known blockchain");
+  }
+
+  m_blockchain.resize(height);
+  m_blockchain.insert(m_blockchain.end(), blocks.begin(), blocks.end());
+  m_changedHeight = getHeight();
 }
 
 CryptoNote::ISerializer& SynchronizationState::serialize(CryptoNote::ISerializer& s, const std::string& name) {
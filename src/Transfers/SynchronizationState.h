@@ -38,7 +38,7 @@ public:
 
   typedef std::vector<Crypto::Hash> ShortHistory;
 
-  explicit SynchronizationState(const Crypto::Hash& genesisBlockHash) {
+  explicit SynchronizationState(const Crypto::Hash& genesisBlockHash) : m_changedHeight(0) {
     m_blockchain.push_back(genesisBlockHash);
   }
 
@@ -53,6 +53,8 @@ public:
   // IStreamSerializable
   virtual void save(std::ostream& os) override;
   virtual void load(std::istream& in) override;
+  virtual void saveChanges(std::ostream& os) override;
+  virtual void loadChanges(std::istream& in) override;
 
   // serialization
   CryptoNote::ISerializer& serialize(CryptoNote::ISerializer& s, const std::string& name);
@@ -60,6 +62,7 @@ public:
 private:
 
   std::vector<Crypto::Hash> m_blockchain;
+  uint32_t m_changedHeight; // lowest height changed since the last save
 };
 
 }
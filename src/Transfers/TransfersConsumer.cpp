@@ -19,11 +19,13 @@
 
 #include "TransfersConsumer.h"
 
-#include <numeric>
+#include <atomic>
 #include <future>
+#include <limits>
+#include <numeric>
+#include <thread>
 
 #include "CommonTypes.h"
-#include "Common/BlockingQueue.h"
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/TransactionApi.h"
@@ -46,7 +48,7 @@ using namespace CryptoNote;
 
 class MarkTransactionConfirmedException : public std::exception {
 public:
-  MarkTransactionConfirmedException(const Crypto::Hash& txHash) {
+  MarkTransactionConfirmedException(const Crypto::Hash& txHash) : m_txHash(txHash) {
   }
 
   const Hash& getTxHash() const {
@@ -132,9 +134,18 @@ namespace CryptoNote {
 
 TransfersConsumer::TransfersConsumer(const CryptoNote::Currency& currency, INode& node, Logging::ILogger& logger, const SecretKey& viewSecret) :
   m_node(node), m_viewSecret(viewSecret), m_currency(currency), m_logger(logger, "TransfersConsumer") {
+  m_threadCount = std::thread::hardware_concurrency();
+  if (m_threadCount == 0) {
+    m_threadCount = 2;
+  }
+
   updateSyncStart();
 }
 
+void TransfersConsumer::setThreadCount(size_t threadCount) {
+  m_threadCount = std::max<size_t>(threadCount, 1);
+}
+
 ITransfersSubscription& TransfersConsumer::addSubscription(const AccountSubscription& subscription) {
   if (subscription.keys.viewSecretKey != m_viewSecret) {
     throw std::runtime_error("TransfersConsumer: view secret key mismatch");
@@ -229,75 +240,65 @@ uint32_t TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint32_t st
 
   struct PreprocessedTx : Tx, PreprocessInfo {};
 
+  // every transaction owns its slot, so the workers fill them in chain order without locking
   std::vector<PreprocessedTx> preprocessedTransactions;
-  std::mutex preprocessedTransactionsMutex;
-
-  size_t workers = std::thread::hardware_concurrency();
-  if (workers == 0) {
-    workers = 2;
-  }
+  uint32_t emptyBlockCount = 0;
 
-  BlockingQueue<Tx> inputQueue(workers * 2);
+  for (uint32_t i = 0; i < count; ++i) {
+    const auto& block = blocks[i].block;
 
-  std::atomic<bool> stopProcessing(false);
-  std::atomic<size_t> emptyBlockCount(0);
+    if (!block.is_initialized()) {
+      ++emptyBlockCount;
+      continue;
+    }
 
-  auto pushingThread = std::async(std::launch::async, [&] {
-    for (uint32_t i = 0; i < count && !stopProcessing; ++i) {
-      const auto& block = blocks[i].block;
+    // filter by syncStartTimestamp
+    if (m_syncStart.timestamp && block->timestamp < m_syncStart.timestamp) {
+      ++emptyBlockCount;
+      continue;
+    }
 
-      if (!block.is_initialized()) {
-        ++emptyBlockCount;
-        continue;
-      }
+    TransactionBlockInfo blockInfo;
+    blockInfo.height = startHeight + i;
+    blockInfo.timestamp = block->timestamp;
+    blockInfo.transactionIndex = 0; // position in block
 
-      // filter by syncStartTimestamp
-      if (m_syncStart.timestamp && block->timestamp < m_syncStart.timestamp) {
-        ++emptyBlockCount;
+    for (const auto& tx : blocks[i].transactions) {
+      auto pubKey = tx->getTransactionPublicKey();
+      if (pubKey == NULL_PUBLIC_KEY) {
+        ++blockInfo.transactionIndex;
         continue;
       }
 
-      TransactionBlockInfo blockInfo;
-      blockInfo.height = startHeight + i;
-      blockInfo.timestamp = block->timestamp;
-      blockInfo.transactionIndex = 0; // position in block
-
-      for (const auto& tx : blocks[i].transactions) {
-        auto pubKey = tx->getTransactionPublicKey();
-        if (pubKey == NULL_PUBLIC_KEY) {
-          ++blockInfo.transactionIndex;
-          continue;
-        }
-
-        bool isLastTransactionInBlock = blockInfo.transactionIndex + 1 == blocks[i].transactions.size();
-        Tx item = { blockInfo, tx.get(), isLastTransactionInBlock };
-        inputQueue.push(item);
-        ++blockInfo.transactionIndex;
-      }
+      PreprocessedTx item;
+      item.blockInfo = blockInfo;
+      item.tx = tx.get();
+      item.isLastTransactionInBlock = blockInfo.transactionIndex + 1 == blocks[i].transactions.size();
+      preprocessedTransactions.push_back(std::move(item));
+      ++blockInfo.transactionIndex;
     }
+  }
 
-    inputQueue.close();
-  });
+  std::atomic<size_t> nextTransaction(0);
+  std::atomic<bool> stopProcessing(false);
 
   auto processingFunction = [&] {
-    Tx item;
     std::error_code ec;
-    while (!stopProcessing && inputQueue.pop(item)) {
-      PreprocessedTx output;
-      static_cast<Tx&>(output) = item;
+    for (size_t i = nextTransaction++; i < preprocessedTransactions.size() && !stopProcessing; i = nextTransaction++) {
+      auto& item = preprocessedTransactions[i];
+      // the hash is cached on first use, get it here before the subscription shards read it concurrently
+      item.tx->getTransactionHash();
 
-      ec = preprocessOutputs(item.blockInfo, *item.tx, output);
+      ec = preprocessOutputs(item.blockInfo, *item.tx, item);
       if (ec) {
         stopProcessing = true;
         break;
       }
-
-      std::lock_guard<std::mutex> lk(preprocessedTransactionsMutex);
-      preprocessedTransactions.push_back(std::move(output));
     }
     return ec;
   };
 
+  size_t workers = std::min(m_threadCount, std::max<size_t>(preprocessedTransactions.size(), 1));
   std::vector<std::future<std::error_code>> processingThreads;
   for (size_t i = 0; i < workers; ++i) {
     processingThreads.push_back(std::async(std::launch::async, processingFunction));
@@ -328,39 +329,140 @@ uint32_t TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint32_t st
   std::vector<Crypto::Hash> blockHashes = getBlockHashes(blocks, count);
   m_observerManager.notify(&IBlockchainConsumerObserver::onBlocksAdded, this, blockHashes);
 
-  // sort by block height and transaction index in block
-  std::sort(preprocessedTransactions.begin(), preprocessedTransactions.end(), [](const PreprocessedTx& a, const PreprocessedTx& b) {
-    return std::tie(a.blockInfo.height, a.blockInfo.transactionIndex) < std::tie(b.blockInfo.height, b.blockInfo.transactionIndex);
-  });
+  // height every subscription advances to after the last transaction of a block
+  std::vector<uint32_t> advanceHeights(preprocessedTransactions.size());
+  uint32_t processedBlockCount = emptyBlockCount;
+  for (size_t i = 0; i < preprocessedTransactions.size(); ++i) {
+    if (preprocessedTransactions[i].isLastTransactionInBlock) {
+      ++processedBlockCount;
+      advanceHeights[i] = startHeight + processedBlockCount - 1;
+    }
+  }
+
+  // Containers of different subscriptions don't share anything, so they are split into shards and
+  // every shard takes the whole batch in chain order. The results are merged back in the same order.
+  struct Shard {
+    std::vector<TransfersSubscription*> subscriptions;
+    std::vector<std::pair<size_t, TransfersSubscription*>> updated;
+    std::vector<std::pair<size_t, ITransfersContainer*>> containers;
+    size_t failedTransaction = std::numeric_limits<size_t>::max();
+    bool confirmationFailed = false;
+    std::string error;
+  };
 
-  uint32_t processedBlockCount = static_cast<uint32_t>(emptyBlockCount);
-  try {
-    for (const auto& tx : preprocessedTransactions) {
-      processTransaction(tx.blockInfo, *tx.tx, tx);
-
-      if (tx.isLastTransactionInBlock) {
-        ++processedBlockCount;
-        m_logger(TRACE) << "Processed block " << processedBlockCount << " of " << count << ", last processed block index " << tx.blockInfo.height <<
-          ", hash " << blocks[processedBlockCount - 1].blockHash;
-
-        auto newHeight = startHeight + processedBlockCount - 1;
-        forEachSubscription([newHeight](TransfersSubscription& sub) {
-          sub.advanceHeight(newHeight);
-        });
+  size_t shardCount = std::min(m_threadCount, std::max<size_t>(m_subscriptions.size() / MIN_SUBSCRIPTIONS_PER_SHARD, 1));
+  std::vector<Shard> shards(shardCount);
+  size_t subscriptionIndex = 0;
+  for (const auto& kv : m_subscriptions) {
+    shards[subscriptionIndex++ * shardCount / m_subscriptions.size()].subscriptions.push_back(kv.second.get());
+  }
+
+  auto shardFunction = [&](Shard& shard) {
+    size_t i = 0;
+    try {
+      for (; i < preprocessedTransactions.size(); ++i) {
+        const auto& tx = preprocessedTransactions[i];
+        std::vector<ITransfersContainer*> transactionContainers;
+        for (auto sub : shard.subscriptions) {
+          if (processSubscription(tx.blockInfo, *sub, *tx.tx, tx, transactionContainers)) {
+            shard.updated.emplace_back(i, sub);
+          }
+        }
+
+        for (auto container : transactionContainers) {
+          shard.containers.emplace_back(i, container);
+        }
+
+        if (tx.isLastTransactionInBlock) {
+          for (auto sub : shard.subscriptions) {
+            sub->advanceHeight(advanceHeights[i]);
+          }
+        }
+      }
+    } catch (const MarkTransactionConfirmedException&) {
+      shard.failedTransaction = i;
+      shard.confirmationFailed = true;
+    } catch (std::exception& e) {
+      shard.failedTransaction = i;
+      shard.error = e.what();
+    } catch (...) {
+      shard.failedTransaction = i;
+      shard.error = "unknown exception";
+    }
+  };
+
+  std::vector<std::future<void>> shardThreads;
+  for (size_t i = 1; i < shards.size(); ++i) {
+    shardThreads.push_back(std::async(std::launch::async, shardFunction, std::ref(shards[i])));
+  }
+
+  shardFunction(shards[0]);
+  for (auto& f : shardThreads) {
+    f.get();
+  }
+
+  const Shard* failedShard = nullptr;
+  for (const auto& shard : shards) {
+    if (failedShard == nullptr || shard.failedTransaction < failedShard->failedTransaction) {
+      failedShard = &shard;
+    }
+  }
+
+  size_t processedTransactions = std::min(failedShard->failedTransaction, preprocessedTransactions.size());
+  std::vector<size_t> shardUpdates(shards.size(), 0);
+  std::vector<size_t> shardContainers(shards.size(), 0);
+
+  processedBlockCount = emptyBlockCount;
+  for (size_t i = 0; i < processedTransactions; ++i) {
+    const auto& tx = preprocessedTransactions[i];
+    m_logger(TRACE) << "Process transaction, block " << tx.blockInfo.height << ", transaction index " << tx.blockInfo.transactionIndex <<
+      ", hash " << tx.tx->getTransactionHash();
+
+    // observers of the subscriptions are notified here rather than on the shard threads
+    bool someContainerUpdated = false;
+    std::vector<ITransfersContainer*> transactionContainers;
+    for (size_t j = 0; j < shards.size(); ++j) {
+      auto& nextUpdate = shardUpdates[j];
+      for (; nextUpdate < shards[j].updated.size() && shards[j].updated[nextUpdate].first == i; ++nextUpdate) {
+        shards[j].updated[nextUpdate].second->notifyTransactionUpdated(tx.tx->getTransactionHash());
+        someContainerUpdated = true;
+      }
+
+      auto& next = shardContainers[j];
+      for (; next < shards[j].containers.size() && shards[j].containers[next].first == i; ++next) {
+        transactionContainers.push_back(shards[j].containers[next].second);
       }
     }
-  } catch (const MarkTransactionConfirmedException& e) {
-    m_logger(ERROR, BRIGHT_RED) << "Failed to process block transactions: failed to confirm transaction " << e.getTxHash() <<
+
+    notifyTransactionUpdated(tx.tx->getTransactionHash(), someContainerUpdated, transactionContainers);
+
+    if (tx.isLastTransactionInBlock) {
+      ++processedBlockCount;
+      m_logger(TRACE) << "Processed block " << processedBlockCount << " of " << count << ", last processed block index " << tx.blockInfo.height <<
+        ", hash " << blocks[processedBlockCount - 1].blockHash;
+    }
+  }
+
+  // other shards may have got past the failed transaction, the detach below deletes what they added
+  // and every deletion has to follow an update
+  for (size_t j = 0; j < shards.size(); ++j) {
+    for (size_t k = shardUpdates[j]; k < shards[j].updated.size(); ++k) {
+      const auto& update = shards[j].updated[k];
+      update.second->notifyTransactionUpdated(preprocessedTransactions[update.first].tx->getTransactionHash());
+    }
+  }
+
+  if (failedShard->confirmationFailed) {
+    const auto& txHash = preprocessedTransactions[processedTransactions].tx->getTransactionHash();
+    m_logger(ERROR, BRIGHT_RED) << "Failed to process block transactions: failed to confirm transaction " << txHash <<
       ", remove this transaction from all containers and transaction pool";
-    forEachSubscription([&e](TransfersSubscription& sub) {
-      sub.deleteUnconfirmedTransaction(e.getTxHash());
+    forEachSubscription([&txHash](TransfersSubscription& sub) {
+      sub.deleteUnconfirmedTransaction(txHash);
     });
 
-    m_poolTxs.erase(e.getTxHash());
-  } catch (std::exception& e) {
-    m_logger(ERROR, BRIGHT_RED) << "Failed to process block transactions, exception: " << e.what();
-  } catch (...) {
-    m_logger(ERROR, BRIGHT_RED) << "Failed to process block transactions, unknown exception";
+    m_poolTxs.erase(txHash);
+  } else if (processedTransactions < preprocessedTransactions.size()) {
+    m_logger(ERROR, BRIGHT_RED) << "Failed to process block transactions, exception: " << failedShard->error;
   }
 
   if (processedBlockCount < count) {
@@ -591,29 +693,46 @@ std::error_code TransfersConsumer::processTransaction(const TransactionBlockInfo
 }
 
 void TransfersConsumer::processTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, const PreprocessInfo& info) {
-  std::vector<TransactionOutputInformationIn> emptyOutputs;
   std::vector<ITransfersContainer*> transactionContainers;
 
   m_logger(TRACE) << "Process transaction, block " << blockInfo.height << ", transaction index " << blockInfo.transactionIndex << ", hash " << tx.getTransactionHash();
   bool someContainerUpdated = false;
   for (auto& kv : m_subscriptions) {
-    auto it = info.outputs.find(kv.first);
-    auto& subscriptionOutputs = (it == info.outputs.end()) ? emptyOutputs : it->second;
+    bool containerUpdated = processSubscription(blockInfo, *kv.second, tx, info, transactionContainers);
+    if (containerUpdated) {
+      kv.second->notifyTransactionUpdated(tx.getTransactionHash());
+    }
 
-    bool containerContainsTx;
-    bool containerUpdated;
-    processOutputs(blockInfo, *kv.second, tx, subscriptionOutputs, info.globalIdxs, containerContainsTx, containerUpdated);
     someContainerUpdated = someContainerUpdated || containerUpdated;
-    if (containerContainsTx) {
-      transactionContainers.emplace_back(&kv.second->getContainer());
-    }
   }
 
+  notifyTransactionUpdated(tx.getTransactionHash(), someContainerUpdated, transactionContainers);
+}
+
+bool TransfersConsumer::processSubscription(const TransactionBlockInfo& blockInfo, TransfersSubscription& sub, const ITransactionReader& tx,
+  const PreprocessInfo& info, std::vector<ITransfersContainer*>& transactionContainers) {
+  static const std::vector<TransactionOutputInformationIn> emptyOutputs;
+
+  auto it = info.outputs.find(sub.getKeys().address.spendPublicKey);
+  auto& subscriptionOutputs = (it == info.outputs.end()) ? emptyOutputs : it->second;
+
+  bool containerContainsTx;
+  bool containerUpdated;
+  processOutputs(blockInfo, sub, tx, subscriptionOutputs, info.globalIdxs, containerContainsTx, containerUpdated);
+  if (containerContainsTx) {
+    transactionContainers.emplace_back(&sub.getContainer());
+  }
+
+  return containerUpdated;
+}
+
+void TransfersConsumer::notifyTransactionUpdated(const Crypto::Hash& transactionHash, bool someContainerUpdated,
+  const std::vector<ITransfersContainer*>& transactionContainers) {
   if (someContainerUpdated) {
-    m_logger(TRACE) << "Transaction updated some containers, hash " << tx.getTransactionHash();
-    m_observerManager.notify(&IBlockchainConsumerObserver::onTransactionUpdated, this, tx.getTransactionHash(), transactionContainers);
+    m_logger(TRACE) << "Transaction updated some containers, hash " << transactionHash;
+    m_observerManager.notify(&IBlockchainConsumerObserver::onTransactionUpdated, this, transactionHash, transactionContainers);
   } else {
-    m_logger(TRACE) << "Transaction doesn't updated any container, hash " << tx.getTransactionHash();
+    m_logger(TRACE) << "Transaction doesn't updated any container, hash " << transactionHash;
   }
 }
 
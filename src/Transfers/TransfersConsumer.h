@@ -49,6 +49,10 @@ public:
   void initTransactionPool(const std::unordered_set<Crypto::Hash>& uncommitedTransactions);
   void addPublicKeysSeen(const Crypto::Hash& transactionHash, const Crypto::PublicKey& outputKey);
 
+  // Threads scanning new blocks for outputs and, with enough subscriptions, updating their containers.
+  // Defaults to the number of cores.
+  void setThreadCount(size_t threadCount);
+
   // IBlockchainConsumer
   virtual SynchronizationStart getSyncStart() override;
   virtual void onBlockchainDetach(uint32_t height) override;
@@ -76,13 +80,20 @@ private:
   std::error_code preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, PreprocessInfo& info);
   std::error_code processTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx);
   void processTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, const PreprocessInfo& info);
+  bool processSubscription(const TransactionBlockInfo& blockInfo, TransfersSubscription& sub, const ITransactionReader& tx,
+    const PreprocessInfo& info, std::vector<ITransfersContainer*>& transactionContainers);
   void processOutputs(const TransactionBlockInfo& blockInfo, TransfersSubscription& sub, const ITransactionReader& tx,
     const std::vector<TransactionOutputInformationIn>& outputs, const std::vector<uint32_t>& globalIdxs, bool& contains, bool& updated);
+  void notifyTransactionUpdated(const Crypto::Hash& transactionHash, bool someContainerUpdated,
+    const std::vector<ITransfersContainer*>& transactionContainers);
 
   std::error_code getGlobalIndices(const Crypto::Hash& transactionHash, std::vector<uint32_t>& outsGlobalIndices);
 
   void updateSyncStart();
 
+  // fewer subscriptions per thread aren't worth the hand-off
+  static const size_t MIN_SUBSCRIPTIONS_PER_SHARD = 32;
+
   SynchronizationStart m_syncStart;
   const Crypto::SecretKey m_viewSecret;
   // map { spend public key -> subscription }
@@ -93,6 +104,7 @@ private:
   INode& m_node;
   const CryptoNote::Currency& m_currency;
   Logging::LoggerRef m_logger;
+  size_t m_threadCount;
 };
 
 }
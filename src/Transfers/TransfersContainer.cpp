@@ -18,6 +18,7 @@
 
 #include "TransfersContainer.h"
 #include "IWalletLegacy.h"
+#include "Common/ShuffleGenerator.h"
 #include "Common/StdInputStream.h"
 #include "Common/StdOutputStream.h"
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
@@ -171,6 +172,8 @@ size_t SpentOutputDescriptor::hash() const {
 
 TransfersContainer::TransfersContainer(const Currency& currency, Logging::ILogger& logger, size_t transactionSpendableAge) :
   m_currentHeight(0),
+  m_balances(),
+  m_balanceTime(static_cast<uint64_t>(time(nullptr))),
   m_currency(currency),
   m_logger(logger, "TransfersContainer"),
   m_transactionSpendableAge(transactionSpendableAge) {
@@ -202,7 +205,7 @@ bool TransfersContainer::addTransaction(const TransactionBlockInfo& block, const
     }
 
     if (block.height != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT) {
-      m_currentHeight = block.height;
+      setCurrentHeight(block.height);
     }
 
     return added;
@@ -240,6 +243,7 @@ void TransfersContainer::addTransaction(const TransactionBlockInfo& block, const
   auto result = m_transactions.emplace(std::move(txInfo));
   (void)result; // Disable unused warning
   assert(result.second);
+  markTransactionChanged(txHash);
 }
 
 /**
@@ -273,8 +277,8 @@ bool TransfersContainer::addTransactionOutputs(const TransactionBlockInfo& block
 
     if (transferIsUnconfirmed) {
       auto result = m_unconfirmedTransfers.emplace(std::move(info));
-      (void)result; // Disable unused warning
       assert(result.second);
+      addTransferBalance(*result.first);
     } else {
       if (info.type == TransactionTypes::OutputType::Key) {
         bool duplicate = false;
@@ -311,14 +315,15 @@ bool TransfersContainer::addTransactionOutputs(const TransactionBlockInfo& block
       }
 
       auto result = m_availableTransfers.emplace(std::move(info));
-      (void)result; // Disable unused warning
       assert(result.second);
+      addTransferBalance(*result.first);
     }
 
     if (info.type == TransactionTypes::OutputType::Key) {
       updateTransfersVisibility(info.keyImage);
     }
 
+    markTransactionChanged(txHash);
     outputsAdded = true;
   }
 
@@ -395,6 +400,7 @@ bool TransfersContainer::addTransactionInputs(const TransactionBlockInfo& block,
       assert(spendingTransferIt->keyImage == input.keyImage);
       copyToSpent(block, tx, i, *spendingTransferIt);
       // erase from available outputs
+      removeTransferBalance(*spendingTransferIt);
       outputDescriptorIndex.erase(spendingTransferIt);
       updateTransfersVisibility(input.keyImage);
 
@@ -408,6 +414,7 @@ bool TransfersContainer::addTransactionInputs(const TransactionBlockInfo& block,
       if (availableOutputIt != outputDescriptorIndex.end()) {
         copyToSpent(block, tx, i, *availableOutputIt);
         // erase from available outputs
+        removeTransferBalance(*availableOutputIt);
         outputDescriptorIndex.erase(availableOutputIt);
 
         inputsAdded = true;
@@ -429,6 +436,7 @@ bool TransfersContainer::deleteUnconfirmedTransaction(const Hash& transactionHas
   } else if (it->blockHeight != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT) {
     return false;
   } else {
+    markTransactionChanged(it->transactionHash);
     deleteTransactionTransfers(it->transactionHash);
     m_transactions.erase(it);
     return true;
@@ -454,6 +462,8 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
     return false;
   }
 
+  markTransactionChanged(transactionHash);
+
   try {
     auto txInfo = *transactionIt;
     txInfo.blockHeight = block.height;
@@ -487,9 +497,10 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
       }
 
       auto result = m_availableTransfers.emplace(std::move(transfer));
-      (void)result; // Disable unused warning
       assert(result.second);
+      addTransferBalance(*result.first);
 
+      removeTransferBalance(*transferIt);
       transferIt = m_unconfirmedTransfers.get<ContainingTransactionIndex>().erase(transferIt);
 
       if (transfer.type == TransactionTypes::OutputType::Key) {
@@ -505,6 +516,7 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
 
       transfer.spendingBlock = block;
       spendingTransactionIndex.replace(transferIt, transfer);
+      markTransactionChanged(transfer.transactionHash);
     }
   } catch (std::exception& e) {
     m_logger(ERROR, BRIGHT_RED) << "markTransactionConfirmed failed: " << e.what() << ", rollback changes, block index " << block.height <<
@@ -525,9 +537,10 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
       unconfirmedTransfer.globalOutputIndex = UNCONFIRMED_TRANSACTION_GLOBAL_OUTPUT_INDEX;
 
       auto result = m_unconfirmedTransfers.emplace(std::move(unconfirmedTransfer));
-      (void)result; // Disable unused warning
       assert(result.second);
+      addTransferBalance(*result.first);
 
+      removeTransferBalance(*transferIt);
       transferIt = m_availableTransfers.get<ContainingTransactionIndex>().erase(transferIt);
 
       if (unconfirmedTransfer.type == TransactionTypes::OutputType::Key) {
@@ -544,6 +557,7 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
       spentTransfer.spendingBlock.transactionIndex = 0;
 
       spendingTransactionIndex.replace(transferIt, spentTransfer);
+      markTransactionChanged(spentTransfer.transactionHash);
     }
 
     throw;
@@ -556,6 +570,8 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
  * \pre m_mutex is locked.
  */
 void TransfersContainer::deleteTransactionTransfers(const Hash& transactionHash) {
+  markTransactionChanged(transactionHash);
+
   auto& spendingTransactionIndex = m_spentTransfers.get<SpendingTransactionIndex>();
   auto spentTransfersRange = spendingTransactionIndex.equal_range(transactionHash);
   for (auto it = spentTransfersRange.first; it != spentTransfersRange.second;) {
@@ -564,6 +580,8 @@ void TransfersContainer::deleteTransactionTransfers(const Hash& transactionHash)
 
     auto result = m_availableTransfers.emplace(static_cast<const TransactionOutputInformationEx&>(*it));
     assert(result.second);
+    addTransferBalance(*result.first);
+    markTransactionChanged(it->transactionHash);
     it = spendingTransactionIndex.erase(it);
 
     if (result.first->type == TransactionTypes::OutputType::Key) {
@@ -573,6 +591,7 @@ void TransfersContainer::deleteTransactionTransfers(const Hash& transactionHash)
 
   auto unconfirmedTransfersRange = m_unconfirmedTransfers.get<ContainingTransactionIndex>().equal_range(transactionHash);
   for (auto it = unconfirmedTransfersRange.first; it != unconfirmedTransfersRange.second;) {
+    removeTransferBalance(*it);
     if (it->type == TransactionTypes::OutputType::Key) {
       KeyImage keyImage = it->keyImage;
       it = m_unconfirmedTransfers.get<ContainingTransactionIndex>().erase(it);
@@ -585,6 +604,7 @@ void TransfersContainer::deleteTransactionTransfers(const Hash& transactionHash)
   auto& transactionTransfersIndex = m_availableTransfers.get<ContainingTransactionIndex>();
   auto transactionTransfersRange = transactionTransfersIndex.equal_range(transactionHash);
   for (auto it = transactionTransfersRange.first; it != transactionTransfersRange.second;) {
+    removeTransferBalance(*it);
     if (it->type == TransactionTypes::OutputType::Key) {
       KeyImage keyImage = it->keyImage;
       it = transactionTransfersIndex.erase(it);
@@ -611,6 +631,7 @@ void TransfersContainer::copyToSpent(const TransactionBlockInfo& block, const IT
   auto result = m_spentTransfers.emplace(std::move(spentOutput));
   (void)result; // Disable unused warning
   assert(result.second);
+  markTransactionChanged(output.transactionHash);
 }
 
 std::vector<Hash> TransfersContainer::detach(uint32_t height) {
@@ -642,6 +663,7 @@ std::vector<Hash> TransfersContainer::detach(uint32_t height) {
     }
 
     if (doDelete) {
+      markTransactionChanged(it->transactionHash);
       deleteTransactionTransfers(it->transactionHash);
       deletedTransactions.emplace_back(it->transactionHash);
       it = blockHeightIndex.erase(it);
@@ -649,20 +671,28 @@ std::vector<Hash> TransfersContainer::detach(uint32_t height) {
   }
 
   // TODO: notification on detach
-  m_currentHeight = height == 0 ? 0 : height - 1;
+  setCurrentHeight(height == 0 ? 0 : height - 1);
 
   return deletedTransactions;
 }
 
 namespace {
-  template<typename C, typename T>
-  void updateVisibility(C& collection, const T& range, bool visible) {
+  template<typename C, typename T, typename F>
+  void updateVisibility(C& collection, const T& range, bool visible, F&& onUpdate) {
     for (auto it = range.first; it != range.second; ++it) {
       auto updated = *it;
       updated.visible = visible;
+      onUpdate(*it, updated);
       collection.replace(it, updated);
     }
   }
+
+  template<typename T>
+  void collectTransactionHashes(const T& range, std::unordered_set<Hash>& hashes) {
+    for (auto it = range.first; it != range.second; ++it) {
+      hashes.insert(it->transactionHash);
+    }
+  }
 }
 
 /**
@@ -683,13 +713,22 @@ void TransfersContainer::updateTransfersVisibility(const KeyImage& keyImage) {
   size_t spentCount = std::distance(spentRange.first, spentRange.second);
   assert(spentCount == 0 || spentCount == 1);
 
+  collectTransactionHashes(unconfirmedRange, m_changedTransactions);
+  collectTransactionHashes(availableRange, m_changedTransactions);
+  collectTransactionHashes(spentRange, m_changedTransactions);
+
+  auto updateBalance = [this](const TransactionOutputInformationEx& transfer, const TransactionOutputInformationEx& updated) {
+    removeTransferBalance(transfer);
+    addTransferBalance(updated);
+  };
+
   if (spentCount > 0) {
-    updateVisibility(unconfirmedIndex, unconfirmedRange, false);
-    updateVisibility(availableIndex, availableRange, false);
-    updateVisibility(spentIndex, spentRange, true);
+    updateVisibility(unconfirmedIndex, unconfirmedRange, false, updateBalance);
+    updateVisibility(availableIndex, availableRange, false, updateBalance);
+    updateVisibility(spentIndex, spentRange, true, [](const SpentTransactionOutput&, const SpentTransactionOutput&) {});
   } else if (availableCount > 0) {
-    updateVisibility(unconfirmedIndex, unconfirmedRange, false);
-    updateVisibility(availableIndex, availableRange, false);
+    updateVisibility(unconfirmedIndex, unconfirmedRange, false, updateBalance);
+    updateVisibility(availableIndex, availableRange, false, updateBalance);
 
     auto iteratorList = createTransferIteratorList(availableRange);
     auto earliestTransferIt = iteratorList.minElement();
@@ -697,9 +736,156 @@ void TransfersContainer::updateTransfersVisibility(const KeyImage& keyImage) {
 
     auto earliestTransfer = *earliestTransferIt;
     earliestTransfer.visible = true;
+    updateBalance(*earliestTransferIt, earliestTransfer);
     availableIndex.replace(earliestTransferIt, earliestTransfer);
   } else {
-    updateVisibility(unconfirmedIndex, unconfirmedRange, unconfirmedCount == 1);
+    updateVisibility(unconfirmedIndex, unconfirmedRange, unconfirmedCount == 1, updateBalance);
+  }
+}
+
+/**
+ * \pre m_mutex is locked.
+ */
+void TransfersContainer::markTransactionChanged(const Hash& transactionHash) {
+  m_changedTransactions.insert(transactionHash);
+}
+
+namespace {
+  size_t getBalanceTypeIndex(TransactionTypes::OutputType type) {
+    assert(type == TransactionTypes::OutputType::Key || type == TransactionTypes::OutputType::Multisignature);
+    return type == TransactionTypes::OutputType::Key ? 0 : 1;
+  }
+
+  size_t getBalanceStateIndex(uint32_t state) {
+    switch (state) {
+    case ITransfersContainer::IncludeStateUnlocked:
+      return 0;
+    case ITransfersContainer::IncludeStateLocked:
+      return 1;
+    default:
+      assert(state == ITransfersContainer::IncludeStateSoftLocked);
+      return 2;
+    }
+  }
+}
+
+/**
+ * \pre m_mutex is locked.
+ */
+void TransfersContainer::addTransferBalance(const TransactionOutputInformationEx& transfer) const {
+  if (transfer.visible) {
+    uint32_t state = getTransferState(transfer, m_currentHeight, m_balanceTime);
+    m_balances[getBalanceTypeIndex(transfer.type)][getBalanceStateIndex(state)] += transfer.amount;
+  }
+}
+
+/**
+ * \pre m_mutex is locked.
+ */
+void TransfersContainer::removeTransferBalance(const TransactionOutputInformationEx& transfer) const {
+  if (transfer.visible) {
+    uint32_t state = getTransferState(transfer, m_currentHeight, m_balanceTime);
+    uint64_t& balance = m_balances[getBalanceTypeIndex(transfer.type)][getBalanceStateIndex(state)];
+    assert(balance >= transfer.amount);
+    balance -= transfer.amount;
+  }
+}
+
+/**
+ * \pre m_mutex is locked.
+ */
+void TransfersContainer::moveTransferBalance(const TransactionOutputInformationEx& transfer, uint32_t height, uint64_t time) const {
+  if (!transfer.visible) {
+    return;
+  }
+
+  uint32_t oldState = getTransferState(transfer, m_currentHeight, m_balanceTime);
+  uint32_t newState = getTransferState(transfer, height, time);
+  if (oldState != newState) {
+    size_t typeIndex = getBalanceTypeIndex(transfer.type);
+    assert(m_balances[typeIndex][getBalanceStateIndex(oldState)] >= transfer.amount);
+    m_balances[typeIndex][getBalanceStateIndex(oldState)] -= transfer.amount;
+    m_balances[typeIndex][getBalanceStateIndex(newState)] += transfer.amount;
+  }
+}
+
+/**
+ * \pre m_mutex is locked.
+ *
+ * Only available transfers can change their state with the height: the ones whose unlock height is passed between
+ * the old and the new height and the ones which leave or return to the soft lock. Both are looked up by the indexes.
+ */
+void TransfersContainer::setCurrentHeight(uint32_t height) {
+  if (height == m_currentHeight) {
+    return;
+  }
+
+  uint64_t lowHeight = std::min(m_currentHeight, height);
+  uint64_t highHeight = std::max(m_currentHeight, height);
+
+  // Unlocked by height when height + lockedTxAllowedDeltaBlocks >= unlockTime, see isSpendTimeUnlocked()
+  uint64_t unlockBegin = lowHeight + m_currency.lockedTxAllowedDeltaBlocks() + 1;
+  uint64_t unlockEnd = std::min<uint64_t>(highHeight + m_currency.lockedTxAllowedDeltaBlocks() + 1, m_currency.maxBlockHeight());
+  auto& unlockTimeIndex = m_availableTransfers.get<UnlockTimeIndex>();
+  for (auto it = unlockTimeIndex.lower_bound(unlockBegin); it != unlockTimeIndex.end() && it->unlockTime < unlockEnd; ++it) {
+    moveTransferBalance(*it, height, m_balanceTime);
+  }
+
+  // Soft locked while height < blockHeight + m_transactionSpendableAge
+  uint64_t softLockBegin = lowHeight + 1 > m_transactionSpendableAge ? lowHeight + 1 - m_transactionSpendableAge : 0;
+  uint64_t softLockEnd = highHeight + 1 > m_transactionSpendableAge ? highHeight + 1 - m_transactionSpendableAge : 0;
+  auto& blockHeightIndex = m_availableTransfers.get<BlockHeightIndex>();
+  for (auto it = blockHeightIndex.lower_bound(static_cast<uint32_t>(softLockBegin)); it != blockHeightIndex.end() && it->blockHeight < softLockEnd; ++it) {
+    if (it->unlockTime >= unlockBegin && it->unlockTime < unlockEnd) {
+      // already moved above
+      continue;
+    }
+
+    moveTransferBalance(*it, height, m_balanceTime);
+  }
+
+  m_currentHeight = height;
+}
+
+/**
+ * \pre m_mutex is locked.
+ *
+ * Transfers unlocked by time are moved lazily, when the balance is requested.
+ */
+void TransfersContainer::updateBalanceTime() const {
+  uint64_t now = static_cast<uint64_t>(time(NULL));
+  if (now == m_balanceTime) {
+    return;
+  }
+
+  uint64_t lowTime = std::min(m_balanceTime, now);
+  uint64_t highTime = std::max(m_balanceTime, now);
+
+  uint64_t unlockBegin = std::max<uint64_t>(lowTime + m_currency.lockedTxAllowedDeltaSeconds() + 1, m_currency.maxBlockHeight());
+  uint64_t unlockEnd = highTime + m_currency.lockedTxAllowedDeltaSeconds() + 1;
+  auto& unlockTimeIndex = m_availableTransfers.get<UnlockTimeIndex>();
+  for (auto it = unlockTimeIndex.lower_bound(unlockBegin); it != unlockTimeIndex.end() && it->unlockTime < unlockEnd; ++it) {
+    moveTransferBalance(*it, m_currentHeight, now);
+  }
+
+  m_balanceTime = now;
+}
+
+/**
+ * \pre m_mutex is locked.
+ */
+void TransfersContainer::rebuildBalances() const {
+  m_balanceTime = static_cast<uint64_t>(time(NULL));
+  for (auto& typeBalances : m_balances) {
+    std::fill(std::begin(typeBalances), std::end(typeBalances), 0);
+  }
+
+  for (const auto& transfer : m_unconfirmedTransfers) {
+    addTransferBalance(transfer);
+  }
+
+  for (const auto& transfer : m_availableTransfers) {
+    addTransferBalance(transfer);
   }
 }
 
@@ -707,7 +893,7 @@ bool TransfersContainer::advanceHeight(uint32_t height) {
   std::lock_guard<std::mutex> lk(m_mutex);
 
   if (m_currentHeight <= height) {
-    m_currentHeight = height;
+    setCurrentHeight(height);
     return true;
   }
 
@@ -726,18 +912,13 @@ size_t TransfersContainer::transactionsCount() const {
 
 uint64_t TransfersContainer::balance(uint32_t flags) const {
   std::lock_guard<std::mutex> lk(m_mutex);
-  uint64_t amount = 0;
-
-  for (const auto& t : m_availableTransfers) {
-    if (t.visible && isIncluded(t, flags)) {
-      amount += t.amount;
-    }
-  }
+  updateBalanceTime();
 
-  if ((flags & IncludeStateLocked) != 0) {
-    for (const auto& t : m_unconfirmedTransfers) {
-      if (t.visible && isIncluded(t.type, IncludeStateLocked, flags)) {
-        amount += t.amount;
+  uint64_t amount = 0;
+  for (auto type : { TransactionTypes::OutputType::Key, TransactionTypes::OutputType::Multisignature }) {
+    for (auto state : { IncludeStateUnlocked, IncludeStateLocked, IncludeStateSoftLocked }) {
+      if (isIncluded(type, state, flags)) {
+        amount += m_balances[getBalanceTypeIndex(type)][getBalanceStateIndex(state)];
       }
     }
   }
@@ -762,6 +943,124 @@ void TransfersContainer::getOutputs(std::vector<TransactionOutputInformation>& t
   }
 }
 
+namespace {
+  enum class AmountOrder {
+    Ascending,
+    Descending,
+    Random
+  };
+
+  // Visits the transfers with amount ranks in [begin, end) until the visitor returns false
+  template<typename Index, typename F>
+  void visitByAmount(const Index& index, size_t begin, size_t end, AmountOrder order, F&& visitor) {
+    switch (order) {
+    case AmountOrder::Ascending:
+      for (auto it = index.nth(begin), last = index.nth(end); it != last; ++it) {
+        if (!visitor(*it)) {
+          return;
+        }
+      }
+      break;
+
+    case AmountOrder::Descending:
+      for (auto it = index.nth(end), first = index.nth(begin); it != first;) {
+        if (!visitor(*--it)) {
+          return;
+        }
+      }
+      break;
+
+    case AmountOrder::Random: {
+      ShuffleGenerator<size_t> generator(end - begin);
+      while (!generator.empty()) {
+        if (!visitor(*index.nth(begin + generator()))) {
+          return;
+        }
+      }
+      break;
+    }
+    }
+  }
+}
+
+/**
+ * The wallet merges the outputs selected from its containers and applies the strategy once more, so each container
+ * selects enough outputs to cover neededMoney by itself, or all of them.
+ */
+uint64_t TransfersContainer::selectOutputs(uint64_t neededMoney, uint64_t dustThreshold, size_t dustCount, OutputSelectionStrategy strategy,
+                                           std::vector<TransactionOutputInformation>& outputs) const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+
+  uint64_t now = static_cast<uint64_t>(time(NULL));
+  auto isSpendable = [this, now](const TransactionOutputInformationEx& transfer) {
+    return transfer.visible && transfer.type == TransactionTypes::OutputType::Key &&
+      getTransferState(transfer, m_currentHeight, now) == IncludeStateUnlocked;
+  };
+
+  auto& amountIndex = m_availableTransfers.get<AmountIndex>();
+  size_t dustEnd = amountIndex.rank(amountIndex.upper_bound(dustThreshold));
+  size_t transferCount = amountIndex.size();
+
+  auto select = [&](size_t begin, size_t end, AmountOrder order, uint64_t amount, size_t maxCount) {
+    uint64_t foundMoney = 0;
+    size_t foundCount = 0;
+    if (amount == 0 || maxCount == 0) {
+      return foundMoney;
+    }
+
+    visitByAmount(amountIndex, begin, end, order, [&](const TransactionOutputInformationEx& transfer) {
+      if (isSpendable(transfer)) {
+        outputs.push_back(transfer);
+        foundMoney += transfer.amount;
+        ++foundCount;
+      }
+
+      return foundMoney < amount && foundCount < maxCount;
+    });
+
+    return foundMoney;
+  };
+
+  uint64_t foundMoney = 0;
+  switch (strategy) {
+  case OutputSelectionStrategy::Random:
+    foundMoney += select(dustEnd, transferCount, AmountOrder::Random, neededMoney, std::numeric_limits<size_t>::max());
+    // Dust is picked even if the money is found, see WalletGreen::selectTransfers()
+    foundMoney += select(0, dustEnd, AmountOrder::Random, neededMoney, dustCount);
+    break;
+
+  case OutputSelectionStrategy::SmallestSufficient:
+  case OutputSelectionStrategy::LargestFirst:
+    if (strategy == OutputSelectionStrategy::SmallestSufficient) {
+      auto it = amountIndex.lower_bound(std::max(neededMoney, dustThreshold + 1));
+      while (it != amountIndex.end() && !isSpendable(*it)) {
+        ++it;
+      }
+
+      if (it != amountIndex.end()) {
+        outputs.push_back(*it);
+        foundMoney += it->amount;
+        break;
+      }
+
+      // No output covers the whole amount
+    }
+
+    foundMoney += select(dustEnd, transferCount, AmountOrder::Descending, neededMoney, std::numeric_limits<size_t>::max());
+    if (foundMoney < neededMoney) {
+      foundMoney += select(0, dustEnd, AmountOrder::Descending, neededMoney - foundMoney, dustCount);
+    }
+    break;
+
+  case OutputSelectionStrategy::ConsolidateDust:
+    foundMoney += select(0, dustEnd, AmountOrder::Ascending, std::numeric_limits<uint64_t>::max(), dustCount);
+    foundMoney += select(dustEnd, transferCount, AmountOrder::Descending, neededMoney, std::numeric_limits<size_t>::max());
+    break;
+  }
+
+  return foundMoney;
+}
+
 bool TransfersContainer::getTransactionInformation(const Hash& transactionHash, TransactionInformation& info, uint64_t* amountIn, uint64_t* amountOut) const {
   std::lock_guard<std::mutex> lk(m_mutex);
   auto it = m_transactions.find(transactionHash);
@@ -901,6 +1200,8 @@ void TransfersContainer::save(std::ostream& os) {
   writeSequence<TransactionOutputInformationEx>(m_unconfirmedTransfers.begin(), m_unconfirmedTransfers.end(), "unconfirmedTransfers", s);
   writeSequence<TransactionOutputInformationEx>(m_availableTransfers.begin(), m_availableTransfers.end(), "availableTransfers", s);
   writeSequence<SpentTransactionOutput>(m_spentTransfers.begin(), m_spentTransfers.end(), "spentTransfers", s);
+
+  m_changedTransactions.clear();
 }
 
 void TransfersContainer::load(std::istream& in) {
@@ -934,12 +1235,141 @@ void TransfersContainer::load(std::istream& in) {
   m_unconfirmedTransfers = std::move(unconfirmedTransfers);
   m_availableTransfers = std::move(availableTransfers);
   m_spentTransfers = std::move(spentTransfers);
+  m_changedTransactions.clear();
+  rebuildBalances();
 
   // Repair the container if it was broken while handling addTransaction() in previous version of the code
   // Hope it isn't necessary anymore
   //repair();
 }
 
+namespace {
+
+template<typename Element, typename Index>
+void writeTransactionTransfers(const Index& index, const Hash& transactionHash, Common::StringView name, ISerializer& s) {
+  auto range = index.equal_range(transactionHash);
+  writeSequence<Element>(range.first, range.second, name, s);
+}
+
+}
+
+void TransfersContainer::saveChanges(std::ostream& os) {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  StdOutputStream stream(os);
+  CryptoNote::BinaryOutputStreamSerializer s(stream);
+
+  s(const_cast<uint32_t&>(TRANSFERS_CONTAINER_STORAGE_VERSION), "version");
+  s(m_currentHeight, "height");
+
+  // Each changed transaction is written with everything stored under its hash: the transaction information, if the
+  // transaction is still known, and the outputs it contains, whatever their state is
+  size_t count = m_changedTransactions.size();
+  s.beginArray(count, "transactions");
+  for (const auto& transactionHash : m_changedTransactions) {
+    s.beginObject("");
+    s(const_cast<Hash&>(transactionHash), "hash");
+
+    auto it = m_transactions.find(transactionHash);
+    bool exists = it != m_transactions.end();
+    s(exists, "exists");
+    if (exists) {
+      s(const_cast<TransactionInformation&>(*it), "transaction");
+    }
+
+    writeTransactionTransfers<TransactionOutputInformationEx>(m_unconfirmedTransfers.get<ContainingTransactionIndex>(), transactionHash, "unconfirmedTransfers", s);
+    writeTransactionTransfers<TransactionOutputInformationEx>(m_availableTransfers.get<ContainingTransactionIndex>(), transactionHash, "availableTransfers", s);
+    writeTransactionTransfers<SpentTransactionOutput>(m_spentTransfers.get<ContainingTransactionIndex>(), transactionHash, "spentTransfers", s);
+    s.endObject();
+  }
+  s.endArray();
+
+  m_changedTransactions.clear();
+}
+
+void TransfersContainer::loadChanges(std::istream& in) {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  StdInputStream stream(in);
+  CryptoNote::BinaryInputStreamSerializer s(stream);
+
+  uint32_t version = 0;
+  s(version, "version");
+
+  if (version > TRANSFERS_CONTAINER_STORAGE_VERSION) {
+    auto message = "Failed to load changes: unsupported version";
+    m_logger(ERROR, BRIGHT_RED) << message << ", version " << version << ", supported version " << TRANSFERS_CONTAINER_STORAGE_VERSION;
+    throw std::runtime_error(message);
+  }
+
+  struct TransactionChange {
+    Hash transactionHash;
+    bool exists;
+    TransactionInformation transaction;
+    std::vector<TransactionOutputInformationEx> unconfirmedTransfers;
+    std::vector<TransactionOutputInformationEx> availableTransfers;
+    std::vector<SpentTransactionOutput> spentTransfers;
+  };
+
+  uint32_t currentHeight = 0;
+  std::vector<TransactionChange> changes;
+
+  s(currentHeight, "height");
+
+  size_t count = 0;
+  s.beginArray(count, "transactions");
+  changes.resize(count);
+  for (auto& change : changes) {
+    s.beginObject("");
+    s(change.transactionHash, "hash");
+    s(change.exists, "exists");
+    if (change.exists) {
+      s(change.transaction, "transaction");
+    }
+
+    readSequence<TransactionOutputInformationEx>(std::back_inserter(change.unconfirmedTransfers), "unconfirmedTransfers", s);
+    readSequence<TransactionOutputInformationEx>(std::back_inserter(change.availableTransfers), "availableTransfers", s);
+    readSequence<SpentTransactionOutput>(std::back_inserter(change.spentTransfers), "spentTransfers", s);
+    s.endObject();
+  }
+  s.endArray();
+
+  // Everything is erased first, so an output moved between transactions never collides with its stale copy
+  for (const auto& change : changes) {
+    auto unconfirmedRange = m_unconfirmedTransfers.get<ContainingTransactionIndex>().equal_range(change.transactionHash);
+    for (auto it = unconfirmedRange.first; it != unconfirmedRange.second; ++it) {
+      removeTransferBalance(*it);
+    }
+
+    auto availableRange = m_availableTransfers.get<ContainingTransactionIndex>().equal_range(change.transactionHash);
+    for (auto it = availableRange.first; it != availableRange.second; ++it) {
+      removeTransferBalance(*it);
+    }
+
+    m_transactions.erase(change.transactionHash);
+    m_unconfirmedTransfers.get<ContainingTransactionIndex>().erase(change.transactionHash);
+    m_availableTransfers.get<ContainingTransactionIndex>().erase(change.transactionHash);
+    m_spentTransfers.get<ContainingTransactionIndex>().erase(change.transactionHash);
+  }
+
+  for (auto& change : changes) {
+    if (change.exists) {
+      m_transactions.emplace(std::move(change.transaction));
+    }
+
+    for (const auto& transfer : change.unconfirmedTransfers) {
+      addTransferBalance(*m_unconfirmedTransfers.insert(transfer).first);
+    }
+
+    for (const auto& transfer : change.availableTransfers) {
+      addTransferBalance(*m_availableTransfers.insert(transfer).first);
+    }
+
+    m_spentTransfers.insert(change.spentTransfers.begin(), change.spentTransfers.end());
+  }
+
+  setCurrentHeight(currentHeight);
+  m_changedTransactions.clear();
+}
+
 void TransfersContainer::repair() {
   size_t deletedInputCount = 0;
   for (auto it = m_spentTransfers.begin(); it != m_spentTransfers.end();) {
@@ -962,6 +1392,7 @@ void TransfersContainer::repair() {
 
       auto result = m_availableTransfers.emplace(static_cast<const TransactionOutputInformationEx&>(*it));
       assert(result.second);
+      addTransferBalance(*result.first);
       it = m_spentTransfers.erase(it);
 
       if (result.first->type == TransactionTypes::OutputType::Key) {
@@ -986,9 +1417,11 @@ void TransfersContainer::repair() {
 
       if (it->type == TransactionTypes::OutputType::Key) {
         KeyImage keyImage = it->keyImage;
+        removeTransferBalance(*it);
         it = m_unconfirmedTransfers.erase(it);
         updateTransfersVisibility(keyImage);
       } else {
+        removeTransferBalance(*it);
         it = m_unconfirmedTransfers.erase(it);
       }
 
@@ -1012,9 +1445,11 @@ void TransfersContainer::repair() {
 
       if (it->type == TransactionTypes::OutputType::Key) {
         KeyImage keyImage = it->keyImage;
+        removeTransferBalance(*it);
         it = m_availableTransfers.erase(it);
         updateTransfersVisibility(keyImage);
       } else {
+        removeTransferBalance(*it);
         it = m_availableTransfers.erase(it);
       }
 
@@ -1034,29 +1469,30 @@ void TransfersContainer::repair() {
   }
 }
 
-bool TransfersContainer::isSpendTimeUnlocked(uint64_t unlockTime) const {
+bool TransfersContainer::isSpendTimeUnlocked(uint64_t unlockTime, uint32_t height, uint64_t time) const {
   if (unlockTime < m_currency.maxBlockHeight()) {
     // interpret as block index
-    return m_currentHeight + m_currency.lockedTxAllowedDeltaBlocks() >= unlockTime;
+    return height + m_currency.lockedTxAllowedDeltaBlocks() >= unlockTime;
   } else {
     //interpret as time
-    uint64_t current_time = static_cast<uint64_t>(time(NULL));
-    return current_time + m_currency.lockedTxAllowedDeltaSeconds() >= unlockTime;
+    return time + m_currency.lockedTxAllowedDeltaSeconds() >= unlockTime;
   }
 
   return false;
 }
 
-bool TransfersContainer::isIncluded(const TransactionOutputInformationEx& info, uint32_t flags) const {
-  uint32_t state;
-  if (info.blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT || !isSpendTimeUnlocked(info.unlockTime)) {
-    state = IncludeStateLocked;
-  } else if (m_currentHeight < info.blockHeight + m_transactionSpendableAge) {
-    state = IncludeStateSoftLocked;
+uint32_t TransfersContainer::getTransferState(const TransactionOutputInformationEx& info, uint32_t height, uint64_t time) const {
+  if (info.blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT || !isSpendTimeUnlocked(info.unlockTime, height, time)) {
+    return IncludeStateLocked;
+  } else if (height < info.blockHeight + m_transactionSpendableAge) {
+    return IncludeStateSoftLocked;
   } else {
-    state = IncludeStateUnlocked;
+    return IncludeStateUnlocked;
   }
+}
 
+bool TransfersContainer::isIncluded(const TransactionOutputInformationEx& info, uint32_t flags) const {
+  uint32_t state = getTransferState(info, m_currentHeight, static_cast<uint64_t>(time(NULL)));
   return isIncluded(info.type, state, flags);
 }
 
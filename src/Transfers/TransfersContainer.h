@@ -20,6 +20,7 @@
 
 #include <cstdint>
 #include <unordered_map>
+#include <unordered_set>
 #include <mutex>
 
 #include <boost/multi_index_container.hpp>
@@ -27,6 +28,7 @@
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/ranked_index.hpp>
 
 #include "crypto/crypto.h"
 #include "CryptoNoteCore/CryptoNoteBasic.h"
@@ -87,6 +89,7 @@ struct TransactionOutputInformationEx : public TransactionOutputInformationIn {
 
   SpentOutputDescriptor getSpentOutputDescriptor() const { return SpentOutputDescriptor(*this); }
   const Crypto::Hash& getTransactionHash() const { return transactionHash; }
+  uint64_t getAmount() const { return amount; }
 
   void serialize(CryptoNote::ISerializer& s) {
     s(reinterpret_cast<uint8_t&>(type), "type");
@@ -166,6 +169,8 @@ public:
   virtual size_t transactionsCount() const override;
   virtual uint64_t balance(uint32_t flags) const override;
   virtual void getOutputs(std::vector<TransactionOutputInformation>& transfers, uint32_t flags) const override;
+  virtual uint64_t selectOutputs(uint64_t neededMoney, uint64_t dustThreshold, size_t dustCount, OutputSelectionStrategy strategy,
+    std::vector<TransactionOutputInformation>& outputs) const override;
   virtual bool getTransactionInformation(const Crypto::Hash& transactionHash, TransactionInformation& info,
     uint64_t* amountIn = nullptr, uint64_t* amountOut = nullptr) const override;
   virtual std::vector<TransactionOutputInformation> getTransactionOutputs(const Crypto::Hash& transactionHash, uint32_t flags) const override;
@@ -177,11 +182,16 @@ public:
   // IStreamSerializable
   virtual void save(std::ostream& os) override;
   virtual void load(std::istream& in) override;
+  virtual void saveChanges(std::ostream& os) override;
+  virtual void loadChanges(std::istream& in) override;
 
 private:
   struct ContainingTransactionIndex { };
   struct SpendingTransactionIndex { };
   struct SpentOutputDescriptorIndex { };
+  struct UnlockTimeIndex { };
+  struct BlockHeightIndex { };
+  struct AmountIndex { };
 
   typedef boost::multi_index_container<
     TransactionInformation,
@@ -229,6 +239,21 @@ private:
           TransactionOutputInformationEx,
           const Crypto::Hash&,
           &TransactionOutputInformationEx::getTransactionHash>
+      >,
+      boost::multi_index::ordered_non_unique<
+        boost::multi_index::tag<UnlockTimeIndex>,
+        BOOST_MULTI_INDEX_MEMBER(TransactionOutputInformationEx, uint64_t, unlockTime)
+      >,
+      boost::multi_index::ordered_non_unique<
+        boost::multi_index::tag<BlockHeightIndex>,
+        BOOST_MULTI_INDEX_MEMBER(TransactionOutputInformationEx, uint32_t, blockHeight)
+      >,
+      boost::multi_index::ranked_non_unique<
+        boost::multi_index::tag<AmountIndex>,
+        boost::multi_index::const_mem_fun<
+          TransactionOutputInformationEx,
+          uint64_t,
+          &TransactionOutputInformationEx::getAmount>
       >
     >
   > AvailableTransfersMultiIndex;
@@ -267,10 +292,19 @@ private:
                              const std::vector<TransactionOutputInformationIn>& transfers);
   bool addTransactionInputs(const TransactionBlockInfo& block, const ITransactionReader& tx);
   void deleteTransactionTransfers(const Crypto::Hash& transactionHash);
-  bool isSpendTimeUnlocked(uint64_t unlockTime) const;
+  bool isSpendTimeUnlocked(uint64_t unlockTime, uint32_t height, uint64_t time) const;
+  uint32_t getTransferState(const TransactionOutputInformationEx& info, uint32_t height, uint64_t time) const;
   bool isIncluded(const TransactionOutputInformationEx& info, uint32_t flags) const;
   static bool isIncluded(TransactionTypes::OutputType type, uint32_t state, uint32_t flags);
   void updateTransfersVisibility(const Crypto::KeyImage& keyImage);
+  void markTransactionChanged(const Crypto::Hash& transactionHash);
+
+  void addTransferBalance(const TransactionOutputInformationEx& transfer) const;
+  void removeTransferBalance(const TransactionOutputInformationEx& transfer) const;
+  void moveTransferBalance(const TransactionOutputInformationEx& transfer, uint32_t height, uint64_t time) const;
+  void setCurrentHeight(uint32_t height);
+  void updateBalanceTime() const;
+  void rebuildBalances() const;
 
   void copyToSpent(const TransactionBlockInfo& block, const ITransactionReader& tx, size_t inputIndex, const TransactionOutputInformationEx& output);
   void repair();
@@ -280,8 +314,14 @@ private:
   UnconfirmedTransfersMultiIndex m_unconfirmedTransfers;
   AvailableTransfersMultiIndex m_availableTransfers;
   SpentTransfersMultiIndex m_spentTransfers;
+  // Transactions whose information or outputs changed since the last save, see saveChanges()
+  std::unordered_set<Crypto::Hash> m_changedTransactions;
 
   uint32_t m_currentHeight; // current height is needed to check if a transfer is unlocked
+  // Amounts of visible unconfirmed and available transfers by output type and state, as of m_currentHeight and
+  // m_balanceTime. Only the transfers which change their state are moved when the height or the time advances
+  mutable uint64_t m_balances[2][3];
+  mutable uint64_t m_balanceTime;
   size_t m_transactionSpendableAge;
   const CryptoNote::Currency& m_currency;
   mutable std::mutex m_mutex;
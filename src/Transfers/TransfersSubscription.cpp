@@ -60,13 +60,12 @@ const AccountKeys& TransfersSubscription::getKeys() const {
 
 bool TransfersSubscription::addTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx,
                                            const std::vector<TransactionOutputInformationIn>& transfersList) {
-  bool added = transfers.addTransaction(blockInfo, tx, transfersList);
-  if (added) {
-    logger(TRACE) << "Transaction updates balance of wallet " << m_address << ", hash " << tx.getTransactionHash();
-    m_observerManager.notify(&ITransfersObserver::onTransactionUpdated, this, tx.getTransactionHash());
-  }
+  return transfers.addTransaction(blockInfo, tx, transfersList);
+}
 
-  return added;
+void TransfersSubscription::notifyTransactionUpdated(const Hash& transactionHash) {
+  logger(TRACE) << "Transaction updates balance of wallet " << m_address << ", hash " << transactionHash;
+  m_observerManager.notify(&ITransfersObserver::onTransactionUpdated, this, transactionHash);
 }
 
 AccountPublicAddress TransfersSubscription::getAddress() {
@@ -87,7 +86,6 @@ void TransfersSubscription::deleteUnconfirmedTransaction(const Hash& transaction
 void TransfersSubscription::markTransactionConfirmed(const TransactionBlockInfo& block, const Hash& transactionHash,
                                                      const std::vector<uint32_t>& globalIndices) {
   transfers.markTransactionConfirmed(block, transactionHash, globalIndices);
-  m_observerManager.notify(&ITransfersObserver::onTransactionUpdated, this, transactionHash);
 }
 
 }
@@ -35,11 +35,15 @@ public:
   void onError(const std::error_code& ec, uint32_t height);
   bool advanceHeight(uint32_t height);
   const AccountKeys& getKeys() const;
+
+  // addTransaction and markTransactionConfirmed may run on a scanning thread, so they leave
+  // onTransactionUpdated to notifyTransactionUpdated, which the consumer calls on its own thread
   bool addTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx,
                       const std::vector<TransactionOutputInformationIn>& transfers);
+  void markTransactionConfirmed(const TransactionBlockInfo& block, const Crypto::Hash& transactionHash, const std::vector<uint32_t>& globalIndices);
+  void notifyTransactionUpdated(const Crypto::Hash& transactionHash);
 
   void deleteUnconfirmedTransaction(const Crypto::Hash& transactionHash);
-  void markTransactionConfirmed(const TransactionBlockInfo& block, const Crypto::Hash& transactionHash, const std::vector<uint32_t>& globalIndices);
 
   // ITransfersSubscription
   virtual AccountPublicAddress getAddress() override;
@@ -160,6 +160,14 @@ void TransfersSyncronizer::unsubscribeConsumerNotifications(const Crypto::Public
 }
 
 void TransfersSyncronizer::save(std::ostream& os) {
+  saveState(os, false);
+}
+
+void TransfersSyncronizer::saveChanges(std::ostream& os) {
+  saveState(os, true);
+}
+
+void TransfersSyncronizer::saveState(std::ostream& os, bool changesOnly) {
   m_sync.save(os);
 
   StdOutputStream stream(os);
@@ -176,7 +184,12 @@ void TransfersSyncronizer::save(std::ostream& os) {
 
     std::stringstream consumerState;
     // synchronization state
-    m_sync.getConsumerState(consumer.second.get())->save(consumerState);
+    auto state = m_sync.getConsumerState(consumer.second.get());
+    if (changesOnly) {
+      state->saveChanges(consumerState);
+    } else {
+      state->save(consumerState);
+    }
 
     std::string blob = consumerState.str();
     s(blob, "state");
@@ -194,7 +207,11 @@ void TransfersSyncronizer::save(std::ostream& os) {
 
         std::stringstream subState;
         assert(sub);
-        sub->getContainer().save(subState);
+        if (changesOnly) {
+          sub->getContainer().saveChanges(subState);
+        } else {
+          sub->getContainer().save(subState);
+        }
         // store data block
         std::string blob = subState.str();
         s(addr, "address");
@@ -221,9 +238,22 @@ void setObjectState(IStreamSerializable& obj, const std::string& state) {
   obj.load(stream);
 }
 
+void applyObjectChanges(IStreamSerializable& obj, const std::string& changes) {
+  std::stringstream stream(changes);
+  obj.loadChanges(stream);
+}
+
 }
 
 void TransfersSyncronizer::load(std::istream& is) {
+  loadState(is, false);
+}
+
+void TransfersSyncronizer::loadChanges(std::istream& is) {
+  loadState(is, true);
+}
+
+void TransfersSyncronizer::loadState(std::istream& is, bool changesOnly) {
   m_sync.load(is);
 
   StdInputStream inputStream(is);
@@ -266,7 +296,11 @@ void TransfersSyncronizer::load(std::istream& is) {
           // store previous state
           auto prevConsumerState = getObjectState(*consumerState);
           // load consumer state
-          setObjectState(*consumerState, blob);
+          if (changesOnly) {
+            applyObjectChanges(*consumerState, blob);
+          } else {
+            setObjectState(*consumerState, blob);
+          }
           updatedStates.push_back(ConsumerState{ viewKey, std::move(prevConsumerState) });
         }
 
@@ -287,7 +321,11 @@ void TransfersSyncronizer::load(std::istream& is) {
 
           if (sub != nullptr) {
             auto prevState = getObjectState(sub->getContainer());
-            setObjectState(sub->getContainer(), state);
+            if (changesOnly) {
+              applyObjectChanges(sub->getContainer(), state);
+            } else {
+              setObjectState(sub->getContainer(), state);
+            }
             updatedStates.back().subscriptionStates.push_back(std::make_pair(acc, prevState));
           } else {
             m_logger(Logging::DEBUGGING) << "Subscription not found: " << m_currency.accountAddressAsString(acc);
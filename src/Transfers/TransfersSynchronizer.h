@@ -59,6 +59,8 @@ public:
   // IStreamSerializable
   virtual void save(std::ostream& os) override;
   virtual void load(std::istream& in) override;
+  virtual void saveChanges(std::ostream& os) override;
+  virtual void loadChanges(std::istream& in) override;
 
 private:
   Logging::LoggerRef m_logger;
@@ -83,6 +85,9 @@ private:
   virtual void onTransactionUpdated(IBlockchainConsumer* consumer, const Crypto::Hash& transactionHash,
     const std::vector<ITransfersContainer*>& containers) override;
 
+  void saveState(std::ostream& os, bool changesOnly);
+  void loadState(std::istream& is, bool changesOnly);
+
   bool findViewKeyForConsumer(IBlockchainConsumer* consumer, Crypto::PublicKey& viewKey) const;
   SubscribersContainer::const_iterator findSubscriberForConsumer(IBlockchainConsumer* consumer) const;
 };
@@ -141,6 +141,24 @@ uint64_t calculateDonationAmount(uint64_t freeAmount, uint64_t donationThreshold
   return donationAmount;
 }
 
+// The journal is compacted into the cache when it grows bigger than the cache, but not before it reaches this size
+const uint64_t WALLET_JOURNAL_MIN_COMPACTION_SIZE = 1024 * 1024;
+
+// Dust outputs spent at most by a transaction with OutputSelectionStrategy::ConsolidateDust
+const size_t DUST_CONSOLIDATION_MAX_INPUT_COUNT = 100;
+
+std::string getJournalPath(const std::string& path) {
+  return path + ".journal";
+}
+
+Crypto::chacha8_iv getContainerDataIv(ContainerStorage& storage) {
+  Common::MemoryInputStream suffixStream(storage.suffix(), storage.suffixSize());
+  BinaryInputStreamSerializer suffixSerializer(suffixStream);
+  Crypto::chacha8_iv suffixIv;
+  suffixSerializer(suffixIv, "suffixIv");
+  return suffixIv;
+}
+
 }
 
 namespace CryptoNote {
@@ -151,6 +169,7 @@ WalletGreen::WalletGreen(System::Dispatcher& dispatcher, const Currency& currenc
   m_node(node),
   m_logger(logger, "WalletGreen/empty"),
   m_stopped(false),
+  m_journalEnabled(false),
   m_blockchainSynchronizerStarted(false),
   m_blockchainSynchronizer(node, logger, currency.genesisBlockHash()),
   m_synchronizer(currency, logger, m_blockchainSynchronizer, node),
@@ -235,6 +254,7 @@ void WalletGreen::doShutdown() {
   m_blockchainSynchronizer.removeObserver(this);
 
   m_containerStorage.close();
+  m_journal.close();
   m_walletsContainer.clear();
   clearCaches(true, true);
 
@@ -245,6 +265,10 @@ void WalletGreen::doShutdown() {
 }
 
 void WalletGreen::clearCaches(bool clearTransactions, bool clearCachedData) {
+  m_journalEnabled = false;
+  m_changedTransactions.clear();
+  m_changedWallets.clear();
+
   if (clearTransactions) {
     m_transactions.clear();
     m_transfers.clear();
@@ -373,6 +397,7 @@ void WalletGreen::initWithKeys(const std::string& path, const std::string& passw
   m_viewSecretKey = viewSecretKey;
   m_password = password;
   m_path = path;
+  m_journal.open(getJournalPath(path));
   m_logger = Logging::LoggerRef(m_logger.getLogger(), "WalletGreen/" + podToHex(m_viewPublicKey).substr(0, 5));
 
   assert(m_blockchain.empty());
@@ -392,7 +417,10 @@ void WalletGreen::save(WalletSaveLevel saveLevel, const std::string& extra) {
   stopBlockchainSynchronizer();
 
   try {
-    saveWalletCache(m_containerStorage, m_key, saveLevel, extra);
+    if (!appendWalletJournal(saveLevel, extra)) {
+      saveWalletCache(m_containerStorage, m_key, saveLevel, extra);
+      resetWalletJournal(saveLevel);
+    }
   } catch (const std::exception& e) {
     m_logger(ERROR, BRIGHT_RED) << "Failed to save container: " << e.what();
     startBlockchainSynchronizer();
@@ -411,6 +439,9 @@ void WalletGreen::exportWallet(const std::string& path, bool encrypt, WalletSave
 
   stopBlockchainSynchronizer();
 
+  // Saving the cache resets the change tracking of the transfers synchronizer, the next save must be a full one
+  m_journalEnabled = false;
+
   try {
     bool storageCreated = false;
     Tools::ScopeExit failExitHandler([path, &storageCreated] {
@@ -461,6 +492,7 @@ void WalletGreen::load(const std::string& path, const std::string& password, std
   stopBlockchainSynchronizer();
 
   generate_chacha8_key(password, m_key);
+  m_journal.open(getJournalPath(path));
 
   std::ifstream walletFileStream(path, std::ios_base::binary);
   int version = walletFileStream.peek();
@@ -487,6 +519,12 @@ void WalletGreen::load(const std::string& path, const std::string& password, std
         std::unordered_set<Crypto::PublicKey> addedSpendKeys;
         std::unordered_set<Crypto::PublicKey> deletedSpendKeys;
         loadWalletCache(addedSpendKeys, deletedSpendKeys, extra);
+        if (!replayWalletJournal(extra)) {
+          m_logger(WARNING, BRIGHT_YELLOW) << "Wallet journal partially replayed, reload container cache";
+          clearCaches(true, true);
+          subscribeWallets();
+          loadWalletCache(addedSpendKeys, deletedSpendKeys, extra);
+        }
 
         if (!addedSpendKeys.empty()) {
           m_logger(WARNING, BRIGHT_YELLOW) << "Found addresses not saved in container cache. Resynchronize container";
@@ -501,6 +539,7 @@ void WalletGreen::load(const std::string& path, const std::string& password, std
 
         if (!addedSpendKeys.empty() || !deletedSpendKeys.empty()) {
           saveWalletCache(m_containerStorage, m_key, WalletSaveLevel::SAVE_ALL, extra);
+          resetWalletJournal(WalletSaveLevel::SAVE_ALL);
         }
       } catch (const std::exception& e) {
         m_logger(ERROR, BRIGHT_RED) << "Failed to load cache: " << e.what() << ", reset wallet data";
@@ -670,6 +709,124 @@ void WalletGreen::saveWalletCache(ContainerStorage& storage, const Crypto::chach
   m_logger(DEBUGGING) << "Container saving finished";
 }
 
+bool WalletGreen::appendWalletJournal(WalletSaveLevel saveLevel, const std::string& extra) {
+  if (saveLevel != WalletSaveLevel::SAVE_ALL || !m_journalEnabled) {
+    return false;
+  }
+
+  if (m_journal.size() > std::max<uint64_t>(m_containerStorage.suffixSize(), WALLET_JOURNAL_MIN_COMPACTION_SIZE)) {
+    m_logger(DEBUGGING) << "Journal is bigger than the cache, compacting it. Journal records " << m_journal.recordCount() <<
+      ", size " << m_journal.size();
+    return false;
+  }
+
+  try {
+    std::string changes;
+    Common::StringOutputStream changesStream(changes);
+
+    WalletSerializerV2 s(
+      *this,
+      m_viewPublicKey,
+      m_viewSecretKey,
+      m_actualBalance,
+      m_pendingBalance,
+      m_walletsContainer,
+      m_synchronizer,
+      m_unlockTransactionsJob,
+      m_transactions,
+      m_transfers,
+      m_uncommitedTransactions,
+      const_cast<std::string&>(extra),
+      m_transactionSoftLockTime
+    );
+
+    s.saveChanges(changesStream, m_changedTransactions, m_changedWallets);
+    m_journal.append(m_key, changes.data(), changes.size());
+  } catch (const std::exception& e) {
+    m_logger(WARNING, BRIGHT_YELLOW) << "Failed to append changes to the journal: " << e.what() << ", save the whole cache";
+    m_journalEnabled = false;
+    return false;
+  }
+
+  m_logger(DEBUGGING) << "Changes appended to the journal. Transactions " << m_changedTransactions.size() <<
+    ", wallets " << m_changedWallets.size() << ", journal records " << m_journal.recordCount() << ", size " << m_journal.size();
+
+  m_changedTransactions.clear();
+  m_changedWallets.clear();
+  m_extra = extra;
+
+  return true;
+}
+
+void WalletGreen::resetWalletJournal(WalletSaveLevel saveLevel) {
+  m_journalEnabled = false;
+  m_changedTransactions.clear();
+  m_changedWallets.clear();
+
+  // The cache doesn't have deleted transactions and the ids of the following ones are shifted. The journal refers to
+  // the ids in memory, so it can't be used until the container is loaded again
+  bool hasDeletedTransactions = std::any_of(m_transactions.begin(), m_transactions.end(), [](const WalletTransaction& tx) {
+    return tx.state == WalletTransactionState::DELETED;
+  });
+
+  try {
+    if (saveLevel != WalletSaveLevel::SAVE_ALL || hasDeletedTransactions) {
+      m_journal.remove();
+    } else {
+      m_journal.reset(getContainerDataIv(m_containerStorage));
+      m_journalEnabled = true;
+    }
+  } catch (const std::exception& e) {
+    m_logger(WARNING, BRIGHT_YELLOW) << "Failed to reset the journal: " << e.what();
+  }
+}
+
+bool WalletGreen::replayWalletJournal(std::string& extra) {
+  std::vector<BinaryArray> records;
+  try {
+    if (!m_journal.read(m_key, getContainerDataIv(m_containerStorage), records)) {
+      m_logger(DEBUGGING) << "No journal for the container cache";
+      return true;
+    }
+  } catch (const std::exception& e) {
+    m_logger(WARNING, BRIGHT_YELLOW) << "Failed to read the journal: " << e.what() << ", discard it";
+    m_journal.remove();
+    return true;
+  }
+
+  WalletSerializerV2 s(
+    *this,
+    m_viewPublicKey,
+    m_viewSecretKey,
+    m_actualBalance,
+    m_pendingBalance,
+    m_walletsContainer,
+    m_synchronizer,
+    m_unlockTransactionsJob,
+    m_transactions,
+    m_transfers,
+    m_uncommitedTransactions,
+    extra,
+    m_transactionSoftLockTime
+  );
+
+  try {
+    for (const auto& record : records) {
+      Common::MemoryInputStream recordStream(record.data(), record.size());
+      s.loadChanges(recordStream);
+    }
+  } catch (const std::exception& e) {
+    // The changes applied so far can't be undone, the caller restores the cache without the journal
+    m_logger(WARNING, BRIGHT_YELLOW) << "Failed to replay the journal: " << e.what() << ", discard it";
+    m_journal.remove();
+    return false;
+  }
+
+  m_journalEnabled = true;
+  m_logger(DEBUGGING) << "Journal replayed, records " << records.size() << ", size " << m_journal.size();
+  return true;
+}
+
 void WalletGreen::copyContainerStorageKeys(ContainerStorage& src, const chacha8_key& srcKey, ContainerStorage& dst, const chacha8_key& dstKey) {
   m_logger(DEBUGGING) << "Copying wallet keys...";
   dst.reserve(src.size());
@@ -932,6 +1089,12 @@ void WalletGreen::changePassword(const std::string& oldPassword, const std::stri
     return;
   }
 
+  if (m_journal.recordCount() != 0) {
+    // The journal is encrypted with the old key, fold it into the cache that is encrypted again below
+    m_journalEnabled = false;
+    save(WalletSaveLevel::SAVE_ALL, m_extra);
+  }
+
   Crypto::chacha8_key newKey;
   Crypto::generate_chacha8_key(newPassword, newKey);
 
@@ -949,6 +1112,11 @@ void WalletGreen::changePassword(const std::string& oldPassword, const std::stri
   m_key = newKey;
   m_password = newPassword;
 
+  if (m_journalEnabled) {
+    // The cache got a new IV, bind the empty journal to it
+    resetWalletJournal(WalletSaveLevel::SAVE_ALL);
+  }
+
   m_logger(INFO, BRIGHT_WHITE) << "Container password changed";
 }
 
@@ -1152,6 +1320,9 @@ std::vector<std::string> WalletGreen::doCreateAddressList(const std::vector<NewA
 
   stopBlockchainSynchronizer();
 
+  // The cache doesn't know the new addresses, save it as a whole next time
+  m_journalEnabled = false;
+
   std::vector<std::string> addresses;
   try {
     uint64_t minCreationTimestamp = std::numeric_limits<uint64_t>::max();
@@ -1397,6 +1568,9 @@ void WalletGreen::deleteAddress(const std::string& address) {
 
   stopBlockchainSynchronizer();
 
+  // The deleted address and its transactions are still in the cache, save it as a whole next time
+  m_journalEnabled = false;
+
   m_actualBalance -= it->actualBalance;
   m_pendingBalance -= it->pendingBalance;
 
@@ -1561,7 +1735,7 @@ size_t WalletGreen::transfer(const TransactionParameters& transactionParameters,
 
 uint64_t WalletGreen::getBalanceMinusDust(const std::vector<std::string>& addresses)
 {
-    std::vector<WalletOuts> wallets = addresses.empty() ? pickWalletsWithMoney() : pickWallets(addresses);
+    std::vector<WalletRecord*> wallets = pickSpendingWallets(addresses);
     std::vector<OutputToTransfer> unused;
 
 	/* We want to get the full balance, so don't stop getting outputs early */
@@ -1573,15 +1747,17 @@ uint64_t WalletGreen::getBalanceMinusDust(const std::vector<std::string>& addres
 		/* Don't include dust outputs */
 		false,
 		m_currency.defaultDustThreshold(),
-		std::move(wallets),
+		OutputSelectionStrategy::LargestFirst,
+		wallets,
 		unused
 	);
 }
 
-void WalletGreen::prepareTransaction(std::vector<WalletOuts>&& wallets,
+void WalletGreen::prepareTransaction(const std::vector<WalletRecord*>& wallets,
   const std::vector<WalletOrder>& orders,
   uint64_t fee,
   uint16_t mixIn,
+  OutputSelectionStrategy outputSelection,
   const std::string& extra,
   uint64_t unlockTimestamp,
   const DonationSettings& donation,
@@ -1593,7 +1769,7 @@ void WalletGreen::prepareTransaction(std::vector<WalletOuts>&& wallets,
   preparedTransaction.neededMoney = countNeededMoney(preparedTransaction.destinations, fee);
 
   std::vector<OutputToTransfer> selectedTransfers;
-  uint64_t foundMoney = selectTransfers(preparedTransaction.neededMoney, mixIn == 0, m_currency.defaultDustThreshold(), std::move(wallets), selectedTransfers);
+  uint64_t foundMoney = selectTransfers(preparedTransaction.neededMoney, mixIn == 0, m_currency.defaultDustThreshold(), outputSelection, wallets, selectedTransfers);
 
   if (foundMoney < preparedTransaction.neededMoney) {
     m_logger(ERROR, BRIGHT_RED) << "Failed to create transaction: not enough money. Needed " << m_currency.formatAmount(preparedTransaction.neededMoney) <<
@@ -1817,18 +1993,14 @@ size_t WalletGreen::doTransfer(const TransactionParameters& transactionParameter
   CryptoNote::AccountPublicAddress changeDestination = getChangeDestination(transactionParameters.changeDestination, transactionParameters.sourceAddresses);
   m_logger(DEBUGGING) << "Change address " << m_currency.accountAddressAsString(changeDestination);
 
-  std::vector<WalletOuts> wallets;
-  if (!transactionParameters.sourceAddresses.empty()) {
-    wallets = pickWallets(transactionParameters.sourceAddresses);
-  } else {
-    wallets = pickWalletsWithMoney();
-  }
+  std::vector<WalletRecord*> wallets = pickSpendingWallets(transactionParameters.sourceAddresses);
 
   PreparedTransaction preparedTransaction;
-  prepareTransaction(std::move(wallets),
+  prepareTransaction(wallets,
     transactionParameters.destinations,
     transactionParameters.fee,
     transactionParameters.mixIn,
+    transactionParameters.outputSelection,
     transactionParameters.extra,
     transactionParameters.unlockTimestamp,
     transactionParameters.donation,
@@ -1873,20 +2045,16 @@ size_t WalletGreen::makeTransaction(const TransactionParameters& sendingTransact
   CryptoNote::AccountPublicAddress changeDestination = getChangeDestination(sendingTransaction.changeDestination, sendingTransaction.sourceAddresses);
   m_logger(DEBUGGING) << "Change address " << m_currency.accountAddressAsString(changeDestination);
 
-  std::vector<WalletOuts> wallets;
-  if (!sendingTransaction.sourceAddresses.empty()) {
-    wallets = pickWallets(sendingTransaction.sourceAddresses);
-  } else {
-    wallets = pickWalletsWithMoney();
-  }
+  std::vector<WalletRecord*> wallets = pickSpendingWallets(sendingTransaction.sourceAddresses);
 
   PreparedTransaction preparedTransaction;
   Crypto::SecretKey txSecretKey;
   prepareTransaction(
-    std::move(wallets),
+    wallets,
     sendingTransaction.destinations,
     sendingTransaction.fee,
     sendingTransaction.mixIn,
+    sendingTransaction.outputSelection,
     sendingTransaction.extra,
     sendingTransaction.unlockTimestamp,
     sendingTransaction.donation,
@@ -2476,38 +2644,94 @@ uint64_t WalletGreen::selectTransfers(
   uint64_t neededMoney,
   bool dust,
   uint64_t dustThreshold,
-  std::vector<WalletOuts>&& wallets,
+  OutputSelectionStrategy strategy,
+  const std::vector<WalletRecord*>& wallets,
   std::vector<OutputToTransfer>& selectedTransfers) {
 
+  size_t dustCount = !dust ? 0 :
+    strategy == OutputSelectionStrategy::ConsolidateDust ? DUST_CONSOLIDATION_MAX_INPUT_COUNT : std::numeric_limits<size_t>::max();
+
+  // Every container selects enough outputs to cover the money by itself, the strategy is applied to all of them here
+  std::vector<OutputToTransfer> dustOutputs;
+  std::vector<OutputToTransfer> walletOuts;
+  std::vector<TransactionOutputInformation> outs;
+  for (WalletRecord* wallet : wallets) {
+    outs.clear();
+    wallet->container->selectOutputs(neededMoney, dustThreshold, dustCount, strategy, outs);
+    for (auto& out : outs) {
+      if (out.amount > dustThreshold) {
+        walletOuts.emplace_back(OutputToTransfer{ std::move(out), wallet });
+      } else {
+        dustOutputs.emplace_back(OutputToTransfer{ std::move(out), wallet });
+      }
+    }
+  }
+
+  auto largerAmount = [](const OutputToTransfer& l, const OutputToTransfer& r) { return l.out.amount > r.out.amount; };
+  auto smallerAmount = [](const OutputToTransfer& l, const OutputToTransfer& r) { return l.out.amount < r.out.amount; };
+
   uint64_t foundMoney = 0;
+  auto pick = [&foundMoney, &selectedTransfers](OutputToTransfer& out) {
+    foundMoney += out.out.amount;
+    selectedTransfers.emplace_back(std::move(out));
+  };
 
-  typedef std::pair<WalletRecord*, TransactionOutputInformation> OutputData;
-  std::vector<OutputData> dustOutputs;
-  std::vector<OutputData> walletOuts;
-  for (auto walletIt = wallets.begin(); walletIt != wallets.end(); ++walletIt) {
-    for (auto outIt = walletIt->outs.begin(); outIt != walletIt->outs.end(); ++outIt) {
-      if (outIt->amount > dustThreshold) {
-        walletOuts.emplace_back(std::piecewise_construct, std::forward_as_tuple(walletIt->wallet), std::forward_as_tuple(*outIt));
-      } else if (dust) {
-        dustOutputs.emplace_back(std::piecewise_construct, std::forward_as_tuple(walletIt->wallet), std::forward_as_tuple(*outIt));
+  switch (strategy) {
+  case OutputSelectionStrategy::Random:
+    std::shuffle(walletOuts.begin(), walletOuts.end(), Random::generator());
+    std::shuffle(dustOutputs.begin(), dustOutputs.end(), Random::generator());
+    break;
+
+  case OutputSelectionStrategy::SmallestSufficient: {
+    auto sufficientIt = walletOuts.end();
+    for (auto it = walletOuts.begin(); it != walletOuts.end(); ++it) {
+      if (it->out.amount >= neededMoney && (sufficientIt == walletOuts.end() || it->out.amount < sufficientIt->out.amount)) {
+        sufficientIt = it;
       }
     }
+
+    if (sufficientIt != walletOuts.end()) {
+      pick(*sufficientIt);
+      return foundMoney;
+    }
+
+    std::sort(walletOuts.begin(), walletOuts.end(), largerAmount);
+    std::sort(dustOutputs.begin(), dustOutputs.end(), largerAmount);
+    break;
   }
 
-  ShuffleGenerator<size_t> indexGenerator(walletOuts.size());
-  while (foundMoney < neededMoney && !indexGenerator.empty()) {
-    auto& out = walletOuts[indexGenerator()];
-    foundMoney += out.second.amount;
-    selectedTransfers.emplace_back(OutputToTransfer{ std::move(out.second), std::move(out.first) });
+  case OutputSelectionStrategy::LargestFirst:
+    std::sort(walletOuts.begin(), walletOuts.end(), largerAmount);
+    std::sort(dustOutputs.begin(), dustOutputs.end(), largerAmount);
+    break;
+
+  case OutputSelectionStrategy::ConsolidateDust:
+    std::sort(dustOutputs.begin(), dustOutputs.end(), smallerAmount);
+    for (size_t i = 0; i < dustOutputs.size() && i < dustCount; ++i) {
+      pick(dustOutputs[i]);
+    }
+
+    dustOutputs.clear();
+    std::sort(walletOuts.begin(), walletOuts.end(), largerAmount);
+    break;
   }
 
-  if (dust && !dustOutputs.empty()) {
-    ShuffleGenerator<size_t> dustIndexGenerator(dustOutputs.size());
-    do {
-      auto& out = dustOutputs[dustIndexGenerator()];
-      foundMoney += out.second.amount;
-      selectedTransfers.emplace_back(OutputToTransfer{ std::move(out.second), std::move(out.first) });
-    } while (foundMoney < neededMoney && !dustIndexGenerator.empty());
+  for (auto it = walletOuts.begin(); foundMoney < neededMoney && it != walletOuts.end(); ++it) {
+    pick(*it);
+  }
+
+  if (strategy == OutputSelectionStrategy::Random) {
+    // At least one dust output is spent whenever dust is allowed
+    for (auto it = dustOutputs.begin(); it != dustOutputs.end(); ++it) {
+      pick(*it);
+      if (foundMoney >= neededMoney) {
+        break;
+      }
+    }
+  } else {
+    for (auto it = dustOutputs.begin(); foundMoney < neededMoney && it != dustOutputs.end(); ++it) {
+      pick(*it);
+    }
   }
 
   return foundMoney;
@@ -2559,6 +2783,27 @@ std::vector<WalletGreen::WalletOuts> WalletGreen::pickWallets(const std::vector<
   return wallets;
 }
 
+std::vector<WalletRecord*> WalletGreen::pickSpendingWallets(const std::vector<std::string>& addresses) const {
+  std::vector<WalletRecord*> wallets;
+  if (addresses.empty()) {
+    for (const auto& wallet : m_walletsContainer.get<RandomAccessIndex>()) {
+      if (wallet.actualBalance != 0) {
+        wallets.push_back(const_cast<WalletRecord*>(&wallet));
+      }
+    }
+  } else {
+    wallets.reserve(addresses.size());
+    for (const auto& address : addresses) {
+      const auto& wallet = getWalletRecord(address);
+      if (wallet.actualBalance != 0) {
+        wallets.push_back(const_cast<WalletRecord*>(&wallet));
+      }
+    }
+  }
+
+  return wallets;
+}
+
 std::vector<CryptoNote::WalletGreen::ReceiverAmounts> WalletGreen::splitDestinations(const std::vector<CryptoNote::WalletTransfer>& destinations,
   uint64_t dustThreshold,
   const CryptoNote::Currency& currency) {
@@ -2835,25 +3080,23 @@ std::string WalletGreen::getReserveProof(const uint64_t &reserve, const std::str
   }
 
   std::vector<OutputToTransfer> selectedOutputsToTransfers;
-  std::vector<WalletOuts> wallets;
+  std::vector<WalletRecord*> wallets;
 
   // determine which outputs to include in the proof
   // if account is provided use it, otherwise try to find account with sufficient balance
   if (!address.empty()) {
-    WalletOuts wallet = pickWallet(address);
-    wallets.push_back(wallet);
+    wallets.push_back(const_cast<WalletRecord*>(&getWalletRecord(address)));
   }
   else {
-    std::vector<WalletOuts> walletsWithMoney = pickWalletsWithMoney();
-    for (const auto& w : walletsWithMoney) {
-      if (w.wallet->actualBalance >= reserve) {
-        wallets.push_back(w);
+    for (WalletRecord* wallet : pickSpendingWallets({})) {
+      if (wallet->actualBalance >= reserve) {
+        wallets.push_back(wallet);
         break;
       }
     }
   }
 
-  uint64_t found = selectTransfers(reserve, true, m_currency.defaultDustThreshold(), std::move(wallets), selectedOutputsToTransfers);
+  uint64_t found = selectTransfers(reserve, true, m_currency.defaultDustThreshold(), OutputSelectionStrategy::Random, wallets, selectedOutputsToTransfers);
 
   if (found < reserve) {
     throw std::runtime_error("Not enough balance for the requested minimum reserve amount");
@@ -2865,9 +3108,9 @@ std::string WalletGreen::getReserveProof(const uint64_t &reserve, const std::str
   }
 
   CryptoNote::AccountKeys keys;
-  keys.spendSecretKey = wallets[0].wallet->spendSecretKey;
+  keys.spendSecretKey = wallets[0]->spendSecretKey;
   keys.viewSecretKey = m_viewSecretKey;
-  keys.address = { wallets[0].wallet->spendPublicKey, m_viewPublicKey };
+  keys.address = { wallets[0]->spendPublicKey, m_viewPublicKey };
 
   std::string reserveProof = "";
   bool r = CryptoNote::getReserveProof(selectedTransfers, keys, reserve, message, reserveProof, m_logger.getLogger());
@@ -3161,6 +3404,12 @@ void WalletGreen::transactionUpdated(const TransactionInformation& transactionIn
 }
 
 void WalletGreen::pushEvent(const WalletEvent& event) {
+  if (event.type == WalletEventType::TRANSACTION_CREATED) {
+    m_changedTransactions.insert(event.transactionCreated.transactionIndex);
+  } else if (event.type == WalletEventType::TRANSACTION_UPDATED) {
+    m_changedTransactions.insert(event.transactionUpdated.transactionIndex);
+  }
+
   m_events.push(event);
   m_eventOccurred.set();
 }
@@ -3314,6 +3563,7 @@ void WalletGreen::updateBalance(CryptoNote::ITransfersContainer* container) {
       wallet.actualBalance = actual;
       wallet.pendingBalance = pending;
     });
+    m_changedWallets.insert(it->spendPublicKey);
 
     m_logger(INFO, BRIGHT_WHITE) << "Wallet balance updated, address " << m_currency.accountAddressAsString({ it->spendPublicKey, m_viewPublicKey }) <<
       ", actual " << m_currency.formatAmount(it->actualBalance) <<
@@ -3899,21 +4149,16 @@ size_t WalletGreen::getTxSize(const TransactionParameters &sendingTransaction)
 
   CryptoNote::AccountPublicAddress changeDestination = getChangeDestination(sendingTransaction.changeDestination, sendingTransaction.sourceAddresses);
 
-  std::vector<WalletOuts> wallets;
-  if (!sendingTransaction.sourceAddresses.empty()) {
-
-    wallets = pickWallets(sendingTransaction.sourceAddresses);
-  } else {
-    wallets = pickWalletsWithMoney();
-  }
+  std::vector<WalletRecord*> wallets = pickSpendingWallets(sendingTransaction.sourceAddresses);
 
   PreparedTransaction preparedTransaction;
   Crypto::SecretKey txSecretKey;
   prepareTransaction(
-    std::move(wallets),
+    wallets,
     sendingTransaction.destinations,
     sendingTransaction.fee,
     sendingTransaction.mixIn,
+    sendingTransaction.outputSelection,
     sendingTransaction.extra,
     sendingTransaction.unlockTimestamp,
     sendingTransaction.donation,
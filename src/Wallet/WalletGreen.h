@@ -23,10 +23,12 @@
 #include "IWallet.h"
 
 #include <queue>
+#include <set>
 #include <unordered_map>
 
 #include "IFusionManager.h"
 #include "WalletIndices.h"
+#include "WalletJournal.h"
 
 #include "Logging/LoggerRef.h"
 #include <System/Dispatcher.h>
@@ -235,6 +237,7 @@ protected:
   std::vector<WalletOuts> pickWalletsWithMoney() const;
   WalletOuts pickWallet(const std::string& address) const;
   std::vector<WalletOuts> pickWallets(const std::vector<std::string>& addresses) const;
+  std::vector<WalletRecord*> pickSpendingWallets(const std::vector<std::string>& addresses) const;
 
   void updateBalance(CryptoNote::ITransfersContainer* container);
   void unlockBalances(uint32_t height);
@@ -257,10 +260,11 @@ protected:
     uint64_t changeAmount;
   };
 
-  void prepareTransaction(std::vector<WalletOuts>&& wallets,
+  void prepareTransaction(const std::vector<WalletRecord*>& wallets,
     const std::vector<WalletOrder>& orders,
     uint64_t fee,
     uint16_t mixIn,
+    OutputSelectionStrategy outputSelection,
     const std::string& extra,
     uint64_t unlockTimestamp,
     const DonationSettings& donation,
@@ -293,7 +297,8 @@ protected:
   uint64_t selectTransfers(uint64_t needeMoney,
     bool dust,
     uint64_t dustThreshold,
-    std::vector<WalletOuts>&& wallets,
+    OutputSelectionStrategy strategy,
+    const std::vector<WalletRecord*>& wallets,
     std::vector<OutputToTransfer>& selectedTransfers);
 
   std::vector<ReceiverAmounts> splitDestinations(const std::vector<WalletTransfer>& destinations,
@@ -339,6 +344,10 @@ protected:
   void loadContainerStorage(const std::string& path);
   void loadWalletCache(std::unordered_set<Crypto::PublicKey>& addedKeys, std::unordered_set<Crypto::PublicKey>& deletedKeys, std::string& extra);
   void saveWalletCache(ContainerStorage& storage, const Crypto::chacha8_key& key, WalletSaveLevel saveLevel, const std::string& extra);
+  bool appendWalletJournal(WalletSaveLevel saveLevel, const std::string& extra);
+  void resetWalletJournal(WalletSaveLevel saveLevel);
+  // Returns false if a record failed after others were applied, the loaded cache has to be restored then
+  bool replayWalletJournal(std::string& extra);
   void subscribeWallets();
 
   std::vector<OutputToTransfer> pickRandomFusionInputs(const std::vector<std::string>& addresses,
@@ -380,6 +389,12 @@ protected:
 
   WalletsContainer m_walletsContainer;
   ContainerStorage m_containerStorage;
+  // Changes saved on top of the SAVE_ALL cache in m_containerStorage. It's disabled after changes it can't express,
+  // the next save then writes the whole cache and starts the journal over
+  WalletJournal m_journal;
+  bool m_journalEnabled;
+  std::set<size_t> m_changedTransactions;
+  std::unordered_set<Crypto::PublicKey> m_changedWallets;
   UnlockTransactionJobs m_unlockTransactionsJob;
   WalletTransactions m_transactions;
   WalletTransfers m_transfers; //sorted
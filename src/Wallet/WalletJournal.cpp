@@ -0,0 +1,205 @@
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "WalletJournal.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <boost/filesystem.hpp>
+
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+namespace {
+
+const uint64_t JOURNAL_SIGNATURE = 0x31304a5758495353; // "SSIXWJ01"
+
+struct JournalHeader {
+  uint64_t signature;
+  Crypto::chacha8_iv snapshotIv;
+};
+
+struct RecordHeader {
+  uint32_t size;
+  Crypto::chacha8_iv iv;
+};
+
+Crypto::Hash getRecordChecksum(const RecordHeader& header, const char* encryptedData) {
+  std::string checksumData(reinterpret_cast<const char*>(&header), sizeof(header));
+  checksumData.append(encryptedData, header.size);
+  return Crypto::cn_fast_hash(checksumData.data(), checksumData.size());
+}
+
+// Writes the data and waits until it reaches the disk, a record saved in the journal must survive a power loss
+void writeFileSynced(const std::string& path, const char* mode, const std::string& data) {
+  FILE* file = fopen(path.c_str(), mode);
+  if (file == nullptr) {
+    throw std::runtime_error("Failed to open " + path);
+  }
+
+  bool written = fwrite(data.data(), 1, data.size(), file) == data.size() && fflush(file) == 0;
+#ifdef _WIN32
+  written = written && _commit(_fileno(file)) == 0;
+#else
+  written = written && fsync(fileno(file)) == 0;
+#endif
+  if (fclose(file) != 0 || !written) {
+    throw std::runtime_error("Failed to write " + path);
+  }
+}
+
+}
+
+WalletJournal::WalletJournal() : m_size(0), m_recordCount(0) {
+}
+
+void WalletJournal::open(const std::string& path) {
+  m_path = path;
+  m_size = 0;
+  m_recordCount = 0;
+}
+
+void WalletJournal::close() {
+  m_path.clear();
+  m_size = 0;
+  m_recordCount = 0;
+}
+
+bool WalletJournal::isOpened() const {
+  return !m_path.empty();
+}
+
+uint64_t WalletJournal::size() const {
+  return m_size;
+}
+
+size_t WalletJournal::recordCount() const {
+  return m_recordCount;
+}
+
+bool WalletJournal::read(const Crypto::chacha8_key& key, const Crypto::chacha8_iv& snapshotIv, std::vector<BinaryArray>& records) {
+  assert(isOpened());
+
+  m_size = 0;
+  m_recordCount = 0;
+
+  std::ifstream file(m_path, std::ios_base::binary);
+  if (!file) {
+    return false;
+  }
+
+  JournalHeader journalHeader;
+  if (!file.read(reinterpret_cast<char*>(&journalHeader), sizeof(journalHeader)) || journalHeader.signature != JOURNAL_SIGNATURE ||
+      memcmp(&journalHeader.snapshotIv, &snapshotIv, sizeof(snapshotIv)) != 0) {
+    return false;
+  }
+
+  uint64_t fileSize = boost::filesystem::file_size(m_path);
+  uint64_t offset = sizeof(journalHeader);
+  std::string encryptedData;
+  for (;;) {
+    RecordHeader header;
+    Crypto::Hash checksum;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.size > fileSize - offset - sizeof(header)) {
+      break;
+    }
+
+    encryptedData.resize(header.size);
+    if (!file.read(&encryptedData[0], header.size) || !file.read(reinterpret_cast<char*>(&checksum), sizeof(checksum))) {
+      break;
+    }
+
+    Crypto::Hash expectedChecksum = getRecordChecksum(header, encryptedData.data());
+    if (memcmp(&checksum, &expectedChecksum, sizeof(checksum)) != 0) {
+      break;
+    }
+
+    BinaryArray record(header.size);
+    Crypto::chacha8(encryptedData.data(), encryptedData.size(), key, header.iv, reinterpret_cast<char*>(record.data()));
+    records.emplace_back(std::move(record));
+
+    offset += sizeof(header) + header.size + sizeof(checksum);
+    ++m_recordCount;
+  }
+
+  file.close();
+
+  if (offset != fileSize) {
+    // The tail was torn while it was appended, drop it so the next record follows the last complete one
+    boost::filesystem::resize_file(m_path, offset);
+  }
+
+  m_size = offset - sizeof(journalHeader);
+  return true;
+}
+
+void WalletJournal::append(const Crypto::chacha8_key& key, const void* data, size_t dataSize) {
+  assert(isOpened());
+
+  RecordHeader header;
+  header.size = static_cast<uint32_t>(dataSize);
+  header.iv = Crypto::randomChachaIV();
+
+  std::string encryptedData(dataSize, '\0');
+  Crypto::chacha8(data, dataSize, key, header.iv, &encryptedData[0]);
+  Crypto::Hash checksum = getRecordChecksum(header, encryptedData.data());
+
+  std::string record(reinterpret_cast<const char*>(&header), sizeof(header));
+  record.append(encryptedData);
+  record.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+  writeFileSynced(m_path, "ab", record);
+
+  m_size += record.size();
+  ++m_recordCount;
+}
+
+void WalletJournal::reset(const Crypto::chacha8_iv& snapshotIv) {
+  assert(isOpened());
+
+  JournalHeader journalHeader;
+  journalHeader.signature = JOURNAL_SIGNATURE;
+  journalHeader.snapshotIv = snapshotIv;
+
+  writeFileSynced(m_path, "wb", std::string(reinterpret_cast<const char*>(&journalHeader), sizeof(journalHeader)));
+
+  m_size = 0;
+  m_recordCount = 0;
+}
+
+void WalletJournal::remove() {
+  assert(isOpened());
+
+  boost::system::error_code ignore;
+  boost::filesystem::remove(m_path, ignore);
+
+  m_size = 0;
+  m_recordCount = 0;
+}
+
+}
@@ -0,0 +1,60 @@
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CryptoNote.h"
+#include "crypto/chacha8.h"
+
+namespace CryptoNote {
+
+// Append-only file of encrypted records with the changes saved on top of a container snapshot.
+//
+// The journal header holds the IV of the container data it was started for, so a journal left from an older
+// snapshot is recognized and ignored. Every record is encrypted with its own random IV and ends with a checksum,
+// a record torn by a crash is dropped when the journal is read.
+class WalletJournal {
+public:
+  WalletJournal();
+
+  void open(const std::string& path);
+  void close();
+  bool isOpened() const;
+
+  // Size of the records in bytes and their count
+  uint64_t size() const;
+  size_t recordCount() const;
+
+  // Reads the records if the journal belongs to the snapshot, returns false otherwise
+  bool read(const Crypto::chacha8_key& key, const Crypto::chacha8_iv& snapshotIv, std::vector<BinaryArray>& records);
+  void append(const Crypto::chacha8_key& key, const void* data, size_t dataSize);
+
+  // Starts an empty journal for the snapshot
+  void reset(const Crypto::chacha8_iv& snapshotIv);
+  void remove();
+
+private:
+  std::string m_path;
+  uint64_t m_size;
+  size_t m_recordCount;
+};
+
+}
@@ -118,6 +118,33 @@ void serialize(WalletTransferDtoV2& value, CryptoNote::ISerializer& serializer)
   serializer(value.type, "type");
 }
 
+CryptoNote::WalletTransaction makeWalletTransaction(const WalletTransactionDtoV2& dto) {
+  CryptoNote::WalletTransaction tx;
+  tx.state = dto.state;
+  tx.timestamp = dto.timestamp;
+  tx.blockHeight = dto.blockHeight;
+  tx.hash = dto.hash;
+  tx.totalAmount = dto.totalAmount;
+  tx.fee = dto.fee;
+  tx.creationTime = dto.creationTime;
+  tx.unlockTime = dto.unlockTime;
+  tx.extra = dto.extra;
+  tx.isBase = dto.isBase;
+  if (dto.secretKey)
+    tx.secretKey = reinterpret_cast<const Crypto::SecretKey&>(dto.secretKey.get());
+
+  return tx;
+}
+
+CryptoNote::WalletTransfer makeWalletTransfer(const WalletTransferDtoV2& dto) {
+  CryptoNote::WalletTransfer tr;
+  tr.address = dto.address;
+  tr.amount = dto.amount;
+  tr.type = static_cast<CryptoNote::WalletTransferType>(dto.type);
+
+  return tr;
+}
+
 }
 
 namespace CryptoNote {
@@ -196,6 +223,40 @@ void WalletSerializerV2::save(Common::IOutputStream& destination, WalletSaveLeve
   s(m_extra, "extra");
 }
 
+void WalletSerializerV2::loadChanges(Common::IInputStream& source) {
+  CryptoNote::BinaryInputStreamSerializer s(source);
+
+  loadBalanceChanges(s);
+  loadTransactionChanges(s);
+
+  std::string transfersSynchronizerChanges;
+  s(transfersSynchronizerChanges, "transfersSynchronizer");
+  std::stringstream stream(transfersSynchronizerChanges);
+  m_synchronizer.loadChanges(stream);
+
+  m_unlockTransactions.clear();
+  loadUnlockTransactionsJobs(s);
+  s(m_uncommitedTransactions, "uncommitedTransactions");
+  s(m_extra, "extra");
+}
+
+void WalletSerializerV2::saveChanges(Common::IOutputStream& destination, const std::set<size_t>& transactionIds,
+  const std::unordered_set<Crypto::PublicKey>& walletKeys) {
+  CryptoNote::BinaryOutputStreamSerializer s(destination);
+
+  saveBalanceChanges(s, walletKeys);
+  saveTransactionChanges(s, transactionIds);
+
+  std::stringstream stream;
+  m_synchronizer.saveChanges(stream);
+  std::string transfersSynchronizerChanges = stream.str();
+  s(transfersSynchronizerChanges, "transfersSynchronizer");
+
+  saveUnlockTransactionsJobs(s);
+  s(m_uncommitedTransactions, "uncommitedTransactions");
+  s(m_extra, "extra");
+}
+
 std::unordered_set<Crypto::PublicKey>& WalletSerializerV2::addedKeys() {
   return m_addedKeys;
 }
@@ -261,6 +322,126 @@ void WalletSerializerV2::saveKeyListAndBanalces(CryptoNote::ISerializer& seriali
   }
 }
 
+void WalletSerializerV2::loadBalanceChanges(CryptoNote::ISerializer& serializer) {
+  uint64_t walletCount = 0;
+  serializer(walletCount, "walletCount");
+
+  auto& index = m_walletsContainer.get<KeysIndex>();
+  for (uint64_t i = 0; i < walletCount; ++i) {
+    Crypto::PublicKey spendPublicKey;
+    uint64_t actualBalance;
+    uint64_t pendingBalance;
+    serializer(spendPublicKey, "spendPublicKey");
+    serializer(actualBalance, "actualBalance");
+    serializer(pendingBalance, "pendingBalance");
+
+    auto it = index.find(spendPublicKey);
+    if (it != index.end()) {
+      index.modify(it, [actualBalance, pendingBalance](WalletRecord& wallet) {
+        wallet.actualBalance = actualBalance;
+        wallet.pendingBalance = pendingBalance;
+      });
+    }
+  }
+
+  m_actualBalance = 0;
+  m_pendingBalance = 0;
+  for (const auto& wallet : index) {
+    m_actualBalance += wallet.actualBalance;
+    m_pendingBalance += wallet.pendingBalance;
+  }
+}
+
+void WalletSerializerV2::saveBalanceChanges(CryptoNote::ISerializer& serializer, const std::unordered_set<Crypto::PublicKey>& walletKeys) {
+  auto& index = m_walletsContainer.get<KeysIndex>();
+
+  std::vector<WalletRecord> wallets;
+  for (const auto& spendPublicKey : walletKeys) {
+    auto it = index.find(spendPublicKey);
+    if (it != index.end()) {
+      wallets.push_back(*it);
+    }
+  }
+
+  uint64_t walletCount = wallets.size();
+  serializer(walletCount, "walletCount");
+  for (auto wallet : wallets) {
+    serializer(wallet.spendPublicKey, "spendPublicKey");
+    serializer(wallet.actualBalance, "actualBalance");
+    serializer(wallet.pendingBalance, "pendingBalance");
+  }
+}
+
+void WalletSerializerV2::loadTransactionChanges(CryptoNote::ISerializer& serializer) {
+  auto& transactions = m_transactions.get<RandomAccessIndex>();
+
+  uint64_t count = 0;
+  serializer(count, "transactionCount");
+
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t txId = 0;
+    WalletTransactionDtoV2 dto;
+    serializer(txId, "transactionId");
+    serializer(dto, "transaction");
+
+    // Transaction ids only grow between snapshots, a new transaction is always the next one
+    bool replaced;
+    if (txId < transactions.size()) {
+      replaced = transactions.replace(std::next(transactions.begin(), txId), makeWalletTransaction(dto));
+    } else if (txId == transactions.size()) {
+      replaced = transactions.push_back(makeWalletTransaction(dto)).second;
+    } else {
+      replaced = false;
+    }
+
+    if (!replaced) {
+      throw std::runtime_error("Failed to load transaction changes: transaction " + std::to_string(txId) + " doesn't match the container");
+    }
+
+    uint64_t transferCount = 0;
+    serializer(transferCount, "transferCount");
+
+    std::vector<TransactionTransferPair> transfers;
+    transfers.reserve(transferCount);
+    for (uint64_t j = 0; j < transferCount; ++j) {
+      WalletTransferDtoV2 transferDto;
+      serializer(transferDto, "transfer");
+      transfers.emplace_back(txId, makeWalletTransfer(transferDto));
+    }
+
+    auto range = std::equal_range(m_transfers.begin(), m_transfers.end(), TransactionTransferPair(txId, WalletTransfer()),
+      [](const TransactionTransferPair& a, const TransactionTransferPair& b) { return a.first < b.first; });
+    auto insertIt = m_transfers.erase(range.first, range.second);
+    m_transfers.insert(insertIt, transfers.begin(), transfers.end());
+  }
+}
+
+void WalletSerializerV2::saveTransactionChanges(CryptoNote::ISerializer& serializer, const std::set<size_t>& transactionIds) {
+  auto& transactions = m_transactions.get<RandomAccessIndex>();
+
+  uint64_t count = transactionIds.size();
+  serializer(count, "transactionCount");
+
+  for (auto id : transactionIds) {
+    assert(id < transactions.size());
+
+    uint64_t txId = id;
+    WalletTransactionDtoV2 dto(transactions[id]);
+    serializer(txId, "transactionId");
+    serializer(dto, "transaction");
+
+    auto range = std::equal_range(m_transfers.begin(), m_transfers.end(), TransactionTransferPair(id, WalletTransfer()),
+      [](const TransactionTransferPair& a, const TransactionTransferPair& b) { return a.first < b.first; });
+
+    uint64_t transferCount = std::distance(range.first, range.second);
+    serializer(transferCount, "transferCount");
+    for (auto it = range.first; it != range.second; ++it) {
+      WalletTransferDtoV2 transferDto(it->second);
+      serializer(transferDto, "transfer");
+    }
+  }
+}
+
 void WalletSerializerV2::loadTransactions(CryptoNote::ISerializer& serializer) {
   uint64_t count = 0;
   serializer(count, "transactionCount");
@@ -271,21 +452,7 @@ void WalletSerializerV2::loadTransactions(CryptoNote::ISerializer& serializer) {
     WalletTransactionDtoV2 dto;
     serializer(dto, "transaction");
 
-    WalletTransaction tx;
-    tx.state = dto.state;
-    tx.timestamp = dto.timestamp;
-    tx.blockHeight = dto.blockHeight;
-    tx.hash = dto.hash;
-    tx.totalAmount = dto.totalAmount;
-    tx.fee = dto.fee;
-    tx.creationTime = dto.creationTime;
-    tx.unlockTime = dto.unlockTime;
-    tx.extra = dto.extra;
-    tx.isBase = dto.isBase;
-    if (dto.secretKey)
-      tx.secretKey = reinterpret_cast<const Crypto::SecretKey&>(dto.secretKey.get());
-
-    m_transactions.get<RandomAccessIndex>().emplace_back(std::move(tx));
+    m_transactions.get<RandomAccessIndex>().emplace_back(makeWalletTransaction(dto));
   }
 }
 
@@ -312,12 +479,7 @@ void WalletSerializerV2::loadTransfers(CryptoNote::ISerializer& serializer) {
     WalletTransferDtoV2 dto;
     serializer(dto, "transfer");
 
-    WalletTransfer tr;
-    tr.address = dto.address;
-    tr.amount = dto.amount;
-    tr.type = static_cast<WalletTransferType>(dto.type);
-
-    m_transfers.emplace_back(std::piecewise_construct, std::forward_as_tuple(txId), std::forward_as_tuple(std::move(tr)));
+    m_transfers.emplace_back(std::piecewise_construct, std::forward_as_tuple(txId), std::forward_as_tuple(makeWalletTransfer(dto)));
   }
 }
 
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <set>
+
 #include "Common/IInputStream.h"
 #include "Common/IOutputStream.h"
 #include "Serialization/ISerializer.h"
@@ -47,6 +49,10 @@ public:
   void load(Common::IInputStream& source, uint8_t version);
   void save(Common::IOutputStream& destination, WalletSaveLevel saveLevel);
 
+  // Changes of the given transactions and wallet balances on top of the last SAVE_ALL snapshot, see WalletJournal
+  void loadChanges(Common::IInputStream& source);
+  void saveChanges(Common::IOutputStream& destination, const std::set<size_t>& transactionIds, const std::unordered_set<Crypto::PublicKey>& walletKeys);
+
   std::unordered_set<Crypto::PublicKey>& addedKeys();
   std::unordered_set<Crypto::PublicKey>& deletedKeys();
 
@@ -69,6 +75,12 @@ private:
   void loadUnlockTransactionsJobs(CryptoNote::ISerializer& serializer);
   void saveUnlockTransactionsJobs(CryptoNote::ISerializer& serializer);
 
+  void loadBalanceChanges(CryptoNote::ISerializer& serializer);
+  void saveBalanceChanges(CryptoNote::ISerializer& serializer, const std::unordered_set<Crypto::PublicKey>& walletKeys);
+
+  void loadTransactionChanges(CryptoNote::ISerializer& serializer);
+  void saveTransactionChanges(CryptoNote::ISerializer& serializer, const std::set<size_t>& transactionIds);
+
   ITransfersObserver& m_transfersObserver;
   uint64_t& m_actualBalance;
   uint64_t& m_pendingBalance;
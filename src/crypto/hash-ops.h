@@ -61,12 +61,22 @@ void hash_process(union hash_state *state, const uint8_t *buf, size_t count);
 enum {
   HASH_SIZE = 32,
   HASH_DATA_AREA = 136,
-  SLOW_HASH_CONTEXT_SIZE = 2097552
+  SLOW_HASH_CONTEXT_SIZE = 2097552,
+  SLOW_HASH_SCRATCHPAD_SIZE = 1 << 21
 };
 
 void cn_fast_hash(const void *data, size_t length, char *hash);
 
 void cn_slow_hash(const void *data, size_t length, char *hash);
+// Hashes count inputs, several at a time on CPUs with AES-NI
+void cn_slow_hash_multi(const void *const *data, const size_t *length, char *const *hash, size_t count);
+// How many hashes cn_slow_hash_multi computes at once on this CPU
+size_t cn_slow_hash_lanes_count(void);
+// The same with caller owned scratchpads of SLOW_HASH_SCRATCHPAD_SIZE bytes, 16 byte aligned,
+// cn_slow_hash_multi_scratchpads needs one per lane
+void cn_slow_hash_scratchpad(const void *data, size_t length, char *hash, void *scratchpad);
+void cn_slow_hash_multi_scratchpads(const void *const *data, const size_t *length, char *const *hash, size_t count,
+                                    void *const *scratchpads);
 
 void hash_extra_blake(const void *data, size_t length, char *hash);
 void hash_extra_groestl(const void *data, size_t length, char *hash);
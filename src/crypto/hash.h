@@ -19,6 +19,8 @@
 #pragma once
 
 #include <stddef.h>
+#include <algorithm>
+#include <vector>
 
 #include <CryptoTypes.h>
 #include "generic-ops.h"
@@ -43,6 +45,8 @@ namespace Crypto {
     return h;
   }
 
+  // Owns the scratchpads of the thread hashing with it. They are taken from ScratchpadPool
+  // on first use, so they come from that thread's NUMA node, and go back to the pool on destruction.
   class cn_context {
   public:
 
@@ -53,14 +57,25 @@ namespace Crypto {
     void operator=(const cn_context &) = delete;
 #endif
 
+    void *const *getScratchpads(size_t count);
+
   private:
 
-    void *data;
-    friend inline void cn_slow_hash(cn_context &, const void *, size_t, Hash &);
+    std::vector<void *> scratchpads;
   };
 
   inline void cn_slow_hash(cn_context &context, const void *data, size_t length, Hash &hash) {
-	cn_slow_hash(data, length, reinterpret_cast<char *>(&hash));
+    cn_slow_hash_scratchpad(data, length, reinterpret_cast<char *>(&hash), context.getScratchpads(1)[0]);
+  }
+
+  // Hashes count inputs, several at a time when the CPU allows it
+  inline void cn_slow_hash(cn_context &context, const void *const *data, const size_t *length, Hash *const *hash, size_t count) {
+    if (count == 0) {
+      return;
+    }
+
+    void *const *scratchpads = context.getScratchpads(std::min(count, cn_slow_hash_lanes_count()));
+    cn_slow_hash_multi_scratchpads(data, length, reinterpret_cast<char *const *>(hash), count, scratchpads);
   }
 
   inline void tree_hash(const Hash *hashes, size_t count, Hash &root_hash) {
@@ -0,0 +1,276 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "scratchpad-pool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+
+#include "hash-ops.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Crypto {
+
+namespace {
+
+#if defined(__linux__)
+// Parses the kernel's list format, "0-3,8,10-11"
+std::vector<unsigned> readNumberList(const std::string& path) {
+  std::vector<unsigned> numbers;
+  std::ifstream file(path);
+  std::string list;
+  if (!std::getline(file, list)) {
+    return numbers;
+  }
+
+  size_t position = 0;
+  while (position < list.size()) {
+    size_t end = list.find(',', position);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+
+    std::string range = list.substr(position, end - position);
+    size_t dash = range.find('-');
+    try {
+      unsigned first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+      unsigned last = dash == std::string::npos ? first : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+      for (unsigned number = first; number <= last; ++number) {
+        numbers.push_back(number);
+      }
+    } catch (std::exception&) {
+      return std::vector<unsigned>();
+    }
+
+    position = end + 1;
+  }
+
+  return numbers;
+}
+#endif
+
+}
+
+ScratchpadPool& ScratchpadPool::instance() {
+  // never destroyed, cn_contexts with static storage may still release to it at exit
+  static ScratchpadPool* pool = new ScratchpadPool();
+  return *pool;
+}
+
+void* ScratchpadPool::acquire() {
+  unsigned node = currentNumaNode();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (node < m_free.size() && !m_free[node].empty()) {
+    void* memory = m_free[node].back();
+    m_free[node].pop_back();
+    return memory;
+  }
+
+  lock.unlock();
+
+  // first touched by this thread, so the pages come from its node
+  Scratchpad scratchpad;
+  scratchpad.node = node;
+  bool allocated = allocate(scratchpad);
+
+  lock.lock();
+  if (allocated) {
+    m_scratchpads.push_back(scratchpad);
+    return scratchpad.memory;
+  }
+
+  // out of memory, a scratchpad on another node is still better than none
+  for (auto& nodeScratchpads : m_free) {
+    if (!nodeScratchpads.empty()) {
+      void* memory = nodeScratchpads.back();
+      nodeScratchpads.pop_back();
+      return memory;
+    }
+  }
+
+  throw std::bad_alloc();
+}
+
+void ScratchpadPool::release(void* memory) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = std::find_if(m_scratchpads.begin(), m_scratchpads.end(), [memory](const Scratchpad& scratchpad) {
+    return scratchpad.memory == memory;
+  });
+
+  assert(it != m_scratchpads.end());
+  if (it->node >= m_free.size()) {
+    m_free.resize(it->node + 1);
+  }
+
+  m_free[it->node].push_back(memory);
+}
+
+ScratchpadPoolStatistics ScratchpadPool::getStatistics() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ScratchpadPoolStatistics statistics;
+  statistics.scratchpads = m_scratchpads.size();
+  statistics.hugePageScratchpads = std::count_if(m_scratchpads.begin(), m_scratchpads.end(), [](const Scratchpad& scratchpad) {
+    return scratchpad.hugePages;
+  });
+
+  statistics.freeScratchpads = 0;
+  for (const auto& nodeScratchpads : m_free) {
+    statistics.freeScratchpads += nodeScratchpads.size();
+  }
+
+  return statistics;
+}
+
+bool ScratchpadPool::allocate(Scratchpad& scratchpad) {
+#if defined(_WIN32)
+  // large pages need the "Lock pages in memory" privilege, without it the plain allocation is used
+  scratchpad.hugePages = true;
+  scratchpad.memory = VirtualAlloc(nullptr, SLOW_HASH_SCRATCHPAD_SIZE, MEM_LARGE_PAGES | MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+  if (scratchpad.memory == nullptr) {
+    scratchpad.hugePages = false;
+    scratchpad.memory = VirtualAlloc(nullptr, SLOW_HASH_SCRATCHPAD_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+  }
+
+  return scratchpad.memory != nullptr;
+#else
+  scratchpad.hugePages = false;
+  scratchpad.memory = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+  scratchpad.memory = mmap(nullptr, SLOW_HASH_SCRATCHPAD_SIZE, PROT_READ | PROT_WRITE,
+    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+  scratchpad.hugePages = scratchpad.memory != MAP_FAILED;
+#endif
+  if (scratchpad.memory == MAP_FAILED) {
+#if defined(MAP_POPULATE)
+    scratchpad.memory = mmap(nullptr, SLOW_HASH_SCRATCHPAD_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+#else
+    scratchpad.memory = mmap(nullptr, SLOW_HASH_SCRATCHPAD_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+#endif
+    if (scratchpad.memory == MAP_FAILED) {
+      scratchpad.memory = nullptr;
+      return false;
+    }
+
+    // may fail under RLIMIT_MEMLOCK, the scratchpad works either way
+    mlock(scratchpad.memory, SLOW_HASH_SCRATCHPAD_SIZE);
+  }
+
+  return true;
+#endif
+}
+
+unsigned numaNodeCount() {
+#if defined(__linux__)
+  static const unsigned count = [] {
+    std::vector<unsigned> nodes = readNumberList("/sys/devices/system/node/online");
+    return nodes.empty() ? 1 : *std::max_element(nodes.begin(), nodes.end()) + 1;
+  }();
+
+  return count;
+#else
+  return 1;
+#endif
+}
+
+unsigned currentNumaNode() {
+#if defined(__linux__) && defined(SYS_getcpu)
+  if (numaNodeCount() == 1) {
+    return 0;
+  }
+
+  unsigned cpu;
+  unsigned node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+    return 0;
+  }
+
+  return node;
+#else
+  return 0;
+#endif
+}
+
+bool bindThreadToNumaNode(unsigned node) {
+#if defined(__linux__)
+  std::vector<unsigned> cpus = readNumberList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+  if (cpus.empty()) {
+    return false;
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (unsigned cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+NumaNodeBinding::NumaNodeBinding(unsigned node) : m_bound(false) {
+#if defined(__linux__)
+  cpu_set_t previous;
+  if (sched_getaffinity(0, sizeof(previous), &previous) != 0) {
+    return;
+  }
+
+  m_previousMask.assign(reinterpret_cast<unsigned char*>(&previous), reinterpret_cast<unsigned char*>(&previous) + sizeof(previous));
+  m_bound = bindThreadToNumaNode(node);
+#else
+  (void)node;
+#endif
+}
+
+NumaNodeBinding::~NumaNodeBinding() {
+#if defined(__linux__)
+  if (m_bound) {
+    cpu_set_t previous;
+    std::memcpy(&previous, m_previousMask.data(), sizeof(previous));
+    sched_setaffinity(0, sizeof(previous), &previous);
+  }
+#endif
+}
+
+bool NumaNodeBinding::isBound() const {
+  return m_bound;
+}
+
+}
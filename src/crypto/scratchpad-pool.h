@@ -0,0 +1,89 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace Crypto {
+
+struct ScratchpadPoolStatistics {
+  size_t scratchpads;
+  size_t hugePageScratchpads;
+  size_t freeScratchpads;
+};
+
+// Scratchpads of SLOW_HASH_SCRATCHPAD_SIZE bytes for cn_slow_hash, shared by all cn_contexts.
+// A scratchpad is created on the NUMA node of the thread asking for it, huge pages first,
+// and is kept after release for the next thread on that node.
+class ScratchpadPool {
+public:
+  static ScratchpadPool& instance();
+
+  // throws std::bad_alloc if no memory is left
+  void* acquire();
+  void release(void* scratchpad);
+  ScratchpadPoolStatistics getStatistics() const;
+
+private:
+  struct Scratchpad {
+    void* memory;
+    unsigned node;
+    bool hugePages;
+  };
+
+  ScratchpadPool() = default;
+  ScratchpadPool(const ScratchpadPool&) = delete;
+  ScratchpadPool& operator=(const ScratchpadPool&) = delete;
+
+  static bool allocate(Scratchpad& scratchpad);
+
+  mutable std::mutex m_mutex;
+  std::vector<Scratchpad> m_scratchpads;
+  // free scratchpads by node
+  std::vector<std::vector<void*>> m_free;
+};
+
+// A machine without NUMA, or a platform where it isn't detected, is a single node 0
+unsigned numaNodeCount();
+unsigned currentNumaNode();
+// Restricts the calling thread to the CPUs of the node, false if that isn't possible
+bool bindThreadToNumaNode(unsigned node);
+
+// Restricts the calling thread to the CPUs of the node while it exists, for threads of a pool
+// which run other work afterwards. Has to be destroyed on the thread which created it.
+class NumaNodeBinding {
+public:
+  explicit NumaNodeBinding(unsigned node);
+  ~NumaNodeBinding();
+
+  // false if the thread couldn't be bound, it then runs where it ran before
+  bool isBound() const;
+
+private:
+  NumaNodeBinding(const NumaNodeBinding&) = delete;
+  NumaNodeBinding& operator=(const NumaNodeBinding&) = delete;
+
+  bool m_bound;
+  // CPU mask of the thread before it was bound
+  std::vector<unsigned char> m_previousMask;
+};
+
+}
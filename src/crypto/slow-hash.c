@@ -520,8 +520,10 @@ void slow_hash_free_state(void)
  */
 
 
-void cn_slow_hash(const void *data, size_t length, char *hash)
+/* hp_state here is the caller's scratchpad and shadows the thread-local one, pre_aes and post_aes use it */
+void cn_slow_hash_scratchpad(const void *data, size_t length, char *hash, void *scratchpad)
 {
+    uint8_t *hp_state = (uint8_t *) scratchpad;
     RDATA_ALIGN16 uint8_t expandedKey[240];  /* These buffers are aligned to use later with SSE functions */
 
     uint8_t text[INIT_SIZE_BYTE];
@@ -542,12 +544,6 @@ void cn_slow_hash(const void *data, size_t length, char *hash)
         hash_extra_blake, hash_extra_groestl, hash_extra_jh, hash_extra_skein
     };
 
-	// hp_state is supposed to be managed externally with respect to the 2MB scratchpad reusage logic.
-	// However, if it is not managed, it needs to be locally allocated/freed.
-    int bLocalStateAllocation = (hp_state == NULL);
-	if (bLocalStateAllocation)
-        slow_hash_allocate_state();
-
     /* CryptoNight Step 1:  Use Keccak1600 to initialize the 'state' (and 'text') buffers from the data. */
 
     hash_process(&state.hs, data, length);
@@ -649,11 +645,244 @@ void cn_slow_hash(const void *data, size_t length, char *hash)
     memcpy(state.init, text, INIT_SIZE_BYTE);
     hash_permutation(&state.hs);
     extra_hashes[state.hs.b[0] & 3](&state, 200, hash);
+}
+
+void cn_slow_hash(const void *data, size_t length, char *hash)
+{
+	// hp_state is supposed to be managed externally with respect to the 2MB scratchpad reusage logic.
+	// However, if it is not managed, it needs to be locally allocated/freed.
+    int bLocalStateAllocation = (hp_state == NULL);
+	if (bLocalStateAllocation)
+        slow_hash_allocate_state();
+
+    cn_slow_hash_scratchpad(data, length, hash, hp_state);
 
 	if (bLocalStateAllocation)
 		slow_hash_free_state();
 }
 
+/*
+ * Interleaved CryptoNight: several independent hashes share one pass of the
+ * mixing loop.  Every iteration of step 3 waits for a random scratchpad read;
+ * with two or four lanes in flight those reads overlap instead of following
+ * each other, which is where a single hash spends most of its time.  Each
+ * lane has its own 2MB scratchpad, so four lanes need 8MB of cache to pay off.
+ */
+
+#define CN_MAX_LANES 4
+
+THREADV uint8_t *hp_lanes_state = NULL;
+THREADV int hp_lanes_allocated = 0;
+
+static void slow_hash_allocate_lanes_state(void)
+{
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    hp_lanes_state = (uint8_t *) VirtualAlloc(NULL, CN_MAX_LANES * MEMORY, MEM_LARGE_PAGES |
+                                              MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || \
+  defined(__DragonFly__)
+    hp_lanes_state = mmap(0, CN_MAX_LANES * MEMORY, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANON, 0, 0);
+#else
+    hp_lanes_state = mmap(0, CN_MAX_LANES * MEMORY, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, 0, 0);
+#endif
+    if(hp_lanes_state == MAP_FAILED)
+        hp_lanes_state = NULL;
+#endif
+    hp_lanes_allocated = 1;
+    if(hp_lanes_state == NULL)
+    {
+        hp_lanes_allocated = 0;
+        hp_lanes_state = (uint8_t *) malloc(CN_MAX_LANES * MEMORY);
+    }
+}
+
+static void slow_hash_free_lanes_state(void)
+{
+    if(!hp_lanes_allocated)
+        free(hp_lanes_state);
+    else
+    {
+#if defined(_MSC_VER) || defined(__MINGW32__)
+        VirtualFree(hp_lanes_state, 0, MEM_RELEASE);
+#else
+        munmap(hp_lanes_state, CN_MAX_LANES * MEMORY);
+#endif
+    }
+
+    hp_lanes_state = NULL;
+    hp_lanes_allocated = 0;
+}
+
+/* The first half of a mixing iteration for lane l: the AES round, up to the second scratchpad read */
+#define lane_pre_mul(l) \
+  j[l] = state_index(a[l]); \
+  _c[l] = _mm_load_si128(R128(&lp[l][j[l]])); \
+  _c[l] = _mm_aesenc_si128(_c[l], _mm_load_si128(R128(a[l]))); \
+  _mm_store_si128(R128(c[l]), _c[l]); \
+  _mm_store_si128(R128(&lp[l][j[l]]), _mm_xor_si128(_b[l], _c[l])); \
+  j[l] = state_index(c[l]); \
+  p[l] = U64(&lp[l][j[l]]); \
+
+#if defined(_MSC_VER)
+#define __lane_mul(x, y) lo = _umul128(x, y, &hi);
+#else
+#define __lane_mul(x, y) ASM("mulq %3\n\t" : "=d"(hi), "=a"(lo) : "%a" (x), "rm" (y) : "cc");
+#endif
+
+/* The second half: the multiply, the write back and the next address */
+#define lane_post_mul(l) \
+  { \
+    uint64_t hi, lo, b0, b1; \
+    b0 = p[l][0]; b1 = p[l][1]; \
+    __lane_mul(c[l][0], b0); \
+    a[l][0] += hi; a[l][1] += lo; \
+    p[l][0] = a[l][0]; p[l][1] = a[l][1]; \
+    a[l][0] ^= b0; a[l][1] ^= b1; \
+    _b[l] = _c[l]; \
+  } \
+
+STATIC void cn_slow_hash_lanes(const void *const *data, const size_t *length, char *const *hash, size_t lanes,
+                               void *const *scratchpads)
+{
+    RDATA_ALIGN16 uint8_t expandedKey[240];
+    uint8_t text[INIT_SIZE_BYTE];
+    RDATA_ALIGN16 uint64_t a[CN_MAX_LANES][2];
+    RDATA_ALIGN16 uint64_t c[CN_MAX_LANES][2];
+    union cn_slow_hash_state state[CN_MAX_LANES];
+    __m128i _b[CN_MAX_LANES], _c[CN_MAX_LANES];
+    uint8_t *lp[CN_MAX_LANES];
+    uint64_t *p[CN_MAX_LANES];
+    size_t i, j[CN_MAX_LANES], l;
+
+    static void (*const extra_hashes[4])(const void *, size_t, char *) =
+    {
+        hash_extra_blake, hash_extra_groestl, hash_extra_jh, hash_extra_skein
+    };
+
+    /* Steps 1 and 2 are bound by AES throughput, not by memory, so lanes don't need interleaving there */
+    for(l = 0; l < lanes; l++)
+    {
+        lp[l] = (uint8_t *) scratchpads[l];
+        hash_process(&state[l].hs, data[l], length[l]);
+        memcpy(text, state[l].init, INIT_SIZE_BYTE);
+        aes_expand_key(state[l].hs.b, expandedKey);
+        for(i = 0; i < MEMORY / INIT_SIZE_BYTE; i++)
+        {
+            aes_pseudo_round(text, text, expandedKey, INIT_SIZE_BLK);
+            memcpy(&lp[l][i * INIT_SIZE_BYTE], text, INIT_SIZE_BYTE);
+        }
+
+        a[l][0] = U64(&state[l].k[0])[0] ^ U64(&state[l].k[32])[0];
+        a[l][1] = U64(&state[l].k[0])[1] ^ U64(&state[l].k[32])[1];
+        _b[l] = _mm_xor_si128(_mm_loadu_si128(R128(&state[l].k[16])), _mm_loadu_si128(R128(&state[l].k[48])));
+    }
+
+    /* Step 3 with every lane's memory accesses issued back to back */
+    if(lanes == 4)
+    {
+        for(i = 0; i < ITER / 2; i++)
+        {
+            lane_pre_mul(0);
+            lane_pre_mul(1);
+            lane_pre_mul(2);
+            lane_pre_mul(3);
+            lane_post_mul(0);
+            lane_post_mul(1);
+            lane_post_mul(2);
+            lane_post_mul(3);
+        }
+    }
+    else
+    {
+        assert(lanes == 2);
+        for(i = 0; i < ITER / 2; i++)
+        {
+            lane_pre_mul(0);
+            lane_pre_mul(1);
+            lane_post_mul(0);
+            lane_post_mul(1);
+        }
+    }
+
+    /* Steps 4 and 5 */
+    for(l = 0; l < lanes; l++)
+    {
+        memcpy(text, state[l].init, INIT_SIZE_BYTE);
+        aes_expand_key(&state[l].hs.b[32], expandedKey);
+        for(i = 0; i < MEMORY / INIT_SIZE_BYTE; i++)
+        {
+            aes_pseudo_round_xor(text, text, expandedKey, &lp[l][i * INIT_SIZE_BYTE], INIT_SIZE_BLK);
+        }
+
+        memcpy(state[l].init, text, INIT_SIZE_BYTE);
+        hash_permutation(&state[l].hs);
+        extra_hashes[state[l].hs.b[0] & 3](&state[l], 200, hash[l]);
+    }
+}
+
+size_t cn_slow_hash_lanes_count(void)
+{
+    static size_t lanes = 0;
+
+    if(lanes != 0)
+        return lanes;
+
+    if(force_software_aes() || !check_aes_hw())
+        return lanes = 1;
+
+    const char *env = getenv("CN_SLOW_HASH_LANES");
+    if(env && (!strcmp(env, "1") || !strcmp(env, "2")))
+        return lanes = (size_t) (env[0] - '0');
+
+    return lanes = CN_MAX_LANES;
+}
+
+void cn_slow_hash_multi_scratchpads(const void *const *data, const size_t *length, char *const *hash, size_t count,
+                                    void *const *scratchpads)
+{
+    size_t lanes = cn_slow_hash_lanes_count();
+
+    while(count > 0)
+    {
+        if(lanes >= 4 && count >= 4)
+        {
+            cn_slow_hash_lanes(data, length, hash, 4, scratchpads);
+            data += 4; length += 4; hash += 4; count -= 4;
+        }
+        else if(lanes >= 2 && count >= 2)
+        {
+            cn_slow_hash_lanes(data, length, hash, 2, scratchpads);
+            data += 2; length += 2; hash += 2; count -= 2;
+        }
+        else
+        {
+            cn_slow_hash_scratchpad(*data, *length, *hash, scratchpads[0]);
+            data++; length++; hash++; count--;
+        }
+    }
+}
+
+void cn_slow_hash_multi(const void *const *data, const size_t *length, char *const *hash, size_t count)
+{
+    void *scratchpads[CN_MAX_LANES];
+    size_t l;
+
+    int bLocalStateAllocation = (hp_lanes_state == NULL);
+    if (bLocalStateAllocation)
+        slow_hash_allocate_lanes_state();
+
+    for(l = 0; l < CN_MAX_LANES; l++)
+        scratchpads[l] = &hp_lanes_state[l * MEMORY];
+
+    cn_slow_hash_multi_scratchpads(data, length, hash, count, scratchpads);
+
+    if (bLocalStateAllocation)
+        slow_hash_free_lanes_state();
+}
+
 #elif !defined NO_AES && (defined(__arm__) || defined(__aarch64__))
 void slow_hash_allocate_state(void)
 {
@@ -1282,4 +1511,33 @@ void cn_slow_hash(const void *data, size_t length, char *hash) {
   free(long_state);
 }
 
-#endif
\ No newline at end of file
+#endif
+
+#if !(!defined NO_AES && (defined(__x86_64__) || (defined(_MSC_VER) && defined(_WIN64))))
+// Without AES-NI there is nothing to interleave, hashes are computed one by one.
+// These implementations allocate their own scratchpad, the one passed in is not used.
+
+size_t cn_slow_hash_lanes_count(void)
+{
+  return 1;
+}
+
+void cn_slow_hash_multi(const void *const *data, const size_t *length, char *const *hash, size_t count)
+{
+  size_t i;
+  for (i = 0; i < count; i++) {
+    cn_slow_hash(data[i], length[i], hash[i]);
+  }
+}
+
+void cn_slow_hash_scratchpad(const void *data, size_t length, char *hash, void *scratchpad)
+{
+  cn_slow_hash(data, length, hash);
+}
+
+void cn_slow_hash_multi_scratchpads(const void *const *data, const size_t *length, char *const *hash, size_t count,
+                                    void *const *scratchpads)
+{
+  cn_slow_hash_multi(data, length, hash, count);
+}
+#endif
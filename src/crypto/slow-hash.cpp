@@ -16,64 +16,27 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
-#include <assert.h>
-#include <new>
-
 #include "hash.h"
-
-#if defined(_WIN32)
-#ifndef NOMINMAX
-#define NOMINMAX
-#endif
-#include <Windows.h>
-#else
-#include <sys/mman.h>
-#endif
-
-using std::bad_alloc;
+#include "scratchpad-pool.h"
 
 namespace Crypto {
 
-  enum {
-    MAP_SIZE = SLOW_HASH_CONTEXT_SIZE + ((-SLOW_HASH_CONTEXT_SIZE) & 0xfff)
-  };
-
-#if defined(WIN32)
-
   cn_context::cn_context() {
-    data = VirtualAlloc(nullptr, MAP_SIZE, MEM_COMMIT, PAGE_READWRITE);
-    if (data == nullptr) {
-      throw std::bad_alloc();
-    }
   }
 
   cn_context::~cn_context() {
-    if (!VirtualFree(data, 0, MEM_RELEASE)) {
-      assert(false);
+    for (void *scratchpad : scratchpads) {
+      ScratchpadPool::instance().release(scratchpad);
     }
   }
 
-#else
-
-  cn_context::cn_context() {
-#if !defined(__APPLE__) && !defined(__FreeBSD__)
-    data = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
-#else
-    data = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
-#endif
-    if (data == MAP_FAILED) {
-      throw std::bad_alloc();
+  void *const *cn_context::getScratchpads(size_t count) {
+    scratchpads.reserve(count);
+    while (scratchpads.size() < count) {
+      scratchpads.push_back(ScratchpadPool::instance().acquire());
     }
-    mlock(data, MAP_SIZE);
-  }
 
-  cn_context::~cn_context() {
-    if (munmap(data, MAP_SIZE) != 0) {
-      assert(false);
-      std::terminate();
-    }
+    return scratchpads.data();
   }
 
-#endif
-
 }
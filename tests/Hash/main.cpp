@@ -19,8 +19,11 @@
 #include <fstream>
 #include <iomanip>
 #include <ios>
+#include <iostream>
 #include <string>
+#include <vector>
 
+#include "crypto/crypto.h"
 #include "crypto/hash.h"
 #include "../Io.h"
 
@@ -54,6 +57,77 @@ struct hash_func {
   {"extra-blake", Crypto::hash_extra_blake}, {"extra-groestl", Crypto::hash_extra_groestl},
   {"extra-jh", Crypto::hash_extra_jh}, {"extra-skein", Crypto::hash_extra_skein}};
 
+static void print_hash(const char *name, const chash &hash) {
+  cerr << name;
+  for (size_t i = 0; i < 32; i++) {
+    cerr << setbase(16) << setw(2) << setfill('0') << int(reinterpret_cast<const unsigned char *>(&hash)[i]);
+  }
+  cerr << endl;
+}
+
+// Runs the known slow hash vectors through cn_slow_hash_multi in batches of lanes inputs, so the interleaved
+// kernel of that width is used, and rotates the batches until every vector has been in every lane.
+static bool test_slow_lanes(size_t lanes, fstream &input) {
+  vector<chash> expected;
+  vector<vector<char>> data;
+  for (;;) {
+    chash hash;
+    vector<char> bytes;
+    input.exceptions(ios_base::badbit);
+    get(input, hash);
+    if (input.rdstate() & ios_base::eofbit) {
+      break;
+    }
+    input.exceptions(ios_base::badbit | ios_base::failbit | ios_base::eofbit);
+    input.clear(input.rdstate());
+    get(input, bytes);
+    expected.push_back(hash);
+    data.push_back(bytes);
+  }
+
+  if (data.size() < lanes) {
+    cerr << "Not enough test vectors for " << lanes << " lanes" << endl;
+    return false;
+  }
+
+  if (Crypto::cn_slow_hash_lanes_count() < lanes) {
+    cerr << "Only " << Crypto::cn_slow_hash_lanes_count() << " lanes on this CPU, the " << lanes <<
+      " lane kernel is not used" << endl;
+  }
+
+  Crypto::cn_context context;
+  bool error = false;
+  for (size_t rotation = 0; rotation < data.size(); ++rotation) {
+    vector<const void *> inputs(lanes);
+    vector<size_t> lengths(lanes);
+    vector<chash> results(lanes);
+    vector<chash *> outputs(lanes);
+    for (size_t l = 0; l < lanes; ++l) {
+      size_t test = (rotation + l) % data.size();
+      inputs[l] = data[test].data();
+      lengths[l] = data[test].size();
+      outputs[l] = &results[l];
+    }
+
+    Crypto::cn_slow_hash(context, inputs.data(), lengths.data(), outputs.data(), lanes);
+
+    for (size_t l = 0; l < lanes; ++l) {
+      size_t test = (rotation + l) % data.size();
+      chash single;
+      Crypto::cn_slow_hash(context, data[test].data(), data[test].size(), single);
+      if (results[l] != expected[test] || results[l] != single) {
+        cerr << "Hash mismatch on test " << test + 1 << " in lane " << l << " of " << lanes << endl;
+        print_hash("Expected hash: ", expected[test]);
+        print_hash("Single hash: ", single);
+        print_hash("Lane hash: ", results[l]);
+        error = true;
+      }
+    }
+  }
+
+  return !error;
+}
+
 int main(int argc, char *argv[]) {
   hash_f *f;
   hash_func *hf;
@@ -66,6 +140,10 @@ int main(int argc, char *argv[]) {
     cerr << "Wrong number of arguments" << endl;
     return 1;
   }
+  if (argv[1] == string("slow-2") || argv[1] == string("slow-4")) {
+    input.open(argv[2], ios_base::in);
+    return test_slow_lanes(argv[1][5] - '0', input) ? 0 : 1;
+  }
   for (hf = hashes;; hf++) {
     if (hf >= &hashes[sizeof(hashes) / sizeof(hash_func)]) {
       cerr << "Unknown function" << endl;
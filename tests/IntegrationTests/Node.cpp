@@ -375,3 +375,34 @@ TEST_F(NodeTest, observerHeightNotifications) {
 
   }
 }
+
+TEST_F(NodeTest, synchronizeFromSeveralPeers) {
+  const size_t SEED_COUNT = 4;
+
+  // node 0 starts empty and connects to all the others
+  auto networkCfg = TestNetworkBuilder(SEED_COUNT + 1, Topology::Star).build();
+  for (size_t i = 1; i < networkCfg.size(); ++i) {
+    networkCfg[i].blockchainLocation = "testnet_300";
+  }
+
+  network.addNodes(networkCfg);
+  network.waitNodesReady();
+
+  auto& daemon = network.getNode(0);
+  uint64_t targetHeight = network.getNode(1).getLocalHeight();
+  ASSERT_GT(targetHeight, 1U);
+
+  System::Timer timer(dispatcher);
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + std::chrono::minutes(5);
+
+  while (daemon.getLocalHeight() < targetHeight && std::chrono::steady_clock::now() < deadline) {
+    timer.sleep(std::chrono::milliseconds(100));
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  ASSERT_EQ(targetHeight, daemon.getLocalHeight());
+
+  std::cout << "Synchronized " << targetHeight << " blocks from " << SEED_COUNT << " peers in " << elapsed.count() << " ms ("
+    << targetHeight * 1000.0 / std::max<int64_t>(elapsed.count(), 1) << " blocks/s)" << std::endl;
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Common/ThreadPool.h"
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/BlockSignatureBatch.h"
+#include "CryptoNoteCore/CryptoNoteBasic.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "crypto/crypto.h"
+
+#include "MultiTransactionTestBase.h"
+
+// Verifies the ring signatures of a whole block (tx_count transactions) through
+// BlockSignatureBatch, the way Core::addBlock does during sync. Time per call is
+// the time per block, so running it with a growing thread count shows how block
+// verification scales with cores.
+template<size_t a_ring_size, size_t a_tx_count, size_t a_thread_count>
+class test_check_block_ring_signatures : private multi_tx_test_base<a_ring_size>
+{
+  static_assert(0 < a_ring_size, "ring_size must be greater than 0");
+  static_assert(0 < a_tx_count, "tx_count must be greater than 0");
+
+public:
+  static const size_t loop_count = 10;
+  static const size_t ring_size = a_ring_size;
+  static const size_t tx_count = a_tx_count;
+  static const size_t thread_count = a_thread_count;
+
+  typedef multi_tx_test_base<a_ring_size> base_class;
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    if (!base_class::init())
+      return false;
+
+    m_alice.generate();
+
+    std::vector<TransactionDestinationEntry> destinations;
+    destinations.push_back(TransactionDestinationEntry(this->m_source_amount, m_alice.getAccountKeys().address));
+
+    Crypto::SecretKey txKey;
+    if (!constructTransaction(this->m_miners[this->real_source_idx].getAccountKeys(), this->m_sources, destinations, std::vector<uint8_t>(), m_tx, 0, txKey, this->m_logger))
+      return false;
+
+    getObjectHash(*static_cast<TransactionPrefix*>(&m_tx), m_tx_prefix_hash);
+
+    m_threadPool.reset(new Utilities::ThreadPool<bool>(thread_count));
+
+    return true;
+  }
+
+  bool test()
+  {
+    const CryptoNote::KeyInput& txin = boost::get<CryptoNote::KeyInput>(m_tx.inputs[0]);
+
+    CryptoNote::BlockSignatureBatch batch(*m_threadPool);
+    for (size_t i = 0; i < tx_count; ++i)
+    {
+      batch.addJob(i, [this, &txin] {
+        return Crypto::check_ring_signature(m_tx_prefix_hash, txin.keyImage, this->m_public_key_ptrs, ring_size, m_tx.signatures[0].data(), true);
+      });
+    }
+
+    size_t failedTransactionIndex;
+    return batch.wait(failedTransactionIndex);
+  }
+
+private:
+  CryptoNote::AccountBase m_alice;
+  CryptoNote::Transaction m_tx;
+  Crypto::Hash m_tx_prefix_hash;
+  std::unique_ptr<Utilities::ThreadPool<bool>> m_threadPool;
+};
@@ -0,0 +1,103 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Common/MemoryInputStream.h"
+#include "crypto/random.h"
+#include "Serialization/KVBinaryInputStreamSerializer.h"
+#include "Serialization/KVBinaryStreamingInputSerializer.h"
+#include "Serialization/SerializationOverloads.h"
+#include "Serialization/SerializationTools.h"
+
+// Same layout as NOTIFY_RESPONSE_GET_OBJECTS, which carries the blocks during synchronization
+struct kv_test_block {
+  std::string block;
+  std::vector<std::string> txs;
+
+  void serialize(CryptoNote::ISerializer& s) {
+    s(block, "block");
+    s(txs, "txs");
+  }
+};
+
+struct kv_test_get_objects {
+  std::vector<std::string> txs;
+  std::vector<kv_test_block> blocks;
+  std::vector<Crypto::Hash> missed_ids;
+  uint32_t current_blockchain_height;
+
+  void serialize(CryptoNote::ISerializer& s) {
+    s(txs, "txs");
+    s(blocks, "blocks");
+    serializeAsBinary(missed_ids, "missed_ids", s);
+    s(current_blockchain_height, "current_blockchain_height");
+  }
+};
+
+// Decodes a KV binary message with blocks, either through a JsonValue tree as
+// KVBinaryInputStreamSerializer does or in place with KVBinaryStreamingInputSerializer.
+template<size_t a_block_count, size_t a_tx_count, bool a_streaming>
+class test_kv_binary_deserialization
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t tx_size = 1024;
+
+  bool init()
+  {
+    kv_test_get_objects message;
+    message.current_blockchain_height = 1000000;
+    message.blocks.resize(a_block_count);
+    for (auto& block : message.blocks) {
+      block.block.resize(tx_size / 2);
+      Random::randomBytes(block.block.size(), reinterpret_cast<uint8_t*>(&block.block[0]));
+      block.txs.resize(a_tx_count, std::string(tx_size, '\0'));
+      for (auto& transaction : block.txs) {
+        Random::randomBytes(transaction.size(), reinterpret_cast<uint8_t*>(&transaction[0]));
+      }
+    }
+
+    m_buffer = CryptoNote::storeToBinaryKeyValue(message);
+
+    std::cout << "  message bytes:          " << m_buffer.size() << std::endl;
+    return true;
+  }
+
+  bool test()
+  {
+    kv_test_get_objects message;
+    if (a_streaming) {
+      CryptoNote::KVBinaryStreamingInputSerializer serializer(m_buffer.data(), m_buffer.size());
+      serialize(message, serializer);
+    } else {
+      Common::MemoryInputStream stream(m_buffer.data(), m_buffer.size());
+      CryptoNote::KVBinaryInputStreamSerializer serializer(stream);
+      serialize(message, serializer);
+    }
+
+    return message.blocks.size() == a_block_count && message.blocks.back().txs.size() == a_tx_count;
+  }
+
+private:
+  std::string m_buffer;
+};
@@ -0,0 +1,81 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <boost/filesystem.hpp>
+
+#include "crypto/hash.h"
+#include "CryptoNoteCore/CryptoNoteBasicImpl.h"
+#include "Logging/LoggerManager.h"
+#include "Logging/LoggerRef.h"
+
+// Cost of a typical debug message on the logging thread, writing to a file logger.
+// loop_count is a million, so the elapsed milliseconds are nanoseconds per message.
+template<bool a_enabled, bool a_async>
+class test_log_message
+{
+public:
+  static const size_t loop_count = 1000000;
+
+  test_log_message() : m_logger(m_logManager, "performance"), m_index(0)
+  {
+  }
+
+  ~test_log_message()
+  {
+    m_logManager.configure(buildConfiguration(Logging::FATAL, false));
+    boost::system::error_code ignore;
+    boost::filesystem::remove(m_logFile, ignore);
+  }
+
+  bool init()
+  {
+    m_logFile = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    m_logManager.configure(buildConfiguration(a_enabled ? Logging::TRACE : Logging::INFO, a_async));
+    cn_fast_hash("performance", 11, m_hash);
+    return true;
+  }
+
+  bool test()
+  {
+    m_logger(Logging::DEBUGGING) << "Block " << m_index++ << " (" << m_hash << ") added to main chain";
+    return true;
+  }
+
+private:
+  Common::JsonValue buildConfiguration(Logging::Level level, bool async)
+  {
+    Common::JsonValue configuration(Common::JsonValue::OBJECT);
+    configuration.insert("globalLevel", static_cast<int64_t>(level));
+    configuration.insert("async", Common::JsonValue(async));
+
+    Common::JsonValue& loggers = configuration.insert("loggers", Common::JsonValue::ARRAY);
+    Common::JsonValue& fileLogger = loggers.pushBack(Common::JsonValue::OBJECT);
+    fileLogger.insert("type", "file");
+    fileLogger.insert("filename", m_logFile);
+    fileLogger.insert("level", static_cast<int64_t>(Logging::TRACE));
+    return configuration;
+  }
+
+  Logging::LoggerManager m_logManager;
+  Logging::LoggerRef m_logger;
+  std::string m_logFile;
+  Crypto::Hash m_hash;
+  uint32_t m_index;
+};
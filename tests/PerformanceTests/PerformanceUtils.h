@@ -50,6 +50,31 @@ void set_process_affinity(int core)
 #endif
 }
 
+void reset_process_affinity()
+{
+#if defined (__APPLE__)
+    return;
+#elif defined(BOOST_WINDOWS)
+  DWORD_PTR processMask = 0;
+  DWORD_PTR systemMask = 0;
+  if (::GetProcessAffinityMask(::GetCurrentProcess(), &processMask, &systemMask))
+  {
+    ::SetProcessAffinityMask(::GetCurrentProcess(), systemMask);
+  }
+#elif defined(BOOST_HAS_PTHREADS)
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (int i = 0; i < CPU_SETSIZE; ++i)
+  {
+    CPU_SET(i, &cpuset);
+  }
+  if (0 != ::pthread_setaffinity_np(::pthread_self(), sizeof(cpuset), &cpuset))
+  {
+    std::cout << "pthread_setaffinity_np - ERROR" << std::endl;
+  }
+#endif
+}
+
 void set_thread_high_priority()
 {
 #if defined(__APPLE__)
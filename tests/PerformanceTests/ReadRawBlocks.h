@@ -0,0 +1,94 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "crypto/random.h"
+#include "CryptoNoteCore/BlockchainReadBatch.h"
+#include "CryptoNoteCore/DBUtils.h"
+
+// Feeds stored raw blocks to BlockchainReadBatch the way RocksDBWrapper::read does when serving
+// getblocks.bin / queryblocks.bin, and moves them out like DatabaseBlockchainCache::getBlocksByHeight.
+// With zero_copy the values are handed over as views into the "database" memory (pinned slices),
+// otherwise every value is first copied into a std::string as MultiGet used to do.
+template<size_t a_block_count, size_t a_tx_count, bool a_zero_copy>
+class test_read_raw_blocks
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t tx_size = 1024;
+
+  bool init()
+  {
+    m_values_size = 0;
+    for (size_t i = 0; i < a_block_count; ++i) {
+      CryptoNote::RawBlock block;
+      block.block.resize(tx_size / 2);
+      Random::randomBytes(block.block.size(), block.block.data());
+      block.transactions.resize(a_tx_count, CryptoNote::BinaryArray(tx_size));
+      for (auto& transaction : block.transactions) {
+        Random::randomBytes(transaction.size(), transaction.data());
+      }
+
+      m_values.push_back(CryptoNote::DB::serialize(block, std::string()));
+      m_values_size += m_values.back().size();
+    }
+
+    m_result_states.assign(a_block_count, true);
+
+    std::cout << "  value bytes per call:   " << m_values_size << '\n';
+    std::cout << "  copied bytes per call:  " << (a_zero_copy ? 0 : m_values_size) << '\n';
+    std::cout << "  value copies per call:  " << (a_zero_copy ? 0 : a_block_count) << std::endl;
+    return true;
+  }
+
+  bool test()
+  {
+    CryptoNote::BlockchainReadBatch batch;
+    batch.requestRawBlocks(0, a_block_count);
+    batch.getRawKeys();
+
+    if (a_zero_copy) {
+      std::vector<std::string_view> values(m_values.begin(), m_values.end());
+      batch.submitRawResult(values, m_result_states);
+    } else {
+      std::vector<std::string> values(m_values.begin(), m_values.end());
+      batch.submitRawResult(values, m_result_states);
+    }
+
+    auto rawBlocks = batch.extractResult().extractRawBlocks();
+
+    std::vector<CryptoNote::RawBlock> orderedBlocks;
+    orderedBlocks.reserve(rawBlocks.size());
+    for (uint32_t height = 0; height < rawBlocks.size(); ++height) {
+      orderedBlocks.push_back(std::move(rawBlocks.at(height)));
+    }
+
+    return orderedBlocks.size() == a_block_count && orderedBlocks.back().transactions.size() == a_tx_count;
+  }
+
+private:
+  std::vector<std::string> m_values;
+  std::vector<bool> m_result_states;
+  size_t m_values_size;
+};
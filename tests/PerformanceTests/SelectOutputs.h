@@ -0,0 +1,110 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "Common/ShuffleGenerator.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/TransactionApi.h"
+#include "crypto/crypto.h"
+#include "crypto/random.h"
+#include "Logging/ConsoleLogger.h"
+#include "Transfers/TransfersContainer.h"
+
+// Picks the inputs of a transfer from a wallet address with a_output_count unlocked outputs, which is what
+// WalletGreen::transfer() does before it asks the node for mixins. a_copy_all copies every output and picks
+// them at random, the way the wallet did before TransfersContainer::selectOutputs().
+template<size_t a_output_count, bool a_copy_all, CryptoNote::OutputSelectionStrategy a_strategy>
+class test_select_outputs
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t outputs_per_tx = 100;
+  static const uint64_t dust_threshold = 1000000;
+  static const uint64_t max_amount = 1000000000000;
+  static const uint64_t needed_money = 5 * max_amount;
+
+  test_select_outputs() :
+    m_logger(Logging::ERROR),
+    m_currency(CryptoNote::CurrencyBuilder(m_logger).currency()),
+    m_container(m_currency, m_logger, 1)
+  {
+  }
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    Crypto::PublicKey outputKey;
+    Crypto::SecretKey outputSecretKey;
+    Crypto::generate_keys(outputKey, outputSecretKey);
+
+    uint32_t globalOutputIndex = 0;
+    for (size_t txIndex = 0; txIndex * outputs_per_tx < a_output_count; ++txIndex) {
+      auto tx = createTransaction();
+      std::vector<TransactionOutputInformationIn> transfers;
+      for (size_t i = 0; i < outputs_per_tx && txIndex * outputs_per_tx + i < a_output_count; ++i) {
+        TransactionOutputInformationIn transfer;
+        transfer.type = TransactionTypes::OutputType::Key;
+        transfer.amount = Random::randomValue<uint64_t>(1, max_amount);
+        transfer.globalOutputIndex = globalOutputIndex++;
+        transfer.outputInTransaction = static_cast<uint32_t>(tx->addOutput(transfer.amount, KeyOutput{ outputKey }));
+        transfer.transactionPublicKey = tx->getTransactionPublicKey();
+        transfer.outputKey = outputKey;
+        Random::randomBytes(sizeof(transfer.keyImage), reinterpret_cast<uint8_t*>(&transfer.keyImage));
+        transfers.push_back(transfer);
+      }
+
+      if (!m_container.addTransaction(TransactionBlockInfo{ 1, 0, static_cast<uint32_t>(txIndex) }, *tx, transfers)) {
+        return false;
+      }
+    }
+
+    m_container.advanceHeight(1000);
+    return m_container.balance(ITransfersContainer::IncludeKeyUnlocked) >= needed_money;
+  }
+
+  bool test()
+  {
+    std::vector<CryptoNote::TransactionOutputInformation> outputs;
+    uint64_t foundMoney = 0;
+    if (a_copy_all) {
+      std::vector<CryptoNote::TransactionOutputInformation> allOutputs;
+      m_container.getOutputs(allOutputs, CryptoNote::ITransfersContainer::IncludeKeyUnlocked);
+
+      ShuffleGenerator<size_t> indexGenerator(allOutputs.size());
+      while (foundMoney < needed_money && !indexGenerator.empty()) {
+        auto& out = allOutputs[indexGenerator()];
+        foundMoney += out.amount;
+        outputs.push_back(out);
+      }
+    } else {
+      foundMoney = m_container.selectOutputs(needed_money, dust_threshold, 0, a_strategy, outputs);
+    }
+
+    return foundMoney >= needed_money;
+  }
+
+private:
+  Logging::ConsoleLogger m_logger;
+  CryptoNote::Currency m_currency;
+  CryptoNote::TransfersContainer m_container;
+};
@@ -21,6 +21,7 @@
 // tests
 #include "ConstructTransaction.h"
 #include "CheckRingSignature.h"
+#include "CheckBlockRingSignatures.h"
 #include "CryptoNoteSlowHash.h"
 #include "DerivePublicKey.h"
 #include "DeriveSecretKey.h"
@@ -28,6 +29,10 @@
 #include "GenerateKeyImage.h"
 #include "GenerateKeyImageHelper.h"
 #include "IsOutToAccount.h"
+#include "KVBinaryDeserialization.h"
+#include "LogMessage.h"
+#include "ReadRawBlocks.h"
+#include "SelectOutputs.h"
 
 int main(int argc, char** argv)
 {
@@ -63,6 +68,15 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE1(test_check_ring_signature, 10);
   TEST_PERFORMANCE1(test_check_ring_signature, 100);
 
+  // Block-wide verification needs every core, not just the pinned one
+  reset_process_affinity();
+  TEST_PERFORMANCE3(test_check_block_ring_signatures, 4, 50, 1);
+  TEST_PERFORMANCE3(test_check_block_ring_signatures, 4, 50, 2);
+  TEST_PERFORMANCE3(test_check_block_ring_signatures, 4, 50, 4);
+  TEST_PERFORMANCE3(test_check_block_ring_signatures, 4, 50, 8);
+  TEST_PERFORMANCE3(test_check_block_ring_signatures, 4, 50, 16);
+  set_process_affinity(1);
+
   TEST_PERFORMANCE0(test_is_out_to_acc);
   TEST_PERFORMANCE0(test_generate_key_image_helper);
   TEST_PERFORMANCE0(test_generate_key_derivation);
@@ -71,6 +85,32 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE0(test_derive_secret_key);
 
   TEST_PERFORMANCE0(test_cn_slow_hash);
+  TEST_PERFORMANCE1(test_cn_slow_hash_multi, 1);
+  TEST_PERFORMANCE1(test_cn_slow_hash_multi, 2);
+  TEST_PERFORMANCE1(test_cn_slow_hash_multi, 4);
+
+  TEST_PERFORMANCE3(test_read_raw_blocks, 100, 10, false);
+  TEST_PERFORMANCE3(test_read_raw_blocks, 100, 10, true);
+  TEST_PERFORMANCE3(test_read_raw_blocks, 20, 200, false);
+  TEST_PERFORMANCE3(test_read_raw_blocks, 20, 200, true);
+
+  TEST_PERFORMANCE3(test_kv_binary_deserialization, 100, 10, false);
+  TEST_PERFORMANCE3(test_kv_binary_deserialization, 100, 10, true);
+  TEST_PERFORMANCE3(test_kv_binary_deserialization, 500, 2, false);
+  TEST_PERFORMANCE3(test_kv_binary_deserialization, 500, 2, true);
+
+  TEST_PERFORMANCE2(test_log_message, false, false);
+  TEST_PERFORMANCE2(test_log_message, true, false);
+  TEST_PERFORMANCE2(test_log_message, true, true);
+
+  TEST_PERFORMANCE3(test_select_outputs, 1000, true, CryptoNote::OutputSelectionStrategy::Random);
+  TEST_PERFORMANCE3(test_select_outputs, 1000, false, CryptoNote::OutputSelectionStrategy::Random);
+  TEST_PERFORMANCE3(test_select_outputs, 1000, false, CryptoNote::OutputSelectionStrategy::LargestFirst);
+  TEST_PERFORMANCE3(test_select_outputs, 1000, false, CryptoNote::OutputSelectionStrategy::SmallestSufficient);
+  TEST_PERFORMANCE3(test_select_outputs, 200000, true, CryptoNote::OutputSelectionStrategy::Random);
+  TEST_PERFORMANCE3(test_select_outputs, 200000, false, CryptoNote::OutputSelectionStrategy::Random);
+  TEST_PERFORMANCE3(test_select_outputs, 200000, false, CryptoNote::OutputSelectionStrategy::LargestFirst);
+  TEST_PERFORMANCE3(test_select_outputs, 200000, false, CryptoNote::OutputSelectionStrategy::SmallestSufficient);
 
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
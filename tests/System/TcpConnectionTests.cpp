@@ -89,6 +89,20 @@ TEST_F(TcpConnectionTests, sendAndClose) {
   ASSERT_EQ(0, size);
 }
 
+TEST_F(TcpConnectionTests, sendBuffers) {
+  connect();
+  TcpConnection::Buffer buffers[] = { { reinterpret_cast<const uint8_t*>("Te"), 2 }, { reinterpret_cast<const uint8_t*>("st"), 2 } };
+  ASSERT_EQ(4, connection1.writeBuffers(buffers, 2));
+  uint8_t data[1024];
+  size_t size = 0;
+  while (size < 4) {
+    size += connection2.read(data + size, 1024 - size);
+  }
+
+  ASSERT_EQ(4, size);
+  ASSERT_EQ(0, memcmp(data, "Test", 4));
+}
+
 TEST_F(TcpConnectionTests, stoppedState) {
   connect();
   bool stopped = false;
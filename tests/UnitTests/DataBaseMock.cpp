@@ -58,6 +58,16 @@ std::error_code DataBaseMock::read(IReadBatch& batch) {
   return{};
 }
 
+std::error_code DataBaseMock::readThreadSafe(IReadBatch& batch) {
+  return read(batch);
+}
+
+std::unique_ptr<IDataBase> DataBaseMock::createSnapshot() {
+  std::unique_ptr<DataBaseMock> snapshot(new DataBaseMock());
+  snapshot->baseState = baseState;
+  return std::move(snapshot);
+}
+
 std::unordered_map<uint32_t, RawBlock> DataBaseMock::blocks() {
   BlockchainReadBatch req;
   for (int i = 0; i < 30; ++i) {
@@ -31,9 +31,17 @@ public:
   DataBaseMock() = default;
   ~DataBaseMock() override;
 
+  void init() override {}
+  void shutdown() override {}
+  void destroy() override { baseState.clear(); }
+  void recreate() override { baseState.clear(); }
+
   std::error_code write(IWriteBatch& batch) override;
   std::error_code writeSync(IWriteBatch& batch) override;
   std::error_code read(IReadBatch& batch) override;
+  std::error_code readThreadSafe(IReadBatch& batch) override;
+  std::error_code migrateStorageLayout() override { return {}; }
+  std::unique_ptr<IDataBase> createSnapshot() override;
   std::unordered_map<uint32_t, RawBlock> blocks();
 
   std::map<std::string, std::string> baseState;
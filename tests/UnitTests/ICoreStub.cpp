@@ -282,6 +282,20 @@ bool ICoreStub::getRandomOutputs(uint64_t amount, uint16_t count, std::vector<ui
   return randomOutsResult;
 }
 
+bool ICoreStub::getRandomOutputs(const std::vector<uint64_t>& amounts, uint16_t count, std::vector<CryptoNote::RandomOutputsForAmount>& outs) const {
+  for (auto amount : amounts) {
+    CryptoNote::RandomOutputsForAmount outsForAmount;
+    outsForAmount.amount = amount;
+    if (!getRandomOutputs(amount, count, outsForAmount.globalIndexes, outsForAmount.publicKeys)) {
+      return false;
+    }
+
+    outs.push_back(std::move(outsForAmount));
+  }
+
+  return true;
+}
+
 bool ICoreStub::addTransactionToPool(const CryptoNote::BinaryArray& transactionBinaryArray) {
   transactionPool.emplace(CryptoNote::getBinaryArrayHash(transactionBinaryArray), transactionBinaryArray);
   return true;
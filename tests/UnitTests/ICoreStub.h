@@ -56,6 +56,7 @@ public:
   virtual std::vector<CryptoNote::RawBlock> getBlocks(uint32_t startIndex, uint32_t count) const override;
   virtual void getBlocks(const std::vector<Crypto::Hash>& blockHashes, std::vector<CryptoNote::RawBlock>& blocks, std::vector<Crypto::Hash>& missedHashes) const override;
   virtual bool getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_t>& globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const override;
+  virtual bool getRandomOutputs(const std::vector<uint64_t>& amounts, uint16_t count, std::vector<CryptoNote::RandomOutputsForAmount>& outs) const override;
   virtual bool addTransactionToPool(const CryptoNote::BinaryArray& transactionBinaryArray) override;
   virtual std::vector<Crypto::Hash> getPoolTransactionHashes() const override;
   virtual bool getBlockTemplate(CryptoNote::BlockTemplate& b, const CryptoNote::AccountPublicAddress& adr, const CryptoNote::BinaryArray& extraNonce, CryptoNote::Difficulty& difficulty, uint32_t& height) const override;
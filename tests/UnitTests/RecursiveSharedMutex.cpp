@@ -0,0 +1,112 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+#include "Common/RecursiveSharedMutex.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <shared_mutex>
+
+using namespace Common;
+
+namespace {
+  // long enough for a writer thread to reach the gate
+  const std::chrono::milliseconds SETTLE_TIME(100);
+  const std::chrono::seconds DEADLOCK_TIMEOUT(5);
+}
+
+TEST(RecursiveSharedMutex, readerReentersWhileWriterWaits) {
+  RecursiveSharedMutex mutex;
+  std::atomic<bool> writerEntered(false);
+  std::promise<void> writerWaits;
+
+  auto reader = std::async(std::launch::async, [&] {
+    std::shared_lock<RecursiveSharedMutex> outer(mutex);
+    writerWaits.get_future().wait();
+    // the writer is at the gate now, a nested shared lock must not queue behind it
+    std::shared_lock<RecursiveSharedMutex> inner(mutex);
+    EXPECT_FALSE(writerEntered);
+  });
+
+  std::this_thread::sleep_for(SETTLE_TIME);
+  auto writer = std::async(std::launch::async, [&] {
+    std::unique_lock<RecursiveSharedMutex> lock(mutex);
+    writerEntered = true;
+  });
+
+  std::this_thread::sleep_for(SETTLE_TIME);
+  ASSERT_FALSE(writerEntered);
+  writerWaits.set_value();
+
+  ASSERT_EQ(std::future_status::ready, reader.wait_for(DEADLOCK_TIMEOUT));
+  ASSERT_EQ(std::future_status::ready, writer.wait_for(DEADLOCK_TIMEOUT));
+  ASSERT_TRUE(writerEntered);
+}
+
+TEST(RecursiveSharedMutex, waitingWriterHoldsBackNewReaders) {
+  RecursiveSharedMutex mutex;
+  std::atomic<bool> readerEntered(false);
+
+  std::shared_lock<RecursiveSharedMutex> outer(mutex);
+
+  auto writer = std::async(std::launch::async, [&] {
+    std::unique_lock<RecursiveSharedMutex> lock(mutex);
+    std::this_thread::sleep_for(SETTLE_TIME);
+    EXPECT_FALSE(readerEntered);
+  });
+
+  std::this_thread::sleep_for(SETTLE_TIME);
+
+  auto reader = std::async(std::launch::async, [&] {
+    std::shared_lock<RecursiveSharedMutex> lock(mutex);
+    readerEntered = true;
+  });
+
+  std::this_thread::sleep_for(SETTLE_TIME);
+  ASSERT_FALSE(readerEntered);
+
+  outer.unlock();
+  ASSERT_EQ(std::future_status::ready, writer.wait_for(DEADLOCK_TIMEOUT));
+  ASSERT_EQ(std::future_status::ready, reader.wait_for(DEADLOCK_TIMEOUT));
+  ASSERT_TRUE(readerEntered);
+}
+
+TEST(RecursiveSharedMutex, writerTakesBothSidesRecursively) {
+  RecursiveSharedMutex mutex;
+
+  std::unique_lock<RecursiveSharedMutex> outer(mutex);
+  {
+    std::unique_lock<RecursiveSharedMutex> inner(mutex);
+    std::shared_lock<RecursiveSharedMutex> shared(mutex);
+  }
+
+  std::atomic<bool> readerEntered(false);
+  auto reader = std::async(std::launch::async, [&] {
+    std::shared_lock<RecursiveSharedMutex> lock(mutex);
+    readerEntered = true;
+  });
+
+  std::this_thread::sleep_for(SETTLE_TIME);
+  ASSERT_FALSE(readerEntered);
+
+  outer.unlock();
+  ASSERT_EQ(std::future_status::ready, reader.wait_for(DEADLOCK_TIMEOUT));
+  ASSERT_TRUE(readerEntered);
+}
@@ -19,8 +19,10 @@
 
 #include <boost/lexical_cast.hpp>
 
+#include "Common/MemoryInputStream.h"
 #include "Serialization/KVBinaryInputStreamSerializer.h"
 #include "Serialization/KVBinaryOutputStreamSerializer.h"
+#include "Serialization/KVBinaryStreamingInputSerializer.h"
 #include "Serialization/SerializationOverloads.h"
 #include "Serialization/SerializationTools.h"
 
@@ -84,6 +86,73 @@ struct TestStruct {
 
 };
 
+struct TestScalars {
+  int16_t i16;
+  uint16_t u16;
+  int32_t i32;
+  int64_t i64;
+  double real;
+  bool flag;
+  std::string text;
+
+  bool operator == (const TestScalars& other) const {
+    return
+      i16 == other.i16 &&
+      u16 == other.u16 &&
+      i32 == other.i32 &&
+      i64 == other.i64 &&
+      real == other.real &&
+      flag == other.flag &&
+      text == other.text;
+  }
+
+  void serialize(ISerializer& s) {
+    s(i16, "i16");
+    s(u16, "u16");
+    s(i32, "i32");
+    s(i64, "i64");
+    s(real, "real");
+    s(flag, "flag");
+    s(text, "text");
+  }
+};
+
+// reads the fields of TestStruct in another order, together with some which aren't there
+struct TestReordered {
+  uint64_t u64;
+  uint8_t u8;
+  uint32_t missing;
+  bool hasMissing;
+  std::vector<TestElement> vec2;
+  std::vector<TestElement> vec1;
+  TestElement root;
+  std::vector<uint32_t> missingArray;
+  bool hasMissingArray;
+
+  bool operator == (const TestReordered& other) const {
+    return
+      u64 == other.u64 &&
+      u8 == other.u8 &&
+      missing == other.missing &&
+      hasMissing == other.hasMissing &&
+      vec2 == other.vec2 &&
+      vec1 == other.vec1 &&
+      root == other.root &&
+      missingArray == other.missingArray &&
+      hasMissingArray == other.hasMissingArray;
+  }
+
+  void serialize(ISerializer& s) {
+    s(u64, "u64");
+    hasMissing = s(missing, "missing");
+    s(vec2, "vec2");
+    s(u8, "u8");
+    s(root, "root");
+    hasMissingArray = s(missingArray, "missingArray");
+    s(vec1, "vec1");
+  }
+};
+
 }
 
 
@@ -104,6 +173,51 @@ private:
   hclock::time_point start;
 };
 
+template <typename T>
+bool loadWithValueSerializer(T& v, const std::string& buf) {
+  try {
+    Common::MemoryInputStream stream(buf.data(), buf.size());
+    KVBinaryInputStreamSerializer s(stream);
+    serialize(v, s);
+    return true;
+  } catch (std::exception&) {
+    return false;
+  }
+}
+
+template <typename T>
+bool loadWithStreamingSerializer(T& v, const std::string& buf) {
+  try {
+    KVBinaryStreamingInputSerializer s(buf.data(), buf.size());
+    serialize(v, s);
+    return true;
+  } catch (std::exception&) {
+    return false;
+  }
+}
+
+TestStruct makeTestStruct() {
+  TestStruct ts;
+  ts.u8 = 200;
+  ts.u32 = 0xff00ff;
+  ts.u64 = 0xfedcba9876543210ULL;
+  ts.root.name = "root";
+  ts.root.nonce = 7;
+  ts.root.blob.fill(0x5a);
+  ts.root.u32array = { 1, 2, 3 };
+
+  for (uint32_t i = 0; i < 50; ++i) {
+    TestElement element;
+    element.name = std::string(i, 'x');
+    element.nonce = i;
+    element.blob.fill(static_cast<uint8_t>(i));
+    element.u32array.resize(i % 5, i);
+    (i % 2 == 0 ? ts.vec1 : ts.vec2).push_back(element);
+  }
+
+  return ts;
+}
+
 TEST(KVSerialize, Simple) {
   TestElement testData1, testData2;
 
@@ -152,3 +266,76 @@ TEST(KVSerialize, DISABLED_CollectionOfCollections) {
   ASSERT_TRUE(CryptoNote::loadFromBinaryKeyValue(ts2, buf));
   EXPECT_EQ(ts1, ts2);
 }
+
+TEST(KVSerialize, StreamingMatchesValueSerializer) {
+  TestStruct ts1 = makeTestStruct();
+  std::string buf = CryptoNote::storeToBinaryKeyValue(ts1);
+
+  TestStruct ts2;
+  TestStruct ts3;
+  ASSERT_TRUE(loadWithValueSerializer(ts2, buf));
+  ASSERT_TRUE(loadWithStreamingSerializer(ts3, buf));
+  EXPECT_EQ(ts1, ts2);
+  EXPECT_EQ(ts2, ts3);
+}
+
+TEST(KVSerialize, StreamingReadsScalars) {
+  TestScalars s1{ -12345, 54321, -1234567890, -(1LL << 62), 3.25, true, std::string("a\0b", 3) };
+  std::string buf = CryptoNote::storeToBinaryKeyValue(s1);
+
+  TestScalars s2;
+  TestScalars s3;
+  ASSERT_TRUE(loadWithValueSerializer(s2, buf));
+  ASSERT_TRUE(loadWithStreamingSerializer(s3, buf));
+  EXPECT_EQ(s1, s2);
+  EXPECT_EQ(s2, s3);
+}
+
+TEST(KVSerialize, StreamingReadsFieldsOutOfOrder) {
+  TestStruct ts = makeTestStruct();
+  std::string buf = CryptoNote::storeToBinaryKeyValue(ts);
+
+  TestReordered r1;
+  TestReordered r2;
+  r1.missing = r2.missing = 0;
+  ASSERT_TRUE(loadWithValueSerializer(r1, buf));
+  ASSERT_TRUE(loadWithStreamingSerializer(r2, buf));
+  EXPECT_EQ(r1, r2);
+
+  EXPECT_FALSE(r2.hasMissing);
+  EXPECT_FALSE(r2.hasMissingArray);
+  EXPECT_EQ(ts.u64, r2.u64);
+  EXPECT_EQ(ts.u8, r2.u8);
+  EXPECT_EQ(ts.vec1, r2.vec1);
+  EXPECT_EQ(ts.vec2, r2.vec2);
+  EXPECT_EQ(ts.root, r2.root);
+}
+
+TEST(KVSerialize, StreamingRejectsTruncatedData) {
+  TestStruct ts = makeTestStruct();
+  std::string buf = CryptoNote::storeToBinaryKeyValue(ts);
+
+  for (size_t size = 0; size < buf.size(); ++size) {
+    TestStruct loaded;
+    ASSERT_FALSE(loadWithStreamingSerializer(loaded, buf.substr(0, size))) << "size " << size;
+  }
+}
+
+TEST(KVSerialize, StreamingRejectsWrongTypes) {
+  TestScalars s1{ 1, 2, 3, 4, 5.0, false, "text" };
+  std::string buf = CryptoNote::storeToBinaryKeyValue(s1);
+
+  struct TextAsNumber {
+    uint32_t text;
+
+    void serialize(ISerializer& s) {
+      s(text, "text");
+    }
+  } wrongType;
+
+  ASSERT_FALSE(loadWithValueSerializer(wrongType, buf));
+  ASSERT_FALSE(loadWithStreamingSerializer(wrongType, buf));
+
+  buf[0] ^= 1;
+  ASSERT_FALSE(loadWithStreamingSerializer(s1, buf));
+}
@@ -107,14 +107,17 @@ public:
 
 class IBlockchainSynchronizerFunctorialObserver : public IBlockchainSynchronizerObserver {
 public:
-  IBlockchainSynchronizerFunctorialObserver() : updFunc([](uint32_t, uint32_t) {}), syncFunc([](std::error_code) {}) {
+  IBlockchainSynchronizerFunctorialObserver() : updFunc([](uint32_t, uint32_t) {}), syncFunc([](std::error_code) {}),
+    timingsFunc([](const BlockchainSynchronizationTimings&) {}) {
   }
 
   virtual void synchronizationProgressUpdated(uint32_t current, uint32_t total) override { updFunc(current, total); }
   virtual void synchronizationCompleted(std::error_code result) override { syncFunc(result); }
+  virtual void synchronizationTimingsUpdated(const BlockchainSynchronizationTimings& timings) override { timingsFunc(timings); }
 
   std::function<void(uint32_t, uint32_t)> updFunc;
   std::function<void(std::error_code)> syncFunc;
+  std::function<void(const BlockchainSynchronizationTimings&)> timingsFunc;
 };
 
 class ConsumerStub : public IBlockchainConsumer {
@@ -1088,6 +1091,43 @@ TEST_F(BcSTest, checkBlocksRequesting) {
   EXPECT_EQ(blocksExpected, blocksRequested);
 }
 
+TEST_F(BcSTest, timingsReportedForProcessedRanges) {
+  FunctorialBlockhainConsumerStub c(m_currency.genesisBlockHash());
+  IBlockchainSynchronizerFunctorialObserver o1;
+  EventWaiter e;
+  o1.syncFunc = [&](std::error_code) {
+    e.notify();
+  };
+
+  size_t blocksExpected = 20;
+
+  generator.generateEmptyBlocks(blocksExpected - 1); //-1 for genesis
+  m_node.setGetNewBlocksLimit(3);
+
+  size_t rangesReported = 0;
+  uint32_t reportedHeight = 0;
+  o1.timingsFunc = [&](const BlockchainSynchronizationTimings& timings) {
+    ++rangesReported;
+    reportedHeight = std::max(reportedHeight, timings.startHeight + timings.blockCount);
+  };
+
+  c.onNewBlocksFunctor = [&](const CompleteBlock*, uint32_t, uint32_t count) -> uint32_t {
+    return count;
+  };
+
+  m_sync.addObserver(&o1);
+  m_sync.addConsumer(&c);
+  m_sync.start();
+  e.wait();
+  m_sync.stop();
+  m_sync.removeObserver(&o1);
+  o1.syncFunc = [](std::error_code) {};
+  o1.timingsFunc = [](const BlockchainSynchronizationTimings&) {};
+
+  EXPECT_LE(blocksExpected / 3, rangesReported);
+  EXPECT_EQ(blocksExpected, reportedHeight);
+}
+
 TEST_F(BcSTest, checkConsumerHeightReceived) {
   FunctorialBlockhainConsumerStub c(m_currency.genesisBlockHash());
   IBlockchainSynchronizerFunctorialObserver o1;
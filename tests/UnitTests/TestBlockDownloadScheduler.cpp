@@ -0,0 +1,233 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/uuid/uuid_generators.hpp>
+
+#include "CryptoNoteConfig.h"
+#include "CryptoNoteProtocol/BlockDownloadScheduler.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+typedef BlockDownloadScheduler::Clock Clock;
+
+const size_t CHAIN_LENGTH = 300;
+
+class BlockDownloadSchedulerTest : public ::testing::Test {
+public:
+  BlockDownloadSchedulerTest() : peerA(generator()), peerB(generator()), start(Clock::now()) {
+    for (size_t i = 0; i < CHAIN_LENGTH; ++i) {
+      BlockTemplate block;
+      block.majorVersion = BLOCK_MAJOR_VERSION_1;
+      block.minorVersion = 0;
+      block.timestamp = 0;
+      block.nonce = static_cast<uint32_t>(i);
+      block.previousBlockHash = i == 0 ? Crypto::Hash() : hashes.back();
+
+      hashes.push_back(CachedBlock(block).getBlockHash());
+      templates[hashes.back()] = block;
+    }
+  }
+
+protected:
+  std::vector<Crypto::Hash> chain(size_t count) const {
+    return std::vector<Crypto::Hash>(hashes.begin(), hashes.begin() + count);
+  }
+
+  std::vector<std::unique_ptr<DownloadedBlock>> respond(const boost::uuids::uuid& peer, const std::vector<Crypto::Hash>& request) {
+    std::vector<std::unique_ptr<DownloadedBlock>> blocks;
+    for (const auto& hash : request) {
+      BlockTemplate block = templates.at(hash);
+      blocks.emplace_back(new DownloadedBlock(std::move(block), RawBlock(), peer));
+    }
+
+    return blocks;
+  }
+
+  std::vector<Crypto::Hash> range(size_t first, size_t count) const {
+    return std::vector<Crypto::Hash>(hashes.begin() + first, hashes.begin() + first + count);
+  }
+
+  void popAllInOrder(size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      auto block = scheduler.popNextBlock();
+      ASSERT_NE(nullptr, block);
+      ASSERT_EQ(hashes[i], block->cachedBlock.getBlockHash());
+    }
+
+    ASSERT_EQ(nullptr, scheduler.popNextBlock());
+    ASSERT_EQ(0, scheduler.getDownloadedCount());
+  }
+
+  boost::uuids::random_generator generator;
+  boost::uuids::uuid peerA;
+  boost::uuids::uuid peerB;
+  Clock::time_point start;
+  std::vector<Crypto::Hash> hashes;
+  std::unordered_map<Crypto::Hash, BlockTemplate> templates;
+  BlockDownloadScheduler scheduler;
+};
+
+}
+
+TEST_F(BlockDownloadSchedulerTest, peersTakeDisjointBatchesFromTheBottom) {
+  ASSERT_TRUE(scheduler.addChain(peerA, 0, chain(CHAIN_LENGTH)));
+  ASSERT_TRUE(scheduler.addChain(peerB, 0, chain(CHAIN_LENGTH)));
+
+  ASSERT_EQ(range(0, BLOCKS_SYNCHRONIZING_DEFAULT_COUNT), scheduler.takeBlocks(peerA, start));
+  ASSERT_EQ(range(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT, BLOCKS_SYNCHRONIZING_DEFAULT_COUNT), scheduler.takeBlocks(peerB, start));
+
+  auto indexes = scheduler.getRequestIndexes(peerB);
+  ASSERT_EQ(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT, indexes.size());
+  ASSERT_EQ(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT, indexes.front());
+}
+
+TEST_F(BlockDownloadSchedulerTest, conflictingChainIsRejected) {
+  ASSERT_TRUE(scheduler.addChain(peerA, 0, chain(CHAIN_LENGTH)));
+
+  auto otherChain = chain(CHAIN_LENGTH);
+  otherChain[CHAIN_LENGTH / 2] = Crypto::Hash();
+  ASSERT_FALSE(scheduler.addChain(peerB, 0, otherChain));
+  ASSERT_FALSE(scheduler.hasPeer(peerB));
+}
+
+TEST_F(BlockDownloadSchedulerTest, blocksArrivingOutOfOrderArePoppedInChainOrder) {
+  ASSERT_TRUE(scheduler.addChain(peerA, 0, chain(CHAIN_LENGTH)));
+  ASSERT_TRUE(scheduler.addChain(peerB, 0, chain(CHAIN_LENGTH)));
+
+  auto requestA = scheduler.takeBlocks(peerA, start);
+  auto requestB = scheduler.takeBlocks(peerB, start);
+  auto requestB2 = scheduler.takeBlocks(peerB, start);
+  ASSERT_EQ(CHAIN_LENGTH, requestA.size() + requestB.size() + requestB2.size());
+
+  // the higher blocks come first and wait for the lowest ones
+  ASSERT_TRUE(scheduler.completeRequest(peerB, respond(peerB, requestB), start + std::chrono::seconds(1)));
+  ASSERT_TRUE(scheduler.completeRequest(peerB, respond(peerB, requestB2), start + std::chrono::seconds(2)));
+  ASSERT_EQ(requestB.size() + requestB2.size(), scheduler.getDownloadedCount());
+  ASSERT_EQ(nullptr, scheduler.popNextBlock());
+
+  // blocks of a response may come in any order
+  std::reverse(requestA.begin(), requestA.end());
+  ASSERT_TRUE(scheduler.completeRequest(peerA, respond(peerA, requestA), start + std::chrono::seconds(3)));
+  ASSERT_EQ(CHAIN_LENGTH, scheduler.getDownloadedCount());
+
+  popAllInOrder(CHAIN_LENGTH);
+  ASSERT_TRUE(scheduler.isDone(peerA));
+  ASSERT_TRUE(scheduler.isDone(peerB));
+}
+
+TEST_F(BlockDownloadSchedulerTest, responseToAnotherRequestIsRejected) {
+  ASSERT_TRUE(scheduler.addChain(peerA, 0, chain(CHAIN_LENGTH)));
+
+  auto first = scheduler.takeBlocks(peerA, start);
+  auto second = scheduler.takeBlocks(peerA, start);
+
+  // responses come in the order of the requests
+  ASSERT_FALSE(scheduler.completeRequest(peerA, respond(peerA, second), start));
+  ASSERT_FALSE(scheduler.completeRequest(peerA, respond(peerA, range(0, first.size() - 1)), start));
+  ASSERT_EQ(0, scheduler.getDownloadedCount());
+
+  ASSERT_TRUE(scheduler.completeRequest(peerA, respond(peerA, first), start));
+  ASSERT_TRUE(scheduler.completeRequest(peerA, respond(peerA, second), start));
+  ASSERT_EQ(first.size() + second.size(), scheduler.getDownloadedCount());
+}
+
+TEST_F(BlockDownloadSchedulerTest, requestsOfDroppedPeerGoToOtherPeers) {
+  const size_t SHORT_CHAIN_LENGTH = 200;
+
+  ASSERT_TRUE(scheduler.addChain(peerA, 0, chain(CHAIN_LENGTH)));
+  ASSERT_TRUE(scheduler.addChain(peerB, 0, chain(SHORT_CHAIN_LENGTH)));
+
+  auto requestA = scheduler.takeBlocks(peerA, start);
+  auto requestA2 = scheduler.takeBlocks(peerA, start);
+  ASSERT_EQ(range(0, requestA.size()), requestA);
+  ASSERT_EQ(2 * BLOCKS_SYNCHRONIZING_DEFAULT_COUNT, requestA.size() + requestA2.size());
+  // everything peerB announced is in flight already
+  ASSERT_TRUE(scheduler.takeBlocks(peerB, start).empty());
+
+  scheduler.removePeer(peerA);
+  ASSERT_FALSE(scheduler.hasPeer(peerA));
+
+  // the responses still on their way are thrown away one by one
+  ASSERT_TRUE(scheduler.takeDiscardedResponse(peerA));
+  ASSERT_TRUE(scheduler.takeDiscardedResponse(peerA));
+  ASSERT_FALSE(scheduler.takeDiscardedResponse(peerA));
+  ASSERT_FALSE(scheduler.completeRequest(peerA, respond(peerA, requestA), start));
+
+  // the blocks only the dropped peer announced are gone, the others are requested again
+  auto retried = scheduler.takeBlocks(peerB, start);
+  ASSERT_EQ(requestA, retried);
+  ASSERT_EQ(range(retried.size(), SHORT_CHAIN_LENGTH - retried.size()), scheduler.takeBlocks(peerB, start));
+  ASSERT_TRUE(scheduler.takeBlocks(peerB, start).empty());
+}
+
+TEST_F(BlockDownloadSchedulerTest, overdueLowestBlocksAreRequestedFromIdlePeer) {
+  ASSERT_TRUE(scheduler.addChain(peerA, 0, chain(CHAIN_LENGTH)));
+  ASSERT_TRUE(scheduler.addChain(peerB, 0, chain(CHAIN_LENGTH)));
+
+  auto stalled = scheduler.takeBlocks(peerA, start);
+  auto requestB = scheduler.takeBlocks(peerB, start);
+  auto requestB2 = scheduler.takeBlocks(peerB, start);
+  ASSERT_EQ(CHAIN_LENGTH, stalled.size() + requestB.size() + requestB2.size());
+
+  // nothing is left to take, and the lowest blocks are not overdue yet
+  auto beforeTimeout = start + std::chrono::seconds(BLOCKS_SYNCHRONIZING_STALL_TIMEOUT - 1);
+  ASSERT_TRUE(scheduler.takeBlocks(peerB, beforeTimeout).empty());
+
+  auto afterTimeout = start + std::chrono::seconds(BLOCKS_SYNCHRONIZING_STALL_TIMEOUT);
+  ASSERT_EQ(stalled, scheduler.takeBlocks(peerB, afterTimeout));
+  // a peer doesn't repeat its own requests
+  ASSERT_TRUE(scheduler.takeBlocks(peerA, afterTimeout).empty());
+
+  ASSERT_TRUE(scheduler.completeRequest(peerB, respond(peerB, requestB), afterTimeout));
+  ASSERT_TRUE(scheduler.completeRequest(peerB, respond(peerB, requestB2), afterTimeout));
+  ASSERT_TRUE(scheduler.completeRequest(peerB, respond(peerB, stalled), afterTimeout));
+  ASSERT_EQ(CHAIN_LENGTH, scheduler.getDownloadedCount());
+  popAllInOrder(CHAIN_LENGTH);
+
+  // the late answer of the stalled peer is accepted and ignored
+  ASSERT_TRUE(scheduler.completeRequest(peerA, respond(peerA, stalled), afterTimeout));
+  ASSERT_EQ(0, scheduler.getDownloadedCount());
+  ASSERT_EQ(nullptr, scheduler.popNextBlock());
+}
+
+TEST_F(BlockDownloadSchedulerTest, overdueBlocksAreRequestedAgainOnlyOnce) {
+  boost::uuids::uuid peerC = generator();
+
+  ASSERT_TRUE(scheduler.addChain(peerA, 0, chain(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT)));
+  ASSERT_TRUE(scheduler.addChain(peerB, 0, chain(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT)));
+  ASSERT_TRUE(scheduler.addChain(peerC, 0, chain(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT)));
+
+  auto stalled = scheduler.takeBlocks(peerA, start);
+  auto afterTimeout = start + std::chrono::seconds(BLOCKS_SYNCHRONIZING_STALL_TIMEOUT);
+  ASSERT_EQ(stalled, scheduler.takeBlocks(peerB, afterTimeout));
+  ASSERT_TRUE(scheduler.takeBlocks(peerC, afterTimeout).empty());
+
+  // once both requests are lost the blocks are free for anybody
+  scheduler.removePeer(peerA);
+  ASSERT_TRUE(scheduler.takeBlocks(peerC, afterTimeout).empty());
+  scheduler.removePeer(peerB);
+  ASSERT_EQ(stalled, scheduler.takeBlocks(peerC, afterTimeout));
+}
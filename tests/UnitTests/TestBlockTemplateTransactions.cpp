@@ -0,0 +1,237 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+#include "CryptoNoteConfig.h"
+#include "CryptoNoteCore/BlockTemplateTransactionsCache.h"
+#include "CryptoNoteCore/CachedTransaction.h"
+#include "CryptoNoteCore/TransactionPool.h"
+#include "CryptoNoteCore/TransactionValidatorState.h"
+#include "crypto/crypto.h"
+#include "crypto/random.h"
+#include "Logging/ConsoleLogger.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const uint64_t INPUT_AMOUNT = 1000000;
+
+// Core::fillBlockTemplate before the pool selected the transactions itself
+void fillBlockTemplateFromPoolCopy(const ITransactionPool& pool, size_t fusionTxMaxSize, size_t medianSize, size_t maxTotalSize,
+  std::vector<Crypto::Hash>& transactionHashes, size_t& transactionsSize, uint64_t& fee) {
+  transactionsSize = 0;
+  fee = 0;
+
+  std::unordered_set<Crypto::KeyImage> spentKeyImages;
+  auto haveSpentInputs = [&spentKeyImages](const Transaction& transaction) {
+    for (const auto& input : transaction.inputs) {
+      if (input.type() == typeid(KeyInput) && !spentKeyImages.insert(boost::get<KeyInput>(input).keyImage).second) {
+        return true;
+      }
+    }
+
+    return false;
+  };
+
+  std::vector<CachedTransaction> poolTransactions = pool.getPoolTransactions();
+  for (auto it = poolTransactions.rbegin(); it != poolTransactions.rend() && it->getTransactionFee() == 0; ++it) {
+    auto transactionBlobSize = it->getTransactionBinaryArray().size();
+    if (fusionTxMaxSize < transactionsSize + transactionBlobSize) {
+      continue;
+    }
+
+    if (!haveSpentInputs(it->getTransaction())) {
+      transactionHashes.emplace_back(it->getTransactionHash());
+      transactionsSize += transactionBlobSize;
+    }
+  }
+
+  for (const auto& cachedTransaction : poolTransactions) {
+    size_t blockSizeLimit = (cachedTransaction.getTransactionFee() == 0) ? medianSize : maxTotalSize;
+    if (blockSizeLimit < transactionsSize + cachedTransaction.getTransactionBinaryArray().size()) {
+      continue;
+    }
+
+    if (!haveSpentInputs(cachedTransaction.getTransaction())) {
+      transactionsSize += cachedTransaction.getTransactionBinaryArray().size();
+      fee += cachedTransaction.getTransactionFee();
+      transactionHashes.emplace_back(cachedTransaction.getTransactionHash());
+    }
+  }
+}
+
+class BlockTemplateTransactionsTest : public ::testing::Test {
+public:
+  BlockTemplateTransactionsTest() : logger(Logging::ERROR), pool(logger) {
+  }
+
+protected:
+  Crypto::Hash push(uint64_t fee, size_t extraSize) {
+    Transaction transaction;
+    transaction.version = TRANSACTION_VERSION_1;
+    transaction.unlockTime = 0;
+    transaction.extra.assign(extraSize, 0);
+
+    KeyInput input;
+    input.amount = INPUT_AMOUNT;
+    input.keyImage = Crypto::rand<Crypto::KeyImage>();
+    input.outputIndexes.assign(3, 1);
+    transaction.inputs.push_back(input);
+    transaction.signatures.emplace_back(input.outputIndexes.size());
+
+    TransactionOutput output;
+    output.amount = INPUT_AMOUNT - fee;
+    output.target = KeyOutput{Crypto::rand<Crypto::PublicKey>()};
+    transaction.outputs.push_back(output);
+
+    TransactionValidatorState state;
+    state.spentKeyImages.insert(input.keyImage);
+
+    CachedTransaction cachedTransaction(std::move(transaction));
+    Crypto::Hash hash = cachedTransaction.getTransactionHash();
+    EXPECT_TRUE(pool.pushTransaction(std::move(cachedTransaction), std::move(state)));
+    return hash;
+  }
+
+  void fillRandomPool(size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      // a quarter pays no fee, like fusion transactions, and fees repeat so ties are broken by size
+      uint64_t fee = Random::randomValue<uint64_t>(0, 3) == 0 ? 0 : Random::randomValue<uint64_t>(1, 10) * 100;
+      push(fee, Random::randomValue<size_t>(0, 2000));
+    }
+  }
+
+  void checkSameAsPoolCopy(size_t fusionTxMaxSize, size_t medianSize, size_t maxTotalSize) {
+    std::vector<Crypto::Hash> expectedHashes;
+    size_t expectedSize;
+    uint64_t expectedFee;
+    fillBlockTemplateFromPoolCopy(pool, fusionTxMaxSize, medianSize, maxTotalSize, expectedHashes, expectedSize, expectedFee);
+
+    std::vector<Crypto::Hash> hashes;
+    size_t size;
+    uint64_t fee;
+    ASSERT_EQ(pool.getVersion(), pool.selectBlockTemplateTransactions(fusionTxMaxSize, medianSize, maxTotalSize, hashes, size, fee));
+
+    ASSERT_EQ(expectedHashes, hashes) << "fusion " << fusionTxMaxSize << ", median " << medianSize << ", total " << maxTotalSize;
+    ASSERT_EQ(expectedSize, size);
+    ASSERT_EQ(expectedFee, fee);
+  }
+
+  bool select(const Crypto::Hash& topBlockHash, size_t medianSize, size_t maxTotalSize, std::vector<Crypto::Hash>& hashes) {
+    size_t size;
+    uint64_t fee;
+    return cache.select(pool, topBlockHash, 10000, medianSize, maxTotalSize, hashes, size, fee);
+  }
+
+  Logging::ConsoleLogger logger;
+  TransactionPool pool;
+  BlockTemplateTransactionsCache cache;
+};
+
+}
+
+TEST_F(BlockTemplateTransactionsTest, emptyPoolSelectsNothing) {
+  checkSameAsPoolCopy(1000, 10000, 12500);
+
+  std::vector<Crypto::Hash> hashes;
+  size_t size = 1;
+  uint64_t fee = 1;
+  pool.selectBlockTemplateTransactions(1000, 10000, 12500, hashes, size, fee);
+  ASSERT_TRUE(hashes.empty());
+  ASSERT_EQ(0, size);
+  ASSERT_EQ(0, fee);
+}
+
+TEST_F(BlockTemplateTransactionsTest, selectionMatchesPreviousCoreAlgorithm) {
+  fillRandomPool(200);
+
+  const size_t limits[] = {0, 100, 500, 1000, 3000, 10000, 30000, 100000, 1000000};
+  for (size_t fusionTxMaxSize : limits) {
+    for (size_t medianSize : limits) {
+      for (size_t maxTotalSize : limits) {
+        checkSameAsPoolCopy(fusionTxMaxSize, medianSize, maxTotalSize);
+      }
+    }
+  }
+}
+
+TEST_F(BlockTemplateTransactionsTest, selectionMatchesPreviousCoreAlgorithmAfterRemovals) {
+  fillRandomPool(100);
+  auto hashes = pool.getTransactionHashes();
+  for (size_t i = 0; i < hashes.size(); i += 3) {
+    ASSERT_TRUE(pool.removeTransaction(hashes[i]));
+  }
+
+  fillRandomPool(20);
+  for (size_t medianSize = 0; medianSize < 60000; medianSize += 777) {
+    checkSameAsPoolCopy(medianSize / 4, medianSize, medianSize * 5 / 4);
+  }
+}
+
+TEST_F(BlockTemplateTransactionsTest, cacheIsReusedWhileNothingChanges) {
+  fillRandomPool(20);
+  auto topBlockHash = Crypto::rand<Crypto::Hash>();
+
+  std::vector<Crypto::Hash> first;
+  std::vector<Crypto::Hash> second;
+  ASSERT_FALSE(select(topBlockHash, 10000, 12500, first));
+  ASSERT_TRUE(select(topBlockHash, 10000, 12500, second));
+  ASSERT_EQ(first, second);
+}
+
+TEST_F(BlockTemplateTransactionsTest, cacheIsInvalidatedByNewTip) {
+  fillRandomPool(20);
+
+  std::vector<Crypto::Hash> hashes;
+  ASSERT_FALSE(select(Crypto::rand<Crypto::Hash>(), 10000, 12500, hashes));
+  ASSERT_FALSE(select(Crypto::rand<Crypto::Hash>(), 10000, 12500, hashes));
+}
+
+TEST_F(BlockTemplateTransactionsTest, cacheIsInvalidatedByPoolChanges) {
+  fillRandomPool(20);
+  auto topBlockHash = Crypto::rand<Crypto::Hash>();
+
+  std::vector<Crypto::Hash> hashes;
+  ASSERT_FALSE(select(topBlockHash, 100000, 125000, hashes));
+
+  auto added = push(INPUT_AMOUNT / 2, 0);
+  ASSERT_FALSE(select(topBlockHash, 100000, 125000, hashes));
+  ASSERT_EQ(1, std::count(hashes.begin(), hashes.end(), added));
+  ASSERT_TRUE(select(topBlockHash, 100000, 125000, hashes));
+
+  ASSERT_TRUE(pool.removeTransaction(added));
+  ASSERT_FALSE(select(topBlockHash, 100000, 125000, hashes));
+  ASSERT_EQ(0, std::count(hashes.begin(), hashes.end(), added));
+}
+
+TEST_F(BlockTemplateTransactionsTest, cacheIsInvalidatedBySizeLimits) {
+  fillRandomPool(20);
+  auto topBlockHash = Crypto::rand<Crypto::Hash>();
+
+  std::vector<Crypto::Hash> hashes;
+  ASSERT_FALSE(select(topBlockHash, 100000, 125000, hashes));
+  ASSERT_FALSE(select(topBlockHash, 1000, 1250, hashes));
+  ASSERT_FALSE(select(topBlockHash, 1000, 1000, hashes));
+  ASSERT_TRUE(select(topBlockHash, 1000, 1000, hashes));
+}
@@ -0,0 +1,185 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+#include "Checkpoints/Checkpoints.h"
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/CachedBlock.h"
+#include "CryptoNoteCore/Core.h"
+#include "CryptoNoteCore/CoreErrors.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/DatabaseBlockchainCacheFactory.h"
+#include "CryptoNoteCore/MinerConfig.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+#include "DataBaseMock.h"
+#include "Logging/ConsoleLogger.h"
+#include "System/Dispatcher.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class CorePoolReorgTest : public ::testing::Test {
+public:
+  CorePoolReorgTest() :
+    logger(Logging::ERROR),
+    currency(CurrencyBuilder(logger).currency()),
+    mainCore(createCore(mainDatabase)),
+    altCore(createCore(altDatabase))
+  {
+    miner.generate();
+    startTimestamp = time(nullptr) - 1000 * currency.difficultyTarget();
+  }
+
+  virtual void SetUp() override {
+    mainCore->load(MinerConfig());
+    altCore->load(MinerConfig());
+  }
+
+protected:
+  std::unique_ptr<Core> createCore(DataBaseMock& database) {
+    return std::unique_ptr<Core>(new Core(currency, logger, Checkpoints(logger), dispatcher,
+      std::unique_ptr<IBlockchainCacheFactory>(new DatabaseBlockchainCacheFactory(database, logger)), 1));
+  }
+
+  // A block on top of the core's main chain with the transactions of its pool
+  BlockTemplate mineBlock(Core& core) {
+    BlockTemplate block;
+    Difficulty difficulty;
+    uint32_t height;
+    if (!core.getBlockTemplate(block, miner.getAccountKeys().address, BinaryArray(), difficulty, height)) {
+      throw std::runtime_error("Failed to create block template");
+    }
+
+    // keep the blocks at the target pace so the difficulty stays low
+    block.timestamp = startTimestamp + height * currency.difficultyTarget();
+
+    Crypto::cn_context context;
+    while (!currency.checkProofOfWork(context, CachedBlock(block), difficulty)) {
+      ++block.nonce;
+    }
+
+    return block;
+  }
+
+  void submitBlock(Core& core, const BlockTemplate& block, error::AddBlockErrorCode expected) {
+    ASSERT_EQ(make_error_code(expected), core.submitBlock(toBinaryArray(block)));
+  }
+
+  // Spends the biggest output of the block's miner transaction back to the miner
+  Transaction spendMinerOutput(Core& core, const BlockTemplate& block) {
+    const Transaction& baseTransaction = block.baseTransaction;
+    std::vector<uint32_t> globalIndexes;
+    if (!core.getTransactionGlobalIndexes(getObjectHash(baseTransaction), globalIndexes)) {
+      throw std::runtime_error("Failed to get global indexes of the miner transaction");
+    }
+
+    size_t outputIndex = 0;
+    for (size_t i = 1; i < baseTransaction.outputs.size(); ++i) {
+      if (baseTransaction.outputs[i].amount > baseTransaction.outputs[outputIndex].amount) {
+        outputIndex = i;
+      }
+    }
+
+    const TransactionOutput& output = baseTransaction.outputs[outputIndex];
+    TransactionSourceEntry source;
+    source.outputs.emplace_back(globalIndexes[outputIndex], boost::get<KeyOutput>(output.target).key);
+    source.realOutput = 0;
+    source.realTransactionPublicKey = getTransactionPublicKeyFromExtra(baseTransaction.extra);
+    source.realOutputIndexInTransaction = outputIndex;
+    source.amount = output.amount;
+
+    std::vector<uint64_t> amounts;
+    decomposeAmount(output.amount - currency.minimumFee(), currency.defaultDustThreshold(), amounts);
+    std::vector<TransactionDestinationEntry> destinations;
+    for (uint64_t amount : amounts) {
+      destinations.push_back(TransactionDestinationEntry{ amount, miner.getAccountKeys().address });
+    }
+
+    Transaction transaction;
+    Crypto::SecretKey transactionKey;
+    if (!constructTransaction(miner.getAccountKeys(), { source }, destinations, {}, transaction, 0, transactionKey, logger)) {
+      throw std::runtime_error("Failed to construct transaction");
+    }
+
+    return transaction;
+  }
+
+  System::Dispatcher dispatcher;
+  Logging::ConsoleLogger logger;
+  Currency currency;
+  DataBaseMock mainDatabase;
+  DataBaseMock altDatabase;
+  std::unique_ptr<Core> mainCore;
+  std::unique_ptr<Core> altCore;
+  AccountBase miner;
+  uint64_t startTimestamp;
+};
+
+}
+
+TEST_F(CorePoolReorgTest, transactionMinedBelowNewTopIsRemovedFromPool) {
+  // both cores share the chain up to the split point, where the first miner reward is unlocked
+  BlockTemplate rewardBlock;
+  for (uint32_t i = 0; i <= currency.minedMoneyUnlockWindow(); ++i) {
+    BlockTemplate block = mineBlock(*mainCore);
+    submitBlock(*mainCore, block, error::AddBlockErrorCode::ADDED_TO_MAIN);
+    submitBlock(*altCore, block, error::AddBlockErrorCode::ADDED_TO_MAIN);
+    if (i == 0) {
+      rewardBlock = block;
+    }
+  }
+
+  Transaction transaction = spendMinerOutput(*mainCore, rewardBlock);
+  Crypto::Hash transactionHash = getObjectHash(transaction);
+
+  // the main chain grows by an empty block while the transaction waits in the pool
+  BlockTemplate mainBlock = mineBlock(*mainCore);
+  submitBlock(*mainCore, mainBlock, error::AddBlockErrorCode::ADDED_TO_MAIN);
+  ASSERT_TRUE(mainCore->addTransactionToPool(toBinaryArray(transaction)));
+
+  // the alternative chain mines the transaction and then an empty block on top of it
+  ASSERT_TRUE(altCore->addTransactionToPool(toBinaryArray(transaction)));
+  BlockTemplate altBlock1 = mineBlock(*altCore);
+  ASSERT_EQ(1, altBlock1.transactionHashes.size());
+  submitBlock(*altCore, altBlock1, error::AddBlockErrorCode::ADDED_TO_MAIN);
+  BlockTemplate altBlock2 = mineBlock(*altCore);
+  ASSERT_TRUE(altBlock2.transactionHashes.empty());
+  submitBlock(*altCore, altBlock2, error::AddBlockErrorCode::ADDED_TO_MAIN);
+
+  submitBlock(*mainCore, altBlock1, error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE);
+  ASSERT_EQ(1, mainCore->getPoolTransactionsCount());
+
+  submitBlock(*mainCore, altBlock2, error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE_AND_SWITCHED);
+  ASSERT_EQ(CachedBlock(altBlock2).getBlockHash(), mainCore->getTopBlockHash());
+
+  // the transaction is in the new main chain, so it must not be offered to the block template again
+  auto poolHashes = mainCore->getPoolTransactionHashes();
+  ASSERT_EQ(poolHashes.end(), std::find(poolHashes.begin(), poolHashes.end(), transactionHash));
+  BlockTemplate nextBlock = mineBlock(*mainCore);
+  ASSERT_TRUE(nextBlock.transactionHashes.empty());
+  submitBlock(*mainCore, nextBlock, error::AddBlockErrorCode::ADDED_TO_MAIN);
+}
@@ -17,8 +17,13 @@
 
 #include "gtest/gtest.h"
 
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
 #include "crypto/crypto.h"
 
+#include "CryptoNoteConfig.h"
 #include "CryptoNoteCore/BlockchainCache.h"
 #include <CryptoNoteCore/DatabaseBlockchainCache.h>
 #include "CryptoNoteCore/CryptoNoteTools.h"
@@ -186,3 +191,129 @@ TEST_F(DatabaseBlockchainCacheTests, RawBlocksWithTxsSerialization) {
   ASSERT_EQ(deserializedRawBlock.block, rawBlock.block);
   ASSERT_EQ(deserializedRawBlock.transactions, rawBlock.transactions);
 }
+
+TEST_F(DatabaseBlockchainCacheTests, GetRandomOutsByAmountsReturnsNothingForUnknownAmount) {
+  const uint64_t UNKNOWN_AMOUNT = 123456789;
+  ASSERT_EQ(0, countOutputsForAmount().count(UNKNOWN_AMOUNT));
+
+  std::vector<RandomOutputsForAmount> outs;
+  ASSERT_NO_THROW(outs = blockchain.getRandomOutsByAmounts({ UNKNOWN_AMOUNT }, 10, blockchain.getTopBlockIndex()));
+  ASSERT_EQ(1, outs.size());
+  ASSERT_EQ(UNKNOWN_AMOUNT, outs.front().amount);
+  ASSERT_TRUE(outs.front().globalIndexes.empty());
+  ASSERT_TRUE(outs.front().publicKeys.empty());
+
+  ASSERT_TRUE(blockchain.getRandomOutsByAmount(UNKNOWN_AMOUNT, 10, blockchain.getTopBlockIndex()).empty());
+}
+
+namespace {
+
+class DatabaseBlockchainCacheIndexCacheTests : public DatabaseBlockchainCacheTests {
+public:
+  void SetUp() override {
+    DatabaseBlockchainCacheTests::SetUp();
+    cacheDirectory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("test_index_cache_%%%%%%%%%%%%");
+    boost::filesystem::create_directory(cacheDirectory);
+  }
+
+  void TearDown() override {
+    boost::system::error_code ignoredErrorCode;
+    boost::filesystem::remove_all(cacheDirectory, ignoredErrorCode);
+    DatabaseBlockchainCacheTests::TearDown();
+  }
+
+  std::string cachePath() const {
+    return (cacheDirectory / parameters::BLOCK_INDEXES_CACHE_FILENAME).string();
+  }
+
+  std::unique_ptr<DatabaseBlockchainCache> openCached() {
+    return std::unique_ptr<DatabaseBlockchainCache>(
+      new DatabaseBlockchainCache(currency, database, blockchainCacheFactory, logger, cacheDirectory.string()));
+  }
+
+  // blockchain has no index cache, so it reads everything from the database
+  void checkServedAsDatabase(const DatabaseBlockchainCache& cached) {
+    size_t blockCount = blockchain.getTopBlockIndex() + 1;
+    ASSERT_EQ(blockchain.getBlockHashes(0, blockCount), cached.getBlockHashes(0, blockCount));
+    ASSERT_EQ(blockchain.getLastTimestamps(blockCount), cached.getLastTimestamps(blockCount));
+    ASSERT_EQ(blockchain.getLastCumulativeDifficulties(blockCount), cached.getLastCumulativeDifficulties(blockCount));
+  }
+
+  // a record long run of flipped bytes in the middle of the file hits every field of some entry
+  static void damageMiddleEntry(const std::string& path) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekg(0, std::ios::end);
+    std::streamoff middle = file.tellg() / 2;
+
+    std::vector<char> bytes(sizeof(CachedBlockInfo));
+    file.seekg(middle);
+    file.read(bytes.data(), bytes.size());
+    for (auto& byte : bytes) {
+      byte = ~byte;
+    }
+
+    file.seekp(middle);
+    file.write(bytes.data(), bytes.size());
+  }
+
+  boost::filesystem::path cacheDirectory;
+};
+
+}
+
+TEST_F(DatabaseBlockchainCacheIndexCacheTests, ReopenedIndexCacheMatchesDatabase) {
+  // fills the cache from the database and closes it cleanly
+  openCached();
+  ASSERT_TRUE(boost::filesystem::exists(cachePath()));
+
+  auto cached = openCached();
+  checkServedAsDatabase(*cached);
+}
+
+TEST_F(DatabaseBlockchainCacheIndexCacheTests, CorruptedIndexCacheIsRebuilt) {
+  openCached();
+  damageMiddleEntry(cachePath());
+
+  auto cached = openCached();
+  checkServedAsDatabase(*cached);
+}
+
+TEST_F(DatabaseBlockchainCacheIndexCacheTests, TruncatedIndexCacheIsRebuilt) {
+  openCached();
+  boost::filesystem::resize_file(cachePath(), boost::filesystem::file_size(cachePath()) / 2);
+
+  auto cached = openCached();
+  checkServedAsDatabase(*cached);
+}
+
+TEST_F(DatabaseBlockchainCacheIndexCacheTests, IndexCacheLeftByCrashIsRebuilt) {
+  std::string crashedCopy = cachePath() + ".crashed";
+  {
+    auto cached = openCached();
+    // what a power loss leaves behind: the file as it is while in use, with a stale entry in the middle
+    boost::filesystem::copy_file(cachePath(), crashedCopy);
+  }
+
+  damageMiddleEntry(crashedCopy);
+  boost::filesystem::remove(cachePath());
+  boost::filesystem::rename(crashedCopy, cachePath());
+
+  auto cached = openCached();
+  checkServedAsDatabase(*cached);
+}
+
+TEST_F(DatabaseBlockchainCacheIndexCacheTests, SavedSpentKeyImageFilterReplacesOldFile) {
+  auto filterPath = cacheDirectory / parameters::SPENT_KEY_IMAGES_FILTER_FILENAME;
+  {
+    std::ofstream oldFile(filterPath.string(), std::ios::binary);
+    oldFile << "stale";
+  }
+
+  auto cached = openCached();
+  cached->save();
+
+  ASSERT_GT(boost::filesystem::file_size(filterPath), 5);
+  for (boost::filesystem::directory_iterator it(cacheDirectory), end; it != end; ++it) {
+    ASSERT_EQ(std::string::npos, it->path().filename().string().find(".tmp")) << it->path();
+  }
+}
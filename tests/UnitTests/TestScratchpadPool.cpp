@@ -0,0 +1,207 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <fstream>
+#include <new>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+#include "crypto/scratchpad-pool.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace Crypto;
+
+namespace {
+
+std::set<void*> getScratchpadSet(cn_context& context, size_t count) {
+  void* const* scratchpads = context.getScratchpads(count);
+  return std::set<void*>(scratchpads, scratchpads + count);
+}
+
+// takes every free scratchpad out of the pool, so the next acquire has to allocate
+std::vector<void*> drainPool() {
+  std::vector<void*> scratchpads;
+  while (ScratchpadPool::instance().getStatistics().freeScratchpads > 0) {
+    scratchpads.push_back(ScratchpadPool::instance().acquire());
+  }
+
+  return scratchpads;
+}
+
+void releaseAll(const std::vector<void*>& scratchpads) {
+  for (void* scratchpad : scratchpads) {
+    ScratchpadPool::instance().release(scratchpad);
+  }
+}
+
+}
+
+TEST(ScratchpadPool, contextKeepsItsScratchpads) {
+  cn_context context;
+  void* first = context.getScratchpads(1)[0];
+
+  // asking for more keeps the ones handed out already
+  void* const* scratchpads = context.getScratchpads(3);
+  ASSERT_EQ(first, scratchpads[0]);
+  ASSERT_EQ(3, std::set<void*>(scratchpads, scratchpads + 3).size());
+
+  ASSERT_EQ(first, context.getScratchpads(1)[0]);
+}
+
+TEST(ScratchpadPool, releasedScratchpadsAreReused) {
+  const size_t COUNT = 3;
+
+  std::set<void*> released;
+  {
+    cn_context context;
+    released = getScratchpadSet(context, COUNT);
+  }
+
+  auto before = ScratchpadPool::instance().getStatistics();
+  ASSERT_GE(before.freeScratchpads, COUNT);
+
+  cn_context context;
+  auto reused = getScratchpadSet(context, COUNT);
+  auto after = ScratchpadPool::instance().getStatistics();
+
+  ASSERT_EQ(before.scratchpads, after.scratchpads);
+  ASSERT_EQ(before.freeScratchpads - COUNT, after.freeScratchpads);
+  // the pool holds a single node here, so the last released come back first
+  if (numaNodeCount() == 1) {
+    ASSERT_EQ(released, reused);
+  }
+}
+
+TEST(ScratchpadPool, scratchpadsAreNotSharedBetweenContexts) {
+  cn_context first;
+  cn_context second;
+
+  auto firstScratchpads = getScratchpadSet(first, 2);
+  for (void* scratchpad : getScratchpadSet(second, 2)) {
+    ASSERT_EQ(0, firstScratchpads.count(scratchpad));
+  }
+}
+
+TEST(ScratchpadPool, contextStillHashesWithReusedScratchpad) {
+  const char data[] = "de omnibus dubitandum";
+  Hash expected;
+  Hash actual;
+
+  {
+    cn_context context;
+    cn_slow_hash(context, data, sizeof(data) - 1, expected);
+  }
+
+  cn_context context;
+  cn_slow_hash(context, data, sizeof(data) - 1, actual);
+  ASSERT_EQ(expected, actual);
+}
+
+#if defined(__linux__)
+TEST(ScratchpadPool, exhaustedPoolThrowsAndFreeScratchpadIsStillHandedOut) {
+  auto held = drainPool();
+  held.push_back(ScratchpadPool::instance().acquire());
+  size_t allocated = ScratchpadPool::instance().getStatistics().scratchpads;
+
+  // leave too little address space for another scratchpad
+  long pageSize = sysconf(_SC_PAGESIZE);
+  size_t pages = 0;
+  std::ifstream("/proc/self/statm") >> pages;
+  rlimit original;
+  ASSERT_EQ(0, getrlimit(RLIMIT_AS, &original));
+  rlimit limited = original;
+  limited.rlim_cur = pages * pageSize + SLOW_HASH_SCRATCHPAD_SIZE / 2;
+  ASSERT_EQ(0, setrlimit(RLIMIT_AS, &limited));
+
+  bool exhausted = false;
+  try {
+    ScratchpadPool::instance().acquire();
+  } catch (std::bad_alloc&) {
+    exhausted = true;
+  }
+
+  // a released scratchpad is handed out without a new allocation
+  ScratchpadPool::instance().release(held.back());
+  void* reused = ScratchpadPool::instance().acquire();
+
+  ASSERT_EQ(0, setrlimit(RLIMIT_AS, &original));
+
+  ASSERT_TRUE(exhausted);
+  ASSERT_EQ(held.back(), reused);
+  ASSERT_EQ(allocated, ScratchpadPool::instance().getStatistics().scratchpads);
+  releaseAll(held);
+}
+
+TEST(ScratchpadPool, numaNodeBindingRestoresPreviousMask) {
+  std::thread thread([] {
+    cpu_set_t original;
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(original), &original));
+
+    // a mask the binding is unlikely to match, so its restoration shows
+    cpu_set_t single;
+    CPU_ZERO(&single);
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &original)) {
+        CPU_SET(cpu, &single);
+        break;
+      }
+    }
+
+    ASSERT_EQ(0, sched_setaffinity(0, sizeof(single), &single));
+
+    {
+      // not bound where the kernel doesn't list the CPUs of the node, the mask must survive either way
+      NumaNodeBinding binding(currentNumaNode());
+    }
+
+    cpu_set_t restored;
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(restored), &restored));
+    ASSERT_TRUE(CPU_EQUAL(&single, &restored));
+  });
+
+  thread.join();
+}
+
+TEST(ScratchpadPool, numaNodeBindingToMissingNodeLeavesMaskAlone) {
+  std::thread thread([] {
+    cpu_set_t original;
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(original), &original));
+
+    {
+      NumaNodeBinding binding(1 << 20);
+      ASSERT_FALSE(binding.isBound());
+    }
+
+    cpu_set_t after;
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(after), &after));
+    ASSERT_TRUE(CPU_EQUAL(&original, &after));
+  });
+
+  thread.join();
+}
+#endif
@@ -0,0 +1,183 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <vector>
+
+#include "Common/StdInputStream.h"
+#include "Common/StdOutputStream.h"
+#include "CryptoNoteCore/SpentKeyImageFilter.h"
+#include "crypto/crypto.h"
+#include "crypto/random.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+// the first layer of the filter takes this many key images before a second one is added
+const size_t FIRST_LAYER_CAPACITY = 1 << 20;
+
+std::vector<Crypto::KeyImage> generateKeyImages(size_t count) {
+  std::vector<Crypto::KeyImage> keyImages(count);
+  Random::randomBytes(count * sizeof(Crypto::KeyImage), reinterpret_cast<uint8_t*>(keyImages.data()));
+  return keyImages;
+}
+
+Crypto::Hash generateHash() {
+  Crypto::Hash hash;
+  Random::randomBytes(sizeof(hash), hash.data);
+  return hash;
+}
+
+}
+
+TEST(SpentKeyImageFilter, emptyFilterContainsNothing) {
+  SpentKeyImageFilter filter;
+  for (const auto& keyImage : generateKeyImages(1000)) {
+    ASSERT_FALSE(filter.mayContain(keyImage));
+  }
+}
+
+TEST(SpentKeyImageFilter, noFalseNegativesWhileLayersAreAdded) {
+  SpentKeyImageFilter filter;
+  size_t firstLayerMemory = filter.getMemoryUsage();
+
+  auto keyImages = generateKeyImages(FIRST_LAYER_CAPACITY * 3 / 2);
+  for (const auto& keyImage : keyImages) {
+    filter.add(keyImage);
+  }
+
+  ASSERT_GT(filter.getMemoryUsage(), firstLayerMemory);
+  ASSERT_EQ(keyImages.size(), filter.getKeyImageCount());
+  for (const auto& keyImage : keyImages) {
+    ASSERT_TRUE(filter.mayContain(keyImage));
+  }
+}
+
+TEST(SpentKeyImageFilter, falsePositivesStayRare) {
+  const size_t KEY_IMAGE_COUNT = 100000;
+
+  SpentKeyImageFilter filter;
+  for (const auto& keyImage : generateKeyImages(KEY_IMAGE_COUNT)) {
+    filter.add(keyImage);
+  }
+
+  size_t falsePositives = 0;
+  for (const auto& keyImage : generateKeyImages(KEY_IMAGE_COUNT)) {
+    if (filter.mayContain(keyImage)) {
+      ++falsePositives;
+    }
+  }
+
+  ASSERT_LT(falsePositives, KEY_IMAGE_COUNT / 50);
+}
+
+TEST(SpentKeyImageFilter, serializationRoundTrip) {
+  SpentKeyImageFilter filter;
+  auto keyImages = generateKeyImages(FIRST_LAYER_CAPACITY + 1000);
+  for (const auto& keyImage : keyImages) {
+    filter.add(keyImage);
+  }
+
+  auto lastBlockHash = generateHash();
+  filter.setTop(12345, lastBlockHash);
+  filter.markRemoved(100);
+
+  std::stringstream stream;
+  {
+    Common::StdOutputStream output(stream);
+    BinaryOutputStreamSerializer s(output);
+    filter.serialize(s);
+  }
+
+  SpentKeyImageFilter loaded;
+  {
+    Common::StdInputStream input(stream);
+    BinaryInputStreamSerializer s(input);
+    loaded.serialize(s);
+  }
+
+  ASSERT_EQ(12345, loaded.getBlockCount());
+  ASSERT_EQ(lastBlockHash, loaded.getLastBlockHash());
+  ASSERT_EQ(filter.getKeyImageCount(), loaded.getKeyImageCount());
+  ASSERT_EQ(filter.getMemoryUsage(), loaded.getMemoryUsage());
+
+  for (const auto& keyImage : keyImages) {
+    ASSERT_TRUE(loaded.mayContain(keyImage));
+  }
+
+  // the seed is kept, so even the false positives are the same
+  for (const auto& keyImage : generateKeyImages(10000)) {
+    ASSERT_EQ(filter.mayContain(keyImage), loaded.mayContain(keyImage));
+  }
+}
+
+TEST(SpentKeyImageFilter, loadingOtherVersionThrows) {
+  std::stringstream stream;
+  {
+    Common::StdOutputStream output(stream);
+    BinaryOutputStreamSerializer s(output);
+    uint32_t version = 1000;
+    s(version, "version");
+  }
+
+  SpentKeyImageFilter loaded;
+  Common::StdInputStream input(stream);
+  BinaryInputStreamSerializer s(input);
+  ASSERT_ANY_THROW(loaded.serialize(s));
+}
+
+TEST(SpentKeyImageFilter, worthRebuildingOnceAQuarterIsRemoved) {
+  SpentKeyImageFilter filter;
+  for (const auto& keyImage : generateKeyImages(100)) {
+    filter.add(keyImage);
+  }
+
+  ASSERT_FALSE(filter.isWorthRebuilding());
+
+  filter.markRemoved(20);
+  ASSERT_FALSE(filter.isWorthRebuilding());
+
+  filter.markRemoved(5);
+  ASSERT_FALSE(filter.isWorthRebuilding());
+
+  filter.markRemoved(1);
+  ASSERT_TRUE(filter.isWorthRebuilding());
+
+  filter.clear();
+  ASSERT_FALSE(filter.isWorthRebuilding());
+  ASSERT_EQ(0, filter.getKeyImageCount());
+  ASSERT_EQ(0, filter.getBlockCount());
+}
+
+TEST(SpentKeyImageFilter, removedKeyImagesStayInFilter) {
+  SpentKeyImageFilter filter;
+  auto keyImages = generateKeyImages(100);
+  for (const auto& keyImage : keyImages) {
+    filter.add(keyImage);
+  }
+
+  filter.markRemoved(keyImages.size());
+  for (const auto& keyImage : keyImages) {
+    ASSERT_TRUE(filter.mayContain(keyImage));
+  }
+}
@@ -0,0 +1,231 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <limits>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+#include "CryptoNoteCore/CachedTransaction.h"
+#include "CryptoNoteCore/TransactionPool.h"
+#include "CryptoNoteCore/TransactionValidatorState.h"
+#include "CryptoNoteConfig.h"
+#include "crypto/crypto.h"
+#include "crypto/random.h"
+#include "Logging/ConsoleLogger.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const uint64_t INPUT_AMOUNT = 1000000;
+
+typedef std::pair<uint64_t, uint32_t> SpentMultisignatureOutput;
+
+Crypto::KeyImage generateKeyImage() {
+  Crypto::KeyImage keyImage;
+  Random::randomBytes(sizeof(keyImage), reinterpret_cast<uint8_t*>(&keyImage));
+  return keyImage;
+}
+
+class TransactionPoolIndexesTest : public ::testing::Test {
+public:
+  TransactionPoolIndexesTest() : logger(Logging::ERROR), pool(logger) {
+  }
+
+protected:
+  // a transaction spending the key images with the given mixin, padded by extraSize bytes of extra
+  Crypto::Hash push(const std::vector<Crypto::KeyImage>& keyImages, uint64_t mixin = 3, size_t extraSize = 0,
+    const std::vector<SpentMultisignatureOutput>& multisignatureOutputs = {}, uint64_t fee = 1000) {
+    Transaction transaction;
+    transaction.version = TRANSACTION_VERSION_1;
+    transaction.unlockTime = 0;
+    transaction.extra.assign(extraSize, 0);
+
+    TransactionValidatorState state;
+    uint64_t inputAmount = 0;
+    for (const auto& keyImage : keyImages) {
+      KeyInput input;
+      input.amount = INPUT_AMOUNT;
+      input.keyImage = keyImage;
+      input.outputIndexes.assign(mixin, 1);
+      transaction.inputs.push_back(input);
+      transaction.signatures.emplace_back(mixin);
+      state.spentKeyImages.insert(keyImage);
+      inputAmount += input.amount;
+    }
+
+    for (const auto& output : multisignatureOutputs) {
+      MultisignatureInput input;
+      input.amount = output.first;
+      input.outputIndex = output.second;
+      input.signatureCount = 1;
+      transaction.inputs.push_back(input);
+      transaction.signatures.emplace_back(input.signatureCount);
+      state.spentMultisignatureGlobalIndexes.insert(output);
+      inputAmount += input.amount;
+    }
+
+    TransactionOutput output;
+    output.amount = inputAmount - fee;
+    output.target = KeyOutput{Crypto::rand<Crypto::PublicKey>()};
+    transaction.outputs.push_back(output);
+
+    CachedTransaction cachedTransaction(std::move(transaction));
+    Crypto::Hash hash = cachedTransaction.getTransactionHash();
+    EXPECT_TRUE(pool.pushTransaction(std::move(cachedTransaction), std::move(state)));
+    return hash;
+  }
+
+  // what Core::checkAndRemoveInvalidPoolTransactions does with the hashes the indexes return
+  void evict(const std::vector<Crypto::Hash>& hashes) {
+    for (const auto& hash : hashes) {
+      ASSERT_TRUE(pool.removeTransaction(hash));
+    }
+  }
+
+  std::set<Crypto::Hash> getPoolHashes() const {
+    auto hashes = pool.getTransactionHashes();
+    return std::set<Crypto::Hash>(hashes.begin(), hashes.end());
+  }
+
+  Logging::ConsoleLogger logger;
+  TransactionPool pool;
+};
+
+}
+
+TEST_F(TransactionPoolIndexesTest, transactionsSpendingBlockOutputsAreEvicted) {
+  auto keyImages = std::vector<Crypto::KeyImage>{generateKeyImage(), generateKeyImage(), generateKeyImage(), generateKeyImage()};
+  auto twoInputs = push({keyImages[0], keyImages[1]});
+  auto oneInput = push({keyImages[2]});
+  auto multisignature = push({}, 0, 0, {SpentMultisignatureOutput(INPUT_AMOUNT, 5)});
+  auto untouched = push({keyImages[3]}, 3, 0, {SpentMultisignatureOutput(INPUT_AMOUNT, 6)});
+
+  TransactionValidatorState blockState;
+  blockState.spentKeyImages = {keyImages[0], keyImages[1], keyImages[2], generateKeyImage()};
+  blockState.spentMultisignatureGlobalIndexes = {SpentMultisignatureOutput(INPUT_AMOUNT, 5), SpentMultisignatureOutput(INPUT_AMOUNT, 7)};
+
+  // each transaction once, however many of its inputs the block spends
+  auto conflicting = pool.getTransactionHashesSpendingOutputs(blockState);
+  ASSERT_EQ(3, conflicting.size());
+  ASSERT_EQ((std::set<Crypto::Hash>{twoInputs, oneInput, multisignature}), std::set<Crypto::Hash>(conflicting.begin(), conflicting.end()));
+
+  evict(conflicting);
+  ASSERT_EQ(std::set<Crypto::Hash>{untouched}, getPoolHashes());
+  ASSERT_TRUE(pool.getTransactionHashesSpendingOutputs(blockState).empty());
+
+  const auto& poolState = pool.getPoolTransactionValidationState();
+  ASSERT_EQ(std::unordered_set<Crypto::KeyImage>{keyImages[3]}, poolState.spentKeyImages);
+  ASSERT_EQ(std::set<SpentMultisignatureOutput>{SpentMultisignatureOutput(INPUT_AMOUNT, 6)}, poolState.spentMultisignatureGlobalIndexes);
+
+  // the evicted outputs are free again and indexed for their new spender
+  auto respent = push({keyImages[1]}, 3, 0, {SpentMultisignatureOutput(INPUT_AMOUNT, 5)});
+  TransactionValidatorState respentState;
+  respentState.spentKeyImages = {keyImages[1]};
+  ASSERT_EQ(std::vector<Crypto::Hash>{respent}, pool.getTransactionHashesSpendingOutputs(respentState));
+  respentState.spentKeyImages.clear();
+  respentState.spentMultisignatureGlobalIndexes = {SpentMultisignatureOutput(INPUT_AMOUNT, 5)};
+  ASSERT_EQ(std::vector<Crypto::Hash>{respent}, pool.getTransactionHashesSpendingOutputs(respentState));
+}
+
+TEST_F(TransactionPoolIndexesTest, oversizedTransactionsAreEvicted) {
+  std::vector<Crypto::Hash> small;
+  std::vector<Crypto::Hash> big;
+  for (size_t i = 0; i < 4; ++i) {
+    small.push_back(push({generateKeyImage()}, 3, i * 10));
+    big.push_back(push({generateKeyImage()}, 3, 1000 + i * 10));
+  }
+
+  size_t sizeLimit = 0;
+  for (const auto& hash : small) {
+    sizeLimit = std::max(sizeLimit, pool.getTransaction(hash).getTransactionBinaryArray().size());
+  }
+
+  auto oversized = pool.getTransactionHashesBiggerThan(sizeLimit);
+  ASSERT_EQ(std::set<Crypto::Hash>(big.begin(), big.end()), std::set<Crypto::Hash>(oversized.begin(), oversized.end()));
+
+  evict(oversized);
+  ASSERT_EQ(std::set<Crypto::Hash>(small.begin(), small.end()), getPoolHashes());
+  ASSERT_TRUE(pool.getTransactionHashesBiggerThan(sizeLimit).empty());
+  ASSERT_EQ(small.size(), pool.getTransactionHashesBiggerThan(0).size());
+}
+
+TEST_F(TransactionPoolIndexesTest, transactionsOutsideMixinLimitsAreEvicted) {
+  const uint64_t MIN_MIXIN = 2;
+  const uint64_t MAX_MIXIN = 4;
+
+  std::set<Crypto::Hash> allowed;
+  std::set<Crypto::Hash> outside;
+  for (uint64_t mixin = 0; mixin <= 6; ++mixin) {
+    auto hash = push({generateKeyImage(), generateKeyImage()}, mixin);
+    if (mixin >= MIN_MIXIN && mixin <= MAX_MIXIN) {
+      allowed.insert(hash);
+    } else {
+      outside.insert(hash);
+    }
+  }
+
+  ASSERT_TRUE(pool.getTransactionHashesByMixin(MAX_MIXIN, MIN_MIXIN).empty());
+
+  auto found = pool.getTransactionHashesByMixin(MIN_MIXIN, MAX_MIXIN);
+  ASSERT_EQ(allowed, std::set<Crypto::Hash>(found.begin(), found.end()));
+
+  auto tooSmall = pool.getTransactionHashesByMixin(0, MIN_MIXIN - 1);
+  auto tooBig = pool.getTransactionHashesByMixin(MAX_MIXIN + 1, std::numeric_limits<uint64_t>::max());
+  std::set<Crypto::Hash> evicted(tooSmall.begin(), tooSmall.end());
+  evicted.insert(tooBig.begin(), tooBig.end());
+  ASSERT_EQ(outside, evicted);
+
+  evict(tooSmall);
+  evict(tooBig);
+  ASSERT_EQ(allowed, getPoolHashes());
+
+  ASSERT_TRUE(pool.getTransactionHashesByMixin(0, MIN_MIXIN - 1).empty());
+  ASSERT_TRUE(pool.getTransactionHashesByMixin(MAX_MIXIN + 1, std::numeric_limits<uint64_t>::max()).empty());
+}
+
+TEST_F(TransactionPoolIndexesTest, evictionThroughSeveralIndexesRemovesTransactionOnce) {
+  auto keyImage = generateKeyImage();
+  auto spentAndBig = push({keyImage}, 3, 2000);
+  auto kept = push({generateKeyImage()});
+
+  TransactionValidatorState blockState;
+  blockState.spentKeyImages = {keyImage};
+
+  std::unordered_set<Crypto::Hash> invalid;
+  for (const auto& hash : pool.getTransactionHashesSpendingOutputs(blockState)) {
+    invalid.insert(hash);
+  }
+
+  for (const auto& hash : pool.getTransactionHashesBiggerThan(1000)) {
+    invalid.insert(hash);
+  }
+
+  ASSERT_EQ(1, invalid.size());
+  uint64_t version = pool.getVersion();
+  evict(std::vector<Crypto::Hash>(invalid.begin(), invalid.end()));
+  ASSERT_NE(version, pool.getVersion());
+  ASSERT_FALSE(pool.removeTransaction(spentAndBig));
+
+  ASSERT_EQ(std::set<Crypto::Hash>{kept}, getPoolHashes());
+  ASSERT_FALSE(pool.checkIfTransactionPresent(spentAndBig));
+  ASSERT_TRUE(pool.getTransactionHashesBiggerThan(1000).empty());
+}
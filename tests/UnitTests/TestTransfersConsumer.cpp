@@ -23,6 +23,8 @@
 
 #include <algorithm>
 #include <limits>
+#include <set>
+#include <thread>
 #include <Transfers/CommonTypes.h>
 #include <CryptoNoteCore/TransactionApi.h>
 
@@ -806,6 +808,107 @@ TEST_F(TransfersConsumerTest, onNewBlocks_manyBlocks) {
  ASSERT_EQ(expectedAmount, container.balance(ITransfersContainer::IncludeAll));
 }
 
+class ThreadRecordingTransfersObserver : public TransfersObserver {
+public:
+  virtual void onTransactionUpdated(ITransfersSubscription* object, const Hash& transactionHash) override {
+    TransfersObserver::onTransactionUpdated(object, transactionHash);
+    threads.push_back(std::this_thread::get_id());
+  }
+
+  std::vector<std::thread::id> threads;
+};
+
+class ContainersRecordingConsumerObserver : public IBlockchainConsumerObserver {
+public:
+  virtual void onTransactionUpdated(IBlockchainConsumer* consumer, const Hash& transactionHash,
+    const std::vector<ITransfersContainer*>& containers) override {
+    updated.emplace_back(transactionHash, containers);
+    threads.push_back(std::this_thread::get_id());
+  }
+
+  std::vector<std::pair<Hash, std::vector<ITransfersContainer*>>> updated;
+  std::vector<std::thread::id> threads;
+};
+
+TEST_F(TransfersConsumerTest, onNewBlocks_shardsMergeResultsAndNotifyOnCallingThread) {
+  // enough subscriptions for four shards of 32
+  const size_t subscriptionCount = 4 * 32;
+  const size_t blocksCount = 4;
+
+  m_consumer.setThreadCount(4);
+
+  std::vector<AccountKeys> accounts;
+  std::vector<ITransfersSubscription*> subscriptions;
+  std::vector<std::unique_ptr<ThreadRecordingTransfersObserver>> observers;
+  for (size_t i = 0; i < subscriptionCount; ++i) {
+    accounts.push_back(generateAccount());
+    subscriptions.push_back(&addSubscription(accounts.back()));
+    observers.emplace_back(new ThreadRecordingTransfersObserver());
+    subscriptions.back()->addObserver(observers.back().get());
+  }
+
+  ContainersRecordingConsumerObserver consumerObserver;
+  m_consumer.addObserver(&consumerObserver);
+
+  // every account gets a transfer of its own and a share of one paying all of them
+  std::vector<CompleteBlock> blocks(blocksCount);
+  std::vector<Hash> expectedUpdates;
+  std::vector<Hash> ownTransactions(subscriptionCount);
+  uint32_t globalOut = 0;
+  for (size_t i = 0; i < blocksCount; ++i) {
+    blocks[i].block = BlockTemplate();
+    blocks[i].block->timestamp = i;
+  }
+
+  std::shared_ptr<ITransaction> sharedTx(createTransaction());
+  for (const auto& account : accounts) {
+    addTestKeyOutput(*sharedTx, 100, ++globalOut, account);
+  }
+  addTestInput(*sharedTx, 100000);
+
+  blocks[0].transactions.push_back(sharedTx);
+  expectedUpdates.push_back(sharedTx->getTransactionHash());
+
+  for (size_t i = 0; i < subscriptionCount; ++i) {
+    std::shared_ptr<ITransaction> tx(createTransaction());
+    addTestKeyOutput(*tx, 1000 + i, ++globalOut, accounts[i]);
+    addTestInput(*tx, 10000);
+    blocks[1 + i % (blocksCount - 1)].transactions.push_back(tx);
+    ownTransactions[i] = tx->getTransactionHash();
+  }
+
+  for (size_t i = 1; i < blocksCount; ++i) {
+    for (const auto& tx : blocks[i].transactions) {
+      expectedUpdates.push_back(tx->getTransactionHash());
+    }
+  }
+
+  ASSERT_EQ(blocksCount, m_consumer.onNewBlocks(&blocks[0], 0, static_cast<uint32_t>(blocksCount)));
+
+  auto callingThread = std::this_thread::get_id();
+
+  ASSERT_EQ(expectedUpdates.size(), consumerObserver.updated.size());
+  for (size_t i = 0; i < expectedUpdates.size(); ++i) {
+    ASSERT_EQ(expectedUpdates[i], consumerObserver.updated[i].first);
+    ASSERT_EQ(callingThread, consumerObserver.threads[i]);
+  }
+
+  const auto& sharedContainers = consumerObserver.updated.front().second;
+  ASSERT_EQ(subscriptionCount, sharedContainers.size());
+  ASSERT_EQ(subscriptionCount, std::set<ITransfersContainer*>(sharedContainers.begin(), sharedContainers.end()).size());
+
+  for (size_t i = 0; i < subscriptionCount; ++i) {
+    ASSERT_EQ(std::vector<Hash>({ sharedTx->getTransactionHash(), ownTransactions[i] }), observers[i]->updated);
+    ASSERT_EQ(std::vector<std::thread::id>(2, callingThread), observers[i]->threads);
+
+    auto& container = subscriptions[i]->getContainer();
+    ASSERT_EQ(2, container.transactionsCount());
+    ASSERT_EQ(100 + 1000 + i, container.balance(ITransfersContainer::IncludeAll));
+  }
+
+  m_consumer.removeObserver(&consumerObserver);
+}
+
 TEST_F(TransfersConsumerTest, onPoolUpdated_addTransaction) {
   auto& sub = addSubscription();
 
@@ -1105,3 +1208,30 @@ TEST_F(TransfersConsumerPerformanceTest, DISABLED_performanceTest) {
   std::cout << "Running time: " << dur.count() << "s" << std::endl;
   std::cout << "Finish" << std::endl;
 }
+
+TEST_F(TransfersConsumerPerformanceTest, DISABLED_scanningScalesWithThreads) {
+
+  const size_t blocksCount = 200;
+  const size_t txPerBlock = 20;
+
+  addAndSubscribeAccounts(10000);
+  auto expectedTransactions = generateBlocks(blocksCount, txPerBlock, 3);
+
+  std::cout << "Transactions sent to accounts: " << expectedTransactions << std::endl;
+
+  size_t maxThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  double singleThreadSeconds = 0;
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    m_consumer.onBlockchainDetach(0);
+    m_consumer.setThreadCount(threads);
+
+    AutoTimer timer;
+    ASSERT_EQ(blocks.size(), m_consumer.onNewBlocks(&blocks[0], 0, static_cast<uint32_t>(blocks.size())));
+    double seconds = timer.getSeconds().count();
+    if (threads == 1) {
+      singleThreadSeconds = seconds;
+    }
+
+    std::cout << threads << " threads: " << seconds << "s, speedup " << singleThreadSeconds / seconds << std::endl;
+  }
+}
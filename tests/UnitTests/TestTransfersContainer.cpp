@@ -17,6 +17,10 @@
 
 #include "gtest/gtest.h"
 
+#include <chrono>
+#include <sstream>
+#include <thread>
+
 #include "IWalletLegacy.h"
 
 #include "crypto/crypto.h"
@@ -1002,6 +1006,213 @@ TEST_F(TransfersContainer_balance, filtersByStateAndKeySimultaneously) {
 }
 
 
+//--------------------------------------------------------------------------- 
+// TransfersContainer_runningBalance
+//--------------------------------------------------------------------------- 
+
+class TransfersContainer_runningBalance : public TransfersContainerTest {
+public:
+  TransfersContainer_runningBalance() {
+  }
+
+  enum TestAmounts : uint64_t {
+    AMOUNT_1 = 13,
+    AMOUNT_2 = 17,
+    AMOUNT_3 = 19
+  };
+
+protected:
+  std::unique_ptr<ITransactionReader> addUnlockTimeTransaction(uint32_t height, uint64_t unlockTime, uint64_t amount) {
+    TestTransactionBuilder builder;
+    builder.setUnlockTime(unlockTime);
+    builder.addTestInput(amount + 1, account);
+
+    auto outputIndex = (height == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT) ? UNCONFIRMED_TRANSACTION_GLOBAL_OUTPUT_INDEX : TEST_TRANSACTION_OUTPUT_GLOBAL_INDEX;
+    auto outInfo = builder.addTestKeyOutput(amount, outputIndex, account);
+
+    auto tx = builder.build();
+    EXPECT_TRUE(container.addTransaction(blockInfo(height), *tx, { outInfo }));
+    return tx;
+  }
+
+  std::unique_ptr<ITransactionReader> addMultisignatureTransaction(uint32_t height, uint64_t amount, uint32_t globalOutputIndex) {
+    TestTransactionBuilder builder;
+    builder.addTestInput(amount + 1, account);
+    auto outInfo = builder.addTestMultisignatureOutput(amount, globalOutputIndex);
+
+    auto tx = builder.build();
+    EXPECT_TRUE(container.addTransaction(blockInfo(height), *tx, { outInfo }));
+    return tx;
+  }
+
+  // The balance as it was computed before the running balances: a scan of every visible transfer
+  static uint64_t scannedBalance(const TransfersContainer& transfers, uint32_t flags) {
+    std::vector<TransactionOutputInformation> outputs;
+    transfers.getOutputs(outputs, flags);
+
+    uint64_t amount = 0;
+    for (const auto& output : outputs) {
+      amount += output.amount;
+    }
+
+    return amount;
+  }
+
+  static void checkBalances(const TransfersContainer& transfers) {
+    const uint32_t allStates = ITransfersContainer::IncludeStateUnlocked | ITransfersContainer::IncludeStateLocked |
+      ITransfersContainer::IncludeStateSoftLocked;
+
+    for (uint32_t type : { ITransfersContainer::IncludeTypeKey, ITransfersContainer::IncludeTypeMultisignature, ITransfersContainer::IncludeTypeAll }) {
+      for (uint32_t state = 1; state <= allStates; ++state) {
+        uint32_t flags = type | state;
+        EXPECT_EQ(scannedBalance(transfers, flags), transfers.balance(flags)) << "flags 0x" << std::hex << flags;
+      }
+    }
+  }
+};
+
+TEST_F(TransfersContainer_runningBalance, heightUnlocksMatchScan) {
+  addTransaction(TEST_BLOCK_HEIGHT, AMOUNT_1);
+  addUnlockTimeTransaction(TEST_BLOCK_HEIGHT, TEST_BLOCK_HEIGHT + 3, AMOUNT_2);
+  addUnlockTimeTransaction(TEST_BLOCK_HEIGHT + 1, TEST_BLOCK_HEIGHT + 6, AMOUNT_3);
+  addMultisignatureTransaction(TEST_BLOCK_HEIGHT + 1, AMOUNT_1, TEST_TRANSACTION_OUTPUT_GLOBAL_INDEX);
+  checkBalances(container);
+
+  for (uint32_t height = TEST_BLOCK_HEIGHT + 2; height <= TEST_BLOCK_HEIGHT + 8; ++height) {
+    ASSERT_TRUE(container.advanceHeight(height));
+    checkBalances(container);
+  }
+
+  ASSERT_EQ(2 * AMOUNT_1 + AMOUNT_2 + AMOUNT_3, container.balance(ITransfersContainer::IncludeAllUnlocked));
+}
+
+TEST_F(TransfersContainer_runningBalance, heightJumpOverSeveralUnlocksMatchesScan) {
+  addUnlockTimeTransaction(TEST_BLOCK_HEIGHT, TEST_BLOCK_HEIGHT + 3, AMOUNT_1);
+  addUnlockTimeTransaction(TEST_BLOCK_HEIGHT, TEST_BLOCK_HEIGHT + 10, AMOUNT_2);
+  addUnlockTimeTransaction(TEST_BLOCK_HEIGHT, TEST_CONTAINER_CURRENT_HEIGHT, AMOUNT_3);
+  checkBalances(container);
+
+  ASSERT_TRUE(container.advanceHeight(TEST_BLOCK_HEIGHT + 20));
+  checkBalances(container);
+  ASSERT_EQ(AMOUNT_1 + AMOUNT_2, container.balance(ITransfersContainer::IncludeAllUnlocked));
+
+  ASSERT_TRUE(container.advanceHeight(TEST_CONTAINER_CURRENT_HEIGHT));
+  checkBalances(container);
+  ASSERT_EQ(AMOUNT_1 + AMOUNT_2 + AMOUNT_3, container.balance(ITransfersContainer::IncludeAllUnlocked));
+}
+
+TEST_F(TransfersContainer_runningBalance, softLockTransitionsMatchScan) {
+  auto unconfirmedTx = addTransaction(WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT, AMOUNT_1);
+  auto tx = addTransaction(TEST_BLOCK_HEIGHT, AMOUNT_2);
+  checkBalances(container);
+  ASSERT_EQ(AMOUNT_2, container.balance(ITransfersContainer::IncludeStateSoftLocked | ITransfersContainer::IncludeTypeAll));
+
+  ASSERT_TRUE(container.markTransactionConfirmed(blockInfo(TEST_BLOCK_HEIGHT + 1), unconfirmedTx->getTransactionHash(),
+    { TEST_TRANSACTION_OUTPUT_GLOBAL_INDEX + 1 }));
+  checkBalances(container);
+
+  ASSERT_TRUE(container.advanceHeight(TEST_BLOCK_HEIGHT + 1));
+  checkBalances(container);
+  ASSERT_EQ(AMOUNT_1, container.balance(ITransfersContainer::IncludeStateSoftLocked | ITransfersContainer::IncludeTypeAll));
+
+  auto unconfirmedSpendingTx = addSpendingTransaction(tx->getTransactionHash(), WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT,
+    UNCONFIRMED_TRANSACTION_GLOBAL_OUTPUT_INDEX, AMOUNT_2);
+  checkBalances(container);
+  ASSERT_EQ(0, container.balance(ITransfersContainer::IncludeAllUnlocked));
+
+  ASSERT_TRUE(container.deleteUnconfirmedTransaction(unconfirmedSpendingTx->getTransactionHash()));
+  checkBalances(container);
+
+  ASSERT_TRUE(container.advanceHeight(TEST_BLOCK_HEIGHT + 2));
+  checkBalances(container);
+
+  addSpendingTransaction(tx->getTransactionHash(), TEST_BLOCK_HEIGHT + 2, TEST_TRANSACTION_OUTPUT_GLOBAL_INDEX + 2, AMOUNT_2 / 2);
+  checkBalances(container);
+  ASSERT_EQ(AMOUNT_2 - AMOUNT_2 / 2, container.balance(ITransfersContainer::IncludeStateSoftLocked | ITransfersContainer::IncludeTypeAll));
+
+  ASSERT_TRUE(container.advanceHeight(TEST_BLOCK_HEIGHT + 3));
+  checkBalances(container);
+  ASSERT_EQ(AMOUNT_1 + AMOUNT_2 - AMOUNT_2 / 2, container.balance(ITransfersContainer::IncludeAllUnlocked));
+}
+
+TEST_F(TransfersContainer_runningBalance, timestampUnlockMatchesScan) {
+  uint64_t now = static_cast<uint64_t>(time(nullptr));
+  uint64_t unlockTime = now + currency.lockedTxAllowedDeltaSeconds() + 2;
+
+  addUnlockTimeTransaction(TEST_BLOCK_HEIGHT, unlockTime, AMOUNT_1);
+  addUnlockTimeTransaction(TEST_BLOCK_HEIGHT, now + 60 * 60 * 24, AMOUNT_2);
+  addTransaction(TEST_BLOCK_HEIGHT, AMOUNT_3);
+  ASSERT_TRUE(container.advanceHeight(TEST_BLOCK_HEIGHT + TEST_TRANSACTION_SPENDABLE_AGE));
+  checkBalances(container);
+  ASSERT_EQ(AMOUNT_1 + AMOUNT_2, container.balance(ITransfersContainer::IncludeAllLocked));
+
+  while (static_cast<uint64_t>(time(nullptr)) < now + 2) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  checkBalances(container);
+  ASSERT_EQ(AMOUNT_1 + AMOUNT_3, container.balance(ITransfersContainer::IncludeAllUnlocked));
+  ASSERT_EQ(AMOUNT_2, container.balance(ITransfersContainer::IncludeAllLocked));
+}
+
+TEST_F(TransfersContainer_runningBalance, detachMatchesScan) {
+  auto tx = addTransaction(TEST_BLOCK_HEIGHT, AMOUNT_1);
+  addUnlockTimeTransaction(TEST_BLOCK_HEIGHT + 1, TEST_BLOCK_HEIGHT + 4, AMOUNT_2);
+  addMultisignatureTransaction(TEST_BLOCK_HEIGHT + 2, AMOUNT_3, TEST_TRANSACTION_OUTPUT_GLOBAL_INDEX);
+  ASSERT_TRUE(container.advanceHeight(TEST_BLOCK_HEIGHT + 5));
+  addSpendingTransaction(tx->getTransactionHash(), TEST_BLOCK_HEIGHT + 5, TEST_TRANSACTION_OUTPUT_GLOBAL_INDEX + 1, AMOUNT_1 / 2);
+  addTransaction(TEST_BLOCK_HEIGHT + 6, AMOUNT_2);
+  addTransaction(WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT, AMOUNT_3);
+  ASSERT_TRUE(container.advanceHeight(TEST_BLOCK_HEIGHT + 8));
+  checkBalances(container);
+
+  // the spending transaction and the last one are detached, the height lock of the second one applies again
+  container.detach(TEST_BLOCK_HEIGHT + 3);
+  checkBalances(container);
+  ASSERT_EQ(AMOUNT_1, container.balance(ITransfersContainer::IncludeAllUnlocked));
+  ASSERT_EQ(AMOUNT_2 + AMOUNT_3, container.balance(ITransfersContainer::IncludeStateLocked | ITransfersContainer::IncludeTypeAll));
+
+  container.detach(TEST_BLOCK_HEIGHT + 1);
+  checkBalances(container);
+  ASSERT_EQ(AMOUNT_1, container.balance(ITransfersContainer::IncludeStateSoftLocked | ITransfersContainer::IncludeTypeAll));
+
+  ASSERT_TRUE(container.advanceHeight(TEST_BLOCK_HEIGHT + 1));
+  checkBalances(container);
+  ASSERT_EQ(AMOUNT_1, container.balance(ITransfersContainer::IncludeAllUnlocked));
+}
+
+TEST_F(TransfersContainer_runningBalance, loadAndLoadChangesMatchScan) {
+  auto tx = addTransaction(TEST_BLOCK_HEIGHT, AMOUNT_1);
+  addUnlockTimeTransaction(TEST_BLOCK_HEIGHT, TEST_BLOCK_HEIGHT + 4, AMOUNT_2);
+  addTransaction(WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT, AMOUNT_3);
+  ASSERT_TRUE(container.advanceHeight(TEST_BLOCK_HEIGHT + 2));
+
+  std::stringstream stream;
+  container.save(stream);
+
+  TransfersContainer loaded(currency, logger, TEST_TRANSACTION_SPENDABLE_AGE);
+  loaded.load(stream);
+  checkBalances(loaded);
+  ASSERT_EQ(container.balance(ITransfersContainer::IncludeAll), loaded.balance(ITransfersContainer::IncludeAll));
+
+  // the changes cross the height unlock and the soft lock of the new transfers
+  addSpendingTransaction(tx->getTransactionHash(), TEST_BLOCK_HEIGHT + 3, TEST_TRANSACTION_OUTPUT_GLOBAL_INDEX + 1, AMOUNT_1 / 2);
+  addMultisignatureTransaction(TEST_BLOCK_HEIGHT + 5, AMOUNT_3, TEST_TRANSACTION_OUTPUT_GLOBAL_INDEX);
+  ASSERT_TRUE(container.advanceHeight(TEST_BLOCK_HEIGHT + 5));
+
+  std::stringstream changes;
+  container.saveChanges(changes);
+  loaded.loadChanges(changes);
+  checkBalances(loaded);
+
+  const uint32_t comparedFlags[] = { ITransfersContainer::IncludeAllUnlocked, ITransfersContainer::IncludeAllLocked,
+    ITransfersContainer::IncludeStateSoftLocked | ITransfersContainer::IncludeTypeAll, ITransfersContainer::IncludeAll };
+  for (uint32_t flags : comparedFlags) {
+    ASSERT_EQ(container.balance(flags), loaded.balance(flags));
+  }
+}
+
+
 //--------------------------------------------------------------------------- 
 // TransfersContainer_getOutputs
 //--------------------------------------------------------------------------- 
@@ -1131,3 +1342,96 @@ TEST_F(TransfersContainer_getOutputs, filtersByStateAndKeySimultaneously) {
   ASSERT_EQ(AMOUNT_1 + AMOUNT_2, transfers.front().amount);
 }
 
+
+//--------------------------------------------------------------------------- 
+// TransfersContainer_selectOutputs
+//--------------------------------------------------------------------------- 
+
+class TransfersContainer_selectOutputs : public TransfersContainerTest {
+public:
+  enum TestAmounts : uint64_t {
+    DUST_THRESHOLD = 10,
+    DUST_AMOUNT_1 = 1,
+    DUST_AMOUNT_2 = 2,
+    AMOUNT_1 = 20,
+    AMOUNT_2 = 30,
+    AMOUNT_3 = 50
+  };
+
+  void addUnlockedOutputs(const std::vector<uint64_t>& amounts) {
+    for (auto amount : amounts) {
+      addTransaction(TEST_BLOCK_HEIGHT, amount);
+    }
+
+    container.advanceHeight(TEST_CONTAINER_CURRENT_HEIGHT);
+  }
+
+  std::vector<uint64_t> select(uint64_t neededMoney, size_t dustCount, OutputSelectionStrategy strategy, uint64_t& foundMoney) {
+    std::vector<TransactionOutputInformation> outputs;
+    foundMoney = container.selectOutputs(neededMoney, DUST_THRESHOLD, dustCount, strategy, outputs);
+
+    std::vector<uint64_t> amounts;
+    for (const auto& output : outputs) {
+      amounts.push_back(output.amount);
+    }
+
+    return amounts;
+  }
+};
+
+TEST_F(TransfersContainer_selectOutputs, largestFirstSelectsFewestOutputs) {
+  addUnlockedOutputs({ DUST_AMOUNT_1, AMOUNT_1, AMOUNT_2, AMOUNT_3 });
+
+  uint64_t foundMoney;
+  auto amounts = select(AMOUNT_3 + 1, 1, OutputSelectionStrategy::LargestFirst, foundMoney);
+  ASSERT_EQ(std::vector<uint64_t>({ AMOUNT_3, AMOUNT_2 }), amounts);
+  ASSERT_EQ(AMOUNT_3 + AMOUNT_2, foundMoney);
+}
+
+TEST_F(TransfersContainer_selectOutputs, smallestSufficientSelectsSingleOutput) {
+  addUnlockedOutputs({ AMOUNT_1, AMOUNT_2, AMOUNT_3 });
+
+  uint64_t foundMoney;
+  auto amounts = select(AMOUNT_1 + 1, 0, OutputSelectionStrategy::SmallestSufficient, foundMoney);
+  ASSERT_EQ(std::vector<uint64_t>({ AMOUNT_2 }), amounts);
+  ASSERT_EQ(AMOUNT_2, foundMoney);
+}
+
+TEST_F(TransfersContainer_selectOutputs, smallestSufficientFallsBackToLargestFirst) {
+  addUnlockedOutputs({ AMOUNT_1, AMOUNT_2, AMOUNT_3 });
+
+  uint64_t foundMoney;
+  auto amounts = select(AMOUNT_3 + AMOUNT_2 + 1, 0, OutputSelectionStrategy::SmallestSufficient, foundMoney);
+  ASSERT_EQ(std::vector<uint64_t>({ AMOUNT_3, AMOUNT_2, AMOUNT_1 }), amounts);
+  ASSERT_EQ(AMOUNT_3 + AMOUNT_2 + AMOUNT_1, foundMoney);
+}
+
+TEST_F(TransfersContainer_selectOutputs, skipsDustIfDustCountIsZero) {
+  addUnlockedOutputs({ DUST_AMOUNT_1, AMOUNT_1 });
+
+  uint64_t foundMoney;
+  auto amounts = select(AMOUNT_1 + DUST_AMOUNT_1, 0, OutputSelectionStrategy::LargestFirst, foundMoney);
+  ASSERT_EQ(std::vector<uint64_t>({ AMOUNT_1 }), amounts);
+  ASSERT_EQ(AMOUNT_1, foundMoney);
+}
+
+TEST_F(TransfersContainer_selectOutputs, consolidateDustSelectsSmallestDustFirst) {
+  addUnlockedOutputs({ DUST_AMOUNT_2, DUST_AMOUNT_1, DUST_AMOUNT_1, AMOUNT_1, AMOUNT_3 });
+
+  uint64_t foundMoney;
+  auto amounts = select(AMOUNT_1, 2, OutputSelectionStrategy::ConsolidateDust, foundMoney);
+  ASSERT_EQ(std::vector<uint64_t>({ DUST_AMOUNT_1, DUST_AMOUNT_1, AMOUNT_3 }), amounts);
+  ASSERT_EQ(DUST_AMOUNT_1 + DUST_AMOUNT_1 + AMOUNT_3, foundMoney);
+}
+
+TEST_F(TransfersContainer_selectOutputs, randomSelectsOnlyUnlockedOutputs) {
+  addUnlockedOutputs({ AMOUNT_1, AMOUNT_2 });
+  addTransaction(WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT, AMOUNT_3);
+  addTransaction(TEST_CONTAINER_CURRENT_HEIGHT, AMOUNT_3);
+
+  uint64_t foundMoney;
+  auto amounts = select(std::numeric_limits<uint64_t>::max(), 0, OutputSelectionStrategy::Random, foundMoney);
+  std::sort(amounts.begin(), amounts.end());
+  ASSERT_EQ(std::vector<uint64_t>({ AMOUNT_1, AMOUNT_2 }), amounts);
+  ASSERT_EQ(AMOUNT_1 + AMOUNT_2, foundMoney);
+}
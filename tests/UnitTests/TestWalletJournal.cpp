@@ -0,0 +1,370 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) | 2020-2021 Cyber Secure Six Inc. | 2016 - 2019 The Karbo Developers
+//
+// This file is part of SSIX.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "Common/StringTools.h"
+#include "CryptoNoteCore/Currency.h"
+#include "INodeStubs.h"
+#include "Logging/ConsoleLogger.h"
+#include "System/Context.h"
+#include "System/Dispatcher.h"
+#include "System/Timer.h"
+#include "TestBlockchainGenerator.h"
+#include "TransactionApiHelpers.h"
+#include "Wallet/WalletGreen.h"
+#include "Wallet/WalletJournal.h"
+#include "crypto/crypto.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const std::string JOURNAL_PATH = "test.journal";
+const std::string WALLET_PATH = "journal.wallet";
+const std::string WALLET_JOURNAL_PATH = WALLET_PATH + ".journal";
+const std::string PASSWORD = "pass";
+
+// the signature and the snapshot IV
+const uint64_t JOURNAL_HEADER_SIZE = sizeof(uint64_t) + sizeof(Crypto::chacha8_iv);
+
+Crypto::chacha8_key generateKey(const std::string& password) {
+  Crypto::chacha8_key key;
+  Crypto::generate_chacha8_key(password, key);
+  return key;
+}
+
+void appendGarbage(const std::string& path, size_t size) {
+  std::ofstream file(path, std::ios_base::binary | std::ios_base::app);
+  file << std::string(size, '\x5a');
+}
+
+Crypto::chacha8_iv readSnapshotIv(const std::string& path) {
+  std::ifstream file(path, std::ios_base::binary);
+  file.seekg(sizeof(uint64_t));
+
+  Crypto::chacha8_iv iv;
+  file.read(reinterpret_cast<char*>(&iv), sizeof(iv));
+  return iv;
+}
+
+struct WalletSnapshot {
+  uint64_t actualBalance;
+  uint64_t pendingBalance;
+  std::vector<WalletTransaction> transactions;
+};
+
+class WalletJournalTest : public ::testing::Test {
+public:
+  WalletJournalTest() :
+    logger(Logging::ERROR),
+    currency(CurrencyBuilder(logger).currency()),
+    generator(currency),
+    node(generator),
+    wallet(dispatcher, currency, node, logger),
+    key(generateKey(PASSWORD))
+  {
+  }
+
+  virtual void SetUp() override {
+    cleanUpFiles();
+    wallet.initialize(WALLET_PATH, PASSWORD);
+    address = wallet.createAddress();
+  }
+
+  virtual void TearDown() override {
+    wallet.shutdown();
+    wait(100); //ObserverManager bug workaround
+    cleanUpFiles();
+  }
+
+protected:
+  void cleanUpFiles() {
+    boost::filesystem::remove(JOURNAL_PATH);
+    boost::filesystem::remove(WALLET_PATH);
+    boost::filesystem::remove(WALLET_JOURNAL_PATH);
+  }
+
+  void wait(uint64_t milliseconds) {
+    System::Timer(dispatcher).sleep(std::chrono::milliseconds(milliseconds));
+  }
+
+  void waitForPredicate(std::function<bool()>&& pred) {
+    System::Context<> waitContext(dispatcher, [this, &pred]() {
+      while (!pred()) {
+        wallet.getEvent();
+      }
+    });
+
+    System::Context<> timeoutContext(dispatcher, [this, &waitContext] {
+      System::Timer(dispatcher).sleep(std::chrono::seconds(30));
+      waitContext.interrupt();
+    });
+
+    waitContext.get();
+  }
+
+  void generateAndUnlockMoney() {
+    AccountPublicAddress publicAddress;
+    ASSERT_TRUE(currency.parseAccountAddressString(address, publicAddress));
+
+    uint64_t prev = wallet.getActualBalance();
+    generator.getBlockRewardForAddress(publicAddress);
+    generator.generateEmptyBlocks(currency.minedMoneyUnlockWindow());
+    node.updateObservers();
+    waitForPredicate([this, prev] { return wallet.getActualBalance() != prev; });
+  }
+
+  Transaction putTransactionToPool(uint64_t amount) {
+    AccountKeys keys;
+    keys.address.viewPublicKey = wallet.getViewKey().publicKey;
+    keys.address.spendPublicKey = wallet.getAddressSpendKey(0).publicKey;
+
+    TestTransactionBuilder builder;
+    builder.addTestInput(amount + currency.minimumFee());
+    builder.addOutput(amount, keys.address);
+    auto reader = builder.build();
+    Transaction tx = convertTx(*reader);
+
+    uint64_t prev = wallet.getPendingBalance();
+    generator.putTxToPool(tx);
+    node.sendPoolChanged();
+    waitForPredicate([this, prev] { return wallet.getPendingBalance() != prev; });
+    return tx;
+  }
+
+  void clearTransactionPool() {
+    uint64_t prev = wallet.getPendingBalance();
+    generator.clearTxPool();
+    node.sendPoolChanged();
+    waitForPredicate([this, prev] { return wallet.getPendingBalance() != prev; });
+  }
+
+  WalletSnapshot takeSnapshot() {
+    WalletSnapshot snapshot;
+    snapshot.actualBalance = wallet.getActualBalance();
+    snapshot.pendingBalance = wallet.getPendingBalance();
+    for (size_t i = 0; i < wallet.getTransactionCount(); ++i) {
+      snapshot.transactions.push_back(wallet.getTransaction(i));
+    }
+
+    return snapshot;
+  }
+
+  void reload(const std::string& password = PASSWORD) {
+    wallet.shutdown();
+    wait(100); //ObserverManager bug workaround
+    wallet.load(WALLET_PATH, password);
+  }
+
+  // The state is checked before the synchronizer started by load() gets a chance to change it
+  void assertStateIs(const WalletSnapshot& expected) {
+    ASSERT_EQ(expected.actualBalance, wallet.getActualBalance());
+    ASSERT_EQ(expected.pendingBalance, wallet.getPendingBalance());
+    ASSERT_EQ(expected.transactions.size(), wallet.getTransactionCount());
+    for (size_t i = 0; i < expected.transactions.size(); ++i) {
+      WalletTransaction tx = wallet.getTransaction(i);
+      ASSERT_EQ(expected.transactions[i].hash, tx.hash);
+      ASSERT_EQ(expected.transactions[i].state, tx.state);
+      ASSERT_EQ(expected.transactions[i].blockHeight, tx.blockHeight);
+      ASSERT_EQ(expected.transactions[i].totalAmount, tx.totalAmount);
+    }
+  }
+
+  uint64_t walletJournalSize() {
+    return boost::filesystem::file_size(WALLET_JOURNAL_PATH);
+  }
+
+  System::Dispatcher dispatcher;
+  Logging::ConsoleLogger logger;
+  Currency currency;
+  TestBlockchainGenerator generator;
+  INodeTrivialRefreshStub node;
+  WalletGreen wallet;
+  std::string address;
+  Crypto::chacha8_key key;
+};
+
+}
+
+TEST_F(WalletJournalTest, readReturnsAppendedRecords) {
+  auto iv = Crypto::randomChachaIV();
+  WalletJournal journal;
+  journal.open(JOURNAL_PATH);
+  journal.reset(iv);
+  journal.append(key, "first", 5);
+  journal.append(key, "second record", 13);
+  uint64_t size = journal.size();
+
+  WalletJournal loaded;
+  loaded.open(JOURNAL_PATH);
+  std::vector<BinaryArray> records;
+  ASSERT_TRUE(loaded.read(key, iv, records));
+
+  ASSERT_EQ(2, records.size());
+  ASSERT_EQ(Common::asBinaryArray("first"), records[0]);
+  ASSERT_EQ(Common::asBinaryArray("second record"), records[1]);
+  ASSERT_EQ(2, loaded.recordCount());
+  ASSERT_EQ(size, loaded.size());
+}
+
+TEST_F(WalletJournalTest, readTruncatesTornTail) {
+  auto iv = Crypto::randomChachaIV();
+  WalletJournal journal;
+  journal.open(JOURNAL_PATH);
+  journal.reset(iv);
+  journal.append(key, "first", 5);
+  uint64_t fileSize = boost::filesystem::file_size(JOURNAL_PATH);
+
+  appendGarbage(JOURNAL_PATH, 30);
+
+  std::vector<BinaryArray> records;
+  ASSERT_TRUE(journal.read(key, iv, records));
+  ASSERT_EQ(1, records.size());
+  ASSERT_EQ(fileSize, boost::filesystem::file_size(JOURNAL_PATH));
+
+  // the next record follows the last complete one
+  journal.append(key, "second", 6);
+  records.clear();
+  ASSERT_TRUE(journal.read(key, iv, records));
+  ASSERT_EQ(2, records.size());
+  ASSERT_EQ(Common::asBinaryArray("second"), records[1]);
+}
+
+TEST_F(WalletJournalTest, readIgnoresJournalOfOtherSnapshot) {
+  WalletJournal journal;
+  journal.open(JOURNAL_PATH);
+  journal.reset(Crypto::randomChachaIV());
+  journal.append(key, "first", 5);
+
+  std::vector<BinaryArray> records;
+  ASSERT_FALSE(journal.read(key, Crypto::randomChachaIV(), records));
+  ASSERT_TRUE(records.empty());
+  ASSERT_EQ(0, journal.recordCount());
+}
+
+TEST_F(WalletJournalTest, savedChangesAreReplayedOnLoad) {
+  generateAndUnlockMoney();
+  wallet.save();
+  ASSERT_EQ(JOURNAL_HEADER_SIZE, walletJournalSize());
+
+  generateAndUnlockMoney();
+  wallet.save();
+  ASSERT_LT(JOURNAL_HEADER_SIZE, walletJournalSize());
+  auto expected = takeSnapshot();
+
+  reload();
+  assertStateIs(expected);
+}
+
+TEST_F(WalletJournalTest, tornTailIsTruncatedOnLoad) {
+  generateAndUnlockMoney();
+  wallet.save();
+  generateAndUnlockMoney();
+  wallet.save();
+  auto expected = takeSnapshot();
+  uint64_t journalSize = walletJournalSize();
+
+  appendGarbage(WALLET_JOURNAL_PATH, 100);
+
+  reload();
+  assertStateIs(expected);
+  ASSERT_EQ(journalSize, walletJournalSize());
+}
+
+TEST_F(WalletJournalTest, staleJournalIsIgnoredOnLoad) {
+  generateAndUnlockMoney();
+  wallet.save();
+  generateAndUnlockMoney();
+  wallet.save();
+  auto staleJournal = WALLET_JOURNAL_PATH + ".stale";
+  boost::filesystem::copy_file(WALLET_JOURNAL_PATH, staleJournal);
+
+  // a full save writes a new snapshot, the changes of the copied journal are in it already
+  wallet.save(WalletSaveLevel::SAVE_KEYS_AND_TRANSACTIONS);
+  wallet.save();
+  auto expected = takeSnapshot();
+  boost::filesystem::rename(staleJournal, WALLET_JOURNAL_PATH);
+
+  reload();
+  assertStateIs(expected);
+}
+
+TEST_F(WalletJournalTest, deletedPoolTransactionIsReplayed) {
+  generateAndUnlockMoney();
+  wallet.save();
+
+  Transaction tx = putTransactionToPool(1000000);
+  wallet.save();
+
+  clearTransactionPool();
+  wallet.save();
+  auto expected = takeSnapshot();
+
+  size_t id = expected.transactions.size() - 1;
+  ASSERT_EQ(getObjectHash(tx), expected.transactions[id].hash);
+  ASSERT_EQ(WalletTransactionState::CANCELLED, expected.transactions[id].state);
+
+  reload();
+  assertStateIs(expected);
+}
+
+TEST_F(WalletJournalTest, changePasswordFoldsJournal) {
+  generateAndUnlockMoney();
+  wallet.save();
+  generateAndUnlockMoney();
+  wallet.save();
+  auto expected = takeSnapshot();
+  ASSERT_LT(JOURNAL_HEADER_SIZE, walletJournalSize());
+
+  wallet.changePassword(PASSWORD, "new pass");
+  ASSERT_EQ(JOURNAL_HEADER_SIZE, walletJournalSize());
+
+  reload("new pass");
+  assertStateIs(expected);
+}
+
+TEST_F(WalletJournalTest, brokenRecordKeepsCache) {
+  generateAndUnlockMoney();
+  wallet.save();
+  auto expected = takeSnapshot();
+
+  generateAndUnlockMoney();
+  wallet.save();
+
+  // cut the record short and write it back with a valid checksum, so it fails only when it is replayed
+  auto iv = readSnapshotIv(WALLET_JOURNAL_PATH);
+  WalletJournal journal;
+  journal.open(WALLET_JOURNAL_PATH);
+  std::vector<BinaryArray> records;
+  ASSERT_TRUE(journal.read(key, iv, records));
+  ASSERT_EQ(1, records.size());
+  journal.reset(iv);
+  journal.append(key, records[0].data(), records[0].size() / 2);
+
+  reload();
+  assertStateIs(expected);
+  ASSERT_FALSE(boost::filesystem::exists(WALLET_JOURNAL_PATH));
+}